@@ -228,6 +228,8 @@ def get_ir_equivalence_test_cmd(
         # Overrides global entry attribute.
         "function",
         "timeout",
+        "simulation_vectors",
+        "equivalence_point_timeout",
     )
 
     ir_equivalence_args = dict(ctx.attr.ir_equivalence_args)
@@ -16,12 +16,14 @@
 
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "xls/codegen/codegen_pass.h"
 #include "xls/codegen/register_legalization_pass.h"
 #include "xls/codegen/vast.h"
 #include "xls/common/logging/logging.h"
+#include "xls/ir/bits.h"
 #include "xls/ir/channel.h"
 #include "xls/ir/function_builder.h"
 #include "xls/ir/node.h"
@@ -269,22 +271,107 @@ static absl::StatusOr<Node*> MakeOrWithResetNode(Node* src_node,
   return result;
 }
 
+// Inserts a skid buffer after the pipeline registers of the given stage. The
+// skid buffer is a second copy of the stage's registers plus a valid bit
+// (skid_valid) which captures the contents of the pipeline registers when they
+// hold valid data which the downstream stage does not accept while the
+// upstream stage loads new data into them. The stage's load enable is then
+// simply !skid_valid so the ready path is broken at the stage boundary:
+//
+//   output_valid = valid || skid_valid
+//   output_data  = skid_valid ? skid_data : data
+//   skid_valid'  = output_valid && !downstream_ready
+//   skid_data'   = data  if !skid_valid && valid && !downstream_ready
+//
+// Uses of the pipeline registers (and valid register) are replaced with the
+// buffered values.
+static absl::Status AddSkidBuffer(int64_t stage, Node* downstream_ready,
+                                  Node* valid, Node* enable,
+                                  RegisterRead* skid_valid,
+                                  PipelineStageRegisters& stage_registers,
+                                  const ResetInfo& reset_info, Block* block) {
+  XLS_ASSIGN_OR_RETURN(
+      Node * buffered_valid,
+      block->MakeNodeWithName<NaryOp>(
+          /*loc=*/absl::nullopt, std::vector<Node*>({valid, skid_valid}),
+          Op::kOr, PipelineSignalName("buffered_valid", stage)));
+  XLS_RETURN_IF_ERROR(valid->ReplaceUsesWith(buffered_valid));
+  XLS_RETURN_IF_ERROR(buffered_valid->ReplaceOperandNumber(0, valid));
+
+  XLS_ASSIGN_OR_RETURN(
+      Node * not_downstream_ready,
+      block->MakeNode<UnOp>(/*loc=*/absl::nullopt, downstream_ready, Op::kNot));
+  XLS_ASSIGN_OR_RETURN(
+      Node * skid_valid_next,
+      block->MakeNode<NaryOp>(
+          /*loc=*/absl::nullopt,
+          std::vector<Node*>({buffered_valid, not_downstream_ready}),
+          Op::kAnd));
+  XLS_RETURN_IF_ERROR(block
+                          ->MakeNode<RegisterWrite>(
+                              /*loc=*/absl::nullopt, skid_valid_next,
+                              /*load_enable=*/absl::nullopt,
+                              /*reset=*/reset_info.input_port,
+                              skid_valid->GetRegister())
+                          .status());
+
+  XLS_ASSIGN_OR_RETURN(
+      Node * skid_load_enable,
+      block->MakeNodeWithName<NaryOp>(
+          /*loc=*/absl::nullopt,
+          std::vector<Node*>({enable, valid, not_downstream_ready}),
+          Op::kAnd, PipelineSignalName("skid_load_en", stage)));
+
+  for (PipelineRegister& pipeline_reg : stage_registers) {
+    XLS_ASSIGN_OR_RETURN(
+        Register * skid_reg,
+        block->AddRegister(absl::StrCat(pipeline_reg.reg->name(), "_skid"),
+                           pipeline_reg.reg->type()));
+    XLS_ASSIGN_OR_RETURN(
+        RegisterRead * skid_read,
+        block->MakeNode<RegisterRead>(/*loc=*/absl::nullopt, skid_reg));
+    XLS_ASSIGN_OR_RETURN(
+        Node * buffered,
+        block->MakeNodeWithName<Select>(
+            /*loc=*/absl::nullopt, skid_valid,
+            std::vector<Node*>({pipeline_reg.reg_read, skid_read}),
+            /*default_value=*/absl::nullopt,
+            absl::StrCat(pipeline_reg.reg->name(), "_buffered")));
+    XLS_RETURN_IF_ERROR(pipeline_reg.reg_read->ReplaceUsesWith(buffered));
+    XLS_RETURN_IF_ERROR(
+        buffered->ReplaceOperandNumber(1, pipeline_reg.reg_read));
+    XLS_RETURN_IF_ERROR(
+        block
+            ->MakeNode<RegisterWrite>(
+                /*loc=*/absl::nullopt, pipeline_reg.reg_read,
+                /*load_enable=*/skid_load_enable,
+                /*reset=*/absl::nullopt, skid_reg)
+            .status());
+  }
+  return absl::OkStatus();
+}
+
 // Adds bubble flow control to the pipeline.
 //
 // - With bubble flow control, a pipeline stage is not stalled if
 //   the next stage is either invalid or is not stalled.
 // - This enabled bubbles within the pipeline to be collapsed when the
 //   output block of the pipeline is not ready to accept data.
+// - Stages in skid_buffer_stages are followed by a skid buffer (see
+//   AddSkidBuffer) and their enable signal is registered.
 //
 static absl::StatusOr<Node*> UpdatePipelineWithBubbleFlowControl(
     Node* initial_output_ready_node, const ResetInfo& reset_info,
     absl::Span<Node*> pipeline_valid_nodes,
     absl::Span<PipelineStageRegisters> pipeline_data_registers,
+    absl::Span<const int64_t> skid_buffer_stages,
     absl::optional<StateRegister>& state_register, Block* block) {
   // Create enable signals for each pipeline stage.
   //   - the last enable signal is the initial_output_ready_node.
   //     enable_signals[N] = initial_output_ready_node
   //   - enable_signal[n-1] = enable_signal[n] || ! valid[n]
+  //     or, if stage n-1 is followed by a skid buffer,
+  //     enable_signal[n-1] = ! skid_valid[n-1]
   //
   // Data registers are gated whenever data is invalid so
   //   - data_enable_signal[n-1] = (enable_signal[n-1] && valid[n-1]) || rst
@@ -297,19 +384,37 @@ static absl::StatusOr<Node*> UpdatePipelineWithBubbleFlowControl(
   std::vector<Node*> enable_n(stage_count + 1);
   enable_n.at(stage_count) = initial_output_ready_node;
 
+  Type* u1 = block->package()->GetBitsType(1);
   for (int64_t stage = stage_count - 1; stage >= 0; --stage) {
     // Create load enables for valid registers.
-    XLS_ASSIGN_OR_RETURN(
-        Node * not_valid_np1,
-        block->MakeNodeWithName<UnOp>(
-            /*loc=*/absl::nullopt, pipeline_valid_nodes.at(stage + 1), Op::kNot,
-            PipelineSignalName("not_valid", stage)));
+    bool has_skid_buffer = absl::c_linear_search(skid_buffer_stages, stage);
+    Node* enable;
+    RegisterRead* skid_valid = nullptr;
+    if (has_skid_buffer) {
+      XLS_ASSIGN_OR_RETURN(
+          Register * skid_valid_reg,
+          block->AddRegister(PipelineSignalName("skid_valid", stage), u1,
+                             reset_info.behavior));
+      XLS_ASSIGN_OR_RETURN(skid_valid, block->MakeNode<RegisterRead>(
+                                           /*loc=*/absl::nullopt,
+                                           skid_valid_reg));
+      XLS_ASSIGN_OR_RETURN(
+          enable, block->MakeNodeWithName<UnOp>(
+                      /*loc=*/absl::nullopt, skid_valid, Op::kNot,
+                      PipelineSignalName("enable", stage)));
+    } else {
+      XLS_ASSIGN_OR_RETURN(
+          Node * not_valid_np1,
+          block->MakeNodeWithName<UnOp>(
+              /*loc=*/absl::nullopt, pipeline_valid_nodes.at(stage + 1),
+              Op::kNot, PipelineSignalName("not_valid", stage)));
 
-    std::vector<Node*> en_operands = {enable_n.at(stage + 1), not_valid_np1};
-    XLS_ASSIGN_OR_RETURN(
-        Node * enable,
-        block->MakeNodeWithName<NaryOp>(absl::nullopt, en_operands, Op::kOr,
-                                        PipelineSignalName("enable", stage)));
+      std::vector<Node*> en_operands = {enable_n.at(stage + 1), not_valid_np1};
+      XLS_ASSIGN_OR_RETURN(
+          enable,
+          block->MakeNodeWithName<NaryOp>(absl::nullopt, en_operands, Op::kOr,
+                                          PipelineSignalName("enable", stage)));
+    }
     enable_n.at(stage) = enable;
 
     // Update valid registers with load enables.
@@ -369,6 +474,13 @@ static absl::StatusOr<Node*> UpdatePipelineWithBubbleFlowControl(
       XLS_RETURN_IF_ERROR(block->RemoveNode(state_register->reg_write));
       state_register->reg_write = new_reg_write;
     }
+
+    if (has_skid_buffer) {
+      XLS_RETURN_IF_ERROR(AddSkidBuffer(
+          stage, /*downstream_ready=*/enable_n.at(stage + 1),
+          /*valid=*/pipeline_valid_nodes.at(stage + 1), enable, skid_valid,
+          pipeline_data_registers.at(stage), reset_info, block));
+    }
   }
 
   return enable_n.at(0);
@@ -504,6 +616,9 @@ struct StreamingIoPipeline {
   std::vector<StreamingOutput> outputs;
   std::vector<PipelineStageRegisters> pipeline_registers;
   absl::optional<StateRegister> state_register;
+  // Map from each node of the function or proc to the node it was cloned to
+  // in the block.
+  absl::flat_hash_map<Node*, Node*> cloned_nodes;
 };
 
 // For each output streaming channel add a corresponding ready port (input
@@ -683,6 +798,19 @@ static absl::Status AddBubbleFlowControl(const ResetInfo& reset_info,
   absl::string_view valid_suffix = options.streaming_channel_valid_suffix();
   absl::string_view ready_suffix = options.streaming_channel_ready_suffix();
 
+  for (int64_t stage : options.skid_buffer_stages()) {
+    if (stage < 0 || stage >= streaming_io.pipeline_registers.size()) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Skid buffer stage %d is out of range; the pipeline has %d "
+          "register stages",
+          stage, streaming_io.pipeline_registers.size()));
+    }
+  }
+  if (!options.skid_buffer_stages().empty() &&
+      !reset_info.input_port.has_value()) {
+    return absl::InvalidArgumentError("Skid buffers require a reset signal.");
+  }
+
   XLS_ASSIGN_OR_RETURN(Node * all_active_inputs_valid,
                        MakeInputValidPortsForInputChannels(
                            streaming_io.inputs, valid_suffix, block));
@@ -724,6 +852,7 @@ static absl::Status AddBubbleFlowControl(const ResetInfo& reset_info,
                            all_active_outputs_ready, reset_info,
                            absl::MakeSpan(pipelined_valids),
                            absl::MakeSpan(streaming_io.pipeline_registers),
+                           options.skid_buffer_stages(),
                            streaming_io.state_register, block));
 
   XLS_VLOG(3) << "After Bubble Flow Control (pipeline)";
@@ -918,6 +1047,7 @@ class CloneNodesIntoBlockHandler {
       }
 
       node_map_[node] = next_node;
+      result_.cloned_nodes[node] = next_node;
     }
 
     return absl::OkStatus();
@@ -1260,6 +1390,108 @@ class CloneNodesIntoBlockHandler {
   absl::flat_hash_map<Node*, Node*> node_map_;
 };
 
+// Folds the operations of the pipeline onto shared functional units as bound
+// by BindSharedOperations for a pipeline with an initiation interval greater
+// than one. A phase register counts cycles modulo the initiation interval.
+// Because inputs are accepted only when the phase is zero, the data in stage
+// `s` is processed in cycles where the phase is `s` modulo the initiation
+// interval, and the phase selects which of the unit's operations supplies
+// its operands.
+static absl::Status AddSharedFunctionalUnits(
+    const PipelineSchedule& schedule, int64_t initiation_interval,
+    const absl::flat_hash_map<Node*, Node*>& cloned_nodes,
+    const ResetInfo& reset_info, Block* block) {
+  std::vector<std::vector<Node*>> units =
+      BindSharedOperations(schedule, initiation_interval);
+  if (units.empty()) {
+    return absl::OkStatus();
+  }
+  XLS_RET_CHECK(reset_info.input_port.has_value());
+
+  // Add the phase counter which wraps to zero after initiation_interval - 1.
+  int64_t phase_width = Bits::MinBitCountUnsigned(initiation_interval - 1);
+  xls::Reset phase_reset = reset_info.behavior.value();
+  phase_reset.reset_value = Value(UBits(0, phase_width));
+  XLS_ASSIGN_OR_RETURN(
+      Register * phase_reg,
+      block->AddRegister("ii_phase", block->package()->GetBitsType(phase_width),
+                         phase_reset));
+  XLS_ASSIGN_OR_RETURN(
+      Node * phase,
+      block->MakeNode<RegisterRead>(/*loc=*/absl::nullopt, phase_reg));
+  XLS_ASSIGN_OR_RETURN(
+      Node * last_phase,
+      block->MakeNode<xls::Literal>(
+          /*loc=*/absl::nullopt,
+          Value(UBits(initiation_interval - 1, phase_width))));
+  XLS_ASSIGN_OR_RETURN(
+      Node * is_last_phase,
+      block->MakeNode<CompareOp>(/*loc=*/absl::nullopt, phase, last_phase,
+                                 Op::kEq));
+  XLS_ASSIGN_OR_RETURN(
+      Node * one,
+      block->MakeNode<xls::Literal>(/*loc=*/absl::nullopt,
+                                    Value(UBits(1, phase_width))));
+  XLS_ASSIGN_OR_RETURN(
+      Node * incremented_phase,
+      block->MakeNode<BinOp>(/*loc=*/absl::nullopt, phase, one, Op::kAdd));
+  XLS_ASSIGN_OR_RETURN(
+      Node * zero,
+      block->MakeNode<xls::Literal>(/*loc=*/absl::nullopt,
+                                    Value(UBits(0, phase_width))));
+  XLS_ASSIGN_OR_RETURN(
+      Node * next_phase,
+      block->MakeNode<Select>(
+          /*loc=*/absl::nullopt, is_last_phase,
+          std::vector<Node*>{incremented_phase, zero},
+          /*default_value=*/absl::nullopt));
+  XLS_RETURN_IF_ERROR(block
+                          ->MakeNode<RegisterWrite>(
+                              /*loc=*/absl::nullopt, next_phase,
+                              /*load_enable=*/absl::nullopt,
+                              /*reset=*/reset_info.input_port, phase_reg)
+                          .status());
+
+  for (const std::vector<Node*>& unit : units) {
+    // The block operation executing in each phase. Phases without an
+    // operation of the unit reuse the operands of the first operation.
+    std::vector<Node*> op_in_phase(initiation_interval,
+                                   cloned_nodes.at(unit.front()));
+    for (Node* node : unit) {
+      op_in_phase[schedule.cycle(node) % initiation_interval] =
+          cloned_nodes.at(node);
+    }
+    Node* first_op = cloned_nodes.at(unit.front());
+    std::vector<Node*> shared_operands;
+    for (int64_t i = 0; i < first_op->operand_count(); ++i) {
+      std::vector<Node*> cases;
+      for (Node* op : op_in_phase) {
+        cases.push_back(op->operand(i));
+      }
+      // The selector covers all cases only if the initiation interval is a
+      // power of two.
+      absl::optional<Node*> default_value;
+      if (initiation_interval < (int64_t{1} << phase_width)) {
+        default_value = cases.front();
+      }
+      XLS_ASSIGN_OR_RETURN(
+          Node * shared_operand,
+          block->MakeNodeWithName<Select>(
+              /*loc=*/absl::nullopt, phase, cases, default_value,
+              absl::StrFormat("%s_shared_operand%d", first_op->GetName(), i)));
+      shared_operands.push_back(shared_operand);
+    }
+    XLS_ASSIGN_OR_RETURN(Node * shared_op, first_op->Clone(shared_operands));
+    shared_op->SetName(absl::StrCat(first_op->GetName(), "_shared"));
+    for (Node* node : unit) {
+      Node* op = cloned_nodes.at(node);
+      XLS_RETURN_IF_ERROR(op->ReplaceUsesWith(shared_op));
+      XLS_RETURN_IF_ERROR(block->RemoveNode(op));
+    }
+  }
+  return absl::OkStatus();
+}
+
 // Adds the nodes in the given schedule to the block. Pipeline registers are
 // inserted between stages and returned as a vector indexed by cycle. The block
 // should be empty prior to calling this function.
@@ -1316,6 +1548,21 @@ absl::StatusOr<Block*> FunctionToPipelinedBlock(
   if (options.manual_control().has_value()) {
     return absl::UnimplementedError("Manual pipeline control not implemented");
   }
+  if (options.initiation_interval() < 1) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Initiation interval must be positive, got %d",
+                        options.initiation_interval()));
+  }
+  if (options.initiation_interval() > 1 && !options.reset().has_value()) {
+    return absl::InvalidArgumentError(
+        "A reset signal must be specified for a pipeline with an initiation "
+        "interval greater than one");
+  }
+  if (!options.skid_buffer_stages().empty()) {
+    return absl::InvalidArgumentError(
+        "Skid buffers are only supported for pipelines with ready/valid "
+        "channels");
+  }
 
   std::string block_name(
       options.module_name().value_or(SanitizeIdentifier(f->name())));
@@ -1342,6 +1589,12 @@ absl::StatusOr<Block*> FunctionToPipelinedBlock(
 
   XLS_ASSIGN_OR_RETURN(ResetInfo reset_info, MaybeAddResetPort(block, options));
 
+  if (options.initiation_interval() > 1) {
+    XLS_RETURN_IF_ERROR(AddSharedFunctionalUnits(
+        transformed_schedule, options.initiation_interval(),
+        streaming_io_and_pipeline.cloned_nodes, reset_info, block));
+  }
+
   absl::optional<ValidPorts> valid_ports;
   if (options.valid_control().has_value()) {
     XLS_ASSIGN_OR_RETURN(
@@ -1400,6 +1653,11 @@ absl::StatusOr<Block*> ProcToPipelinedBlock(const PipelineSchedule& schedule,
     return absl::UnimplementedError("Manual pipeline control not implemented");
   }
 
+  if (options.initiation_interval() != 1) {
+    return absl::UnimplementedError(
+        "Initiation interval other than one not supported for procs");
+  }
+
   // TODO(tedhong): 2021-09-18 Support input/output flops via skid buffers.
   if (options.flop_outputs() || options.flop_inputs()) {
     return absl::UnimplementedError(
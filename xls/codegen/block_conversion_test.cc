@@ -19,6 +19,8 @@
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/strings/str_cat.h"
 #include "xls/codegen/codegen_options.h"
 #include "xls/common/logging/log_lines.h"
@@ -446,6 +448,106 @@ TEST_F(BlockConversionTest, TrivialPipelinedFunction) {
   }
 }
 
+TEST_F(BlockConversionTest, PipelinedFunctionWithInitiationInterval) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(32));
+  BValue y = fb.Param("y", p->GetBitsType(32));
+  BValue z = fb.Param("z", p->GetBitsType(32));
+  BValue mul0 = fb.UMul(x, y);
+  BValue mul1 = fb.UMul(mul0, z);
+  BValue mul2 = fb.UMul(mul1, x);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  ScheduleCycleMap cycle_map;
+  for (Node* node : f->nodes()) {
+    cycle_map[node] = 0;
+  }
+  cycle_map[mul1.node()] = 1;
+  cycle_map[mul2.node()] = 2;
+  PipelineSchedule schedule(f, cycle_map, 3);
+
+  auto count_multiplies = [](Block* block) {
+    return absl::c_count_if(block->nodes(),
+                            [](Node* n) { return n->op() == Op::kUMul; });
+  };
+
+  {
+    // With an initiation interval of two, only the multiplies in the first
+    // two stages can share a unit.
+    XLS_ASSERT_OK_AND_ASSIGN(
+        Block * block,
+        FunctionToPipelinedBlock(schedule,
+                                 CodegenOptions()
+                                     .flop_inputs(false)
+                                     .flop_outputs(false)
+                                     .clock_name("clk")
+                                     .reset("rst", false, false, false)
+                                     .initiation_interval(2),
+                                 f));
+    EXPECT_EQ(count_multiplies(block), 2);
+    XLS_ASSERT_OK(p->RemoveBlock(block));
+  }
+
+  // With an initiation interval of three, all multiplies share a single unit.
+  // Flopping the inputs shifts the multiplies to stages 1, 2 and 3.
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Block * block,
+      FunctionToPipelinedBlock(schedule,
+                               CodegenOptions()
+                                   .flop_inputs(true)
+                                   .flop_outputs(false)
+                                   .clock_name("clk")
+                                   .reset("rst", false, false, false)
+                                   .initiation_interval(3),
+                               f));
+  EXPECT_EQ(count_multiplies(block), 1);
+
+  // Inputs are accepted in the first cycle after reset and every third cycle
+  // thereafter. Each result appears three cycles after its inputs.
+  std::vector<absl::flat_hash_map<std::string, uint64_t>> inputs;
+  inputs.push_back({{"rst", 1}, {"x", 0}, {"y", 0}, {"z", 0}});
+  std::minstd_rand engine;
+  std::vector<uint64_t> expected;
+  for (int64_t i = 0; i < 4; ++i) {
+    uint64_t xv = engine() & 0xffff;
+    uint64_t yv = engine() & 0xff;
+    uint64_t zv = engine() & 0xff;
+    expected.push_back((xv * yv * zv * xv) & 0xffffffff);
+    inputs.push_back({{"rst", 0}, {"x", xv}, {"y", yv}, {"z", zv}});
+    // The inputs are ignored in the other phases.
+    inputs.push_back({{"rst", 0}, {"x", 42}, {"y", 42}, {"z", 42}});
+    inputs.push_back({{"rst", 0}, {"x", 7}, {"y", 7}, {"z", 7}});
+  }
+  // One more cycle for the final result to emerge.
+  inputs.push_back({{"rst", 0}, {"x", 0}, {"y", 0}, {"z", 0}});
+  std::vector<absl::flat_hash_map<std::string, uint64_t>> outputs;
+  XLS_ASSERT_OK_AND_ASSIGN(outputs, InterpretSequentialBlock(block, inputs));
+  for (int64_t i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(outputs.at(1 + 3 * i + 3).at("out"), expected[i]) << i;
+  }
+}
+
+TEST_F(BlockConversionTest, InitiationIntervalRequiresReset) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(32));
+  fb.UMul(fb.UMul(x, x), x);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      PipelineSchedule schedule,
+      PipelineSchedule::Run(f, TestDelayEstimator(),
+                            SchedulingOptions().pipeline_stages(2)));
+  EXPECT_THAT(
+      FunctionToPipelinedBlock(
+          schedule,
+          CodegenOptions().clock_name("clk").initiation_interval(2), f)
+          .status(),
+      status_testing::StatusIs(absl::StatusCode::kInvalidArgument,
+                               testing::HasSubstr("reset signal")));
+}
+
 TEST_F(BlockConversionTest, ZeroWidthPipeline) {
   auto p = CreatePackage();
   FunctionBuilder fb(TestName(), p.get());
@@ -922,7 +1024,8 @@ class SimplePipelinedProcTest : public ProcConversionTestFixture {
     CodegenOptions codegen_options = options;
     codegen_options.module_name(kBlockName);
 
-    XLS_RET_CHECK_OK(ProcToPipelinedBlock(schedule, codegen_options, proc));
+    XLS_RETURN_IF_ERROR(
+        ProcToPipelinedBlock(schedule, codegen_options, proc).status());
 
     return package_ptr;
   }
@@ -1264,6 +1367,126 @@ TEST_F(SimplePipelinedProcTest, RandomStallingSweep) {
   }
 }
 
+TEST_F(SimplePipelinedProcTest, SkidBuffersRandomStalling) {
+  for (int64_t stage_count : std::vector{2, 3, 4}) {
+    for (bool all_stages : {false, true}) {
+      std::vector<int64_t> skid_stages;
+      for (int64_t stage = all_stages ? 0 : stage_count - 2;
+           stage < stage_count - 1; ++stage) {
+        skid_stages.push_back(stage);
+      }
+      CodegenOptions options;
+      options.flop_inputs(false).flop_outputs(false).clock_name("clk");
+      options.valid_control("input_valid", "output_valid");
+      options.reset("rst", false, false, false);
+      options.skid_buffer_stages(skid_stages);
+
+      XLS_ASSERT_OK_AND_ASSIGN(
+          std::unique_ptr<Package> package,
+          BuildBlockInPackage(/*stage_count=*/stage_count, options));
+      XLS_ASSERT_OK_AND_ASSIGN(Block * block, package->GetBlock(kBlockName));
+
+      XLS_VLOG(2) << "Skid buffered pipelined block";
+      XLS_VLOG_LINES(2, block->DumpIr());
+
+      // A skid buffer in the pipeline breaks the combinational path from
+      // out_rdy to in_rdy.
+      XLS_ASSERT_OK_AND_ASSIGN(Node * in_rdy, block->GetNode("in_rdy"));
+      std::vector<Node*> worklist = {in_rdy};
+      absl::flat_hash_set<Node*> visited;
+      bool out_rdy_in_fan_in = false;
+      while (!worklist.empty()) {
+        Node* node = worklist.back();
+        worklist.pop_back();
+        if (!visited.insert(node).second || node->Is<RegisterRead>()) {
+          continue;
+        }
+        out_rdy_in_fan_in |= node->GetName() == "out_rdy";
+        worklist.insert(worklist.end(), node->operands().begin(),
+                        node->operands().end());
+      }
+      EXPECT_FALSE(out_rdy_in_fan_in);
+
+      // The input stimulus to this test are
+      //  1. 10 cycles of reset
+      //  2. Randomly varying in_vld and out_rdy.
+      //  3. in_vld = 1 and out_rdy = 1 for 20 cycles to check throughput.
+      //  4. in_vld = 0 and out_rdy = 1 for 10 cycles to drain the pipeline
+      int64_t simulation_cycle_count = 5000;
+      int64_t max_random_cycle = simulation_cycle_count - 30 - 1;
+
+      std::vector<absl::flat_hash_map<std::string, uint64_t>> inputs;
+      XLS_ASSERT_OK(SetSignalsOverCycles(0, 9, {{"rst", 1}}, inputs));
+      XLS_ASSERT_OK(SetSignalsOverCycles(10, simulation_cycle_count - 1,
+                                         {{"rst", 0}}, inputs));
+      XLS_ASSERT_OK(SetIncrementingSignalOverCycles(
+          0, simulation_cycle_count - 1, "in", 1, inputs));
+
+      std::minstd_rand rng_engine;
+      XLS_ASSERT_OK(SetRandomSignalOverCycles(0, max_random_cycle, "in_vld", 0,
+                                              1, rng_engine, inputs));
+      XLS_ASSERT_OK(SetRandomSignalOverCycles(0, max_random_cycle, "out_rdy",
+                                              0, 1, rng_engine, inputs));
+      XLS_ASSERT_OK(SetSignalsOverCycles(max_random_cycle + 1,
+                                         max_random_cycle + 20,
+                                         {{"in_vld", 1}, {"out_rdy", 1}},
+                                         inputs));
+      XLS_ASSERT_OK(SetSignalsOverCycles(max_random_cycle + 21,
+                                         simulation_cycle_count - 1,
+                                         {{"in_vld", 0}, {"out_rdy", 1}},
+                                         inputs));
+
+      std::vector<absl::flat_hash_map<std::string, uint64_t>> outputs;
+      XLS_ASSERT_OK_AND_ASSIGN(outputs,
+                               InterpretSequentialBlock(block, inputs));
+
+      // Once the skid buffers have drained the pipeline accepts and produces
+      // a value every cycle.
+      for (int64_t i = max_random_cycle + 11; i <= max_random_cycle + 20;
+           ++i) {
+        EXPECT_EQ(outputs.at(i).at("in_rdy"), 1) << "cycle " << i;
+        EXPECT_EQ(outputs.at(i).at("out_vld"), 1) << "cycle " << i;
+      }
+
+      XLS_ASSERT_OK_AND_ASSIGN(
+          std::vector<CycleAndValue> input_sequence,
+          GetChannelSequenceFromIO(
+              {"in", SignalType::kInput}, {"in_vld", SignalType::kInput},
+              {"in_rdy", SignalType::kOutput}, {"rst", SignalType::kInput},
+              inputs, outputs));
+      XLS_ASSERT_OK_AND_ASSIGN(
+          std::vector<CycleAndValue> output_sequence,
+          GetChannelSequenceFromIO(
+              {"out", SignalType::kOutput}, {"out_vld", SignalType::kOutput},
+              {"out_rdy", SignalType::kInput}, {"rst", SignalType::kInput},
+              inputs, outputs));
+
+      std::vector<uint64_t> input_value_sequence;
+      for (const CycleAndValue& cv : input_sequence) {
+        input_value_sequence.push_back(cv.value);
+      }
+      std::vector<uint64_t> output_value_sequence;
+      for (const CycleAndValue& cv : output_sequence) {
+        output_value_sequence.push_back(cv.value);
+      }
+      EXPECT_FALSE(input_value_sequence.empty());
+      EXPECT_EQ(input_value_sequence, output_value_sequence);
+    }
+  }
+}
+
+TEST_F(SimplePipelinedProcTest, SkidBufferStageOutOfRange) {
+  CodegenOptions options;
+  options.flop_inputs(false).flop_outputs(false).clock_name("clk");
+  options.valid_control("input_valid", "output_valid");
+  options.reset("rst", false, false, false);
+  options.skid_buffer_stages({3});
+
+  EXPECT_THAT(BuildBlockInPackage(/*stage_count=*/3, options).status(),
+              status_testing::StatusIs(absl::StatusCode::kInvalidArgument,
+                                       testing::HasSubstr("out of range")));
+}
+
 // Fixture used to test pipelined BlockConversion on a simple
 // block with a running counter
 class SimpleRunningCounterProcTest
@@ -15,6 +15,7 @@
 #include "xls/codegen/block_generator.h"
 
 #include <deque>
+#include <sstream>
 
 #include "absl/status/status.h"
 #include "xls/codegen/block_conversion.h"
@@ -527,17 +528,36 @@ class BlockGenerator {
 
   // Adds an always_ff (or Verilog equivalent) and use it to assign the next
   // cycle value for each of the given registers. Registers must have been
-  // declared previously with DeclareRegisters.
+  // declared previously with DeclareRegisters. If a clock gate format is
+  // specified, registers with a load enable (and no synchronous reset) are
+  // assigned in a separate always block for each load enable which is clocked
+  // by a gated clock.
   absl::Status AssignRegisters(absl::Span<Register* const> registers) {
     // Group registers with/without reset signal and call
     // ModuleBuilder::AssignRegisters for each.
     std::vector<ModuleBuilder::Register> registers_with_reset;
     std::vector<ModuleBuilder::Register> registers_without_reset;
+    // Clock-gated registers grouped by load enable, in order of first
+    // appearance.
+    std::vector<Node*> load_enables;
+    absl::flat_hash_map<Node*, std::vector<ModuleBuilder::Register>>
+        gated_registers;
     for (Register* reg : registers) {
       XLS_RET_CHECK(mb_registers_.contains(reg)) << absl::StreamFormat(
           "Register `%s` was not previously declared", reg->name());
       ModuleBuilder::Register mb_reg = mb_registers_.at(reg);
-      if (reg->reset().has_value()) {
+      if (options_.clock_gate_format().has_value() &&
+          mb_reg.load_enable != nullptr &&
+          (!reg->reset().has_value() || reg->reset()->asynchronous)) {
+        XLS_ASSIGN_OR_RETURN(RegisterWrite * reg_write,
+                             block_->GetRegisterWrite(reg));
+        Node* load_enable = reg_write->load_enable().value();
+        if (!gated_registers.contains(load_enable)) {
+          load_enables.push_back(load_enable);
+        }
+        mb_reg.load_enable = nullptr;
+        gated_registers[load_enable].push_back(mb_reg);
+      } else if (reg->reset().has_value()) {
         registers_with_reset.push_back(mb_reg);
       } else {
         registers_without_reset.push_back(mb_reg);
@@ -549,9 +569,43 @@ class BlockGenerator {
     if (!registers_with_reset.empty()) {
       XLS_RETURN_IF_ERROR(mb_.AssignRegisters(registers_with_reset));
     }
+    for (Node* load_enable : load_enables) {
+      XLS_ASSIGN_OR_RETURN(LogicRef * gated_clk, GetGatedClock(load_enable));
+      std::vector<ModuleBuilder::Register> with_reset;
+      std::vector<ModuleBuilder::Register> without_reset;
+      for (const ModuleBuilder::Register& mb_reg :
+           gated_registers.at(load_enable)) {
+        (mb_reg.reset_value == nullptr ? without_reset : with_reset)
+            .push_back(mb_reg);
+      }
+      if (!without_reset.empty()) {
+        XLS_RETURN_IF_ERROR(mb_.AssignRegisters(without_reset, gated_clk));
+      }
+      if (!with_reset.empty()) {
+        XLS_RETURN_IF_ERROR(mb_.AssignRegisters(with_reset, gated_clk));
+      }
+    }
     return absl::OkStatus();
   }
 
+  // Returns the gated clock for the given load enable signal, instantiating a
+  // clock-gating cell the first time the load enable is seen.
+  absl::StatusOr<LogicRef*> GetGatedClock(Node* load_enable) {
+    auto it = gated_clocks_.find(load_enable);
+    if (it != gated_clocks_.end()) {
+      return it->second;
+    }
+    XLS_RET_CHECK(
+        absl::holds_alternative<Expression*>(node_exprs_.at(load_enable)));
+    XLS_ASSIGN_OR_RETURN(
+        LogicRef * gated_clk,
+        mb_.EmitClockGate(absl::StrCat(load_enable->GetName(), "_gated_clk"),
+                          absl::get<Expression*>(node_exprs_.at(load_enable)),
+                          options_.clock_gate_format().value()));
+    gated_clocks_[load_enable] = gated_clk;
+    return gated_clk;
+  }
+
   absl::Status EmitOutputPorts() {
     // Iterate through GetPorts and pick out the output ports because GetPorts
     // contains the desired port ordering.
@@ -670,6 +724,9 @@ class BlockGenerator {
   // Map from xls::Register* to the ModuleBuilder register abstraction
   // representing the underlying Verilog register.
   absl::flat_hash_map<xls::Register*, ModuleBuilder::Register> mb_registers_;
+
+  // Gated clocks created for clock-gated registers, indexed by load enable.
+  absl::flat_hash_map<Node*, LogicRef*> gated_clocks_;
 };
 
 // Recursive visitor of blocks in a DFS order. Edges are block instantiations.
@@ -707,8 +764,8 @@ absl::StatusOr<std::vector<Block*>> GatherInstantiatedBlocks(Block* top) {
 
 }  // namespace
 
-absl::StatusOr<std::string> GenerateVerilog(Block* top,
-                                            const CodegenOptions& options) {
+absl::Status GenerateVerilog(Block* top, const CodegenOptions& options,
+                             std::ostream* out) {
   XLS_VLOG(2) << absl::StreamFormat(
       "Generating Verilog for packge with with top level block `%s`:",
       top->name());
@@ -724,7 +781,19 @@ absl::StatusOr<std::string> GenerateVerilog(Block* top,
       file.Add(file.Make<BlankLine>());
     }
   }
-  std::string text = file.Emit();
+  LineWriter writer(out);
+  file.EmitTo(&writer);
+  if (!out->good()) {
+    return absl::InternalError("Error writing Verilog output stream.");
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::string> GenerateVerilog(Block* top,
+                                            const CodegenOptions& options) {
+  std::ostringstream out;
+  XLS_RETURN_IF_ERROR(GenerateVerilog(top, options, &out));
+  std::string text = out.str();
   XLS_VLOG(2) << "Verilog output:";
   XLS_VLOG_LINES(2, text);
 
@@ -15,6 +15,10 @@
 #ifndef XLS_CODEGEN_BLOCK_GENERATOR_H_
 #define XLS_CODEGEN_BLOCK_GENERATOR_H_
 
+#include <ostream>
+#include <string>
+
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "xls/codegen/codegen_options.h"
 #include "xls/ir/block.h"
@@ -28,6 +32,12 @@ namespace verilog {
 absl::StatusOr<std::string> GenerateVerilog(Block* top,
                                             const CodegenOptions& options);
 
+// As above but streams the text to the given output stream rather than
+// returning it. The text is written incrementally as the VAST is traversed
+// rather than being assembled in intermediate strings.
+absl::Status GenerateVerilog(Block* top, const CodegenOptions& options,
+                             std::ostream* out);
+
 }  // namespace verilog
 }  // namespace xls
 
@@ -541,6 +541,61 @@ TEST_P(BlockGeneratorTest, GatedBitsType) {
   }
 }
 
+TEST_P(BlockGeneratorTest, ClockGatedRegisters) {
+  Package package(TestBaseName());
+  Type* u32 = package.GetBitsType(32);
+  BlockBuilder bb(TestBaseName(), &package);
+  BValue a = bb.InputPort("a", u32);
+  BValue b = bb.InputPort("b", u32);
+  BValue en = bb.InputPort("en", package.GetBitsType(1));
+  BValue rst = bb.InputPort("rst", package.GetBitsType(1));
+  BValue p0_a = bb.InsertRegister("p0_a", a, /*load_enable=*/en);
+  BValue p0_b = bb.InsertRegister("p0_b", b, /*load_enable=*/en);
+  BValue p1_sum = bb.InsertRegister(
+      "p1_sum", bb.Add(p0_a, p0_b), rst,
+      xls::Reset{.reset_value = Value(UBits(0, 32)),
+                 .asynchronous = false,
+                 .active_low = false},
+      /*load_enable=*/en);
+  bb.OutputPort("sum", p1_sum);
+  XLS_ASSERT_OK(bb.block()->AddClockPort("clk"));
+  XLS_ASSERT_OK_AND_ASSIGN(Block * block, bb.Build());
+
+  {
+    // No clock gate format.
+    XLS_ASSERT_OK_AND_ASSIGN(std::string verilog,
+                             GenerateVerilog(block, codegen_options()));
+    EXPECT_THAT(verilog, Not(HasSubstr("en_gated_clk")));
+  }
+
+  {
+    XLS_ASSERT_OK_AND_ASSIGN(
+        std::string verilog,
+        GenerateVerilog(block,
+                        codegen_options().clock_gate_format(
+                            "my_icg {gated_clk}_icg(.clk_in({clk}), "
+                            ".en({enable}), .clk_out({gated_clk}))")));
+    // A single clock-gating cell is shared by the registers with the same
+    // load enable.
+    EXPECT_THAT(
+        verilog,
+        HasSubstr(
+            "my_icg en_gated_clk_icg(.clk_in(clk), .en(en), "
+            ".clk_out(en_gated_clk));"));
+    EXPECT_THAT(verilog, HasSubstr("@ (posedge en_gated_clk)"));
+    EXPECT_THAT(verilog, HasSubstr("p0_a <= a;"));
+    EXPECT_THAT(verilog, HasSubstr("p0_b <= b;"));
+    // Registers with a synchronous reset keep the load enable mux on the
+    // ungated clock.
+    EXPECT_THAT(verilog, HasSubstr("p1_sum <= en ? "));
+  }
+
+  EXPECT_THAT(GenerateVerilog(block, codegen_options().clock_gate_format(
+                                         "my_icg {gated_clk}({clock})")),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Invalid placeholder {clock}")));
+}
+
 TEST_P(BlockGeneratorTest, GatedSingleBitType) {
   Package package(TestBaseName());
   BlockBuilder b(TestBaseName(), &package);
@@ -100,6 +100,17 @@ CodegenOptions& CodegenOptions::split_outputs(bool value) {
   return *this;
 }
 
+CodegenOptions& CodegenOptions::initiation_interval(int64_t value) {
+  initiation_interval_ = value;
+  return *this;
+}
+
+CodegenOptions& CodegenOptions::skid_buffer_stages(
+    absl::Span<const int64_t> stages) {
+  skid_buffer_stages_ = std::vector<int64_t>(stages.begin(), stages.end());
+  return *this;
+}
+
 CodegenOptions& CodegenOptions::assert_format(absl::string_view value) {
   assert_format_ = std::string{value};
   return *this;
@@ -110,6 +121,11 @@ CodegenOptions& CodegenOptions::gate_format(absl::string_view value) {
   return *this;
 }
 
+CodegenOptions& CodegenOptions::clock_gate_format(absl::string_view value) {
+  clock_gate_format_ = std::string{value};
+  return *this;
+}
+
 CodegenOptions& CodegenOptions::emit_as_pipeline(bool value) {
   emit_as_pipeline_ = value;
   return *this;
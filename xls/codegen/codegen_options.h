@@ -15,8 +15,11 @@
 #ifndef XLS_CODEGEN_CODEGEN_OPTIONS_H_
 #define XLS_CODEGEN_CODEGEN_OPTIONS_H_
 
+#include <vector>
+
 #include "absl/strings/string_view.h"
 #include "absl/types/optional.h"
+#include "absl/types/span.h"
 #include "xls/codegen/module_signature.pb.h"
 #include "xls/scheduling/pipeline_schedule.h"
 
@@ -82,6 +85,27 @@ struct CodegenOptions {
   CodegenOptions& split_outputs(bool value);
   bool split_outputs() const { return split_outputs_; }
 
+  // The initiation interval of a pipelined block: the number of cycles
+  // between successive inputs. If greater than one, operations in stages
+  // which are distinct modulo the initiation interval share functional units
+  // and a reset signal is required to initialize the phase counter which
+  // controls the sharing. Inputs are accepted in the first cycle after reset
+  // and every initiation-interval cycles thereafter.
+  CodegenOptions& initiation_interval(int64_t value);
+  int64_t initiation_interval() const { return initiation_interval_; }
+
+  // The pipeline stages of a proc with ready/valid channels whose output
+  // registers are followed by a skid buffer. A skid buffer holds one extra
+  // entry so the ready signal into the stage is driven by a register rather
+  // than combinationally by the ready signal of the following stage. This
+  // breaks the ready path which otherwise runs through every stage of the
+  // pipeline, at the cost of a second copy of the stage's registers. Stage
+  // `i` refers to the registers between stage `i` and stage `i + 1`.
+  CodegenOptions& skid_buffer_stages(absl::Span<const int64_t> stages);
+  absl::Span<const int64_t> skid_buffer_stages() const {
+    return skid_buffer_stages_;
+  }
+
   // Format string to use when emitting assert operations in Verilog. Supports
   // the following placeholders:
   //
@@ -141,6 +165,32 @@ struct CodegenOptions {
   CodegenOptions& gate_format(absl::string_view value);
   absl::optional<absl::string_view> gate_format() const { return gate_format_; }
 
+  // Format string used to instantiate a clock-gating cell. If specified,
+  // registers with a load enable are clocked by a gated clock rather than
+  // feeding back their current value through a multiplexer. One cell is
+  // instantiated for each distinct load enable signal. Registers with a
+  // synchronous reset are not clock gated because the reset must take effect
+  // regardless of the load enable. Supports the following placeholders:
+  //
+  //  {clk}       : Name of the clock signal.
+  //  {enable}    : Identifier (or expression) of the load enable signal.
+  //  {gated_clk} : Identifier of the gated clock. The cell must drive this
+  //                (previously declared) wire.
+  //
+  // For example, the format string:
+  //
+  //    'my_icg {gated_clk}_cell (.CK({clk}), .EN({enable}), .GCK({gated_clk}))'
+  //
+  // Might result in the following in the emitted Verilog:
+  //
+  //    wire p0_load_en_gated_clk;
+  //    my_icg p0_load_en_gated_clk_cell (.CK(clk), .EN(p0_load_en),
+  //      .GCK(p0_load_en_gated_clk));
+  CodegenOptions& clock_gate_format(absl::string_view value);
+  absl::optional<absl::string_view> clock_gate_format() const {
+    return clock_gate_format_;
+  }
+
   // Emit the signal declarations and logic in the Verilog as a sequence of
   // pipeline stages separated by per-stage comment headers. The option does not
   // functionally change the generated Verilog but rather affects its layout.
@@ -186,8 +236,11 @@ struct CodegenOptions {
   bool flop_inputs_ = false;
   bool flop_outputs_ = false;
   bool split_outputs_ = false;
+  int64_t initiation_interval_ = 1;
+  std::vector<int64_t> skid_buffer_stages_;
   absl::optional<std::string> assert_format_;
   absl::optional<std::string> gate_format_;
+  absl::optional<std::string> clock_gate_format_;
   bool emit_as_pipeline_ = false;
   std::string streaming_channel_data_suffix_ = "";
   std::string streaming_channel_ready_suffix_ = "_rdy";
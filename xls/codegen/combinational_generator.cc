@@ -62,8 +62,9 @@ absl::StatusOr<ModuleGeneratorResult> GenerateCombinationalModule(
   return GenerateCombinationalModule(func, codegen_options);
 }
 
-absl::StatusOr<ModuleGeneratorResult> GenerateCombinationalModule(
-    FunctionBase* module, const CodegenOptions& options) {
+absl::StatusOr<ModuleGeneratorResult> GenerateCombinationalBlock(
+    FunctionBase* module, const CodegenOptions& options,
+    PassResults* results) {
   std::string module_name(
       options.module_name().value_or(SanitizeIdentifier(module->name())));
 
@@ -85,14 +86,25 @@ absl::StatusOr<ModuleGeneratorResult> GenerateCombinationalModule(
   CodegenPassOptions codegen_pass_options;
   codegen_pass_options.codegen_options = options;
 
-  PassResults results;
-  XLS_RETURN_IF_ERROR(CreateCodegenPassPipeline()
-                          ->Run(&unit, codegen_pass_options, &results)
-                          .status());
+  PassResults local_results;
+  XLS_RETURN_IF_ERROR(
+      CreateCodegenPassPipeline()
+          ->Run(&unit, codegen_pass_options,
+                results == nullptr ? &local_results : results)
+          .status());
   XLS_RET_CHECK(unit.signature.has_value());
-  XLS_ASSIGN_OR_RETURN(std::string verilog, GenerateVerilog(block, options));
+  return ModuleGeneratorResult{/*verilog_text=*/"", unit.signature.value(),
+                               block};
+}
 
-  return ModuleGeneratorResult{verilog, unit.signature.value()};
+absl::StatusOr<ModuleGeneratorResult> GenerateCombinationalModule(
+    FunctionBase* module, const CodegenOptions& options,
+    PassResults* results) {
+  XLS_ASSIGN_OR_RETURN(ModuleGeneratorResult result,
+                       GenerateCombinationalBlock(module, options, results));
+  XLS_ASSIGN_OR_RETURN(result.verilog_text,
+                       GenerateVerilog(result.block, options));
+  return result;
 }
 
 }  // namespace verilog
@@ -25,6 +25,7 @@
 #include "xls/codegen/vast.h"
 #include "xls/ir/function.h"
 #include "xls/ir/proc.h"
+#include "xls/passes/pass_base.h"
 
 namespace xls {
 namespace verilog {
@@ -40,9 +41,18 @@ absl::StatusOr<ModuleGeneratorResult> GenerateCombinationalModule(
 // Emits the given function or proc as a combinational Verilog module.
 //
 // If given a proc, the proc must be able to be represented as a purely
-// combinational block.
+// combinational block. If 'results' is given, the invocations of the codegen
+// passes are recorded in it.
 absl::StatusOr<ModuleGeneratorResult> GenerateCombinationalModule(
-    FunctionBase* module, const CodegenOptions& options);
+    FunctionBase* module, const CodegenOptions& options,
+    PassResults* results = nullptr);
+
+// As above but does not emit Verilog: the result holds the block and its
+// signature, and its verilog_text is empty. The block may be emitted with
+// GenerateVerilog using `options` (e.g., to stream large designs to a file).
+absl::StatusOr<ModuleGeneratorResult> GenerateCombinationalBlock(
+    FunctionBase* module, const CodegenOptions& options,
+    PassResults* results = nullptr);
 
 }  // namespace verilog
 }  // namespace xls
@@ -1070,7 +1070,7 @@ absl::StatusOr<ModuleBuilder::Register> ModuleBuilder::DeclareRegister(
 }
 
 absl::Status ModuleBuilder::AssignRegisters(
-    absl::Span<const Register> registers) {
+    absl::Span<const Register> registers, LogicRef* clock) {
   XLS_RET_CHECK(clk_ != nullptr);
 
   if (registers.empty()) {
@@ -1108,7 +1108,8 @@ absl::Status ModuleBuilder::AssignRegisters(
 
   // Construct an always_ff block.
   std::vector<SensitivityListElement> sensitivity_list;
-  sensitivity_list.push_back(file_->Make<PosEdge>(clk_));
+  sensitivity_list.push_back(
+      file_->Make<PosEdge>(clock == nullptr ? clk_ : clock));
   if (rst_.has_value()) {
     if (rst_->asynchronous) {
       if (rst_->active_low) {
@@ -1169,6 +1170,21 @@ absl::Status ModuleBuilder::AssignRegisters(
   return absl::OkStatus();
 }
 
+absl::StatusOr<LogicRef*> ModuleBuilder::EmitClockGate(
+    absl::string_view name, Expression* enable, absl::string_view fmt_string) {
+  XLS_RET_CHECK(clk_ != nullptr);
+  LogicRef* gated_clk = DeclareVariable(name, /*bit_count=*/1);
+  absl::flat_hash_map<std::string, std::string> placeholders;
+  placeholders["clk"] = clk_->GetName();
+  placeholders["enable"] = enable->Emit();
+  placeholders["gated_clk"] = gated_clk->GetName();
+  XLS_ASSIGN_OR_RETURN(std::string clock_gate_str,
+                       GenerateFormatString(fmt_string, placeholders,
+                                            /*unsupported_placeholders=*/{}));
+  assignment_section()->Add<InlineVerilogStatement>(clock_gate_str + ";");
+  return gated_clk;
+}
+
 bool ModuleBuilder::MustEmitAsFunction(Node* node) {
   switch (node->op()) {
     case Op::kSMul:
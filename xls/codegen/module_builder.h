@@ -172,8 +172,19 @@ class ModuleBuilder {
                                            int64_t bit_count, Expression* next,
                                            Expression* reset_value = nullptr);
 
-  // Construct an always block to assign values to the registers.
-  absl::Status AssignRegisters(absl::Span<const Register> registers);
+  // Construct an always block to assign values to the registers. If `clock` is
+  // given the registers are clocked by it (e.g., a gated clock) rather than by
+  // the module clock.
+  absl::Status AssignRegisters(absl::Span<const Register> registers,
+                               LogicRef* clock = nullptr);
+
+  // Declares a single-bit wire with the given name and drives it with a
+  // clock-gating cell generated from 'fmt_string' which gates the module clock
+  // with 'enable'. Returns a reference to the gated clock. Format string
+  // details described in codegen_options.h.
+  absl::StatusOr<LogicRef*> EmitClockGate(absl::string_view name,
+                                          Expression* enable,
+                                          absl::string_view fmt_string);
 
   // For organization (not functionality) the module is divided into several
   // sections. The emitted module has the following structure:
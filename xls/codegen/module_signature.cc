@@ -95,6 +95,17 @@ ModuleSignatureBuilder& ModuleSignatureBuilder::WithPipelineInterface(
   return *this;
 }
 
+ModuleSignatureBuilder& ModuleSignatureBuilder::WithSkidBufferStages(
+    absl::Span<const int64_t> stages) {
+  XLS_CHECK(proto_.has_pipeline());
+  PipelineInterface* interface = proto_.mutable_pipeline();
+  interface->clear_skid_buffer_stages();
+  for (int64_t stage : stages) {
+    interface->add_skid_buffer_stages(stage);
+  }
+  return *this;
+}
+
 ModuleSignatureBuilder& ModuleSignatureBuilder::WithFunctionType(
     FunctionType* function_type) {
   XLS_CHECK(!proto_.has_function_type());
@@ -132,6 +143,16 @@ absl::StatusOr<ModuleSignature> ModuleSignatureBuilder::Build() {
       !proto.has_clock_name()) {
     return absl::InvalidArgumentError("Missing clock signal");
   }
+  if (proto.has_pipeline()) {
+    for (int64_t stage : proto.pipeline().skid_buffer_stages()) {
+      if (stage < 0 || stage >= proto.pipeline().latency()) {
+        return absl::InvalidArgumentError(absl::StrFormat(
+            "Skid buffer stage %d is out of range for a pipeline of "
+            "latency %d",
+            stage, proto.pipeline().latency()));
+      }
+    }
+  }
 
   ModuleSignature signature;
   signature.proto_ = proto;
@@ -20,9 +20,11 @@
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/statusor.h"
 #include "absl/types/optional.h"
+#include "absl/types/span.h"
 #include "xls/codegen/module_signature.pb.h"
 #include "xls/codegen/vast.h"
 #include "xls/common/proto_adaptor_utils.h"
+#include "xls/ir/block.h"
 #include "xls/ir/type.h"
 #include "xls/ir/value.h"
 
@@ -61,6 +63,11 @@ class ModuleSignatureBuilder {
       int64_t latency, int64_t initiation_interval,
       absl::optional<PipelineControl> pipeline_control = absl::nullopt);
 
+  // Sets the pipeline stages which are followed by a skid buffer. The module
+  // interface must have been previously defined as pipelined.
+  ModuleSignatureBuilder& WithSkidBufferStages(
+      absl::Span<const int64_t> stages);
+
   // Defines the module interface as purely combinational.
   ModuleSignatureBuilder& WithCombinationalInterface();
 
@@ -141,6 +148,9 @@ class ModuleSignature {
 struct ModuleGeneratorResult {
   std::string verilog_text;
   ModuleSignature signature;
+  // The block from which the Verilog is generated. Owned by the package of the
+  // function or proc given to the generator.
+  Block* block = nullptr;
 };
 
 std::ostream& operator<<(std::ostream& os, const ModuleSignature& signature);
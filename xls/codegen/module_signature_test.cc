@@ -25,6 +25,7 @@ namespace verilog {
 namespace {
 
 using status_testing::StatusIs;
+using ::testing::ElementsAre;
 using ::testing::HasSubstr;
 
 std::string TestName() {
@@ -98,6 +99,27 @@ TEST(ModuleSignatureTest, PipelineInterface) {
   EXPECT_EQ(signature.proto().pipeline().initiation_interval(), 3);
 }
 
+TEST(ModuleSignatureTest, PipelineInterfaceWithSkidBuffers) {
+  ModuleSignatureBuilder b(TestName());
+
+  b.WithPipelineInterface(/*latency=*/3, /*initiation_interval=*/1)
+      .WithSkidBufferStages({0, 2})
+      .WithClock("clk")
+      .AddDataInput("in", 4)
+      .AddDataOutput("out", 5);
+
+  XLS_ASSERT_OK_AND_ASSIGN(ModuleSignature signature, b.Build());
+  EXPECT_THAT(signature.proto().pipeline().skid_buffer_stages(),
+              ElementsAre(0, 2));
+
+  ModuleSignatureBuilder bad(TestName());
+  bad.WithPipelineInterface(/*latency=*/3, /*initiation_interval=*/1)
+      .WithSkidBufferStages({3})
+      .WithClock("clk");
+  EXPECT_THAT(bad.Build(), StatusIs(absl::StatusCode::kInvalidArgument,
+                                    HasSubstr("out of range")));
+}
+
 TEST(ModuleSignatureTest, PipelineInterfaceMissingClock) {
   ModuleSignatureBuilder b(TestName());
 
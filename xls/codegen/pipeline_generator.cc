@@ -38,9 +38,10 @@ absl::StatusOr<ModuleGeneratorResult> ToPipelineModuleText(
                               options);
 }
 
-absl::StatusOr<ModuleGeneratorResult> ToPipelineModuleText(
+absl::StatusOr<ModuleGeneratorResult> ToPipelineModuleBlock(
     const PipelineSchedule& schedule, FunctionBase* module,
-    const CodegenOptions& options) {
+    const CodegenOptions& options, CodegenOptions* emit_options,
+    PassResults* results) {
   XLS_VLOG(2) << "Generating pipelined module for module:";
   XLS_VLOG_LINES(2, module->DumpIr());
   XLS_VLOG_LINES(2, schedule.ToString());
@@ -57,6 +58,13 @@ absl::StatusOr<ModuleGeneratorResult> ToPipelineModuleText(
     Function* func = module->AsFunctionOrDie();
     XLS_ASSIGN_OR_RETURN(block,
                          FunctionToPipelinedBlock(schedule, options, func));
+
+    // The phase counter of a pipeline with an initiation interval greater
+    // than one is a register backedge which the pretty-printer can not layer
+    // into stages.
+    if (options.initiation_interval() > 1) {
+      pass_options.codegen_options.emit_as_pipeline(false);
+    }
   } else {
     Proc* proc = module->AsProcOrDie();
     XLS_ASSIGN_OR_RETURN(block, ProcToPipelinedBlock(schedule, options, proc));
@@ -68,14 +76,28 @@ absl::StatusOr<ModuleGeneratorResult> ToPipelineModuleText(
   }
 
   CodegenPassUnit unit(module->package(), block);
-  PassResults results;
-  XLS_RETURN_IF_ERROR(
-      CreateCodegenPassPipeline()->Run(&unit, pass_options, &results).status());
+  PassResults local_results;
+  XLS_RETURN_IF_ERROR(CreateCodegenPassPipeline()
+                          ->Run(&unit, pass_options,
+                                results == nullptr ? &local_results : results)
+                          .status());
   XLS_RET_CHECK(unit.signature.has_value());
-  XLS_ASSIGN_OR_RETURN(std::string verilog,
-                       GenerateVerilog(block, pass_options.codegen_options));
+  *emit_options = pass_options.codegen_options;
+  return ModuleGeneratorResult{/*verilog_text=*/"", unit.signature.value(),
+                               block};
+}
 
-  return ModuleGeneratorResult{verilog, unit.signature.value()};
+absl::StatusOr<ModuleGeneratorResult> ToPipelineModuleText(
+    const PipelineSchedule& schedule, FunctionBase* module,
+    const CodegenOptions& options, PassResults* results) {
+  CodegenOptions emit_options;
+  XLS_ASSIGN_OR_RETURN(
+      ModuleGeneratorResult result,
+      ToPipelineModuleBlock(schedule, module, options, &emit_options,
+                            results));
+  XLS_ASSIGN_OR_RETURN(result.verilog_text,
+                       GenerateVerilog(result.block, emit_options));
+  return result;
 }
 
 }  // namespace verilog
@@ -25,6 +25,7 @@
 #include "xls/codegen/name_to_bit_count.h"
 #include "xls/codegen/vast.h"
 #include "xls/ir/function.h"
+#include "xls/passes/pass_base.h"
 #include "xls/scheduling/pipeline_schedule.h"
 
 namespace xls {
@@ -48,10 +49,21 @@ absl::StatusOr<ModuleGeneratorResult> ToPipelineModuleText(
 
 // Emits the given function or proc as a verilog module which follows the given
 // schedule. The module is pipelined with a latency and initiation interval
-// given in the signature.
+// given in the signature. If 'results' is given, the invocations of the codegen
+// passes are recorded in it.
 absl::StatusOr<ModuleGeneratorResult> ToPipelineModuleText(
     const PipelineSchedule& schedule, FunctionBase* module,
-    const CodegenOptions& options = BuildPipelineOptions());
+    const CodegenOptions& options = BuildPipelineOptions(),
+    PassResults* results = nullptr);
+
+// As above but does not emit Verilog: the result holds the block and its
+// signature, and its verilog_text is empty. `emit_options` is set to the
+// options with which GenerateVerilog should emit the block (e.g., to stream
+// large designs to a file).
+absl::StatusOr<ModuleGeneratorResult> ToPipelineModuleBlock(
+    const PipelineSchedule& schedule, FunctionBase* module,
+    const CodegenOptions& options, CodegenOptions* emit_options,
+    PassResults* results = nullptr);
 
 }  // namespace verilog
 }  // namespace xls
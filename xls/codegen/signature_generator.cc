@@ -116,10 +116,11 @@ absl::StatusOr<ModuleSignature> GenerateSignature(
       pipeline_control = PipelineControl();
       *(pipeline_control->mutable_valid()) = options.valid_control().value();
     }
-    // We assume initiation-interval of one because that is all we generate at
-    // the moment.
-    b.WithPipelineInterface(register_levels, /*initiation_interval=*/1,
+    b.WithPipelineInterface(register_levels, options.initiation_interval(),
                             pipeline_control);
+    if (!options.skid_buffer_stages().empty()) {
+      b.WithSkidBufferStages(options.skid_buffer_stages());
+    }
   }
 
   return b.Build();
@@ -14,6 +14,8 @@
 
 #include "xls/codegen/vast.h"
 
+#include <sstream>
+
 #include "absl/flags/flag.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/ascii.h"
@@ -22,7 +24,6 @@
 #include "absl/strings/str_join.h"
 #include "absl/strings/str_replace.h"
 #include "absl/strings/strip.h"
-#include "xls/common/indent.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/common/visitor.h"
@@ -117,21 +118,45 @@ DataType* VerilogFile::UnpackedArrayType(int64_t element_bit_count,
       /*unpacked_dims=*/dim_exprs, is_signed);
 }
 
+void LineWriter::Write(absl::string_view text) {
+  while (!text.empty()) {
+    size_t newline = text.find('\n');
+    absl::string_view line = text.substr(0, newline);
+    if (!line.empty()) {
+      if (at_line_start_) {
+        *out_ << std::string(2 * indent_level_, ' ');
+        at_line_start_ = false;
+      }
+      *out_ << line;
+    }
+    if (newline == absl::string_view::npos) {
+      return;
+    }
+    *out_ << '\n';
+    at_line_start_ = true;
+    text.remove_prefix(newline + 1);
+  }
+}
+
+std::string VastNode::EmitViaWriter() const {
+  std::ostringstream out;
+  LineWriter writer(&out);
+  EmitTo(&writer);
+  return out.str();
+}
+
 std::string VerilogFile::Emit() const {
-  auto file_member_str = [](const FileMember& member) -> std::string {
-    return absl::visit(
-        Visitor{[](Include* m) -> std::string { return m->Emit(); },
-                [](Module* m) -> std::string { return m->Emit(); },
-                [](BlankLine* m) -> std::string { return m->Emit(); },
-                [](Comment* m) -> std::string { return m->Emit(); }},
-        member);
-  };
+  std::ostringstream out;
+  LineWriter writer(&out);
+  EmitTo(&writer);
+  return out.str();
+}
 
-  std::string out;
+void VerilogFile::EmitTo(LineWriter* writer) const {
   for (const FileMember& member : members_) {
-    absl::StrAppend(&out, file_member_str(member), "\n");
+    absl::visit([&](auto* m) { m->EmitTo(writer); }, member);
+    writer->Write("\n");
   }
-  return out;
 }
 
 LocalParamItemRef* LocalParam::AddItem(absl::string_view name,
@@ -152,19 +177,25 @@ std::string CaseArm::Emit() const {
       label_);
 }
 
-std::string StatementBlock::Emit() const {
+std::string StatementBlock::Emit() const { return EmitViaWriter(); }
+
+void StatementBlock::EmitTo(LineWriter* writer) const {
   // TODO(meheff): We can probably be smarter about optionally emitting the
   // begin/end.
   if (statements_.empty()) {
-    return "begin end";
-  }
-  std::string result = "begin\n";
-  std::vector<std::string> lines;
-  for (const auto& statement : statements_) {
-    lines.push_back(statement->Emit());
+    writer->Write("begin end");
+    return;
+  }
+  writer->Write("begin\n");
+  writer->IncreaseIndent();
+  for (int64_t i = 0; i < statements_.size(); ++i) {
+    if (i != 0) {
+      writer->Write("\n");
+    }
+    statements_[i]->EmitTo(writer);
   }
-  absl::StrAppend(&result, Indent(absl::StrJoin(lines, "\n")), "\nend");
-  return result;
+  writer->DecreaseIndent();
+  writer->Write("\nend");
 }
 
 Port Port::FromProto(const PortProto& proto, VerilogFile* f) {
@@ -206,21 +237,23 @@ LogicRef* VerilogFunction::return_value_ref() {
   return file()->Make<LogicRef>(return_value_def_);
 }
 
-std::string VerilogFunction::Emit() const {
-  std::vector<std::string> lines;
+std::string VerilogFunction::Emit() const { return EmitViaWriter(); }
+
+void VerilogFunction::EmitTo(LineWriter* writer) const {
+  writer->Write(absl::StrFormat(
+      "function automatic%s (%s);\n",
+      return_value_def_->data_type()->EmitWithIdentifier(name()),
+      absl::StrJoin(argument_defs_, ", ", [](std::string* out, RegDef* d) {
+        absl::StrAppend(out, "input ", d->EmitNoSemi());
+      })));
+  writer->IncreaseIndent();
   for (RegDef* reg_def : block_reg_defs_) {
-    lines.push_back(reg_def->Emit());
+    reg_def->EmitTo(writer);
+    writer->Write("\n");
   }
-  lines.push_back(statement_block_->Emit());
-  return absl::StrCat(
-      absl::StrFormat(
-          "function automatic%s (%s);\n",
-          return_value_def_->data_type()->EmitWithIdentifier(name()),
-          absl::StrJoin(argument_defs_, ", ",
-                        [](std::string* out, RegDef* d) {
-                          absl::StrAppend(out, "input ", d->EmitNoSemi());
-                        })),
-      Indent(absl::StrJoin(lines, "\n")), "\nendfunction");
+  statement_block_->EmitTo(writer);
+  writer->DecreaseIndent();
+  writer->Write("\nendfunction");
 }
 
 std::string VerilogFunctionCall::Emit() const {
@@ -386,31 +419,6 @@ std::string RegDef::Emit() const {
   return result;
 }
 
-namespace {
-
-// "Match" statement for emitting a ModuleMember.
-std::string EmitModuleMember(const ModuleMember& member) {
-  return absl::visit(
-      Visitor{[](Def* d) { return d->Emit(); },
-              [](LocalParam* p) { return p->Emit(); },
-              [](Parameter* p) { return p->Emit(); },
-              [](Instantiation* i) { return i->Emit(); },
-              [](ContinuousAssignment* c) { return c->Emit(); },
-              [](Comment* c) { return c->Emit(); },
-              [](BlankLine* b) { return b->Emit(); },
-              [](InlineVerilogStatement* s) { return s->Emit(); },
-              [](StructuredProcedure* sp) { return sp->Emit(); },
-              [](AlwaysComb* ac) { return ac->Emit(); },
-              [](AlwaysFf* af) { return af->Emit(); },
-              [](AlwaysFlop* af) { return af->Emit(); },
-              [](VerilogFunction* f) { return f->Emit(); },
-              [](Cover* c) { return c->Emit(); },
-              [](ModuleSection* s) { return s->Emit(); }},
-      member);
-}
-
-}  // namespace
-
 std::vector<ModuleMember> ModuleSection::GatherMembers() const {
   std::vector<ModuleMember> all_members;
   for (const ModuleMember& member : members_) {
@@ -426,12 +434,18 @@ std::vector<ModuleMember> ModuleSection::GatherMembers() const {
   return all_members;
 }
 
-std::string ModuleSection::Emit() const {
-  std::vector<std::string> elements;
+std::string ModuleSection::Emit() const { return EmitViaWriter(); }
+
+void ModuleSection::EmitTo(LineWriter* writer) const {
+  bool first = true;
   for (const ModuleMember& member : GatherMembers()) {
-    elements.push_back(EmitModuleMember(member));
+    if (!first) {
+      writer->Write("\n");
+    }
+    first = false;
+    // Every module member alternative is a VastNode.
+    absl::visit([&](auto* m) { m->EmitTo(writer); }, member);
   }
-  return absl::StrJoin(elements, "\n");
 }
 
 std::string ContinuousAssignment::Emit() const {
@@ -489,23 +503,27 @@ std::string SystemFunctionCall::Emit() const {
   }
 }
 
-std::string Module::Emit() const {
-  std::string result = absl::StrCat("module ", name_);
+std::string Module::Emit() const { return EmitViaWriter(); }
+
+void Module::EmitTo(LineWriter* writer) const {
+  writer->Write(absl::StrCat("module ", name_));
   if (ports_.empty()) {
-    absl::StrAppend(&result, ";\n");
+    writer->Write(";\n");
   } else {
-    absl::StrAppend(&result, "(\n  ");
-    absl::StrAppend(
-        &result,
-        absl::StrJoin(ports_, ",\n  ", [](std::string* out, const Port& port) {
-          absl::StrAppendFormat(out, "%s %s", ToString(port.direction),
-                                port.wire->EmitNoSemi());
-        }));
-    absl::StrAppend(&result, "\n);\n");
+    writer->Write("(\n");
+    writer->IncreaseIndent();
+    for (int64_t i = 0; i < ports_.size(); ++i) {
+      writer->Write(absl::StrFormat("%s %s%s", ToString(ports_[i].direction),
+                                    ports_[i].wire->EmitNoSemi(),
+                                    i + 1 < ports_.size() ? ",\n" : "\n"));
+    }
+    writer->DecreaseIndent();
+    writer->Write(");\n");
   }
-  absl::StrAppend(&result, Indent(top_.Emit()), "\n");
-  absl::StrAppend(&result, "endmodule");
-  return result;
+  writer->IncreaseIndent();
+  top_.EmitTo(writer);
+  writer->DecreaseIndent();
+  writer->Write("\nendmodule");
 }
 
 std::string Literal::Emit() const {
@@ -673,16 +691,18 @@ StatementBlock* Case::AddCaseArm(CaseLabel label) {
   return arms_.back()->statements();
 }
 
-std::string Case::Emit() const {
-  std::string result = absl::StrFormat("case (%s)\n", subject_->Emit());
+std::string Case::Emit() const { return EmitViaWriter(); }
+
+void Case::EmitTo(LineWriter* writer) const {
+  writer->Write(absl::StrFormat("case (%s)\n", subject_->Emit()));
+  writer->IncreaseIndent();
   for (auto& arm : arms_) {
-    absl::StrAppend(&result,
-                    Indent(absl::StrFormat("%s: %s", arm->Emit(),
-                                           arm->statements()->Emit())),
-                    "\n");
+    writer->Write(absl::StrCat(arm->Emit(), ": "));
+    arm->statements()->EmitTo(writer);
+    writer->Write("\n");
   }
-  absl::StrAppend(&result, "endcase");
-  return result;
+  writer->DecreaseIndent();
+  writer->Write("endcase");
 }
 
 Conditional::Conditional(Expression* condition, VerilogFile* file)
@@ -698,18 +718,18 @@ StatementBlock* Conditional::AddAlternate(Expression* condition) {
   return alternates_.back().second;
 }
 
-std::string Conditional::Emit() const {
-  std::string result;
-  absl::StrAppendFormat(&result, "if (%s) %s", condition_->Emit(),
-                        consequent()->Emit());
+std::string Conditional::Emit() const { return EmitViaWriter(); }
+
+void Conditional::EmitTo(LineWriter* writer) const {
+  writer->Write(absl::StrFormat("if (%s) ", condition_->Emit()));
+  consequent()->EmitTo(writer);
   for (auto& alternate : alternates_) {
-    absl::StrAppend(&result, " else ");
+    writer->Write(" else ");
     if (alternate.first != nullptr) {
-      absl::StrAppendFormat(&result, "if (%s) ", alternate.first->Emit());
+      writer->Write(absl::StrFormat("if (%s) ", alternate.first->Emit()));
     }
-    absl::StrAppend(&result, alternate.second->Emit());
+    alternate.second->EmitTo(writer);
   }
-  return result;
 }
 
 WhileStatement::WhileStatement(Expression* condition, VerilogFile* file)
@@ -781,24 +801,30 @@ std::string EmitSensitivityListElement(const SensitivityListElement& element) {
 
 }  // namespace
 
-std::string AlwaysBase::Emit() const {
-  return absl::StrFormat(
-      "%s @ (%s) %s", name(),
+std::string AlwaysBase::Emit() const { return EmitViaWriter(); }
+
+void AlwaysBase::EmitTo(LineWriter* writer) const {
+  writer->Write(absl::StrFormat(
+      "%s @ (%s) ", name(),
       absl::StrJoin(sensitivity_list_, " or ",
                     [](std::string* out, const SensitivityListElement& e) {
                       absl::StrAppend(out, EmitSensitivityListElement(e));
-                    }),
-      statements_->Emit());
+                    })));
+  statements_->EmitTo(writer);
 }
 
-std::string AlwaysComb::Emit() const {
-  return absl::StrFormat("%s %s", name(), statements_->Emit());
+std::string AlwaysComb::Emit() const { return EmitViaWriter(); }
+
+void AlwaysComb::EmitTo(LineWriter* writer) const {
+  writer->Write(absl::StrCat(name(), " "));
+  statements_->EmitTo(writer);
 }
 
-std::string Initial::Emit() const {
-  std::string result = "initial ";
-  absl::StrAppend(&result, statements_->Emit());
-  return result;
+std::string Initial::Emit() const { return EmitViaWriter(); }
+
+void Initial::EmitTo(LineWriter* writer) const {
+  writer->Write("initial ");
+  statements_->EmitTo(writer);
 }
 
 AlwaysFlop::AlwaysFlop(LogicRef* clk, Reset rst, VerilogFile* file)
@@ -835,17 +861,17 @@ void AlwaysFlop::AddRegister(LogicRef* reg, Expression* reg_next,
   assignment_block_->Add<NonblockingAssignment>(reg, reg_next);
 }
 
-std::string AlwaysFlop::Emit() const {
-  std::string result;
+std::string AlwaysFlop::Emit() const { return EmitViaWriter(); }
+
+void AlwaysFlop::EmitTo(LineWriter* writer) const {
   std::string sensitivity_list = absl::StrCat("posedge ", clk_->Emit());
   if (rst_.has_value() && rst_->asynchronous) {
     absl::StrAppendFormat(&sensitivity_list, " or %s %s",
                           (rst_->active_low ? "negedge" : "posedge"),
                           rst_->signal->Emit());
   }
-  absl::StrAppendFormat(&result, "always @ (%s) %s", sensitivity_list,
-                        top_block_->Emit());
-  return result;
+  writer->Write(absl::StrFormat("always @ (%s) ", sensitivity_list));
+  top_block_->EmitTo(writer);
 }
 
 std::string Instantiation::Emit() const {
@@ -20,6 +20,7 @@
 
 #include <limits>
 #include <memory>
+#include <ostream>
 #include <string>
 #include <utility>
 #include <vector>
@@ -49,6 +50,32 @@ class Unary;
 // characters are replaced with '_'.
 std::string SanitizeIdentifier(absl::string_view name);
 
+// Writes emitted Verilog text to an output stream while tracking the current
+// indentation level. Indentation is applied lazily when the first character of
+// a line is written so empty lines never receive trailing whitespace. This
+// matches the output of Indent() without building intermediate strings.
+class LineWriter {
+ public:
+  explicit LineWriter(std::ostream* out) : out_(out) {}
+
+  // Writes the given text. Each line of the text (including the first if the
+  // writer is at the start of a line) is prefixed with the current indentation.
+  void Write(absl::string_view text);
+
+  // Increases/decreases the indentation of subsequently started lines by one
+  // level (two spaces).
+  void IncreaseIndent() { ++indent_level_; }
+  void DecreaseIndent() {
+    XLS_CHECK_GT(indent_level_, 0);
+    --indent_level_;
+  }
+
+ private:
+  std::ostream* out_;
+  int64_t indent_level_ = 0;
+  bool at_line_start_ = true;
+};
+
 // Base type for a VAST node. All nodes are owned by a VerilogFile.
 class VastNode {
  public:
@@ -60,6 +87,17 @@ class VastNode {
 
   virtual std::string Emit() const = 0;
 
+  // Writes the emitted text of the node to the given writer. The text is
+  // identical to that returned by Emit(). Nodes which contain statement blocks
+  // or other nested structure override this method to stream their children
+  // directly rather than concatenating strings.
+  virtual void EmitTo(LineWriter* writer) const { writer->Write(Emit()); }
+
+ protected:
+  // Returns the text written by EmitTo. Used to implement Emit() for nodes
+  // which override EmitTo.
+  std::string EmitViaWriter() const;
+
  private:
   VerilogFile* file_;
 };
@@ -325,6 +363,7 @@ class StatementBlock : public VastNode {
   inline T* Add(Args&&... args);
 
   std::string Emit() const override;
+  void EmitTo(LineWriter* writer) const override;
 
  private:
   std::vector<Statement*> statements_;
@@ -358,6 +397,7 @@ class Case : public Statement {
   StatementBlock* AddCaseArm(CaseLabel label);
 
   std::string Emit() const override;
+  void EmitTo(LineWriter* writer) const override;
 
  private:
   Expression* subject_;
@@ -378,6 +418,7 @@ class Conditional : public Statement {
   StatementBlock* AddAlternate(Expression* condition = nullptr);
 
   std::string Emit() const override;
+  void EmitTo(LineWriter* writer) const override;
 
  private:
   Expression* condition_;
@@ -710,6 +751,7 @@ class AlwaysFlop : public VastNode {
                    Expression* reset_value = nullptr);
 
   std::string Emit() const override;
+  void EmitTo(LineWriter* writer) const override;
 
  private:
   LogicRef* clk_;
@@ -751,6 +793,7 @@ class AlwaysBase : public StructuredProcedure {
       : StructuredProcedure(file),
         sensitivity_list_(sensitivity_list.begin(), sensitivity_list.end()) {}
   std::string Emit() const override;
+  void EmitTo(LineWriter* writer) const override;
 
  protected:
   virtual std::string name() const = 0;
@@ -774,6 +817,7 @@ class AlwaysComb : public AlwaysBase {
  public:
   explicit AlwaysComb(VerilogFile* file) : AlwaysBase({}, file) {}
   std::string Emit() const override;
+  void EmitTo(LineWriter* writer) const override;
 
  protected:
   std::string name() const override { return "always_comb"; }
@@ -794,6 +838,7 @@ class Initial : public StructuredProcedure {
   using StructuredProcedure::StructuredProcedure;
 
   std::string Emit() const override;
+  void EmitTo(LineWriter* writer) const override;
 };
 
 class Concat : public Expression {
@@ -1188,6 +1233,7 @@ class VerilogFunction : public VastNode {
   std::string name() const { return name_; }
 
   std::string Emit() const override;
+  void EmitTo(LineWriter* writer) const override;
 
  private:
   std::string name_;
@@ -1267,6 +1313,7 @@ class ModuleSection : public VastNode {
   std::vector<ModuleMember> GatherMembers() const;
 
   std::string Emit() const override;
+  void EmitTo(LineWriter* writer) const override;
 
  private:
   std::vector<ModuleMember> members_;
@@ -1327,6 +1374,7 @@ class Module : public VastNode {
   const std::string& name() const { return name_; }
 
   std::string Emit() const override;
+  void EmitTo(LineWriter* writer) const override;
 
  private:
   // Add the given Def as a port on the module.
@@ -1380,6 +1428,11 @@ class VerilogFile {
 
   std::string Emit() const;
 
+  // Streams the text of the file to the given writer. The text is identical to
+  // that returned by Emit() but no intermediate string is constructed for the
+  // file or its modules.
+  void EmitTo(LineWriter* writer) const;
+
   verilog::Slice* Slice(IndexableExpression* subject, Expression* hi,
                         Expression* lo) {
     return Make<verilog::Slice>(subject, hi, lo);
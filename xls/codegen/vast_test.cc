@@ -14,6 +14,8 @@
 
 #include "xls/codegen/vast.h"
 
+#include <sstream>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/strings/str_cat.h"
@@ -1020,6 +1022,80 @@ TEST_P(VastTest, VerilogFunctionWithComplicatedTypes) {
 endmodule)");
 }
 
+TEST_P(VastTest, LineWriterIndentation) {
+  std::ostringstream out;
+  LineWriter writer(&out);
+  writer.Write("a\n");
+  writer.IncreaseIndent();
+  writer.Write("b\n\nc");
+  writer.Write(" d\n");
+  writer.IncreaseIndent();
+  writer.Write("e\nf");
+  writer.DecreaseIndent();
+  writer.Write("\ng");
+  writer.DecreaseIndent();
+  writer.Write("\nh\n");
+  EXPECT_EQ(out.str(), "a\n  b\n\n  c d\n    e\n    f\n  g\nh\n");
+}
+
+TEST_P(VastTest, StreamedEmitMatchesEmit) {
+  VerilogFile f(UseSystemVerilog());
+  f.Add(f.Make<Comment>("header\ncomment"));
+  f.Add(f.Make<BlankLine>());
+  Module* m = f.AddModule("top");
+  LogicRef* clk = m->AddInput("clk", f.BitVectorType(1));
+  LogicRef* rst = m->AddInput("rst", f.BitVectorType(1));
+  LogicRef* sel = m->AddInput("sel", f.BitVectorType(2));
+  LogicRef* out = m->AddOutput("out", f.BitVectorType(8));
+
+  ModuleSection* section = m->Add<ModuleSection>();
+  LogicRef* a = m->AddReg("a", f.BitVectorType(8), /*init=*/nullptr, section);
+  LogicRef* b = m->AddWire("b", f.BitVectorType(8), section);
+  section->Add<Comment>("A comment\nspanning lines");
+  section->Add<BlankLine>();
+  m->Add<ModuleSection>();
+
+  VerilogFunction* func = m->Add<VerilogFunction>("f", f.BitVectorType(8));
+  LogicRef* x = func->AddArgument("x", f.BitVectorType(8));
+  LogicRef* tmp = func->AddRegDef("tmp", f.BitVectorType(8));
+  func->AddStatement<BlockingAssignment>(tmp, x);
+  func->AddStatement<BlockingAssignment>(func->return_value_ref(), tmp);
+
+  AlwaysComb* ac = m->Add<AlwaysComb>();
+  Case* case_statement = ac->statements()->Add<Case>(sel);
+  Conditional* cond =
+      case_statement->AddCaseArm(f.Literal(1, 2))->Add<Conditional>(rst);
+  cond->consequent()->Add<BlockingAssignment>(a, f.Literal(0, 8));
+  cond->AddAlternate(clk)->Add<BlockingAssignment>(a, b);
+  cond->AddAlternate();
+  case_statement->AddCaseArm(DefaultSentinel())
+      ->Add<BlockingAssignment>(a, f.Make<XSentinel>(8));
+
+  AlwaysFlop* af = m->Add<AlwaysFlop>(
+      clk, Reset{rst, /*async*/ true, /*active_low*/ false});
+  af->AddRegister(a, b, /*reset_value=*/f.Literal(0, 8));
+  m->Add<ContinuousAssignment>(
+      out, f.Make<VerilogFunctionCall>(func, std::vector<Expression*>{a}));
+
+  f.Add(f.Make<BlankLine>());
+  f.AddModule("empty");
+
+  std::ostringstream streamed;
+  LineWriter writer(&streamed);
+  f.EmitTo(&writer);
+  EXPECT_EQ(streamed.str(), f.Emit());
+  EXPECT_THAT(streamed.str(), HasSubstr(R"(  always_comb begin
+    case (sel)
+      2'h1: begin
+        if (rst) begin
+          a = 8'h00;
+        end else if (clk) begin
+          a = b;
+        end else begin end
+      end)"));
+  EXPECT_THAT(streamed.str(), HasSubstr("module empty;\n\nendmodule\n"));
+}
+
 INSTANTIATE_TEST_SUITE_P(VastTestInstantiation, VastTest,
                          testing::Values(false, true),
                          [](const testing::TestParamInfo<bool>& info) {
@@ -0,0 +1,71 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/common/file/memory_mapped_file.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "xls/common/file/file_descriptor.h"
+#include "xls/common/status/error_code_to_status.h"
+
+namespace xls {
+namespace {
+
+// Returns a Status error based on the errno value. The error message includes
+// the filename.
+absl::Status ErrNoToStatusWithFilename(int errno_value,
+                                       const std::filesystem::path& file_name) {
+  xabsl::StatusBuilder builder = ErrnoToStatus(errno_value);
+  builder << file_name.string();
+  return std::move(builder);
+}
+
+}  // namespace
+
+/* static */ absl::StatusOr<std::unique_ptr<MemoryMappedFile>>
+MemoryMappedFile::Open(const std::filesystem::path& file_name) {
+  FileDescriptor fd(open(file_name.c_str(), O_RDONLY | O_CLOEXEC));
+  if (fd.get() == -1) {
+    return ErrNoToStatusWithFilename(errno, file_name);
+  }
+  struct stat st;
+  if (fstat(fd.get(), &st) == -1) {
+    return ErrNoToStatusWithFilename(errno, file_name);
+  }
+  if (st.st_size == 0) {
+    return absl::WrapUnique(new MemoryMappedFile(nullptr, 0));
+  }
+  // The mapping holds its own reference to the file, so the descriptor can be
+  // closed as soon as the mapping is established.
+  void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd.get(), 0);
+  if (data == MAP_FAILED) {
+    return ErrNoToStatusWithFilename(errno, file_name);
+  }
+  // This is purely a hint, so failure is not an error.
+  (void)madvise(data, st.st_size, MADV_SEQUENTIAL);
+  return absl::WrapUnique(new MemoryMappedFile(data, st.st_size));
+}
+
+MemoryMappedFile::~MemoryMappedFile() {
+  if (data_ != nullptr) {
+    munmap(data_, size_);
+  }
+}
+
+}  // namespace xls
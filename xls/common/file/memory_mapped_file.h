@@ -0,0 +1,59 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_COMMON_FILE_MEMORY_MAPPED_FILE_H_
+#define XLS_COMMON_FILE_MEMORY_MAPPED_FILE_H_
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+
+namespace xls {
+
+// A read-only view of a file's contents that is mapped into memory rather than
+// copied into a buffer. Pages are loaded lazily by the OS as they're touched,
+// so very large inputs (e.g., multi-GB netlists) can be scanned without
+// holding a second copy of the file on the heap. The mapping is released when
+// the object is destroyed.
+class MemoryMappedFile {
+ public:
+  // Maps the file at the given path. The mapping is advised for sequential
+  // access.
+  static absl::StatusOr<std::unique_ptr<MemoryMappedFile>> Open(
+      const std::filesystem::path& file_name);
+
+  ~MemoryMappedFile();
+
+  MemoryMappedFile(const MemoryMappedFile&) = delete;
+  MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+
+  // The contents of the file. Remains valid for the lifetime of this object.
+  absl::string_view contents() const {
+    return absl::string_view(static_cast<const char*>(data_), size_);
+  }
+
+ private:
+  MemoryMappedFile(void* data, int64_t size) : data_(data), size_(size) {}
+
+  // Null for empty files, which cannot be mapped.
+  void* data_;
+  int64_t size_;
+};
+
+}  // namespace xls
+
+#endif  // XLS_COMMON_FILE_MEMORY_MAPPED_FILE_H_
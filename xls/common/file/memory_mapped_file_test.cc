@@ -0,0 +1,52 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/common/file/memory_mapped_file.h"
+
+#include <memory>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "xls/common/file/temp_directory.h"
+#include "xls/common/file/temp_file.h"
+#include "xls/common/status/matchers.h"
+
+namespace xls {
+namespace {
+
+using status_testing::StatusIs;
+
+TEST(MemoryMappedFileTest, MapsContents) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempFile temp_file,
+                           TempFile::CreateWithContent("hello\nworld\n"));
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<MemoryMappedFile> file,
+                           MemoryMappedFile::Open(temp_file.path()));
+  EXPECT_EQ(file->contents(), "hello\nworld\n");
+}
+
+TEST(MemoryMappedFileTest, EmptyFile) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempFile temp_file, TempFile::Create());
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<MemoryMappedFile> file,
+                           MemoryMappedFile::Open(temp_file.path()));
+  EXPECT_TRUE(file->contents().empty());
+}
+
+TEST(MemoryMappedFileTest, MissingFile) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory temp_dir, TempDirectory::Create());
+  EXPECT_THAT(MemoryMappedFile::Open(temp_dir.path() / "missing"),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
+}  // namespace
+}  // namespace xls
@@ -0,0 +1,76 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/common/thread_pool.h"
+
+#include <utility>
+
+#include "xls/common/logging/logging.h"
+
+namespace xls {
+
+ThreadPool::ThreadPool(int64_t thread_count) {
+  XLS_CHECK_GT(thread_count, 0);
+  for (int64_t i = 0; i < thread_count; ++i) {
+    threads_.push_back(std::make_unique<Thread>([this] { WorkLoop(); }));
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    absl::MutexLock lock(&mutex_);
+    shutting_down_ = true;
+  }
+  for (std::unique_ptr<Thread>& thread : threads_) {
+    thread->Join();
+  }
+}
+
+void ThreadPool::Schedule(std::function<void()> fn) {
+  absl::MutexLock lock(&mutex_);
+  XLS_CHECK(!shutting_down_);
+  queue_.push_back(std::move(fn));
+  ++pending_;
+}
+
+void ThreadPool::WaitForIdle() {
+  absl::MutexLock lock(&mutex_);
+  mutex_.Await(absl::Condition(
+      +[](int64_t* pending) { return *pending == 0; }, &pending_));
+}
+
+void ThreadPool::WorkLoop() {
+  while (true) {
+    std::function<void()> fn;
+    {
+      absl::MutexLock lock(&mutex_);
+      mutex_.Await(absl::Condition(
+          +[](ThreadPool* pool) ABSL_EXCLUSIVE_LOCKS_REQUIRED(pool->mutex_) {
+            return !pool->queue_.empty() || pool->shutting_down_;
+          },
+          this));
+      if (queue_.empty()) {
+        // Shutting down and no work is left.
+        return;
+      }
+      fn = std::move(queue_.front());
+      queue_.pop_front();
+    }
+    fn();
+    absl::MutexLock lock(&mutex_);
+    --pending_;
+  }
+}
+
+}  // namespace xls
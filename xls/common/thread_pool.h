@@ -0,0 +1,69 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_COMMON_THREAD_POOL_H_
+#define XLS_COMMON_THREAD_POOL_H_
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "xls/common/thread.h"
+
+namespace xls {
+
+// A fixed-size pool of worker threads which run scheduled closures in FIFO
+// order. Example usage:
+//
+//   ThreadPool pool(/*thread_count=*/4);
+//   for (int64_t i = 0; i < n; ++i) {
+//     pool.Schedule([&, i] { results[i] = Compute(i); });
+//   }
+//   pool.WaitForIdle();
+class ThreadPool {
+ public:
+  explicit ThreadPool(int64_t thread_count);
+
+  // Waits for all scheduled closures to complete and joins the threads.
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  // Schedules the given closure to run on one of the worker threads.
+  void Schedule(std::function<void()> fn);
+
+  // Blocks until every scheduled closure has completed.
+  void WaitForIdle();
+
+  int64_t thread_count() const { return threads_.size(); }
+
+ private:
+  void WorkLoop();
+
+  absl::Mutex mutex_;
+  std::deque<std::function<void()>> queue_ ABSL_GUARDED_BY(mutex_);
+  // Number of closures which have been scheduled but have not completed.
+  int64_t pending_ ABSL_GUARDED_BY(mutex_) = 0;
+  bool shutting_down_ ABSL_GUARDED_BY(mutex_) = false;
+  std::vector<std::unique_ptr<Thread>> threads_;
+};
+
+}  // namespace xls
+
+#endif  // XLS_COMMON_THREAD_POOL_H_
@@ -0,0 +1,64 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/common/thread_pool.h"
+
+#include <atomic>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace xls {
+namespace {
+
+TEST(ThreadPoolTest, RunsAllScheduledClosures) {
+  ThreadPool pool(/*thread_count=*/4);
+  EXPECT_EQ(pool.thread_count(), 4);
+  std::vector<int64_t> results(100, 0);
+  for (int64_t i = 0; i < results.size(); ++i) {
+    pool.Schedule([&results, i] { results[i] = i * i; });
+  }
+  pool.WaitForIdle();
+  for (int64_t i = 0; i < results.size(); ++i) {
+    EXPECT_EQ(results[i], i * i);
+  }
+}
+
+TEST(ThreadPoolTest, WaitForIdleCanBeCalledRepeatedly) {
+  ThreadPool pool(/*thread_count=*/2);
+  std::atomic<int64_t> count(0);
+  pool.WaitForIdle();
+  for (int64_t round = 0; round < 3; ++round) {
+    for (int64_t i = 0; i < 10; ++i) {
+      pool.Schedule([&count] { ++count; });
+    }
+    pool.WaitForIdle();
+    EXPECT_EQ(count.load(), 10 * (round + 1));
+  }
+}
+
+TEST(ThreadPoolTest, DestructorRunsPendingClosures) {
+  std::atomic<int64_t> count(0);
+  {
+    ThreadPool pool(/*thread_count=*/1);
+    for (int64_t i = 0; i < 10; ++i) {
+      pool.Schedule([&count] { ++count; });
+    }
+  }
+  EXPECT_EQ(count.load(), 10);
+}
+
+}  // namespace
+}  // namespace xls
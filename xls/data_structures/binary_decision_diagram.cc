@@ -14,7 +14,9 @@
 
 #include "xls/data_structures/binary_decision_diagram.h"
 
+#include <algorithm>
 #include <limits>
+#include <vector>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -27,13 +29,358 @@
 
 namespace xls {
 
-BinaryDecisionDiagram::BinaryDecisionDiagram() {
+namespace {
+
+// The initial number of entries in the computed table.
+constexpr int64_t kInitialComputedTableSize = 1024;
+
+}  // namespace
+
+BinaryDecisionDiagram::BinaryDecisionDiagram(int64_t max_computed_table_size)
+    : max_computed_table_size_(max_computed_table_size) {
+  XLS_CHECK_GT(max_computed_table_size, 0);
+  XLS_CHECK_EQ(max_computed_table_size & (max_computed_table_size - 1), 0)
+      << "Computed table size must be a power of two";
   // Leaf node 0.
   nodes_.push_back(BddNode(BddVariable(-1), BddNodeIndex(-1), BddNodeIndex(-1),
                            /*p=*/1));
   // Leaf node 1.
   nodes_.push_back(BddNode(BddVariable(-1), BddNodeIndex(-1), BddNodeIndex(-1),
                            /*p=*/1));
+  computed_table_.resize(
+      std::min(kInitialComputedTableSize, max_computed_table_size_));
+}
+
+int64_t BinaryDecisionDiagram::ComputedTableSlot(BddNodeIndex cond,
+                                                 BddNodeIndex if_true,
+                                                 BddNodeIndex if_false) const {
+  uint64_t hash = static_cast<uint32_t>(cond.value());
+  hash = hash * 0x9e3779b97f4a7c15ULL + static_cast<uint32_t>(if_true.value());
+  hash = hash * 0x9e3779b97f4a7c15ULL + static_cast<uint32_t>(if_false.value());
+  hash ^= hash >> 29;
+  return hash & (computed_table_.size() - 1);
+}
+
+void BinaryDecisionDiagram::MaybeGrowComputedTable() {
+  if (computed_table_.size() >= size() ||
+      computed_table_.size() >= max_computed_table_size_) {
+    return;
+  }
+  std::vector<ComputedTableEntry> old_table = std::move(computed_table_);
+  computed_table_ = std::vector<ComputedTableEntry>(
+      std::min(static_cast<int64_t>(old_table.size()) * 2,
+               max_computed_table_size_));
+  for (const ComputedTableEntry& entry : old_table) {
+    if (entry.cond.value() >= 0) {
+      computed_table_[ComputedTableSlot(entry.cond, entry.if_true,
+                                        entry.if_false)] = entry;
+    }
+  }
+}
+
+int64_t BinaryDecisionDiagram::GetMemoryUsageBytes() const {
+  // Each live node has an entry in 'nodes_' and in 'node_map_'. The hash map
+  // stores the key/value pair plus one control byte per slot and is kept at
+  // most 7/8 full.
+  constexpr int64_t kNodeMapEntryBytes =
+      (sizeof(NodeKey) + sizeof(BddNodeIndex) + 1) * 8 / 7;
+  return size() * (sizeof(BddNode) + kNodeMapEntryBytes) +
+         computed_table_.size() * sizeof(ComputedTableEntry);
+}
+
+int64_t BinaryDecisionDiagram::GarbageCollect(
+    absl::Span<const BddNodeIndex> roots) {
+  std::vector<bool> live(nodes_.size(), false);
+  live[zero().value()] = true;
+  live[one().value()] = true;
+  std::vector<BddNodeIndex> worklist(roots.begin(), roots.end());
+  for (int64_t i = 0; i < variable_count(); ++i) {
+    worklist.push_back(GetVariableBaseNode(BddVariable(i)));
+  }
+  while (!worklist.empty()) {
+    BddNodeIndex node_index = worklist.back();
+    worklist.pop_back();
+    if (live[node_index.value()]) {
+      continue;
+    }
+    live[node_index.value()] = true;
+    const BddNode& node = GetNode(node_index);
+    worklist.push_back(node.high);
+    worklist.push_back(node.low);
+  }
+
+  // Reclaimed nodes (and the leaves) have a negative variable.
+  int64_t reclaimed = 0;
+  for (int64_t i = 0; i < nodes_.size(); ++i) {
+    BddNode& node = nodes_[i];
+    if (live[i] || node.variable.value() < 0) {
+      continue;
+    }
+    node_map_.erase(std::make_tuple(node.variable, node.high, node.low));
+    node = BddNode(BddVariable(-1), BddNodeIndex(-1), BddNodeIndex(-1),
+                   /*p=*/0);
+    free_nodes_.push_back(BddNodeIndex(i));
+    ++reclaimed;
+  }
+
+  // Results in the computed table may refer to reclaimed nodes.
+  if (reclaimed > 0) {
+    std::fill(computed_table_.begin(), computed_table_.end(),
+              ComputedTableEntry());
+  }
+  XLS_VLOG(3) << absl::StreamFormat(
+      "BDD garbage collection reclaimed %d nodes, %d nodes remain", reclaimed,
+      size());
+  return reclaimed;
+}
+
+namespace {
+
+// Sifting stops moving a variable in one direction once the BDD has grown by
+// this factor relative to its size before the variable was moved.
+constexpr double kMaxSiftGrowth = 1.2;
+
+// At most this many variables (those labeling the most nodes) are sifted in a
+// single call to Sift.
+constexpr int64_t kMaxSiftedVariables = 256;
+
+// The maximum number of adjacent level swaps performed by a single call to
+// Sift.
+constexpr int64_t kMaxSiftSwaps = 100000;
+
+}  // namespace
+
+struct BinaryDecisionDiagram::ReorderState {
+  // The number of references to each node from other nodes, the roots and
+  // the variables (which pin their base nodes). Terminal nodes are not
+  // tracked.
+  std::vector<int64_t> ref_counts;
+
+  // The nodes labeled with each variable. May contain stale entries of nodes
+  // which have since been reclaimed (or relabeled) which are skipped.
+  std::vector<std::vector<BddNodeIndex>> variable_nodes;
+
+  int64_t swaps_remaining = kMaxSiftSwaps;
+};
+
+void BinaryDecisionDiagram::SwapAdjacentLevels(int64_t level,
+                                               ReorderState* state) {
+  BddVariable x = level_variables_[level];
+  BddVariable y = level_variables_[level + 1];
+  --state->swaps_remaining;
+
+  auto is_terminal = [&](BddNodeIndex n) { return n == zero() || n == one(); };
+  auto variable_of = [&](BddNodeIndex n) {
+    return is_terminal(n) ? BddVariable(-1) : nodes_[n.value()].variable;
+  };
+  auto add_ref = [&](BddNodeIndex n) {
+    if (!is_terminal(n)) {
+      ++state->ref_counts[n.value()];
+    }
+  };
+  // Drops a reference to the given node, reclaiming it (and transitively its
+  // children) if it is no longer referenced.
+  auto drop_ref = [&](BddNodeIndex n) {
+    std::vector<BddNodeIndex> worklist = {n};
+    while (!worklist.empty()) {
+      BddNodeIndex m = worklist.back();
+      worklist.pop_back();
+      if (is_terminal(m) || --state->ref_counts[m.value()] > 0) {
+        continue;
+      }
+      BddNode& node = nodes_[m.value()];
+      node_map_.erase(std::make_tuple(node.variable, node.high, node.low));
+      worklist.push_back(node.high);
+      worklist.push_back(node.low);
+      node = BddNode(BddVariable(-1), BddNodeIndex(-1), BddNodeIndex(-1),
+                     /*p=*/0);
+      free_nodes_.push_back(m);
+    }
+  };
+  std::vector<BddNodeIndex> new_x_nodes;
+  // Returns a referenced node labeled with 'x' with the given children. Slots
+  // of reclaimed nodes are not reused during reordering so the stale entries
+  // in the per-variable node lists remain distinguishable.
+  auto get_or_create_x_node = [&](BddNodeIndex high, BddNodeIndex low) {
+    if (high == low) {
+      add_ref(high);
+      return high;
+    }
+    NodeKey key = std::make_tuple(x, high, low);
+    auto it = node_map_.find(key);
+    if (it != node_map_.end()) {
+      add_ref(it->second);
+      return it->second;
+    }
+    // Path counts are recomputed once reordering is complete.
+    nodes_.emplace_back(x, high, low, /*p=*/0);
+    BddNodeIndex node_index = BddNodeIndex(nodes_.size() - 1);
+    state->ref_counts.push_back(1);
+    add_ref(high);
+    add_ref(low);
+    node_map_[key] = node_index;
+    new_x_nodes.push_back(node_index);
+    return node_index;
+  };
+
+  // Nodes labeled with 'x' which have a child labeled with 'y' are relabeled
+  // in place with 'y' with new children labeled with 'x':
+  //
+  //   x ? (y ? f11 : f10) : (y ? f01 : f00)
+  //     => y ? (x ? f11 : f01) : (x ? f10 : f00)
+  //
+  // Other nodes labeled with 'x' or 'y' are unaffected.
+  std::vector<BddNodeIndex> x_nodes =
+      std::move(state->variable_nodes[x.value()]);
+  std::vector<BddNodeIndex> moved_nodes;
+  for (BddNodeIndex n : x_nodes) {
+    BddNode node = nodes_[n.value()];
+    if (node.variable != x) {
+      continue;
+    }
+    if (variable_of(node.high) != y && variable_of(node.low) != y) {
+      new_x_nodes.push_back(n);
+      continue;
+    }
+    auto cofactors = [&](BddNodeIndex f) {
+      return variable_of(f) == y ? std::make_pair(nodes_[f.value()].high,
+                                                  nodes_[f.value()].low)
+                                 : std::make_pair(f, f);
+    };
+    auto [f11, f10] = cofactors(node.high);
+    auto [f01, f00] = cofactors(node.low);
+    node_map_.erase(std::make_tuple(x, node.high, node.low));
+    BddNodeIndex high = get_or_create_x_node(f11, f01);
+    BddNodeIndex low = get_or_create_x_node(f10, f00);
+    nodes_[n.value()] = BddNode(y, high, low, /*p=*/0);
+    node_map_[std::make_tuple(y, high, low)] = n;
+    moved_nodes.push_back(n);
+    drop_ref(node.high);
+    drop_ref(node.low);
+  }
+
+  std::vector<BddNodeIndex>& y_nodes = state->variable_nodes[y.value()];
+  y_nodes.erase(std::remove_if(y_nodes.begin(), y_nodes.end(),
+                               [&](BddNodeIndex n) {
+                                 return nodes_[n.value()].variable != y;
+                               }),
+                y_nodes.end());
+  y_nodes.insert(y_nodes.end(), moved_nodes.begin(), moved_nodes.end());
+  state->variable_nodes[x.value()] = std::move(new_x_nodes);
+
+  level_variables_[level] = y;
+  level_variables_[level + 1] = x;
+  variable_levels_[y.value()] = level;
+  variable_levels_[x.value()] = level + 1;
+}
+
+bool BinaryDecisionDiagram::SiftVariable(BddVariable variable,
+                                         ReorderState* state) {
+  const int64_t start_size = size();
+  const int64_t max_size = static_cast<int64_t>(start_size * kMaxSiftGrowth);
+  int64_t best_size = start_size;
+  int64_t best_level = GetVariableLevel(variable);
+  int64_t level = best_level;
+  auto record = [&]() {
+    if (size() < best_size) {
+      best_size = size();
+      best_level = level;
+    }
+  };
+
+  // Move the variable towards the nearer end of the order first, then to the
+  // other end, and finally back to the best level seen.
+  const int64_t last_level = variable_count() - 1;
+  bool down_first = last_level - level < level;
+  for (bool down : {down_first, !down_first}) {
+    while ((down ? level < last_level : level > 0) &&
+           state->swaps_remaining > 0 && size() <= max_size) {
+      SwapAdjacentLevels(down ? level : level - 1, state);
+      level += down ? 1 : -1;
+      record();
+    }
+  }
+  while (level != best_level) {
+    bool down = level < best_level;
+    SwapAdjacentLevels(down ? level : level - 1, state);
+    level += down ? 1 : -1;
+  }
+  return state->swaps_remaining > 0;
+}
+
+int64_t BinaryDecisionDiagram::Sift(absl::Span<const BddNodeIndex> roots) {
+  GarbageCollect(roots);
+  if (variable_count() < 2) {
+    return size();
+  }
+  const int64_t start_size = size();
+
+  ReorderState state;
+  state.ref_counts.resize(nodes_.size(), 0);
+  state.variable_nodes.resize(variable_count());
+  for (int64_t i = 2; i < nodes_.size(); ++i) {
+    const BddNode& node = nodes_[i];
+    if (node.variable.value() < 0) {
+      continue;
+    }
+    state.variable_nodes[node.variable.value()].push_back(BddNodeIndex(i));
+    for (BddNodeIndex child : {node.high, node.low}) {
+      if (child != zero() && child != one()) {
+        ++state.ref_counts[child.value()];
+      }
+    }
+  }
+  for (BddNodeIndex root : roots) {
+    if (root != zero() && root != one()) {
+      ++state.ref_counts[root.value()];
+    }
+  }
+  for (int64_t i = 0; i < variable_count(); ++i) {
+    ++state.ref_counts[GetVariableBaseNode(BddVariable(i)).value()];
+  }
+
+  // Sift the variables labeling the most nodes first.
+  std::vector<BddVariable> variables;
+  for (int64_t i = 0; i < variable_count(); ++i) {
+    variables.push_back(BddVariable(i));
+  }
+  std::stable_sort(variables.begin(), variables.end(),
+                   [&](BddVariable a, BddVariable b) {
+                     return state.variable_nodes[a.value()].size() >
+                            state.variable_nodes[b.value()].size();
+                   });
+  if (variables.size() > kMaxSiftedVariables) {
+    variables.resize(kMaxSiftedVariables);
+  }
+  for (BddVariable variable : variables) {
+    if (!SiftVariable(variable, &state)) {
+      break;
+    }
+  }
+
+  // Relabeled and newly created nodes have stale path counts. Recompute the
+  // path counts of all nodes bottom-up.
+  for (int64_t level = variable_count() - 1; level >= 0; --level) {
+    BddVariable variable = level_variables_[level];
+    for (BddNodeIndex n : state.variable_nodes[variable.value()]) {
+      BddNode& node = nodes_[n.value()];
+      if (node.variable != variable) {
+        continue;
+      }
+      node.path_count = std::min(
+          static_cast<int64_t>(GetNode(node.low).path_count) +
+              GetNode(node.high).path_count,
+          static_cast<int64_t>(std::numeric_limits<int32_t>::max()));
+    }
+  }
+
+  // Results in the computed table may refer to reclaimed nodes.
+  std::fill(computed_table_.begin(), computed_table_.end(),
+            ComputedTableEntry());
+  XLS_VLOG(3) << absl::StreamFormat(
+      "BDD sifting reduced the number of nodes from %d to %d", start_size,
+      size());
+  return size();
 }
 
 BddNodeIndex BinaryDecisionDiagram::GetOrCreateNode(BddVariable var,
@@ -52,9 +399,17 @@ BddNodeIndex BinaryDecisionDiagram::GetOrCreateNode(BddVariable var,
   int32_t paths = std::min(
       static_cast<int64_t>(GetNode(low).path_count) + GetNode(high).path_count,
       static_cast<int64_t>(std::numeric_limits<int32_t>::max()));
-  nodes_.emplace_back(var, high, low, paths);
-  BddNodeIndex node_index = BddNodeIndex(nodes_.size() - 1);
+  BddNodeIndex node_index;
+  if (free_nodes_.empty()) {
+    nodes_.emplace_back(var, high, low, paths);
+    node_index = BddNodeIndex(nodes_.size() - 1);
+  } else {
+    node_index = free_nodes_.back();
+    free_nodes_.pop_back();
+    nodes_[node_index.value()] = BddNode(var, high, low, paths);
+  }
   node_map_[key] = node_index;
+  MaybeGrowComputedTable();
   return node_index;
 }
 
@@ -65,7 +420,7 @@ BddNodeIndex BinaryDecisionDiagram::Restrict(BddNodeIndex expr, BddVariable var,
   }
 
   const BddNode& node = GetNode(expr);
-  XLS_CHECK_LE(var, node.variable);
+  XLS_CHECK_LE(GetVariableLevel(var), GetVariableLevel(node.variable));
   if (node.variable == var) {
     return value ? node.high : node.low;
   }
@@ -87,25 +442,26 @@ BddNodeIndex BinaryDecisionDiagram::IfThenElse(BddNodeIndex cond,
   if (if_true == if_false) {
     return if_true;
   }
-  auto key = std::make_tuple(cond, if_true, if_false);
-  auto it = ite_map_.find(key);
-  if (it != ite_map_.end()) {
-    return it->second;
+  const ComputedTableEntry& entry =
+      computed_table_[ComputedTableSlot(cond, if_true, if_false)];
+  if (entry.cond == cond && entry.if_true == if_true &&
+      entry.if_false == if_false) {
+    return entry.result;
   }
 
   // The expression is non-trivial and has not been computed before. Recursively
   // decompose the expression by peeling away the first variable and performing
   // a Shannon decomposition.
 
-  // First, find the lowest-index variable amongst all expressions. In all paths
-  // through the BDD the variable indices are strictly increasing.
+  // First, find the lowest-level variable amongst all expressions. In all
+  // paths through the BDD the variable levels are strictly increasing.
   BddVariable min_var = GetNode(cond).variable;
   // Only non-leaf nodes (not zero or one) have associated variables.
-  if (if_true != zero() && if_true != one()) {
-    min_var = std::min(min_var, GetNode(if_true).variable);
-  }
-  if (if_false != zero() && if_false != one()) {
-    min_var = std::min(min_var, GetNode(if_false).variable);
+  for (BddNodeIndex expr : {if_true, if_false}) {
+    if (expr != zero() && expr != one() &&
+        GetVariableLevel(GetNode(expr).variable) < GetVariableLevel(min_var)) {
+      min_var = GetNode(expr).variable;
+    }
   }
 
   // Perform a Shannon expansion about the variable where Shannon expansion is
@@ -120,18 +476,23 @@ BddNodeIndex BinaryDecisionDiagram::IfThenElse(BddNodeIndex cond,
                                            Restrict(if_true, min_var, false),
                                            Restrict(if_false, min_var, false));
 
-  if (true_cofactor == false_cofactor) {
-    ite_map_[key] = true_cofactor;
-    return true_cofactor;
-  }
-  BddNodeIndex expr = GetOrCreateNode(min_var, true_cofactor, false_cofactor);
-  ite_map_[key] = expr;
+  BddNodeIndex expr =
+      true_cofactor == false_cofactor
+          ? true_cofactor
+          : GetOrCreateNode(min_var, true_cofactor, false_cofactor);
+  // The recursive calls may have grown the computed table so recompute the
+  // slot.
+  computed_table_[ComputedTableSlot(cond, if_true, if_false)] =
+      ComputedTableEntry{cond, if_true, if_false, expr};
   return expr;
 }
 
 BddNodeIndex BinaryDecisionDiagram::NewVariable() {
   BddVariable var = next_var_;
   ++next_var_;
+  // New variables are placed at the bottom of the order.
+  variable_levels_.push_back(level_variables_.size());
+  level_variables_.push_back(var);
   return GetOrCreateNode(var, one(), zero());
 }
 
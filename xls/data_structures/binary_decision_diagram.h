@@ -16,9 +16,11 @@
 #define XLS_DATA_STRUCTURES_BINARY_DECISION_DIAGRAM_H_
 
 #include <cstdint>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/statusor.h"
+#include "absl/types/span.h"
 #include "xls/common/strong_int.h"
 
 namespace xls {
@@ -31,6 +33,20 @@ namespace xls {
 //   K.S. Brace, R.L. Rudell, and R.E. Bryant,
 //   "Efficient Implementation of a BDD package"
 //   https://ieeexplore.ieee.org/document/114826
+//
+// Nodes which are no longer referenced can be reclaimed with GarbageCollect
+// and their slots are reused for subsequently created nodes. As in the paper,
+// the if-then-else results are memoized in a fixed-size, lossy computed table
+// (entries are overwritten on collision) so the memory used by the cache is
+// bounded.
+//
+// Variables are ordered by level (initially the order of creation). The order
+// can be changed dynamically with Sift which implements Rudell's sifting
+// algorithm:
+//   R. Rudell, "Dynamic variable ordering for ordered binary decision
+//   diagrams", ICCAD 1993.
+// Reordering swaps adjacent levels in place so every BddNodeIndex reachable
+// from the given roots continues to refer to the same Boolean function.
 
 // For efficiency variables and nodes are referred to by indices into vector
 // data members in the BDD.
@@ -57,9 +73,15 @@ struct BddNode {
 
 class BinaryDecisionDiagram {
  public:
+  // The default maximum number of entries in the computed table.
+  static constexpr int64_t kDefaultMaxComputedTableSize = int64_t{1} << 20;
+
   // Creates an empty BDD. Initialize the BDD contains only the nodes
-  // corresponding to zero and one.
-  BinaryDecisionDiagram();
+  // corresponding to zero and one. The computed table grows with the number of
+  // nodes up to 'max_computed_table_size' entries which must be a power of
+  // two.
+  explicit BinaryDecisionDiagram(
+      int64_t max_computed_table_size = kDefaultMaxComputedTableSize);
 
   // Adds a new variable to the BDD and returns the node corresponding the
   // variable's value.
@@ -89,12 +111,43 @@ class BinaryDecisionDiagram {
     return nodes_.at(node_index.value());
   }
 
-  // Returns the number of nodes in the graph.
-  int64_t size() const { return nodes_.size(); }
+  // Returns the number of (live) nodes in the graph.
+  int64_t size() const { return nodes_.size() - free_nodes_.size(); }
+
+  // Returns an estimate of the memory in bytes used by the nodes of the graph
+  // and the associated tables.
+  int64_t GetMemoryUsageBytes() const;
+
+  // Reclaims all nodes which are not reachable from the given roots. The base
+  // nodes of the variables (value returned by NewVariable) are always
+  // retained. After collection, node indices not reachable from the roots are
+  // invalid and may be reused by newly created nodes. Returns the number of
+  // nodes which were reclaimed.
+  int64_t GarbageCollect(absl::Span<const BddNodeIndex> roots);
 
   // Returns the number of variables in the graph.
   int64_t variable_count() const { return next_var_.value(); }
 
+  // Returns the position of the given variable in the variable order. Level
+  // zero is closest to the root of every expression.
+  int64_t GetVariableLevel(BddVariable variable) const {
+    return variable_levels_.at(variable.value());
+  }
+
+  // Returns the variable at the given level of the variable order.
+  BddVariable GetVariableAtLevel(int64_t level) const {
+    return level_variables_.at(level);
+  }
+
+  // Reorders the variables using sifting to reduce the number of nodes needed
+  // to represent the given roots. Each variable (in decreasing order of the
+  // number of nodes labeled with it) is moved through the order and placed at
+  // the position minimizing the size of the BDD. Nodes not reachable from the
+  // roots are garbage collected first (see GarbageCollect). Node indices
+  // reachable from the roots keep representing the same functions, though
+  // path counts may change. Returns the number of nodes after reordering.
+  int64_t Sift(absl::Span<const BddNodeIndex> roots);
+
   // Returns the number of paths in the given expression.
   int64_t path_count(BddNodeIndex expr) const {
     return GetNode(expr).path_count;
@@ -113,6 +166,17 @@ class BinaryDecisionDiagram {
   }
 
  private:
+  // State maintained while reordering variables.
+  struct ReorderState;
+
+  // Swaps the variables at the given level and the level below it.
+  void SwapAdjacentLevels(int64_t level, ReorderState* state);
+
+  // Moves the given variable through the order and leaves it at the level
+  // which minimizes the number of nodes. Returns false if the reordering swap
+  // budget was exhausted.
+  bool SiftVariable(BddVariable variable, ReorderState* state);
+
   // Helper for constructing a DNF string respresentation.
   void ToStringDnfHelper(BddNodeIndex expr, int64_t* minterms_to_emit,
                          std::vector<std::string>* terms,
@@ -136,24 +200,49 @@ class BinaryDecisionDiagram {
     return node_map_.at({variable, one(), zero()});
   }
 
+  // Returns the slot in the computed table for the given if-then-else
+  // expression.
+  int64_t ComputedTableSlot(BddNodeIndex cond, BddNodeIndex if_true,
+                            BddNodeIndex if_false) const;
+
+  // Grows the computed table (if permitted by the maximum size) so its size is
+  // at least the number of nodes. Existing entries are retained.
+  void MaybeGrowComputedTable();
+
   // The numeric id to use for the next created variable. Increments with each
   // call to NewVariable which
   BddVariable next_var_ = BddVariable(0);
 
-  // The vector of all the nodes in the BDD.
+  // The level of each variable in the variable order and its inverse. In all
+  // paths through the BDD the variable levels are strictly increasing.
+  std::vector<int64_t> variable_levels_;
+  std::vector<BddVariable> level_variables_;
+
+  // The vector of all the nodes in the BDD. Includes reclaimed nodes whose
+  // indices are held in 'free_nodes_'.
   std::vector<BddNode> nodes_;
 
+  // Indices of reclaimed nodes which may be reused for new nodes.
+  std::vector<BddNodeIndex> free_nodes_;
+
   // A map from BDD node content (variable id, high child, low child) to the
   // index of the respective node. This map is used to ensure that no duplicate
   // nodes are created.
   using NodeKey = std::tuple<BddVariable, BddNodeIndex, BddNodeIndex>;
   absl::flat_hash_map<NodeKey, BddNodeIndex> node_map_;
 
-  // A map from if-then-else expression to the node corresponding to that
-  // expression. The key elements are (condition, if-true, if-false). This map
-  // enables fast lookup for expressions.
-  using IteKey = std::tuple<BddNodeIndex, BddNodeIndex, BddNodeIndex>;
-  absl::flat_hash_map<IteKey, BddNodeIndex> ite_map_;
+  // A cache from if-then-else expression to the node corresponding to that
+  // expression. The table is direct-mapped: each expression hashes to a single
+  // slot and a new result overwrites whatever the slot held before. An entry
+  // with a negative condition is empty.
+  struct ComputedTableEntry {
+    BddNodeIndex cond = BddNodeIndex(-1);
+    BddNodeIndex if_true;
+    BddNodeIndex if_false;
+    BddNodeIndex result;
+  };
+  int64_t max_computed_table_size_;
+  std::vector<ComputedTableEntry> computed_table_;
 };
 
 }  // namespace xls
@@ -14,8 +14,12 @@
 
 #include "xls/data_structures/binary_decision_diagram.h"
 
+#include <string>
+#include <vector>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/inlined_vector.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/status/matchers.h"
@@ -85,6 +89,131 @@ TEST(BinaryDecisionDiagramTest, BddSize) {
   }
 }
 
+TEST(BinaryDecisionDiagramTest, GarbageCollect) {
+  BinaryDecisionDiagram bdd;
+  BddNodeIndex x0 = bdd.NewVariable();
+  BddNodeIndex x1 = bdd.NewVariable();
+  BddNodeIndex x2 = bdd.NewVariable();
+  BddNodeIndex x3 = bdd.NewVariable();
+
+  BddNodeIndex live = bdd.And(bdd.Or(x0, x1), x2);
+  std::string live_str = bdd.ToStringDnf(live);
+  bdd.Or(bdd.And(x0, x3), bdd.And(x1, x2));
+  bdd.Not(bdd.Or(x2, x3));
+  int64_t before_size = bdd.size();
+
+  // Everything except the live expression and the variables is reclaimed.
+  int64_t reclaimed = bdd.GarbageCollect({live});
+  EXPECT_GT(reclaimed, 0);
+  EXPECT_EQ(bdd.size(), before_size - reclaimed);
+  EXPECT_EQ(bdd.GarbageCollect({live}), 0);
+  EXPECT_EQ(bdd.ToStringDnf(live), live_str);
+  EXPECT_EQ(bdd.ToStringDnf(x3), "x3");
+  EXPECT_EQ(bdd.And(bdd.Or(x1, x0), x2), live);
+  EXPECT_THAT(bdd.Evaluate(live, {{x0, true}, {x1, false}, {x2, true}}),
+              IsOkAndHolds(true));
+
+  // Reclaimed nodes are reused and recreated expressions are correct.
+  BddNodeIndex recreated = bdd.Or(bdd.And(x0, x3), bdd.And(x1, x2));
+  EXPECT_LT(recreated.value(), before_size);
+  EXPECT_EQ(bdd.ToStringDnf(recreated),
+            "x0.x1.x2 + x0.x1.!x2.x3 + x0.!x1.x3 + !x0.x1.x2");
+
+  // Collecting with no roots retains only the variables.
+  bdd.GarbageCollect({});
+  EXPECT_EQ(bdd.size(), 2 + bdd.variable_count());
+}
+
+TEST(BinaryDecisionDiagramTest, SmallComputedTable) {
+  // Results are identical regardless of the size of the (lossy) computed
+  // table.
+  BinaryDecisionDiagram small_bdd(/*max_computed_table_size=*/2);
+  BinaryDecisionDiagram bdd;
+  std::vector<BddNodeIndex> small_vars;
+  std::vector<BddNodeIndex> vars;
+  for (int64_t i = 0; i < 8; ++i) {
+    small_vars.push_back(small_bdd.NewVariable());
+    vars.push_back(bdd.NewVariable());
+  }
+  BddNodeIndex small_expr = small_bdd.zero();
+  BddNodeIndex expr = bdd.zero();
+  for (int64_t i = 0; i < 4; ++i) {
+    small_expr = small_bdd.Or(
+        small_expr,
+        small_bdd.And(small_vars[i], small_bdd.Not(small_vars[i + 4])));
+    expr = bdd.Or(expr, bdd.And(vars[i], bdd.Not(vars[i + 4])));
+  }
+  EXPECT_EQ(small_bdd.ToStringDnf(small_expr), bdd.ToStringDnf(expr));
+  EXPECT_EQ(small_bdd.size(), bdd.size());
+  EXPECT_LT(small_bdd.GetMemoryUsageBytes(), bdd.GetMemoryUsageBytes());
+}
+
+TEST(BinaryDecisionDiagramTest, Sift) {
+  // Equality of x0..x5 and y0..y5 with all x variables ordered before the y
+  // variables requires a number of nodes exponential in the bit width.
+  BinaryDecisionDiagram bdd;
+  std::vector<BddNodeIndex> xs;
+  std::vector<BddNodeIndex> ys;
+  for (int64_t i = 0; i < 6; ++i) {
+    xs.push_back(bdd.NewVariable());
+  }
+  for (int64_t i = 0; i < 6; ++i) {
+    ys.push_back(bdd.NewVariable());
+  }
+  BddNodeIndex eq = bdd.one();
+  for (int64_t i = 0; i < 6; ++i) {
+    eq = bdd.And(eq, bdd.Not(bdd.Or(bdd.And(xs[i], bdd.Not(ys[i])),
+                                    bdd.And(bdd.Not(xs[i]), ys[i]))));
+  }
+  BddNodeIndex x0_or_y5 = bdd.Or(xs[0], ys[5]);
+
+  auto evaluate_all = [&](BddNodeIndex expr) {
+    std::vector<bool> results;
+    for (int64_t value = 0; value < (1 << 12); ++value) {
+      absl::flat_hash_map<BddNodeIndex, bool> values;
+      for (int64_t i = 0; i < 6; ++i) {
+        values[xs[i]] = (value >> i) & 1;
+        values[ys[i]] = (value >> (i + 6)) & 1;
+      }
+      results.push_back(bdd.Evaluate(expr, values).value());
+    }
+    return results;
+  };
+  std::vector<bool> eq_results = evaluate_all(eq);
+  std::vector<bool> x0_or_y5_results = evaluate_all(x0_or_y5);
+
+  bdd.GarbageCollect({eq, x0_or_y5});
+  int64_t size_before = bdd.size();
+  int64_t size_after = bdd.Sift({eq, x0_or_y5});
+  EXPECT_EQ(size_after, bdd.size());
+  EXPECT_LT(size_after, size_before / 2);
+
+  // The variable order is a permutation of the variables.
+  std::vector<bool> seen(bdd.variable_count());
+  for (int64_t level = 0; level < bdd.variable_count(); ++level) {
+    BddVariable variable = bdd.GetVariableAtLevel(level);
+    EXPECT_EQ(bdd.GetVariableLevel(variable), level);
+    EXPECT_FALSE(seen[variable.value()]);
+    seen[variable.value()] = true;
+  }
+
+  // The roots represent the same functions and the BDD remains canonical.
+  EXPECT_EQ(evaluate_all(eq), eq_results);
+  EXPECT_EQ(evaluate_all(x0_or_y5), x0_or_y5_results);
+  EXPECT_EQ(bdd.Or(ys[5], xs[0]), x0_or_y5);
+  BddNodeIndex eq_again = bdd.one();
+  for (int64_t i = 5; i >= 0; --i) {
+    eq_again = bdd.And(bdd.Not(bdd.Or(bdd.And(xs[i], bdd.Not(ys[i])),
+                                      bdd.And(bdd.Not(xs[i]), ys[i]))),
+                       eq_again);
+  }
+  EXPECT_EQ(eq_again, eq);
+
+  // In the (optimal) interleaved order each pair of variables x_i, y_i has two
+  // paths to zero and two paths to the pairs below.
+  EXPECT_EQ(bdd.path_count(eq), 190);
+}
+
 TEST(BinaryDecisionDiagramTest, ToString) {
   BinaryDecisionDiagram bdd;
   BddNodeIndex x0 = bdd.NewVariable();
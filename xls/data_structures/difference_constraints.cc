@@ -0,0 +1,300 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/data_structures/difference_constraints.h"
+
+#include <deque>
+#include <limits>
+#include <queue>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/status_macros.h"
+
+namespace xls {
+namespace sdc {
+namespace {
+
+constexpr int64_t kInfinity = std::numeric_limits<int64_t>::max() / 4;
+
+// A residual graph for computing a minimum-cost flow.
+class FlowNetwork {
+ public:
+  explicit FlowNetwork(int64_t node_count) : arcs_(node_count) {}
+
+  // Adds an arc (and its zero-capacity reverse arc) to the network.
+  void AddArc(int64_t from, int64_t to, int64_t capacity, int64_t cost) {
+    arcs_[from].push_back(
+        Arc{to, static_cast<int64_t>(arcs_[to].size()), capacity, cost});
+    arcs_[to].push_back(
+        Arc{from, static_cast<int64_t>(arcs_[from].size()) - 1, 0, -cost});
+  }
+
+  // Computes a minimum-cost flow from `source` to `sink` of maximum value and
+  // returns the value of the flow. Upon return, potentials() holds node
+  // potentials under which every arc of the residual graph has a non-negative
+  // reduced cost. Returns an error if the network contains a negative-cost
+  // cycle.
+  absl::StatusOr<int64_t> MinCostMaxFlow(int64_t source, int64_t sink);
+
+  const std::vector<int64_t>& potentials() const { return potentials_; }
+
+ private:
+  struct Arc {
+    int64_t to;
+    // Index of the reverse arc in arcs_[to].
+    int64_t reverse;
+    int64_t capacity;
+    int64_t cost;
+  };
+
+  // Initializes the potentials to shortest-path distances from a virtual node
+  // connected to every node with a zero-cost arc. Uses the queue-based
+  // Bellman-Ford algorithm because arc costs may be negative.
+  absl::Status InitializePotentials();
+
+  int64_t node_count() const { return arcs_.size(); }
+
+  std::vector<std::vector<Arc>> arcs_;
+  std::vector<int64_t> potentials_;
+};
+
+absl::Status FlowNetwork::InitializePotentials() {
+  potentials_.assign(node_count(), 0);
+  std::vector<int64_t> enqueue_count(node_count(), 1);
+  std::vector<bool> in_queue(node_count(), true);
+  std::deque<int64_t> queue;
+  for (int64_t i = 0; i < node_count(); ++i) {
+    queue.push_back(i);
+  }
+  while (!queue.empty()) {
+    int64_t u = queue.front();
+    queue.pop_front();
+    in_queue[u] = false;
+    for (const Arc& arc : arcs_[u]) {
+      if (arc.capacity <= 0 ||
+          potentials_[u] + arc.cost >= potentials_[arc.to]) {
+        continue;
+      }
+      potentials_[arc.to] = potentials_[u] + arc.cost;
+      if (!in_queue[arc.to]) {
+        // A node relaxed more than node_count() times indicates a negative
+        // cycle.
+        if (++enqueue_count[arc.to] > node_count()) {
+          return absl::InvalidArgumentError(
+              "Difference constraints are infeasible.");
+        }
+        in_queue[arc.to] = true;
+        queue.push_back(arc.to);
+      }
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<int64_t> FlowNetwork::MinCostMaxFlow(int64_t source,
+                                                    int64_t sink) {
+  XLS_RETURN_IF_ERROR(InitializePotentials());
+
+  int64_t total_flow = 0;
+  std::vector<int64_t> distance(node_count());
+  // The node and arc index through which each node was reached in the
+  // shortest path tree.
+  std::vector<std::pair<int64_t, int64_t>> parent(node_count());
+  using QueueElement = std::pair<int64_t, int64_t>;
+  while (true) {
+    // Dijkstra's algorithm on reduced costs, which are non-negative under the
+    // current potentials.
+    std::fill(distance.begin(), distance.end(), kInfinity);
+    std::priority_queue<QueueElement, std::vector<QueueElement>,
+                        std::greater<QueueElement>>
+        queue;
+    distance[source] = 0;
+    queue.push({0, source});
+    while (!queue.empty()) {
+      auto [d, u] = queue.top();
+      queue.pop();
+      if (d > distance[u]) {
+        continue;
+      }
+      for (int64_t i = 0; i < arcs_[u].size(); ++i) {
+        const Arc& arc = arcs_[u][i];
+        if (arc.capacity <= 0) {
+          continue;
+        }
+        int64_t reduced_cost =
+            arc.cost + potentials_[u] - potentials_[arc.to];
+        XLS_DCHECK_GE(reduced_cost, 0);
+        if (d + reduced_cost < distance[arc.to]) {
+          distance[arc.to] = d + reduced_cost;
+          parent[arc.to] = {u, i};
+          queue.push({distance[arc.to], arc.to});
+        }
+      }
+    }
+    if (distance[sink] == kInfinity) {
+      break;
+    }
+
+    // Capping the distance at the sink distance keeps the reduced cost of
+    // every residual arc non-negative, including arcs into nodes which were
+    // not reached.
+    for (int64_t v = 0; v < node_count(); ++v) {
+      potentials_[v] += std::min(distance[v], distance[sink]);
+    }
+
+    int64_t augment = kInfinity;
+    for (int64_t v = sink; v != source; v = parent[v].first) {
+      const Arc& arc = arcs_[parent[v].first][parent[v].second];
+      augment = std::min(augment, arc.capacity);
+    }
+    for (int64_t v = sink; v != source; v = parent[v].first) {
+      Arc& arc = arcs_[parent[v].first][parent[v].second];
+      arc.capacity -= augment;
+      arcs_[v][arc.reverse].capacity += augment;
+    }
+    total_flow += augment;
+  }
+  return total_flow;
+}
+
+}  // namespace
+
+VariableId DifferenceConstraintSystem::AddVariable(std::string name) {
+  VariableId id(objective_.size());
+  objective_.push_back(0);
+  names_.push_back(std::move(name));
+  return id;
+}
+
+void DifferenceConstraintSystem::AddObjectiveCoefficient(VariableId var,
+                                                         int64_t coefficient) {
+  objective_.at(static_cast<int64_t>(var)) += coefficient;
+}
+
+void DifferenceConstraintSystem::AddConstraint(VariableId from, VariableId to,
+                                               int64_t min_difference) {
+  XLS_CHECK_LT(static_cast<int64_t>(from), variable_count());
+  XLS_CHECK_LT(static_cast<int64_t>(to), variable_count());
+  constraints_.push_back({from, to, min_difference});
+}
+
+void DifferenceConstraintSystem::AddLowerBound(VariableId var, int64_t value) {
+  XLS_CHECK_LT(static_cast<int64_t>(var), variable_count());
+  lower_bounds_.push_back({var, value});
+}
+
+void DifferenceConstraintSystem::AddUpperBound(VariableId var, int64_t value) {
+  XLS_CHECK_LT(static_cast<int64_t>(var), variable_count());
+  upper_bounds_.push_back({var, value});
+}
+
+std::string DifferenceConstraintSystem::name(VariableId var) const {
+  const std::string& name = names_.at(static_cast<int64_t>(var));
+  if (name.empty()) {
+    return absl::StrCat("x", static_cast<int64_t>(var));
+  }
+  return name;
+}
+
+std::string DifferenceConstraintSystem::ToString() const {
+  std::vector<std::string> terms;
+  for (int64_t i = 0; i < variable_count(); ++i) {
+    if (objective_[i] != 0) {
+      terms.push_back(
+          absl::StrFormat("%d*%s", objective_[i], name(VariableId(i))));
+    }
+  }
+  std::vector<std::string> lines;
+  lines.push_back(absl::StrCat("minimize: ", absl::StrJoin(terms, " + ")));
+  for (const DifferenceConstraint& c : constraints_) {
+    lines.push_back(absl::StrFormat("  %s - %s >= %d", name(c.to),
+                                    name(c.from), c.min_difference));
+  }
+  for (const auto& [var, value] : lower_bounds_) {
+    lines.push_back(absl::StrFormat("  %s >= %d", name(var), value));
+  }
+  for (const auto& [var, value] : upper_bounds_) {
+    lines.push_back(absl::StrFormat("  %s <= %d", name(var), value));
+  }
+  return absl::StrJoin(lines, "\n");
+}
+
+absl::StatusOr<std::vector<int64_t>> MinimizeDifferenceConstraints(
+    const DifferenceConstraintSystem& system) {
+  XLS_VLOG(4) << "MinimizeDifferenceConstraints:\n" << system.ToString();
+
+  // The dual of the LP
+  //
+  //   minimize    sum_v w_v * x_v
+  //   subject to  x_j - x_i >= c_ij  for each constraint (i, j)
+  //
+  // is a minimum-cost flow problem with an uncapacitated arc i->j of cost
+  // -c_ij for each constraint and a demand of w_v at each node v. Constant
+  // bounds are expressed relative to an additional reference variable which
+  // is fixed at zero. The reference variable absorbs the sum of the objective
+  // coefficients so supply and demand balance.
+  const int64_t n = system.variable_count();
+  const int64_t reference = n;
+  const int64_t source = n + 1;
+  const int64_t sink = n + 2;
+  FlowNetwork network(n + 3);
+  for (const DifferenceConstraint& c : system.constraints()) {
+    network.AddArc(static_cast<int64_t>(c.from), static_cast<int64_t>(c.to),
+                   kInfinity, -c.min_difference);
+  }
+  for (const auto& [var, value] : system.lower_bounds()) {
+    network.AddArc(reference, static_cast<int64_t>(var), kInfinity, -value);
+  }
+  for (const auto& [var, value] : system.upper_bounds()) {
+    network.AddArc(static_cast<int64_t>(var), reference, kInfinity, value);
+  }
+  int64_t coefficient_sum = 0;
+  int64_t total_supply = 0;
+  auto add_demand = [&](int64_t node, int64_t demand) {
+    if (demand > 0) {
+      network.AddArc(node, sink, demand, 0);
+    } else if (demand < 0) {
+      network.AddArc(source, node, -demand, 0);
+      total_supply += -demand;
+    }
+  };
+  for (int64_t v = 0; v < n; ++v) {
+    int64_t coefficient = system.objective_coefficient(VariableId(v));
+    add_demand(v, coefficient);
+    coefficient_sum += coefficient;
+  }
+  add_demand(reference, -coefficient_sum);
+
+  XLS_ASSIGN_OR_RETURN(int64_t flow, network.MinCostMaxFlow(source, sink));
+  if (flow != total_supply) {
+    return absl::InvalidArgumentError(
+        "Difference constraint objective is unbounded.");
+  }
+
+  // By complementary slackness the negated node potentials are an optimal
+  // assignment. Normalize the assignment so the reference variable is zero.
+  const std::vector<int64_t>& potentials = network.potentials();
+  std::vector<int64_t> solution(n);
+  for (int64_t v = 0; v < n; ++v) {
+    solution[v] = potentials[reference] - potentials[v];
+  }
+  return solution;
+}
+
+}  // namespace sdc
+}  // namespace xls
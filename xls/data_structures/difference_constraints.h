@@ -0,0 +1,104 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_DATA_STRUCTURES_DIFFERENCE_CONSTRAINTS_H_
+#define XLS_DATA_STRUCTURES_DIFFERENCE_CONSTRAINTS_H_
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "xls/common/strong_int.h"
+
+namespace xls {
+namespace sdc {
+
+DEFINE_STRONG_INT_TYPE(VariableId, int32_t);
+
+// A constraint of the form: x[to] - x[from] >= min_difference.
+struct DifferenceConstraint {
+  VariableId from;
+  VariableId to;
+  int64_t min_difference;
+};
+
+// A system of difference constraints (SDC) over integer variables with a
+// linear objective to minimize. Because the constraint matrix of a system of
+// difference constraints is totally unimodular, the LP relaxation always has an
+// integral optimum so the system can be solved exactly without branching.
+class DifferenceConstraintSystem {
+ public:
+  // Adds a variable to the system and returns its unique id. Variable ids are
+  // numbered sequentially from zero. The optional name is used only for
+  // generating the ToString output.
+  VariableId AddVariable(std::string name = "");
+
+  // Adds the given value to the coefficient of the variable in the objective
+  // function (which is minimized).
+  void AddObjectiveCoefficient(VariableId var, int64_t coefficient);
+
+  // Adds the constraint: x[to] - x[from] >= min_difference.
+  void AddConstraint(VariableId from, VariableId to, int64_t min_difference);
+
+  // Adds the constraint: x[var] >= value.
+  void AddLowerBound(VariableId var, int64_t value);
+
+  // Adds the constraint: x[var] <= value.
+  void AddUpperBound(VariableId var, int64_t value);
+
+  int64_t variable_count() const { return objective_.size(); }
+  int64_t objective_coefficient(VariableId var) const {
+    return objective_.at(static_cast<int64_t>(var));
+  }
+  const std::vector<DifferenceConstraint>& constraints() const {
+    return constraints_;
+  }
+
+  // Returns the constant-bound constraints as pairs of (variable, bound).
+  const std::vector<std::pair<VariableId, int64_t>>& lower_bounds() const {
+    return lower_bounds_;
+  }
+  const std::vector<std::pair<VariableId, int64_t>>& upper_bounds() const {
+    return upper_bounds_;
+  }
+
+  std::string name(VariableId var) const;
+  std::string ToString() const;
+
+ private:
+  std::vector<int64_t> objective_;
+  std::vector<std::string> names_;
+  std::vector<DifferenceConstraint> constraints_;
+  std::vector<std::pair<VariableId, int64_t>> lower_bounds_;
+  std::vector<std::pair<VariableId, int64_t>> upper_bounds_;
+};
+
+// Returns an assignment of the variables of the system (indexed by VariableId)
+// which satisfies all constraints and minimizes the objective. The problem is
+// solved through its dual which is a minimum-cost flow problem: each
+// constraint becomes an uncapacitated arc and each objective coefficient a
+// supply or demand. The flow problem is solved by successive shortest paths
+// with Dijkstra's algorithm on reduced costs, and the optimal assignment is
+// read off the final node potentials.
+//
+// Returns an InvalidArgument error if the constraints are infeasible or the
+// objective is unbounded below.
+absl::StatusOr<std::vector<int64_t>> MinimizeDifferenceConstraints(
+    const DifferenceConstraintSystem& system);
+
+}  // namespace sdc
+}  // namespace xls
+
+#endif  // XLS_DATA_STRUCTURES_DIFFERENCE_CONSTRAINTS_H_
@@ -0,0 +1,205 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/data_structures/difference_constraints.h"
+
+#include <random>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/random/random.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "xls/common/status/matchers.h"
+
+namespace xls {
+namespace sdc {
+namespace {
+
+using status_testing::StatusIs;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+
+TEST(DifferenceConstraintsTest, SingleConstraint) {
+  // minimize x1 - x0 subject to x1 - x0 >= 3, x0 >= 2.
+  DifferenceConstraintSystem system;
+  VariableId x0 = system.AddVariable("x0");
+  VariableId x1 = system.AddVariable("x1");
+  system.AddObjectiveCoefficient(x0, -1);
+  system.AddObjectiveCoefficient(x1, 1);
+  system.AddConstraint(x0, x1, 3);
+  system.AddLowerBound(x0, 2);
+  system.AddUpperBound(x0, 2);
+  XLS_ASSERT_OK_AND_ASSIGN(std::vector<int64_t> solution,
+                           MinimizeDifferenceConstraints(system));
+  EXPECT_THAT(solution, ElementsAre(2, 5));
+}
+
+TEST(DifferenceConstraintsTest, Bounds) {
+  // minimize x - y subject to 5 <= x, y <= 7.
+  DifferenceConstraintSystem system;
+  VariableId x = system.AddVariable("x");
+  VariableId y = system.AddVariable("y");
+  system.AddObjectiveCoefficient(x, 1);
+  system.AddObjectiveCoefficient(y, -1);
+  system.AddLowerBound(x, 5);
+  system.AddUpperBound(y, 7);
+  XLS_ASSERT_OK_AND_ASSIGN(std::vector<int64_t> solution,
+                           MinimizeDifferenceConstraints(system));
+  EXPECT_THAT(solution, ElementsAre(5, 7));
+}
+
+TEST(DifferenceConstraintsTest, Infeasible) {
+  DifferenceConstraintSystem system;
+  VariableId x = system.AddVariable();
+  VariableId y = system.AddVariable();
+  system.AddConstraint(x, y, 1);
+  system.AddConstraint(y, x, 0);
+  EXPECT_THAT(MinimizeDifferenceConstraints(system).status(),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("infeasible")));
+}
+
+TEST(DifferenceConstraintsTest, InfeasibleBounds) {
+  DifferenceConstraintSystem system;
+  VariableId x = system.AddVariable();
+  system.AddLowerBound(x, 3);
+  system.AddUpperBound(x, 2);
+  EXPECT_THAT(MinimizeDifferenceConstraints(system).status(),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("infeasible")));
+}
+
+TEST(DifferenceConstraintsTest, Unbounded) {
+  DifferenceConstraintSystem system;
+  VariableId x = system.AddVariable();
+  VariableId y = system.AddVariable();
+  system.AddObjectiveCoefficient(x, -1);
+  system.AddConstraint(y, x, 1);
+  system.AddLowerBound(y, 0);
+  EXPECT_THAT(MinimizeDifferenceConstraints(system).status(),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("unbounded")));
+}
+
+TEST(DifferenceConstraintsTest, Lifetimes) {
+  // A value produced at s_a and consumed at s_b and s_c. The lifetime end
+  // variable e must be at least each consumer. With s_c pinned late the
+  // cheapest schedule moves the producer as late as possible.
+  DifferenceConstraintSystem system;
+  VariableId s_a = system.AddVariable("s_a");
+  VariableId s_b = system.AddVariable("s_b");
+  VariableId s_c = system.AddVariable("s_c");
+  VariableId e = system.AddVariable("e");
+  for (VariableId v : {s_a, s_b, s_c}) {
+    system.AddLowerBound(v, 0);
+    system.AddUpperBound(v, 4);
+  }
+  system.AddConstraint(s_a, s_b, 0);
+  system.AddConstraint(s_a, s_c, 1);
+  system.AddConstraint(s_a, e, 0);
+  system.AddConstraint(s_b, e, 0);
+  system.AddConstraint(s_c, e, 0);
+  system.AddLowerBound(s_c, 4);
+  system.AddObjectiveCoefficient(e, 8);
+  system.AddObjectiveCoefficient(s_a, -8);
+  XLS_ASSERT_OK_AND_ASSIGN(std::vector<int64_t> solution,
+                           MinimizeDifferenceConstraints(system));
+  EXPECT_EQ(solution[3] - solution[0], 1);
+  EXPECT_EQ(solution[0], 3);
+  EXPECT_EQ(solution[2], 4);
+}
+
+// Returns the objective value of the given assignment or nullopt if the
+// assignment violates a constraint.
+absl::optional<int64_t> Evaluate(const DifferenceConstraintSystem& system,
+                                 absl::Span<const int64_t> x) {
+  for (const DifferenceConstraint& c : system.constraints()) {
+    if (x[static_cast<int64_t>(c.to)] - x[static_cast<int64_t>(c.from)] <
+        c.min_difference) {
+      return absl::nullopt;
+    }
+  }
+  for (const auto& [var, value] : system.lower_bounds()) {
+    if (x[static_cast<int64_t>(var)] < value) {
+      return absl::nullopt;
+    }
+  }
+  for (const auto& [var, value] : system.upper_bounds()) {
+    if (x[static_cast<int64_t>(var)] > value) {
+      return absl::nullopt;
+    }
+  }
+  int64_t objective = 0;
+  for (int64_t i = 0; i < x.size(); ++i) {
+    objective += system.objective_coefficient(VariableId(i)) * x[i];
+  }
+  return objective;
+}
+
+TEST(DifferenceConstraintsTest, RandomSystemsAgainstExhaustiveSearch) {
+  constexpr int64_t kVariableCount = 4;
+  constexpr int64_t kMaxValue = 3;
+  std::mt19937 bitgen(42);
+  for (int64_t trial = 0; trial < 200; ++trial) {
+    DifferenceConstraintSystem system;
+    for (int64_t i = 0; i < kVariableCount; ++i) {
+      VariableId v = system.AddVariable();
+      system.AddLowerBound(v, 0);
+      system.AddUpperBound(v, kMaxValue);
+      system.AddObjectiveCoefficient(v,
+                                     absl::Uniform<int64_t>(bitgen, -5, 6));
+    }
+    int64_t constraint_count = absl::Uniform<int64_t>(bitgen, 0, 6);
+    for (int64_t i = 0; i < constraint_count; ++i) {
+      system.AddConstraint(
+          VariableId(absl::Uniform<int32_t>(bitgen, 0, kVariableCount)),
+          VariableId(absl::Uniform<int32_t>(bitgen, 0, kVariableCount)),
+          absl::Uniform<int64_t>(bitgen, -2, 3));
+    }
+
+    // Exhaustively enumerate all assignments.
+    absl::optional<int64_t> best;
+    std::vector<int64_t> x(kVariableCount, 0);
+    while (true) {
+      absl::optional<int64_t> value = Evaluate(system, x);
+      if (value.has_value() && (!best.has_value() || *value < *best)) {
+        best = value;
+      }
+      int64_t i = 0;
+      while (i < kVariableCount && x[i] == kMaxValue) {
+        x[i++] = 0;
+      }
+      if (i == kVariableCount) {
+        break;
+      }
+      ++x[i];
+    }
+
+    absl::StatusOr<std::vector<int64_t>> solution =
+        MinimizeDifferenceConstraints(system);
+    if (!best.has_value()) {
+      EXPECT_THAT(solution.status(),
+                  StatusIs(absl::StatusCode::kInvalidArgument))
+          << system.ToString();
+      continue;
+    }
+    XLS_ASSERT_OK(solution.status()) << system.ToString();
+    EXPECT_EQ(Evaluate(system, *solution), best) << system.ToString();
+  }
+}
+
+}  // namespace
+}  // namespace sdc
+}  // namespace xls
@@ -26,7 +26,10 @@ namespace xls {
 
 absl::StatusOr<std::vector<CriticalPathEntry>> AnalyzeCriticalPath(
     FunctionBase* f, absl::optional<int64_t> clock_period_ps,
-    const DelayEstimator& delay_estimator) {
+    const DelayEstimator& uncached_delay_estimator) {
+  // Delays of the nodes on the critical path are queried again when building
+  // the result.
+  CachingDelayEstimator delay_estimator(uncached_delay_estimator);
   absl::flat_hash_map<Node*, std::pair<int64_t, bool>> node_to_output_delay;
 
   auto get_max_operands_delay = [&](Node* node) {
@@ -24,6 +24,80 @@
 
 namespace xls {
 
+/*static*/ CachingDelayEstimator::OperandKey
+CachingDelayEstimator::GetOperandKey(Node* operand) {
+  OperandKey key{operand->GetType(), std::nullopt};
+  if (operand->Is<Literal>()) {
+    key.literal_value = operand->As<Literal>()->value();
+  }
+  return key;
+}
+
+/*static*/ bool CachingDelayEstimator::IsValid(const CacheEntry& entry,
+                                               Node* node) {
+  if (entry.node_id != node->id() || entry.op != node->op() ||
+      entry.type != node->GetType() ||
+      entry.operands.size() != node->operand_count()) {
+    return false;
+  }
+  for (int64_t i = 0; i < node->operand_count(); ++i) {
+    const OperandKey& key = entry.operands[i];
+    Node* operand = node->operand(i);
+    if (key.type != operand->GetType() ||
+        key.literal_value.has_value() != operand->Is<Literal>()) {
+      return false;
+    }
+    if (key.literal_value.has_value() &&
+        *key.literal_value != operand->As<Literal>()->value()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+absl::StatusOr<int64_t> CachingDelayEstimator::GetOperationDelayInPs(
+    Node* node) const {
+  {
+    absl::MutexLock lock(&mutex_);
+    auto it = cache_.find(node);
+    if (it != cache_.end() && IsValid(it->second, node)) {
+      ++hit_count_;
+      return it->second.delay;
+    }
+    ++miss_count_;
+  }
+  // Query the underlying estimator without holding the lock so concurrent
+  // lookups of different nodes are not serialized. Errors are not cached.
+  XLS_ASSIGN_OR_RETURN(int64_t delay, delegate_.GetOperationDelayInPs(node));
+  CacheEntry entry{node->id(), node->op(), node->GetType(), {}, delay};
+  for (Node* operand : node->operands()) {
+    entry.operands.push_back(GetOperandKey(operand));
+  }
+  absl::MutexLock lock(&mutex_);
+  cache_.insert_or_assign(node, std::move(entry));
+  return delay;
+}
+
+void CachingDelayEstimator::Invalidate(Node* node) {
+  absl::MutexLock lock(&mutex_);
+  cache_.erase(node);
+}
+
+void CachingDelayEstimator::Clear() {
+  absl::MutexLock lock(&mutex_);
+  cache_.clear();
+}
+
+int64_t CachingDelayEstimator::hit_count() const {
+  absl::MutexLock lock(&mutex_);
+  return hit_count_;
+}
+
+int64_t CachingDelayEstimator::miss_count() const {
+  absl::MutexLock lock(&mutex_);
+  return miss_count_;
+}
+
 DelayEstimatorManager& GetDelayEstimatorManagerSingleton() {
   static DelayEstimatorManager* manager = new DelayEstimatorManager;
   return *manager;
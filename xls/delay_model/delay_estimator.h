@@ -16,12 +16,17 @@
 #define XLS_DELAY_MODEL_DELAY_ESTIMATOR_H_
 
 #include <cstdint>
+#include <optional>
 
+#include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/inlined_vector.h"
 #include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/ir/node.h"
+#include "xls/ir/value.h"
 
 namespace xls {
 
@@ -40,6 +45,68 @@ class DelayEstimator {
                                                            int64_t tau_in_ps);
 };
 
+// A decorator which memoizes the delays returned by another DelayEstimator
+// keyed by node. Cached delays are revalidated against the node's id, op,
+// type, and operand types on each lookup, so an entry is recomputed if the node
+// was modified (e.g., its operands replaced) or if a new node was allocated at
+// the address of a removed one. The values of literal operands are part of the
+// key as well because estimators may special-case constant operands (e.g., a
+// shift by a constant amount is just wiring). Thread-safe if the underlying
+// estimator is.
+//
+// Example usage:
+//
+//   CachingDelayEstimator caching_estimator(delay_estimator);
+//   XLS_ASSIGN_OR_RETURN(PipelineSchedule schedule,
+//                        PipelineSchedule::Run(f, caching_estimator, options));
+class CachingDelayEstimator : public DelayEstimator {
+ public:
+  explicit CachingDelayEstimator(const DelayEstimator& delegate)
+      : delegate_(delegate) {}
+
+  absl::StatusOr<int64_t> GetOperationDelayInPs(Node* node) const override;
+
+  // Drops the cached delay of the given node.
+  void Invalidate(Node* node);
+
+  // Drops all cached delays.
+  void Clear();
+
+  // Returns the number of lookups which were answered from the cache and the
+  // number which required calling the underlying estimator.
+  int64_t hit_count() const;
+  int64_t miss_count() const;
+
+  const DelayEstimator& delegate() const { return delegate_; }
+
+ private:
+  struct OperandKey {
+    Type* type;
+    // Value of the operand if it is a literal.
+    std::optional<Value> literal_value;
+  };
+  struct CacheEntry {
+    int64_t node_id;
+    Op op;
+    Type* type;
+    absl::InlinedVector<OperandKey, 4> operands;
+    int64_t delay;
+  };
+
+  // Returns the key under which the given operand is recorded in an entry.
+  static OperandKey GetOperandKey(Node* operand);
+
+  // Returns true if the entry was computed for the node in its current form.
+  static bool IsValid(const CacheEntry& entry, Node* node);
+
+  const DelayEstimator& delegate_;
+  mutable absl::Mutex mutex_;
+  mutable absl::flat_hash_map<Node*, CacheEntry> cache_
+      ABSL_GUARDED_BY(mutex_);
+  mutable int64_t hit_count_ ABSL_GUARDED_BY(mutex_) = 0;
+  mutable int64_t miss_count_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
 enum class DelayEstimatorPrecedence {
   kLow = 1,
   kMedium = 2,
@@ -22,6 +22,7 @@
 #include "xls/delay_model/delay_estimators.h"
 #include "xls/ir/function_builder.h"
 #include "xls/ir/ir_test_base.h"
+#include "xls/ir/nodes.h"
 
 namespace xls {
 namespace {
@@ -103,5 +104,89 @@ TEST_F(DelayEstimatorTest, LogicalEffortForXors) {
   }
 }
 
+// A test delay estimator which returns the total bit count of the non-literal
+// operands of a node plus the values of its literal operands, and counts the
+// number of queries.
+class OperandWidthDelayEstimator : public DelayEstimator {
+ public:
+  absl::StatusOr<int64_t> GetOperationDelayInPs(Node* node) const override {
+    ++query_count_;
+    int64_t delay = 0;
+    for (Node* operand : node->operands()) {
+      if (operand->Is<Literal>()) {
+        XLS_ASSIGN_OR_RETURN(
+            uint64_t value,
+            operand->As<Literal>()->value().bits().ToUint64());
+        delay += value;
+      } else {
+        delay += operand->BitCountOrDie();
+      }
+    }
+    return delay;
+  }
+
+  int64_t query_count() const { return query_count_; }
+
+ private:
+  mutable int64_t query_count_ = 0;
+};
+
+TEST_F(DelayEstimatorTest, CachingDelayEstimator) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  BValue y = fb.Param("y", p->GetBitsType(16));
+  BValue ext = fb.ZeroExtend(x, 32);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.BuildWithReturnValue(ext));
+
+  OperandWidthDelayEstimator uncached;
+  CachingDelayEstimator cached(uncached);
+  EXPECT_THAT(cached.GetOperationDelayInPs(ext.node()), IsOkAndHolds(8));
+  EXPECT_THAT(cached.GetOperationDelayInPs(ext.node()), IsOkAndHolds(8));
+  EXPECT_EQ(uncached.query_count(), 1);
+  EXPECT_EQ(cached.hit_count(), 1);
+  EXPECT_EQ(cached.miss_count(), 1);
+
+  // Changing the operand changes the operand types so the cached delay is
+  // stale.
+  XLS_ASSERT_OK(ext.node()->ReplaceOperandNumber(0, y.node(),
+                                                /*type_must_match=*/false));
+  EXPECT_THAT(cached.GetOperationDelayInPs(ext.node()), IsOkAndHolds(16));
+  EXPECT_EQ(uncached.query_count(), 2);
+
+  cached.Invalidate(ext.node());
+  EXPECT_THAT(cached.GetOperationDelayInPs(ext.node()), IsOkAndHolds(16));
+  EXPECT_EQ(uncached.query_count(), 3);
+
+  cached.Clear();
+  EXPECT_THAT(cached.GetOperationDelayInPs(f->return_value()),
+              IsOkAndHolds(16));
+  EXPECT_EQ(uncached.query_count(), 4);
+}
+
+TEST_F(DelayEstimatorTest, CachingDelayEstimatorLiteralOperands) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  BValue three = fb.Literal(UBits(3, 8));
+  BValue five = fb.Literal(UBits(5, 8));
+  BValue shift = fb.Shll(x, three);
+  XLS_ASSERT_OK(fb.BuildWithReturnValue(fb.Tuple({shift, five})).status());
+
+  OperandWidthDelayEstimator uncached;
+  CachingDelayEstimator cached(uncached);
+  EXPECT_THAT(cached.GetOperationDelayInPs(shift.node()), IsOkAndHolds(11));
+  EXPECT_THAT(cached.GetOperationDelayInPs(shift.node()), IsOkAndHolds(11));
+  EXPECT_EQ(uncached.query_count(), 1);
+
+  // Replacing a literal operand with a literal of the same type but a
+  // different value must not return the stale delay.
+  XLS_ASSERT_OK(shift.node()->ReplaceOperandNumber(1, five.node()));
+  EXPECT_THAT(cached.GetOperationDelayInPs(shift.node()), IsOkAndHolds(13));
+  EXPECT_EQ(uncached.query_count(), 2);
+  EXPECT_THAT(cached.GetOperationDelayInPs(shift.node()), IsOkAndHolds(13));
+  EXPECT_EQ(uncached.query_count(), 2);
+}
+
 }  // namespace
 }  // namespace xls
@@ -205,7 +205,9 @@ class DelayHeap {
   // The set of nodes on the frontier of the heap.
   FrontierSet frontier_;
 
-  const DelayEstimator& delay_estimator_;
+  // Nodes are typically probed with CriticalPathDelayAfterAdding before being
+  // added so delays are memoized.
+  CachingDelayEstimator delay_estimator_;
 
   // A map from node in the heap to the longest path length value for the node.
   absl::flat_hash_map<Node*, PathLength> path_lengths_;
@@ -405,6 +405,9 @@ class SampleRunner:
         CODEGEN_MAIN_PATH, '--output_signature_path=module_sig.textproto',
         '--delay_model=unit'
     ]
+    if options.simulator == 'native':
+      # The native simulator evaluates the block rather than the Verilog.
+      args.append('--output_block_ir_path=module_block.ir')
     args.extend(codegen_args)
     args.append(ir_filename)
     verilog_text = self._run_command('Generating Verilog', args, options)
@@ -421,6 +424,8 @@ class SampleRunner:
     ]
     if options.simulator:
       simulator_args.append('--verilog_simulator=' + options.simulator)
+    if options.simulator == 'native':
+      simulator_args.append('--block_ir_path=module_block.ir')
     simulator_args.append(verilog_filename)
 
     check_simulator.check_simulator(options.simulator)
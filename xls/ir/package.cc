@@ -261,6 +261,7 @@ absl::StatusOr<Type*> Package::MapTypeFromOtherPackage(
 }
 
 BitsType* Package::GetBitsType(int64_t bit_count) {
+  absl::MutexLock lock(&types_mutex_);
   if (bit_count_to_type_.find(bit_count) != bit_count_to_type_.end()) {
     return &bit_count_to_type_.at(bit_count);
   }
@@ -272,10 +273,11 @@ BitsType* Package::GetBitsType(int64_t bit_count) {
 
 ArrayType* Package::GetArrayType(int64_t size, Type* element_type) {
   ArrayKey key{size, element_type};
+  absl::MutexLock lock(&types_mutex_);
   if (array_types_.find(key) != array_types_.end()) {
     return &array_types_.at(key);
   }
-  XLS_CHECK(IsOwnedType(element_type))
+  XLS_CHECK(IsOwnedTypeLocked(element_type))
       << "Type is not owned by package: " << *element_type;
   auto it = array_types_.emplace(key, ArrayType(size, element_type));
   ArrayType* new_type = &(it.first->second);
@@ -285,11 +287,12 @@ ArrayType* Package::GetArrayType(int64_t size, Type* element_type) {
 
 TupleType* Package::GetTupleType(absl::Span<Type* const> element_types) {
   TypeVec key(element_types.begin(), element_types.end());
+  absl::MutexLock lock(&types_mutex_);
   if (tuple_types_.find(key) != tuple_types_.end()) {
     return &tuple_types_.at(key);
   }
   for (const Type* element_type : element_types) {
-    XLS_CHECK(IsOwnedType(element_type))
+    XLS_CHECK(IsOwnedTypeLocked(element_type))
         << "Type is not owned by package: " << *element_type;
   }
   auto it = tuple_types_.emplace(key, TupleType(element_types));
@@ -303,11 +306,12 @@ TokenType* Package::GetTokenType() { return &token_type_; }
 FunctionType* Package::GetFunctionType(absl::Span<Type* const> args_types,
                                        Type* return_type) {
   std::string key = FunctionType(args_types, return_type).ToString();
+  absl::MutexLock lock(&types_mutex_);
   if (function_types_.find(key) != function_types_.end()) {
     return &function_types_.at(key);
   }
   for (Type* t : args_types) {
-    XLS_CHECK(IsOwnedType(t))
+    XLS_CHECK(IsOwnedTypeLocked(t))
         << "Parameter type is not owned by package: " << t->ToString();
   }
   auto it = function_types_.emplace(key, FunctionType(args_types, return_type));
@@ -412,7 +416,7 @@ Fileno Package::GetOrCreateFileno(absl::string_view filename) {
 
 int64_t Package::GetNodeCount() const {
   int64_t count = 0;
-  for (const auto& f : functions()) {
+  for (FunctionBase* f : GetFunctionBases()) {
     count += f->node_count();
   }
   return count;
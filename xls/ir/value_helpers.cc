@@ -21,7 +21,6 @@
 #include "xls/ir/type.h"
 
 namespace xls {
-namespace {
 
 Value ValueOfType(Type* type,
                   const std::function<Bits(int64_t bit_count)>& fbits) {
@@ -49,8 +48,6 @@ Value ValueOfType(Type* type,
   XLS_LOG(FATAL) << "Invalid kind: " << type->kind();
 }
 
-}  // namespace
-
 Value ZeroOfType(Type* type) {
   return ValueOfType(type, [](int64_t bit_count) {
     return UBits(0, /*bit_count=*/bit_count);
@@ -15,6 +15,9 @@
 #ifndef XLS_IR_VALUE_HELPERS_H_
 #define XLS_IR_VALUE_HELPERS_H_
 
+#include <cstdint>
+#include <functional>
+
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "xls/common/logging/logging.h"
@@ -23,6 +26,11 @@
 
 namespace xls {
 
+// Returns a value of the given type whose Bits leaves are produced by calling
+// "fbits" with the leaf's bit count.
+Value ValueOfType(Type* type,
+                  const std::function<Bits(int64_t bit_count)>& fbits);
+
 // Returns a zero value for the given type.
 //
 // Note that for composite values (tuples / arrays) all member values are zero.
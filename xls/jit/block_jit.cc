@@ -0,0 +1,203 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/jit/block_jit.h"
+
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/types/span.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/node_iterator.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/package.h"
+#include "xls/ir/value_helpers.h"
+
+namespace xls {
+namespace {
+
+// Returns the next state of the register written by `reg_write`, given the
+// translations of its operands and of the register's current value.
+absl::StatusOr<Node*> NextRegisterState(
+    RegisterWrite* reg_write, Node* current,
+    const absl::flat_hash_map<Node*, Node*>& node_map, Function* f) {
+  Node* next = node_map.at(reg_write->data());
+  if (reg_write->load_enable().has_value()) {
+    std::vector<Node*> cases = {current, next};
+    XLS_ASSIGN_OR_RETURN(
+        next, f->MakeNode<Select>(reg_write->loc(),
+                                  node_map.at(*reg_write->load_enable()),
+                                  cases, /*default_value=*/absl::nullopt));
+  }
+  if (reg_write->reset().has_value()) {
+    const Reset& reset = reg_write->GetRegister()->reset().value();
+    Node* reset_active = node_map.at(*reg_write->reset());
+    if (reset.active_low) {
+      XLS_ASSIGN_OR_RETURN(reset_active, f->MakeNode<UnOp>(reg_write->loc(),
+                                                           reset_active,
+                                                           Op::kNot));
+    }
+    XLS_ASSIGN_OR_RETURN(
+        Node * reset_value,
+        f->MakeNode<Literal>(reg_write->loc(), reset.reset_value));
+    std::vector<Node*> cases = {next, reset_value};
+    XLS_ASSIGN_OR_RETURN(
+        next, f->MakeNode<Select>(reg_write->loc(), reset_active, cases,
+                                  /*default_value=*/absl::nullopt));
+  }
+  return next;
+}
+
+// Builds into `f`, which may belong to a different package than the block,
+// the function computing one cycle of the block. The function's parameters are
+// the input ports followed by the registers' current values, and it returns a
+// tuple of the output port values followed by the registers' next values.
+absl::Status BuildCycleFunction(Block* block, Function* f) {
+  Package* package = f->package();
+  absl::flat_hash_map<Node*, Node*> node_map;
+  for (InputPort* port : block->GetInputPorts()) {
+    XLS_ASSIGN_OR_RETURN(Type * type,
+                         package->MapTypeFromOtherPackage(port->GetType()));
+    XLS_ASSIGN_OR_RETURN(
+        node_map[port],
+        f->MakeNodeWithName<Param>(port->loc(), port->GetName(), type));
+  }
+  absl::flat_hash_map<Register*, Node*> current_state;
+  for (Register* reg : block->GetRegisters()) {
+    XLS_ASSIGN_OR_RETURN(RegisterRead * reg_read, block->GetRegisterRead(reg));
+    XLS_ASSIGN_OR_RETURN(Type * type,
+                         package->MapTypeFromOtherPackage(reg->type()));
+    XLS_ASSIGN_OR_RETURN(
+        current_state[reg],
+        f->MakeNodeWithName<Param>(reg_read->loc(), reg_read->GetName(),
+                                   type));
+    node_map[reg_read] = current_state[reg];
+  }
+
+  absl::flat_hash_map<Register*, Node*> next_state;
+  for (Node* node : TopoSort(block)) {
+    if (node_map.contains(node) || node->Is<OutputPort>()) {
+      continue;
+    }
+    if (node->Is<InstantiationInput>() || node->Is<InstantiationOutput>()) {
+      return absl::UnimplementedError(absl::StrFormat(
+          "Cannot compile block %s: instantiations are not supported",
+          block->name()));
+    }
+    if (node->OpIn({Op::kInvoke, Op::kMap, Op::kCountedFor,
+                    Op::kDynamicCountedFor})) {
+      return absl::UnimplementedError(absl::StrFormat(
+          "Cannot compile block %s: function calls are not supported",
+          block->name()));
+    }
+    if (node->Is<RegisterWrite>()) {
+      RegisterWrite* reg_write = node->As<RegisterWrite>();
+      Register* reg = reg_write->GetRegister();
+      XLS_ASSIGN_OR_RETURN(next_state[reg],
+                           NextRegisterState(reg_write, current_state.at(reg),
+                                             node_map, f));
+      continue;
+    }
+    std::vector<Node*> new_operands;
+    for (Node* operand : node->operands()) {
+      new_operands.push_back(node_map.at(operand));
+    }
+    XLS_ASSIGN_OR_RETURN(node_map[node],
+                         node->CloneInNewFunction(new_operands, f));
+  }
+
+  std::vector<Node*> elements;
+  for (OutputPort* port : block->GetOutputPorts()) {
+    elements.push_back(node_map.at(port->operand(0)));
+  }
+  for (Register* reg : block->GetRegisters()) {
+    auto it = next_state.find(reg);
+    elements.push_back(it == next_state.end() ? current_state.at(reg)
+                                              : it->second);
+  }
+  XLS_ASSIGN_OR_RETURN(Node * result,
+                       f->MakeNode<Tuple>(absl::nullopt, elements));
+  return f->set_return_value(result);
+}
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<BlockJit>> BlockJit::Create(Block* block) {
+  auto package = std::make_unique<Package>(block->package()->name());
+  Function* function = package->AddFunction(std::make_unique<Function>(
+      absl::StrCat("__", block->name(), "_cycle"), package.get()));
+  XLS_RETURN_IF_ERROR(BuildCycleFunction(block, function));
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<IrJit> jit, IrJit::Create(function));
+  return absl::WrapUnique(
+      new BlockJit(block, std::move(package), function, std::move(jit)));
+}
+
+absl::StatusOr<BlockJit::CycleResult> BlockJit::RunOneCycle(
+    const absl::flat_hash_map<std::string, Value>& inputs,
+    const RegisterState& reg_state) {
+  if (inputs.size() != block_->GetInputPorts().size()) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Expected %d inputs, got %d",
+                        block_->GetInputPorts().size(), inputs.size()));
+  }
+  if (reg_state.size() != block_->GetRegisters().size()) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Expected %d register values, got %d",
+                        block_->GetRegisters().size(), reg_state.size()));
+  }
+  std::vector<Value> args;
+  args.reserve(function_->params().size());
+  for (InputPort* port : block_->GetInputPorts()) {
+    auto it = inputs.find(port->GetName());
+    if (it == inputs.end()) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Missing input for port '%s'", port->GetName()));
+    }
+    args.push_back(it->second);
+  }
+  for (Register* reg : block_->GetRegisters()) {
+    auto it = reg_state.find(reg->name());
+    if (it == reg_state.end()) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Missing value for register '%s'", reg->name()));
+    }
+    args.push_back(it->second);
+  }
+
+  XLS_ASSIGN_OR_RETURN(InterpreterResult<Value> result, jit_->Run(args));
+  CycleResult cycle;
+  absl::Span<const Value> elements = result.value.elements();
+  int64_t index = 0;
+  for (OutputPort* port : block_->GetOutputPorts()) {
+    cycle.outputs[port->GetName()] = elements[index++];
+  }
+  for (Register* reg : block_->GetRegisters()) {
+    cycle.reg_state[reg->name()] = elements[index++];
+  }
+  cycle.events = std::move(result.events);
+  return cycle;
+}
+
+BlockJit::RegisterState BlockJit::InitialRegisterState() const {
+  RegisterState reg_state;
+  for (Register* reg : block_->GetRegisters()) {
+    reg_state[reg->name()] = ZeroOfType(reg->type());
+  }
+  return reg_state;
+}
+
+}  // namespace xls
@@ -0,0 +1,85 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_JIT_BLOCK_JIT_H_
+#define XLS_JIT_BLOCK_JIT_H_
+
+#include <memory>
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "xls/ir/block.h"
+#include "xls/ir/events.h"
+#include "xls/ir/function.h"
+#include "xls/ir/package.h"
+#include "xls/ir/value.h"
+#include "xls/jit/ir_jit.h"
+
+namespace xls {
+
+// Compiles a block for cycle-by-cycle evaluation on the host. The block's
+// logic is lowered to a function which maps the values of the input ports and
+// the current register state to the values of the output ports and the next
+// register state; that function is then compiled with the IrJit. The function
+// lives in a package owned by the BlockJit, so the block's package is left
+// untouched and several BlockJits may be created from it concurrently.
+// Register semantics (load enables and resets) match those of
+// InterpretSequentialBlock. Blocks which instantiate other blocks or call
+// functions are not supported.
+class BlockJit {
+ public:
+  static absl::StatusOr<std::unique_ptr<BlockJit>> Create(Block* block);
+
+  // Values of the registers, keyed by register name.
+  using RegisterState = absl::flat_hash_map<std::string, Value>;
+
+  struct CycleResult {
+    // Values of the output ports, keyed by port name.
+    absl::flat_hash_map<std::string, Value> outputs;
+    // Register state after the clock edge ending the cycle.
+    RegisterState reg_state;
+    InterpreterEvents events;
+  };
+
+  // Evaluates one cycle of the block. `inputs` must hold a value for each
+  // input port and `reg_state` a value for each register.
+  absl::StatusOr<CycleResult> RunOneCycle(
+      const absl::flat_hash_map<std::string, Value>& inputs,
+      const RegisterState& reg_state);
+
+  // Returns the register state with every register zero, the initial state
+  // used by the block interpreter.
+  RegisterState InitialRegisterState() const;
+
+  Block* block() const { return block_; }
+
+ private:
+  BlockJit(Block* block, std::unique_ptr<Package> package, Function* function,
+           std::unique_ptr<IrJit> jit)
+      : block_(block),
+        package_(std::move(package)),
+        function_(function),
+        jit_(std::move(jit)) {}
+
+  Block* block_;
+  // Holds the cycle function; declared before jit_ so it outlives it.
+  std::unique_ptr<Package> package_;
+  Function* function_;
+  std::unique_ptr<IrJit> jit_;
+};
+
+}  // namespace xls
+
+#endif  // XLS_JIT_BLOCK_JIT_H_
@@ -0,0 +1,135 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/jit/block_jit.h"
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "xls/common/status/matchers.h"
+#include "xls/interpreter/block_interpreter.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_test_base.h"
+
+namespace xls {
+namespace {
+
+using status_testing::StatusIs;
+using testing::HasSubstr;
+using testing::Pair;
+using testing::UnorderedElementsAre;
+
+class BlockJitTest : public IrTestBase {};
+
+TEST_F(BlockJitTest, SumAndDifferenceBlock) {
+  auto package = CreatePackage();
+  BlockBuilder b(TestName(), package.get());
+  BValue x = b.InputPort("x", package->GetBitsType(32));
+  BValue y = b.InputPort("y", package->GetBitsType(32));
+  b.OutputPort("sum", b.Add(x, y));
+  b.OutputPort("diff", b.Subtract(x, y));
+  XLS_ASSERT_OK_AND_ASSIGN(Block * block, b.Build());
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<BlockJit> jit,
+                           BlockJit::Create(block));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      BlockJit::CycleResult result,
+      jit->RunOneCycle(
+          {{"x", Value(UBits(42, 32))}, {"y", Value(UBits(10, 32))}},
+          jit->InitialRegisterState()));
+  EXPECT_THAT(result.outputs,
+              UnorderedElementsAre(Pair("sum", Value(UBits(52, 32))),
+                                   Pair("diff", Value(UBits(32, 32)))));
+  EXPECT_TRUE(result.reg_state.empty());
+
+  EXPECT_THAT(jit->RunOneCycle({{"x", Value(UBits(42, 32))},
+                                {"z", Value(UBits(10, 32))}},
+                               jit->InitialRegisterState()),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Missing input for port 'y'")));
+}
+
+TEST_F(BlockJitTest, RegisterWithResetAndLoadEnable) {
+  auto package = CreatePackage();
+  BlockBuilder b(TestName(), package.get());
+  XLS_ASSERT_OK(b.block()->AddClockPort("clk"));
+
+  BValue x = b.InputPort("x", package->GetBitsType(32));
+  BValue rst_n = b.InputPort("rst_n", package->GetBitsType(1));
+  BValue le = b.InputPort("le", package->GetBitsType(1));
+
+  BValue x_d =
+      b.InsertRegister("x_d", x, rst_n,
+                       Reset{Value(UBits(42, 32)), /*asynchronous=*/false,
+                             /*active_low=*/true},
+                       le);
+  BValue accum_d = b.InsertRegister("accum_d", b.Add(x, x_d));
+
+  b.OutputPort("out", x_d);
+  b.OutputPort("accum", accum_d);
+
+  XLS_ASSERT_OK_AND_ASSIGN(Block * block, b.Build());
+
+  std::vector<absl::flat_hash_map<std::string, Value>> inputs;
+  for (const auto& [rst_n, le, x] : std::vector<std::array<int64_t, 3>>{
+           {1, 0, 1}, {0, 0, 2}, {0, 1, 3}, {1, 1, 4}, {1, 0, 5}, {1, 1, 6}}) {
+    inputs.push_back({{"rst_n", Value(UBits(rst_n, 1))},
+                      {"le", Value(UBits(le, 1))},
+                      {"x", Value(UBits(x, 32))}});
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(auto expected,
+                           InterpretSequentialBlock(block, inputs));
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<BlockJit> jit,
+                           BlockJit::Create(block));
+  BlockJit::RegisterState reg_state = jit->InitialRegisterState();
+  for (int64_t i = 0; i < inputs.size(); ++i) {
+    XLS_ASSERT_OK_AND_ASSIGN(BlockJit::CycleResult result,
+                             jit->RunOneCycle(inputs[i], reg_state));
+    EXPECT_EQ(result.outputs, expected[i]) << "cycle " << i;
+    reg_state = std::move(result.reg_state);
+  }
+}
+
+TEST_F(BlockJitTest, BlockPackageIsUnchanged) {
+  auto package = CreatePackage();
+  BlockBuilder b(TestName(), package.get());
+  BValue x = b.InputPort("x", package->GetBitsType(32));
+  b.OutputPort("out", b.Add(x, b.Literal(Value(UBits(123, 32)))));
+  XLS_ASSERT_OK_AND_ASSIGN(Block * block, b.Build());
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<BlockJit> jit1,
+                           BlockJit::Create(block));
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<BlockJit> jit2,
+                           BlockJit::Create(block));
+  EXPECT_TRUE(package->functions().empty());
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      BlockJit::CycleResult result1,
+      jit1->RunOneCycle({{"x", Value(UBits(1, 32))}},
+                        jit1->InitialRegisterState()));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      BlockJit::CycleResult result2,
+      jit2->RunOneCycle({{"x", Value(UBits(2, 32))}},
+                        jit2->InitialRegisterState()));
+  EXPECT_EQ(result1.outputs.at("out"), Value(UBits(124, 32)));
+  EXPECT_EQ(result2.outputs.at("out"), Value(UBits(125, 32)));
+}
+
+}  // namespace
+}  // namespace xls
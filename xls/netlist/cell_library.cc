@@ -305,6 +305,12 @@ absl::StatusOr<bool> StateTable::GetSignalValue(
         }
       }
 
+      // "No change" holds the current value of the signal, if it's known.
+      if (response_signal == StateTableSignal::kNoChange &&
+          input_stimulus.contains(signal)) {
+        return input_stimulus.at(signal);
+      }
+
       return response_signal == StateTableSignal::kHigh;
     }
   }
@@ -366,8 +372,13 @@ absl::StatusOr<StateTableProto> StateTable::ToProto() const {
                          StateTable::FromProto(proto.state_table()));
   }
 
+  absl::optional<std::string> clock_name;
+  if (proto.has_clock_name()) {
+    clock_name = proto.clock_name();
+  }
+
   return CellLibraryEntry(cell_kind, proto.name(), proto.input_names(), pins,
-                          state_table);
+                          state_table, clock_name);
 }
 
 absl::StatusOr<CellLibraryEntryProto> CellLibraryEntry::ToProto() const {
@@ -413,6 +424,9 @@ absl::StatusOr<CellLibraryEntryProto> CellLibraryEntry::ToProto() const {
     pin_proto->set_name(kv.first);
     pin_proto->set_function(kv.second);
   }
+  if (clock_name_.has_value()) {
+    proto.set_clock_name(clock_name_.value());
+  }
   return proto;
 }
 
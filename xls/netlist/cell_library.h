@@ -79,7 +79,8 @@ H AbslHashValue(H state, const OutputPin& p) {
 // "H - - : - : N"; this indicates that the value of the internal signal ("D")
 // is unchanged by that stimulus...but the next state value depends on state not
 // captured here. To model that, a StateTable should be wrapped in a stateful
-// class (not implemented here).
+// class which presents the current values of the internal signals as part of
+// the stimulus (see SequentialSimulator).
 class StateTable {
  public:
   // InputStimulus provides one input for evaluation to the table.
@@ -92,7 +93,8 @@ class StateTable {
   static StateTable FromLutMask(uint16_t lut_mask);
 
   // Gets the value of the given signal when the table is presented with the
-  // specified stimulus.
+  // specified stimulus. If the matching row leaves the signal unchanged ("N"),
+  // the signal's value in the stimulus is returned (false if it is absent).
   // return true/false
   absl::StatusOr<bool> GetSignalValue(const InputStimulus& stimulus,
                                       absl::string_view signal) const;
@@ -0,0 +1,122 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/netlist/cell_library_cache.h"
+
+#include <memory>
+#include <system_error>
+
+#include "absl/status/status.h"
+#include "absl/strings/escaping.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/file/memory_mapped_file.h"
+#include "xls/common/file/temp_file.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/netlist/function_extractor.h"
+#include "xls/netlist/lib_parser.h"
+#include "openssl/sha.h"
+
+namespace xls {
+namespace netlist {
+namespace {
+
+// Mixed into every key; bump this whenever the extraction logic changes in a
+// way that alters the produced protos, so that older entries are ignored.
+constexpr absl::string_view kCacheFormatVersion = "xls-cell-library-cache-1";
+
+// Writes the proto to a temporary file and renames it into place, so that
+// concurrent readers (or writers) of the same entry never observe a partial
+// proto.
+absl::Status WriteCacheEntry(const CellLibraryProto& proto,
+                             const std::filesystem::path& cache_dir,
+                             const std::filesystem::path& cache_path) {
+  XLS_RETURN_IF_ERROR(RecursivelyCreateDir(cache_dir));
+  XLS_ASSIGN_OR_RETURN(TempFile temp_file,
+                       TempFile::CreateWithContentInDirectory(
+                           proto.SerializeAsString(), cache_dir, ".tmp"));
+  std::error_code error;
+  std::filesystem::rename(temp_file.path(), cache_path, error);
+  if (error) {
+    return absl::InternalError(
+        absl::StrCat("Failed to rename ", temp_file.path().string(), " to ",
+                     cache_path.string(), ": ", error.message()));
+  }
+  std::move(temp_file).Release();
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+absl::StatusOr<std::string> GetCellLibraryCacheKey(
+    const std::filesystem::path& liberty_path) {
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<MemoryMappedFile> file,
+                       MemoryMappedFile::Open(liberty_path));
+  absl::string_view contents = file->contents();
+
+  SHA256_CTX context;
+  SHA256_Init(&context);
+  // Include the terminating NUL so the version can't run into the contents.
+  SHA256_Update(&context, kCacheFormatVersion.data(),
+                kCacheFormatVersion.size() + 1);
+  SHA256_Update(&context, contents.data(), contents.size());
+  unsigned char digest[SHA256_DIGEST_LENGTH];
+  SHA256_Final(digest, &context);
+  return absl::BytesToHexString(absl::string_view(
+      reinterpret_cast<const char*>(digest), SHA256_DIGEST_LENGTH));
+}
+
+std::filesystem::path GetCellLibraryCachePath(
+    const std::filesystem::path& cache_dir, const std::string& key) {
+  return cache_dir / absl::StrCat(key, ".pb");
+}
+
+absl::StatusOr<CellLibraryProto> LoadCellLibraryProtoWithCache(
+    const std::filesystem::path& liberty_path,
+    const std::filesystem::path& cache_dir) {
+  XLS_ASSIGN_OR_RETURN(std::string key, GetCellLibraryCacheKey(liberty_path));
+  std::filesystem::path cache_path = GetCellLibraryCachePath(cache_dir, key);
+
+  CellLibraryProto proto;
+  if (FileExists(cache_path).ok()) {
+    absl::Status status = ParseProtobinFile(cache_path, &proto);
+    if (status.ok()) {
+      XLS_VLOG(1) << "Loaded cell library for " << liberty_path << " from "
+                  << cache_path;
+      return proto;
+    }
+    XLS_LOG(WARNING) << "Ignoring unreadable cell library cache entry "
+                     << cache_path << ": " << status;
+  }
+
+  XLS_VLOG(1) << "Cell library cache miss for " << liberty_path
+              << "; extracting.";
+  XLS_ASSIGN_OR_RETURN(cell_lib::CharStream stream,
+                       cell_lib::CharStream::FromPath(liberty_path.string()));
+  XLS_ASSIGN_OR_RETURN(proto, function::ExtractFunctions(&stream));
+
+  // The cache is only an accelerator: failing to populate it (e.g., because
+  // cache_dir is read-only) shouldn't fail the load.
+  absl::Status status = WriteCacheEntry(proto, cache_dir, cache_path);
+  if (!status.ok()) {
+    XLS_LOG(WARNING) << "Could not write cell library cache entry "
+                     << cache_path << ": " << status;
+  }
+  return proto;
+}
+
+}  // namespace netlist
+}  // namespace xls
@@ -0,0 +1,60 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_NETLIST_CELL_LIBRARY_CACHE_H_
+#define XLS_NETLIST_CELL_LIBRARY_CACHE_H_
+
+#include <filesystem>
+#include <string>
+
+#include "absl/status/statusor.h"
+#include "xls/netlist/netlist.pb.h"
+
+namespace xls {
+namespace netlist {
+
+// Foundry Liberty files routinely run to gigabytes, nearly all of it timing and
+// power tables that the netlist tools never look at. Extracting the cell
+// functions from such a file takes minutes, while the resulting
+// CellLibraryProto is small; these routines keep the extracted proto on disk
+// (in binary form) so that each Liberty file only has to be parsed once.
+//
+// Cache entries are keyed by a hash of the Liberty file's contents, so a
+// modified library is never served a stale entry, and copies of the same
+// library at different paths share one.
+
+// Returns the cache key for the Liberty file at the given path: a hex-encoded
+// SHA-256 of its contents (and of the cache format version).
+absl::StatusOr<std::string> GetCellLibraryCacheKey(
+    const std::filesystem::path& liberty_path);
+
+// Returns the path at which the entry for the given key is stored in
+// cache_dir.
+std::filesystem::path GetCellLibraryCachePath(
+    const std::filesystem::path& cache_dir, const std::string& key);
+
+// Returns the CellLibraryProto extracted from the Liberty file at
+// liberty_path. If cache_dir holds an entry for the file's contents, that
+// entry is loaded; otherwise the file is parsed and the result is written to
+// cache_dir (which is created if needed) for subsequent calls. Unreadable
+// entries are treated as misses and overwritten; failures to write an entry
+// are logged rather than returned.
+absl::StatusOr<CellLibraryProto> LoadCellLibraryProtoWithCache(
+    const std::filesystem::path& liberty_path,
+    const std::filesystem::path& cache_dir);
+
+}  // namespace netlist
+}  // namespace xls
+
+#endif  // XLS_NETLIST_CELL_LIBRARY_CACHE_H_
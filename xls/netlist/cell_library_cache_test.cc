@@ -0,0 +1,131 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/netlist/cell_library_cache.h"
+
+#include <filesystem>
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/file/temp_directory.h"
+#include "xls/common/status/matchers.h"
+#include "xls/netlist/netlist.pb.h"
+
+namespace xls {
+namespace netlist {
+namespace {
+
+using status_testing::IsOkAndHolds;
+using status_testing::StatusIs;
+
+constexpr const char kLibrary[] = R"(
+library (blah) {
+  cell (cell_1) {
+    pin (i0) {
+      direction: input;
+    }
+    pin (o) {
+      direction: output;
+      function: "!i0";
+      timing () {
+        related_pin: "i0";
+      }
+    }
+  }
+}
+)";
+
+TEST(CellLibraryCacheTest, PopulatesAndReusesEntry) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory temp_dir, TempDirectory::Create());
+  std::filesystem::path lib_path = temp_dir.path() / "cells.lib";
+  std::filesystem::path cache_dir = temp_dir.path() / "cache";
+  XLS_ASSERT_OK(SetFileContents(lib_path, kLibrary));
+
+  XLS_ASSERT_OK_AND_ASSIGN(CellLibraryProto proto,
+                           LoadCellLibraryProtoWithCache(lib_path, cache_dir));
+  ASSERT_EQ(proto.entries_size(), 1);
+  EXPECT_EQ(proto.entries(0).name(), "cell_1");
+  EXPECT_EQ(proto.entries(0).output_pin_list().pins(0).function(), "!i0");
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::string key, GetCellLibraryCacheKey(lib_path));
+  EXPECT_EQ(key.size(), 64);
+  std::filesystem::path cache_path = GetCellLibraryCachePath(cache_dir, key);
+  XLS_ASSERT_OK_AND_ASSIGN(std::string cached, GetFileContents(cache_path));
+  EXPECT_EQ(cached, proto.SerializeAsString());
+
+  // Doctor the entry to show that the next load is served from the cache
+  // rather than by re-parsing the library.
+  CellLibraryProto doctored = proto;
+  doctored.mutable_entries(0)->set_name("cached_cell");
+  XLS_ASSERT_OK(SetFileContents(cache_path, doctored.SerializeAsString()));
+  XLS_ASSERT_OK_AND_ASSIGN(proto,
+                           LoadCellLibraryProtoWithCache(lib_path, cache_dir));
+  ASSERT_EQ(proto.entries_size(), 1);
+  EXPECT_EQ(proto.entries(0).name(), "cached_cell");
+}
+
+TEST(CellLibraryCacheTest, KeyFollowsContents) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory temp_dir, TempDirectory::Create());
+  std::filesystem::path lib_path = temp_dir.path() / "cells.lib";
+  std::filesystem::path copy_path = temp_dir.path() / "copy.lib";
+  std::filesystem::path cache_dir = temp_dir.path() / "cache";
+  XLS_ASSERT_OK(SetFileContents(lib_path, kLibrary));
+  XLS_ASSERT_OK(SetFileContents(copy_path, kLibrary));
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::string key, GetCellLibraryCacheKey(lib_path));
+  EXPECT_THAT(GetCellLibraryCacheKey(copy_path),
+              IsOkAndHolds(key));
+
+  // A modified library must not be served the old entry.
+  XLS_ASSERT_OK(LoadCellLibraryProtoWithCache(lib_path, cache_dir).status());
+  std::string modified = kLibrary;
+  modified.replace(modified.find("cell_1"), 6, "cell_2");
+  XLS_ASSERT_OK(SetFileContents(lib_path, modified));
+  XLS_ASSERT_OK_AND_ASSIGN(std::string new_key,
+                           GetCellLibraryCacheKey(lib_path));
+  EXPECT_NE(new_key, key);
+  XLS_ASSERT_OK_AND_ASSIGN(CellLibraryProto proto,
+                           LoadCellLibraryProtoWithCache(lib_path, cache_dir));
+  EXPECT_EQ(proto.entries(0).name(), "cell_2");
+}
+
+TEST(CellLibraryCacheTest, CorruptEntryIsReplaced) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory temp_dir, TempDirectory::Create());
+  std::filesystem::path lib_path = temp_dir.path() / "cells.lib";
+  std::filesystem::path cache_dir = temp_dir.path() / "cache";
+  XLS_ASSERT_OK(SetFileContents(lib_path, kLibrary));
+  XLS_ASSERT_OK(RecursivelyCreateDir(cache_dir));
+  XLS_ASSERT_OK_AND_ASSIGN(std::string key, GetCellLibraryCacheKey(lib_path));
+  std::filesystem::path cache_path = GetCellLibraryCachePath(cache_dir, key);
+  XLS_ASSERT_OK(SetFileContents(cache_path, "\xff\xff\xff"));
+
+  XLS_ASSERT_OK_AND_ASSIGN(CellLibraryProto proto,
+                           LoadCellLibraryProtoWithCache(lib_path, cache_dir));
+  EXPECT_EQ(proto.entries(0).name(), "cell_1");
+  XLS_ASSERT_OK_AND_ASSIGN(std::string cached, GetFileContents(cache_path));
+  EXPECT_EQ(cached, proto.SerializeAsString());
+}
+
+TEST(CellLibraryCacheTest, MissingLibrary) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory temp_dir, TempDirectory::Create());
+  EXPECT_THAT(LoadCellLibraryProtoWithCache(temp_dir.path() / "missing.lib",
+                                            temp_dir.path() / "cache"),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
+}  // namespace
+}  // namespace netlist
+}  // namespace xls
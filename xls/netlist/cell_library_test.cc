@@ -150,6 +150,64 @@ TEST(CellLibraryTest, EvaluateStateTable) {
               status_testing::StatusIs(absl::StatusCode::kInvalidArgument));
 }
 
+TEST(CellLibraryTest, StateTableNoChangeHoldsValue) {
+  // A latch: IQ follows D while E is high and holds its value otherwise.
+  std::string proto_text = R"(input_names: "D"
+  input_names: "E"
+  internal_names: "IQ"
+  rows {
+    input_signals { key: "D" value: STATE_TABLE_SIGNAL_DONTCARE }
+    input_signals { key: "E" value: STATE_TABLE_SIGNAL_LOW }
+    internal_signals { key: "IQ" value: STATE_TABLE_SIGNAL_DONTCARE }
+    next_internal_signals { key: "IQ" value: STATE_TABLE_SIGNAL_NOCHANGE }
+  }
+  rows {
+    input_signals { key: "D" value: STATE_TABLE_SIGNAL_HIGH }
+    input_signals { key: "E" value: STATE_TABLE_SIGNAL_HIGH }
+    internal_signals { key: "IQ" value: STATE_TABLE_SIGNAL_DONTCARE }
+    next_internal_signals { key: "IQ" value: STATE_TABLE_SIGNAL_HIGH }
+  }
+  rows {
+    input_signals { key: "D" value: STATE_TABLE_SIGNAL_LOW }
+    input_signals { key: "E" value: STATE_TABLE_SIGNAL_HIGH }
+    internal_signals { key: "IQ" value: STATE_TABLE_SIGNAL_DONTCARE }
+    next_internal_signals { key: "IQ" value: STATE_TABLE_SIGNAL_LOW }
+  }
+  )";
+  StateTableProto proto;
+  ASSERT_TRUE(google::protobuf::TextFormat::ParseFromString(proto_text, &proto));
+  XLS_ASSERT_OK_AND_ASSIGN(StateTable table, StateTable::FromProto(proto));
+
+  StateTable::InputStimulus stimulus;
+  stimulus["D"] = true;
+  stimulus["E"] = true;
+  stimulus["IQ"] = false;
+  EXPECT_THAT(table.GetSignalValue(stimulus, "IQ"), IsOkAndHolds(true));
+
+  stimulus["D"] = false;
+  stimulus["E"] = false;
+  stimulus["IQ"] = true;
+  EXPECT_THAT(table.GetSignalValue(stimulus, "IQ"), IsOkAndHolds(true));
+  stimulus["IQ"] = false;
+  EXPECT_THAT(table.GetSignalValue(stimulus, "IQ"), IsOkAndHolds(false));
+
+  // Without the current value the signal reads as low.
+  stimulus.erase("IQ");
+  EXPECT_THAT(table.GetSignalValue(stimulus, "IQ"), IsOkAndHolds(false));
+}
+
+TEST(CellLibraryTest, ClockNameRoundTrips) {
+  CellLibraryEntry::OutputPinToFunction pins;
+  pins["Q"] = "D";
+  CellLibraryEntry entry(CellKind::kFlop, "DFF", std::vector<std::string>{"D"},
+                         pins, absl::nullopt, "CLK");
+  XLS_ASSERT_OK_AND_ASSIGN(CellLibraryEntryProto proto, entry.ToProto());
+  EXPECT_EQ(proto.clock_name(), "CLK");
+  XLS_ASSERT_OK_AND_ASSIGN(CellLibraryEntry round_tripped,
+                           CellLibraryEntry::FromProto(proto));
+  EXPECT_EQ(round_tripped.clock_name(), "CLK");
+}
+
 TEST(CellLibraryTest, LutStateTable) {
   // 4-way AND
   StateTable table = StateTable::FromLutMask(0x8000);
@@ -0,0 +1,590 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/netlist/compiled_netlist.h"
+
+#include <algorithm>
+#include <deque>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+
+namespace xls {
+namespace netlist {
+
+/* static */ absl::StatusOr<CompiledFunction> CompiledFunction::Compile(
+    const CellLibraryEntry& entry, const function::Ast& ast,
+    absl::Span<const std::string> internal_signals) {
+  CompiledFunction function;
+  XLS_RETURN_IF_ERROR(function.Append(entry, ast, internal_signals,
+                                      /*depth=*/0));
+  return function;
+}
+
+absl::Status CompiledFunction::Append(
+    const CellLibraryEntry& entry, const function::Ast& ast,
+    absl::Span<const std::string> internal_signals, int64_t depth) {
+  max_stack_depth_ = std::max(max_stack_depth_, depth + 1);
+  switch (ast.kind()) {
+    case function::Ast::Kind::kIdentifier: {
+      absl::Span<const std::string> input_names = entry.input_names();
+      auto it = std::find(input_names.begin(), input_names.end(), ast.name());
+      if (it != input_names.end()) {
+        instructions_.push_back(
+            Instruction{Op::kInput,
+                        static_cast<int32_t>(it - input_names.begin())});
+        return absl::OkStatus();
+      }
+      it = std::find(internal_signals.begin(), internal_signals.end(),
+                     ast.name());
+      if (it != internal_signals.end()) {
+        uses_internal_signals_ = true;
+        instructions_.push_back(
+            Instruction{Op::kInternal,
+                        static_cast<int32_t>(it - internal_signals.begin())});
+        return absl::OkStatus();
+      }
+      return absl::NotFoundError(
+          absl::StrFormat("Identifier \"%s\" not found in cell %s's inputs "
+                          "or internal signals.",
+                          ast.name(), entry.name()));
+    }
+    case function::Ast::Kind::kLiteralZero:
+      instructions_.push_back(Instruction{Op::kZero, 0});
+      return absl::OkStatus();
+    case function::Ast::Kind::kLiteralOne:
+      instructions_.push_back(Instruction{Op::kOne, 0});
+      return absl::OkStatus();
+    case function::Ast::Kind::kNot:
+      XLS_RETURN_IF_ERROR(
+          Append(entry, ast.children()[0], internal_signals, depth));
+      instructions_.push_back(Instruction{Op::kNot, 0});
+      return absl::OkStatus();
+    case function::Ast::Kind::kAnd:
+    case function::Ast::Kind::kOr:
+    case function::Ast::Kind::kXor: {
+      XLS_RETURN_IF_ERROR(
+          Append(entry, ast.children()[0], internal_signals, depth));
+      XLS_RETURN_IF_ERROR(
+          Append(entry, ast.children()[1], internal_signals, depth + 1));
+      Op op = ast.kind() == function::Ast::Kind::kAnd  ? Op::kAnd
+              : ast.kind() == function::Ast::Kind::kOr ? Op::kOr
+                                                       : Op::kXor;
+      instructions_.push_back(Instruction{op, 0});
+      return absl::OkStatus();
+    }
+  }
+  return absl::InvalidArgumentError(
+      absl::StrCat("Unknown AST element type: ", static_cast<int>(ast.kind())));
+}
+
+absl::StatusOr<int32_t> CompiledModule::GetNetIndex(rtl::NetRef net) const {
+  if (net->id() >= module_->nets().size() ||
+      module_->nets()[net->id()].get() != net) {
+    return absl::NotFoundError(absl::StrFormat(
+        "Net %s is not in module %s", net->name(), module_->name()));
+  }
+  return net->id();
+}
+
+template <typename T>
+std::vector<T> CompiledModule::NewState() const {
+  std::vector<T> values(net_count(), 0);
+  values[one_net_] = NetValueTraits<T>::kOne;
+  return values;
+}
+
+template <typename T>
+absl::Status CompiledModule::Evaluate(std::vector<T>* values) const {
+  return EvaluateSteps(values, /*pinned=*/nullptr);
+}
+
+template <typename T>
+absl::Status CompiledModule::EvaluateWithPinnedNets(
+    std::vector<T>* values, const std::vector<bool>& pinned) const {
+  XLS_RET_CHECK_EQ(pinned.size(), net_count());
+  return EvaluateSteps(values, &pinned);
+}
+
+template <typename T>
+absl::Status CompiledModule::EvaluateSteps(
+    std::vector<T>* values, const std::vector<bool>* pinned) const {
+  XLS_RET_CHECK_EQ(values->size(), net_count());
+  absl::Span<const T> value_span = *values;
+  std::vector<T> stack(max_stack_depth_);
+  auto store = [&](int32_t net, T value) {
+    if (pinned == nullptr || !(*pinned)[net]) {
+      (*values)[net] = value;
+    }
+  };
+  for (const Step& step : steps_) {
+    absl::Span<const int32_t> inputs =
+        absl::MakeConstSpan(input_nets_).subspan(step.input_offset,
+                                                 step.input_count);
+    switch (step.kind) {
+      case StepKind::kCell:
+        for (int32_t i = 0; i < step.output_count; ++i) {
+          store(output_nets_[step.output_offset + i],
+                output_functions_[step.output_offset + i]->Evaluate<T>(
+                    value_span, inputs, /*internals=*/{}, stack.data()));
+        }
+        break;
+      case StepKind::kStateTableCell:
+        XLS_RETURN_IF_ERROR(
+            EvaluateStateTableCell<T>(step, values, pinned, stack.data()));
+        break;
+      case StepKind::kSubmodule: {
+        std::vector<T> submodule_values = step.submodule->NewState<T>();
+        for (int32_t i = 0; i < step.input_count; ++i) {
+          submodule_values[step.submodule->module_inputs_[i]] =
+              (*values)[inputs[i]];
+        }
+        XLS_RETURN_IF_ERROR(step.submodule->Evaluate<T>(&submodule_values));
+        for (int32_t i = 0; i < step.output_count; ++i) {
+          store(output_nets_[step.output_offset + i],
+                submodule_values[step.submodule->module_outputs_[i]]);
+        }
+        break;
+      }
+      case StepKind::kAssign:
+        store(output_nets_[step.output_offset], (*values)[inputs[0]]);
+        break;
+      case StepKind::kFlop:
+        return absl::InternalError("Flops are not part of the step order");
+    }
+  }
+  return absl::OkStatus();
+}
+
+template <typename T>
+absl::Status CompiledModule::EvaluateStateTableCell(
+    const Step& step, std::vector<T>* values, const std::vector<bool>* pinned,
+    T* stack) const {
+  const CellLibraryEntry* entry = step.cell->cell_library_entry();
+  XLS_RET_CHECK(entry->state_table().has_value());
+  const StateTable& state_table = entry->state_table().value();
+  absl::Span<const int32_t> inputs =
+      absl::MakeConstSpan(input_nets_).subspan(step.input_offset,
+                                               step.input_count);
+
+  // The internal signals are indexed in the iteration order of the state
+  // table's signal set, matching CompiledNetlist::GetFunction.
+  std::vector<T> internals(state_table.internal_signals().size(), 0);
+  StateTable::InputStimulus stimulus;
+  for (int64_t lane = 0; lane < NetValueTraits<T>::kLanes; ++lane) {
+    for (int32_t i = 0; i < step.input_count; ++i) {
+      stimulus[step.cell->inputs()[i].name] =
+          ((*values)[inputs[i]] >> lane) & 1;
+    }
+    int64_t signal_index = 0;
+    for (const std::string& signal : state_table.internal_signals()) {
+      XLS_ASSIGN_OR_RETURN(bool value,
+                           state_table.GetSignalValue(stimulus, signal));
+      internals[signal_index++] |= static_cast<T>(value) << lane;
+    }
+  }
+  for (int32_t i = 0; i < step.output_count; ++i) {
+    int32_t net = output_nets_[step.output_offset + i];
+    if (pinned != nullptr && (*pinned)[net]) {
+      continue;
+    }
+    (*values)[net] = output_functions_[step.output_offset + i]->Evaluate<T>(
+        *values, inputs, internals, stack);
+  }
+  return absl::OkStatus();
+}
+
+template std::vector<uint8_t> CompiledModule::NewState<uint8_t>() const;
+template std::vector<uint64_t> CompiledModule::NewState<uint64_t>() const;
+template absl::Status CompiledModule::Evaluate<uint8_t>(
+    std::vector<uint8_t>* values) const;
+template absl::Status CompiledModule::Evaluate<uint64_t>(
+    std::vector<uint64_t>* values) const;
+template absl::Status CompiledModule::EvaluateWithPinnedNets<uint8_t>(
+    std::vector<uint8_t>* values, const std::vector<bool>& pinned) const;
+template absl::Status CompiledModule::EvaluateWithPinnedNets<uint64_t>(
+    std::vector<uint64_t>* values, const std::vector<bool>& pinned) const;
+
+absl::StatusOr<std::vector<bool>> CompiledModule::Run(
+    absl::Span<const bool> inputs) const {
+  XLS_RET_CHECK_EQ(inputs.size(), module_inputs_.size());
+  std::vector<uint8_t> values = NewState<uint8_t>();
+  for (int64_t i = 0; i < inputs.size(); ++i) {
+    values[module_inputs_[i]] = inputs[i];
+  }
+  XLS_RETURN_IF_ERROR(Evaluate(&values));
+  std::vector<bool> outputs;
+  outputs.reserve(module_outputs_.size());
+  for (int32_t net : module_outputs_) {
+    outputs.push_back(values[net]);
+  }
+  return outputs;
+}
+
+absl::StatusOr<std::vector<uint64_t>> CompiledModule::RunBatch(
+    absl::Span<const uint64_t> inputs) const {
+  XLS_RET_CHECK_EQ(inputs.size(), module_inputs_.size());
+  std::vector<uint64_t> values = NewState<uint64_t>();
+  for (int64_t i = 0; i < inputs.size(); ++i) {
+    values[module_inputs_[i]] = inputs[i];
+  }
+  XLS_RETURN_IF_ERROR(Evaluate(&values));
+  std::vector<uint64_t> outputs;
+  outputs.reserve(module_outputs_.size());
+  for (int32_t net : module_outputs_) {
+    outputs.push_back(values[net]);
+  }
+  return outputs;
+}
+
+absl::StatusOr<const CompiledModule*> CompiledNetlist::GetModule(
+    const rtl::Module* module) {
+  auto it = modules_.find(module);
+  if (it != modules_.end()) {
+    return it->second.get();
+  }
+  if (compiling_.contains(module)) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Module %s recursively instantiates itself", module->name()));
+  }
+  compiling_.insert(module);
+  absl::StatusOr<std::unique_ptr<CompiledModule>> compiled = Compile(module);
+  compiling_.erase(module);
+  XLS_RETURN_IF_ERROR(compiled.status());
+  const CompiledModule* result = compiled.value().get();
+  modules_[module] = std::move(compiled).value();
+  return result;
+}
+
+absl::StatusOr<const CompiledFunction*> CompiledNetlist::GetFunction(
+    const CellLibraryEntry* entry, const std::string& pin_name) {
+  auto& entry_functions = functions_[entry];
+  if (entry_functions.empty()) {
+    std::vector<std::string> internal_signals;
+    if (entry->state_table().has_value()) {
+      const absl::flat_hash_set<std::string>& signals =
+          entry->state_table()->internal_signals();
+      internal_signals.assign(signals.begin(), signals.end());
+    }
+    for (const auto& [pin, function_string] :
+         entry->output_pin_to_function()) {
+      XLS_ASSIGN_OR_RETURN(function::Ast ast,
+                           function::Parser::ParseFunction(function_string));
+      XLS_ASSIGN_OR_RETURN(
+          CompiledFunction function,
+          CompiledFunction::Compile(*entry, ast, internal_signals));
+      entry_functions[pin] =
+          std::make_unique<CompiledFunction>(std::move(function));
+    }
+  }
+  auto it = entry_functions.find(pin_name);
+  if (it == entry_functions.end()) {
+    return absl::NotFoundError(absl::StrFormat(
+        "Cell %s has no output pin %s", entry->name(), pin_name));
+  }
+  return it->second.get();
+}
+
+absl::StatusOr<std::unique_ptr<CompiledModule>> CompiledNetlist::Compile(
+    const rtl::Module* module) {
+  auto compiled = absl::WrapUnique(new CompiledModule(module));
+  XLS_ASSIGN_OR_RETURN(rtl::NetRef zero, module->ResolveNumber(0));
+  XLS_ASSIGN_OR_RETURN(rtl::NetRef one, module->ResolveNumber(1));
+  XLS_ASSIGN_OR_RETURN(compiled->zero_net_, compiled->GetNetIndex(zero));
+  XLS_ASSIGN_OR_RETURN(compiled->one_net_, compiled->GetNetIndex(one));
+  XLS_ASSIGN_OR_RETURN(int32_t dummy_net,
+                       compiled->GetNetIndex(module->GetDummyRef()));
+  for (rtl::NetRef input : module->inputs()) {
+    XLS_ASSIGN_OR_RETURN(int32_t index, compiled->GetNetIndex(input));
+    compiled->module_inputs_.push_back(index);
+  }
+  for (rtl::NetRef output : module->outputs()) {
+    XLS_ASSIGN_OR_RETURN(int32_t index, compiled->GetNetIndex(output));
+    compiled->module_outputs_.push_back(index);
+  }
+
+  // Gather the steps in netlist order. Each step's nets and functions are held
+  // separately until the steps are sorted by level.
+  struct PendingStep {
+    CompiledModule::StepKind kind;
+    const rtl::Cell* cell = nullptr;
+    const CompiledModule* submodule = nullptr;
+    std::vector<int32_t> inputs;
+    std::vector<int32_t> outputs;
+    std::vector<const CompiledFunction*> functions;
+  };
+  std::vector<PendingStep> pending;
+  pending.reserve(module->cells().size() + module->assigns().size());
+  std::vector<PendingStep> flops;
+  for (const std::unique_ptr<rtl::Cell>& cell : module->cells()) {
+    PendingStep step;
+    step.cell = cell.get();
+    const CellLibraryEntry* entry = cell->cell_library_entry();
+    absl::StatusOr<const rtl::Module*> child =
+        netlist_->GetModule(entry->name());
+    if (child.ok()) {
+      // The cell instantiates another module of the netlist. Map the cell's
+      // pins onto the child module's ports by name.
+      step.kind = CompiledModule::StepKind::kSubmodule;
+      XLS_ASSIGN_OR_RETURN(step.submodule, GetModule(child.value()));
+      if (!step.submodule->flops().empty()) {
+        return absl::UnimplementedError(absl::StrFormat(
+            "Cell %s of module %s instantiates module %s which contains "
+            "flops; sequential evaluation requires a flattened netlist",
+            cell->name(), module->name(), child.value()->name()));
+      }
+      for (rtl::NetRef child_input : child.value()->inputs()) {
+        auto it = std::find_if(
+            cell->inputs().begin(), cell->inputs().end(),
+            [&](const rtl::Cell::Pin& pin) {
+              return pin.name == child_input->name();
+            });
+        XLS_RET_CHECK(it != cell->inputs().end()) << absl::StrFormat(
+            "Could not find input pin \"%s\" in module \"%s\", referenced in "
+            "cell \"%s\"!",
+            child_input->name(), child.value()->name(), cell->name());
+        XLS_ASSIGN_OR_RETURN(int32_t index, compiled->GetNetIndex(it->netref));
+        step.inputs.push_back(index);
+      }
+      for (rtl::NetRef child_output : child.value()->outputs()) {
+        auto it = std::find_if(
+            cell->outputs().begin(), cell->outputs().end(),
+            [&](const rtl::Cell::Pin& pin) {
+              return pin.name == child_output->name();
+            });
+        XLS_RET_CHECK(it != cell->outputs().end()) << absl::StrFormat(
+            "Could not find cell output pin \"%s\" in cell \"%s\", referenced "
+            "in child module \"%s\"!",
+            child_output->name(), cell->name(), child.value()->name());
+        XLS_ASSIGN_OR_RETURN(int32_t index, compiled->GetNetIndex(it->netref));
+        step.outputs.push_back(index);
+      }
+    } else {
+      step.kind = CompiledModule::StepKind::kCell;
+      for (const rtl::Cell::Pin& pin : cell->inputs()) {
+        XLS_ASSIGN_OR_RETURN(int32_t index, compiled->GetNetIndex(pin.netref));
+        step.inputs.push_back(index);
+      }
+      for (const rtl::Cell::Pin& pin : cell->outputs()) {
+        XLS_ASSIGN_OR_RETURN(int32_t index, compiled->GetNetIndex(pin.netref));
+        XLS_ASSIGN_OR_RETURN(const CompiledFunction* function,
+                             GetFunction(entry, pin.name));
+        if (function->uses_internal_signals()) {
+          step.kind = CompiledModule::StepKind::kStateTableCell;
+        }
+        compiled->max_stack_depth_ =
+            std::max(compiled->max_stack_depth_, function->max_stack_depth());
+        step.outputs.push_back(index);
+        step.functions.push_back(function);
+      }
+      if (flop_mode_ == FlopMode::kSequential && cell->clock().has_value()) {
+        // The outputs of a flop whose state is held in state table internal
+        // signals must be functions of that state alone.
+        if (entry->state_table().has_value()) {
+          for (const CompiledFunction* function : step.functions) {
+            for (const CompiledFunction::Instruction& instruction :
+                 function->instructions()) {
+              if (instruction.op == CompiledFunction::Op::kInput) {
+                return absl::UnimplementedError(absl::StrFormat(
+                    "Output of flop %s depends combinationally on its inputs",
+                    cell->name()));
+              }
+            }
+          }
+        }
+        step.kind = CompiledModule::StepKind::kFlop;
+        flops.push_back(std::move(step));
+        continue;
+      }
+    }
+    pending.push_back(std::move(step));
+  }
+  // Assignments are added in net order so the evaluation order does not
+  // depend on hash map iteration order.
+  std::vector<std::pair<int32_t, int32_t>> assigns;
+  for (const auto& [lhs, rhs] : module->assigns()) {
+    XLS_ASSIGN_OR_RETURN(int32_t lhs_index, compiled->GetNetIndex(lhs));
+    XLS_ASSIGN_OR_RETURN(int32_t rhs_index, compiled->GetNetIndex(rhs));
+    assigns.push_back({lhs_index, rhs_index});
+  }
+  std::sort(assigns.begin(), assigns.end());
+  for (const auto& [lhs, rhs] : assigns) {
+    PendingStep step;
+    step.kind = CompiledModule::StepKind::kAssign;
+    step.inputs.push_back(rhs);
+    step.outputs.push_back(lhs);
+    pending.push_back(std::move(step));
+  }
+
+  // Find the step driving each net. Unused cell outputs are all connected to
+  // the dummy net which is never read.
+  constexpr int32_t kUndriven = -1;
+  const int64_t net_count = module->nets().size();
+  std::vector<int32_t> driver(net_count, kUndriven);
+  for (int32_t i = 0; i < pending.size(); ++i) {
+    for (int32_t net : pending[i].outputs) {
+      if (net == dummy_net) {
+        continue;
+      }
+      if (driver[net] != kUndriven) {
+        return absl::InvalidArgumentError(absl::StrFormat(
+            "Net %s in module %s has multiple drivers",
+            module->nets()[net]->name(), module->name()));
+      }
+      driver[net] = i;
+    }
+  }
+  std::vector<bool> is_source(net_count, false);
+  for (int32_t net : compiled->module_inputs_) {
+    is_source[net] = true;
+  }
+  is_source[compiled->zero_net_] = true;
+  is_source[compiled->one_net_] = true;
+  for (const PendingStep& flop : flops) {
+    for (int32_t net : flop.outputs) {
+      if (net == dummy_net) {
+        continue;
+      }
+      if (driver[net] != kUndriven || is_source[net]) {
+        return absl::InvalidArgumentError(absl::StrFormat(
+            "Net %s in module %s has multiple drivers",
+            module->nets()[net]->name(), module->name()));
+      }
+      is_source[net] = true;
+    }
+  }
+  for (const PendingStep& flop : flops) {
+    for (int32_t net : flop.inputs) {
+      if (driver[net] == kUndriven && !is_source[net]) {
+        return absl::InvalidArgumentError(absl::StrFormat(
+            "Netlist contains unconnected subgraphs and cannot be translated. "
+            "Example: cell %s, input %s.",
+            flop.cell->name(), module->nets()[net]->name()));
+      }
+    }
+  }
+
+  // Levelize with Kahn's algorithm. `readers` holds, for each net, the steps
+  // which read the net.
+  std::vector<std::vector<int32_t>> readers(net_count);
+  std::vector<int32_t> unsatisfied(pending.size(), 0);
+  for (int32_t i = 0; i < pending.size(); ++i) {
+    for (int32_t net : pending[i].inputs) {
+      if (driver[net] != kUndriven) {
+        readers[net].push_back(i);
+        ++unsatisfied[i];
+      } else if (!is_source[net]) {
+        return absl::InvalidArgumentError(absl::StrFormat(
+            "Netlist contains unconnected subgraphs and cannot be translated. "
+            "Example: cell %s, input %s.",
+            pending[i].cell == nullptr ? module->nets()[pending[i].outputs[0]]
+                                             ->name()
+                                       : pending[i].cell->name(),
+            module->nets()[net]->name()));
+      }
+    }
+  }
+  std::vector<int32_t> level(pending.size(), 0);
+  std::deque<int32_t> ready;
+  for (int32_t i = 0; i < pending.size(); ++i) {
+    if (unsatisfied[i] == 0) {
+      ready.push_back(i);
+    }
+  }
+  int64_t processed = 0;
+  int32_t max_level = -1;
+  while (!ready.empty()) {
+    int32_t i = ready.front();
+    ready.pop_front();
+    ++processed;
+    max_level = std::max(max_level, level[i]);
+    for (int32_t net : pending[i].outputs) {
+      if (net == dummy_net) {
+        continue;
+      }
+      for (int32_t reader : readers[net]) {
+        level[reader] = std::max(level[reader], level[i] + 1);
+        if (--unsatisfied[reader] == 0) {
+          ready.push_back(reader);
+        }
+      }
+    }
+  }
+  if (processed != pending.size()) {
+    for (int32_t i = 0; i < pending.size(); ++i) {
+      if (unsatisfied[i] != 0 && pending[i].cell != nullptr) {
+        return absl::InvalidArgumentError(absl::StrFormat(
+            "Module %s contains a combinational cycle through cell %s",
+            module->name(), pending[i].cell->name()));
+      }
+    }
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Module %s contains a combinational cycle", module->name()));
+  }
+  compiled->level_count_ = max_level + 1;
+
+  // Lay out the steps level by level in flat arrays. The sort is stable so
+  // steps within a level keep their netlist order.
+  std::vector<int32_t> order(pending.size());
+  for (int32_t i = 0; i < pending.size(); ++i) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(), [&](int32_t a, int32_t b) {
+    return level[a] < level[b];
+  });
+  auto add_step = [&](const PendingStep& step, int32_t step_level,
+                      std::vector<CompiledModule::Step>* steps) {
+    steps->push_back(CompiledModule::Step{
+        .kind = step.kind,
+        .cell = step.cell,
+        .submodule = step.submodule,
+        .input_offset = static_cast<int32_t>(compiled->input_nets_.size()),
+        .input_count = static_cast<int32_t>(step.inputs.size()),
+        .output_offset = static_cast<int32_t>(compiled->output_nets_.size()),
+        .output_count = static_cast<int32_t>(step.outputs.size()),
+        .level = step_level});
+    compiled->input_nets_.insert(compiled->input_nets_.end(),
+                                 step.inputs.begin(), step.inputs.end());
+    compiled->output_nets_.insert(compiled->output_nets_.end(),
+                                  step.outputs.begin(), step.outputs.end());
+    if (step.functions.empty()) {
+      compiled->output_functions_.insert(compiled->output_functions_.end(),
+                                         step.outputs.size(), nullptr);
+    } else {
+      compiled->output_functions_.insert(compiled->output_functions_.end(),
+                                         step.functions.begin(),
+                                         step.functions.end());
+    }
+  };
+  compiled->steps_.reserve(pending.size());
+  for (int32_t i : order) {
+    add_step(pending[i], level[i], &compiled->steps_);
+  }
+  compiled->flops_.reserve(flops.size());
+  for (const PendingStep& flop : flops) {
+    add_step(flop, compiled->level_count_, &compiled->flops_);
+  }
+  XLS_VLOG(2) << absl::StreamFormat(
+      "Compiled module %s: %d nets, %d steps, %d levels, %d flops",
+      module->name(), net_count, compiled->steps_.size(),
+      compiled->level_count_, compiled->flops_.size());
+  return compiled;
+}
+
+}  // namespace netlist
+}  // namespace xls
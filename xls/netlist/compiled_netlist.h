@@ -0,0 +1,343 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Compiled representation of netlist modules for fast evaluation. Cell
+// functions are parsed once per cell library entry into postfix programs and
+// each module is levelized into flat arrays of evaluation steps over dense net
+// indices.
+
+#ifndef XLS_NETLIST_COMPILED_NETLIST_H_
+#define XLS_NETLIST_COMPILED_NETLIST_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "xls/netlist/cell_library.h"
+#include "xls/netlist/function_parser.h"
+#include "xls/netlist/netlist.h"
+
+namespace xls {
+namespace netlist {
+
+// Traits of the types which hold net values during evaluation. A uint8_t holds
+// a single value (zero or one). A uint64_t holds the values of 64 independent
+// evaluations, one per bit, so a single pass over a module evaluates 64 input
+// vectors with bitwise word operations.
+template <typename T>
+struct NetValueTraits;
+
+template <>
+struct NetValueTraits<uint8_t> {
+  static constexpr int64_t kLanes = 1;
+  static constexpr uint8_t kOne = 1;
+};
+
+template <>
+struct NetValueTraits<uint64_t> {
+  static constexpr int64_t kLanes = 64;
+  static constexpr uint64_t kOne = ~uint64_t{0};
+};
+
+// A cell output pin function (e.g., "(A * B)'") compiled to a postfix program.
+// Identifiers are resolved to indices of the cell's input pins (in the order
+// of CellLibraryEntry::input_names(), which is also the order of
+// rtl::Cell::inputs()) or of the state table internal signals of the entry.
+class CompiledFunction {
+ public:
+  enum class Op : uint8_t {
+    kInput,
+    kInternal,
+    kZero,
+    kOne,
+    kAnd,
+    kOr,
+    kXor,
+    kNot,
+  };
+
+  struct Instruction {
+    Op op;
+    // Index of the input pin (kInput) or internal signal (kInternal).
+    int32_t operand;
+  };
+
+  // Compiles the given function AST of a pin of `entry`. `internal_signals`
+  // holds the names of the state table internal signals which may be referred
+  // to by the function.
+  static absl::StatusOr<CompiledFunction> Compile(
+      const CellLibraryEntry& entry, const function::Ast& ast,
+      absl::Span<const std::string> internal_signals);
+
+  // Evaluates the program. The value of input pin i is values[input_nets[i]]
+  // and the value of internal signal i is internals[i]. `stack` is scratch
+  // space which must hold at least max_stack_depth() elements. T is one of the
+  // types with NetValueTraits.
+  template <typename T>
+  T Evaluate(absl::Span<const T> values, absl::Span<const int32_t> input_nets,
+             absl::Span<const T> internals, T* stack) const;
+
+  absl::Span<const Instruction> instructions() const { return instructions_; }
+  int64_t max_stack_depth() const { return max_stack_depth_; }
+
+  // Returns true if the function refers to a state table internal signal.
+  bool uses_internal_signals() const { return uses_internal_signals_; }
+
+ private:
+  // Appends the postfix program of the given AST. `depth` is the stack depth
+  // before the program of the AST is executed.
+  absl::Status Append(const CellLibraryEntry& entry, const function::Ast& ast,
+                      absl::Span<const std::string> internal_signals,
+                      int64_t depth);
+
+  std::vector<Instruction> instructions_;
+  int64_t max_stack_depth_ = 0;
+  bool uses_internal_signals_ = false;
+};
+
+template <typename T>
+T CompiledFunction::Evaluate(absl::Span<const T> values,
+                             absl::Span<const int32_t> input_nets,
+                             absl::Span<const T> internals, T* stack) const {
+  int64_t top = 0;
+  for (const Instruction& instruction : instructions_) {
+    switch (instruction.op) {
+      case Op::kInput:
+        stack[top++] = values[input_nets[instruction.operand]];
+        break;
+      case Op::kInternal:
+        stack[top++] = internals[instruction.operand];
+        break;
+      case Op::kZero:
+        stack[top++] = 0;
+        break;
+      case Op::kOne:
+        stack[top++] = NetValueTraits<T>::kOne;
+        break;
+      case Op::kAnd:
+        --top;
+        stack[top - 1] &= stack[top];
+        break;
+      case Op::kOr:
+        --top;
+        stack[top - 1] |= stack[top];
+        break;
+      case Op::kXor:
+        --top;
+        stack[top - 1] ^= stack[top];
+        break;
+      case Op::kNot:
+        stack[top - 1] ^= NetValueTraits<T>::kOne;
+        break;
+    }
+  }
+  return stack[0];
+}
+
+class CompiledNetlist;
+
+// A levelized module. Nets are identified by dense indices (the position of the
+// net in rtl::Module::nets()) and the cells are flattened into a sequence of
+// steps ordered such that every step comes after the steps which drive its
+// inputs.
+class CompiledModule {
+ public:
+  // The kind of a step in the evaluation order.
+  enum class StepKind : uint8_t {
+    // A cell library cell whose outputs are computed by compiled functions.
+    kCell,
+    // A cell library cell with a function which refers to state table
+    // internal signals. The internal signals are computed from the state
+    // table before the functions are evaluated.
+    kStateTableCell,
+    // An instance of another module of the netlist.
+    kSubmodule,
+    // An assignment of one net to another.
+    kAssign,
+    // A clocked cell of a module compiled with FlopMode::kSequential. Flops
+    // are not steps of the evaluation order; they are listed in flops().
+    kFlop,
+  };
+
+  struct Step {
+    StepKind kind;
+    // The instantiated cell (null for kAssign).
+    const rtl::Cell* cell;
+    // The instantiated module (kSubmodule only).
+    const CompiledModule* submodule;
+    // Range of the step's input and output nets in input_nets() and
+    // output_nets(). For kSubmodule steps the inputs are in the order of the
+    // submodule's inputs and the outputs in the order of its outputs.
+    int32_t input_offset;
+    int32_t input_count;
+    int32_t output_offset;
+    int32_t output_count;
+    // Topological level of the step: one more than the maximum level of the
+    // steps driving its inputs. Steps fed only by module inputs, constants and
+    // flop outputs are at level zero. Flops are at level level_count().
+    int32_t level;
+  };
+
+  const rtl::Module* module() const { return module_; }
+  int64_t net_count() const { return module_->nets().size(); }
+  absl::Span<const Step> steps() const { return steps_; }
+  int64_t level_count() const { return level_count_; }
+
+  absl::Span<const int32_t> input_nets() const { return input_nets_; }
+  absl::Span<const int32_t> output_nets() const { return output_nets_; }
+
+  // The compiled function computing each entry of output_nets() for kCell,
+  // kStateTableCell and kFlop steps (null for other kinds of steps).
+  absl::Span<const CompiledFunction* const> output_functions() const {
+    return output_functions_;
+  }
+
+  // The clocked cells of a module compiled with FlopMode::kSequential, in
+  // netlist order. Their outputs are treated like module inputs by the
+  // evaluation order, and their inputs are read after all steps have been
+  // evaluated. Empty for modules compiled with FlopMode::kCombinational.
+  absl::Span<const Step> flops() const { return flops_; }
+
+  // Indices of the module's input and output nets in the order of
+  // rtl::Module::inputs() and rtl::Module::outputs().
+  absl::Span<const int32_t> module_inputs() const { return module_inputs_; }
+  absl::Span<const int32_t> module_outputs() const { return module_outputs_; }
+
+  // The maximum stack depth of the functions of the module's cells and flops,
+  // i.e., the scratch space required by CompiledFunction::Evaluate.
+  int64_t max_stack_depth() const { return max_stack_depth_; }
+
+  // Returns the index of the given net of the module, which is its
+  // rtl::NetDef::id().
+  absl::StatusOr<int32_t> GetNetIndex(rtl::NetRef net) const;
+
+  // Returns a vector of net values with the constant nets set and all other
+  // nets zero. T is one of the types with NetValueTraits.
+  template <typename T>
+  std::vector<T> NewState() const;
+
+  // Evaluates all steps in order. `values` is indexed by net index and must
+  // have been created by NewState() with the module inputs set. Upon return
+  // every net driven by a cell or assignment holds its value.
+  template <typename T>
+  absl::Status Evaluate(std::vector<T>* values) const;
+
+  // As Evaluate(), but nets whose entry in `pinned` (indexed by net index) is
+  // true keep the values they hold on entry instead of being recomputed from
+  // their drivers. This cuts the module at internal nets, e.g., to evaluate
+  // the logic downstream of a set of register outputs from chosen values.
+  template <typename T>
+  absl::Status EvaluateWithPinnedNets(std::vector<T>* values,
+                                      const std::vector<bool>& pinned) const;
+
+  // Evaluates the module with the given input values in the order of
+  // module_inputs() and returns the output values in the order of
+  // module_outputs().
+  absl::StatusOr<std::vector<bool>> Run(absl::Span<const bool> inputs) const;
+
+  // Evaluates the module on 64 input vectors at once. Bit i of each input
+  // and output value holds the value of the net in the i-th vector. Inputs
+  // and outputs are in the order of module_inputs() and module_outputs().
+  absl::StatusOr<std::vector<uint64_t>> RunBatch(
+      absl::Span<const uint64_t> inputs) const;
+
+ private:
+  friend class CompiledNetlist;
+
+  explicit CompiledModule(const rtl::Module* module) : module_(module) {}
+
+  // Evaluates all steps in order, skipping stores to the nets marked in
+  // `pinned` if it is non-null.
+  template <typename T>
+  absl::Status EvaluateSteps(std::vector<T>* values,
+                             const std::vector<bool>* pinned) const;
+
+  // Evaluates a cell which uses a state table. Slow path which builds the
+  // state table stimulus by pin name for each lane of T.
+  template <typename T>
+  absl::Status EvaluateStateTableCell(const Step& step, std::vector<T>* values,
+                                      const std::vector<bool>* pinned,
+                                      T* stack) const;
+
+  const rtl::Module* module_;
+  std::vector<Step> steps_;
+  std::vector<Step> flops_;
+  int64_t level_count_ = 0;
+  std::vector<int32_t> input_nets_;
+  std::vector<int32_t> output_nets_;
+  std::vector<const CompiledFunction*> output_functions_;
+  std::vector<int32_t> module_inputs_;
+  std::vector<int32_t> module_outputs_;
+  int32_t zero_net_;
+  int32_t one_net_;
+  int64_t max_stack_depth_ = 0;
+};
+
+// Compiles and owns the compiled forms of the modules of a netlist and of the
+// cell library functions they use. Modules are compiled on demand and cached,
+// so the netlist must not be modified after a module has been compiled.
+class CompiledNetlist {
+ public:
+  // How cells with a clock (see CellLibraryEntry::clock_name()) are compiled.
+  enum class FlopMode {
+    // Flops are evaluated like combinational cells: each output takes the
+    // value of its next-state function within the same evaluation.
+    kCombinational,
+    // Flop outputs hold state between evaluations. Flops are excluded from the
+    // evaluation order and listed in CompiledModule::flops() instead.
+    kSequential,
+  };
+
+  explicit CompiledNetlist(const rtl::Netlist* netlist,
+                           FlopMode flop_mode = FlopMode::kCombinational)
+      : netlist_(netlist), flop_mode_(flop_mode) {}
+
+  // Returns the compiled form of the given module of the netlist, compiling it
+  // (and the modules it instantiates) if necessary. Returns an error if the
+  // module contains combinational cycles or cells whose inputs are not driven,
+  // or if flops are compiled as state and the module instantiates a module
+  // which contains flops.
+  absl::StatusOr<const CompiledModule*> GetModule(const rtl::Module* module);
+
+ private:
+  // Returns the compiled function of the given output pin of the cell library
+  // entry, parsing and compiling the entry's functions on first use.
+  absl::StatusOr<const CompiledFunction*> GetFunction(
+      const CellLibraryEntry* entry, const std::string& pin_name);
+
+  absl::StatusOr<std::unique_ptr<CompiledModule>> Compile(
+      const rtl::Module* module);
+
+  const rtl::Netlist* netlist_;
+  FlopMode flop_mode_;
+  absl::flat_hash_map<const rtl::Module*, std::unique_ptr<CompiledModule>>
+      modules_;
+  // Modules currently being compiled, used to detect recursive instantiation.
+  absl::flat_hash_set<const rtl::Module*> compiling_;
+  absl::flat_hash_map<
+      const CellLibraryEntry*,
+      absl::flat_hash_map<std::string, std::unique_ptr<CompiledFunction>>>
+      functions_;
+};
+
+}  // namespace netlist
+}  // namespace xls
+
+#endif  // XLS_NETLIST_COMPILED_NETLIST_H_
@@ -0,0 +1,275 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/netlist/compiled_netlist.h"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "xls/common/status/matchers.h"
+#include "xls/netlist/fake_cell_library.h"
+#include "xls/netlist/function_parser.h"
+#include "xls/netlist/netlist.h"
+#include "xls/netlist/netlist_parser.h"
+
+namespace xls {
+namespace netlist {
+namespace {
+
+using status_testing::IsOkAndHolds;
+using status_testing::StatusIs;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+
+absl::StatusOr<std::unique_ptr<rtl::Netlist>> ParseNetlist(
+    CellLibrary* cell_library, const std::string& text) {
+  rtl::Scanner scanner(text);
+  return rtl::Parser::ParseNetlist(cell_library, &scanner);
+}
+
+TEST(CompiledNetlistTest, CompiledFunction) {
+  XLS_ASSERT_OK_AND_ASSIGN(CellLibrary cell_library, MakeFakeCellLibrary());
+  XLS_ASSERT_OK_AND_ASSIGN(const CellLibraryEntry* entry,
+                           cell_library.GetEntry("AOI21"));
+  XLS_ASSERT_OK_AND_ASSIGN(function::Ast ast,
+                           function::Parser::ParseFunction("!((A*B)|C)"));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      CompiledFunction function,
+      CompiledFunction::Compile(*entry, ast, /*internal_signals=*/{}));
+  EXPECT_EQ(function.instructions().size(), 6);
+  EXPECT_EQ(function.max_stack_depth(), 2);
+  EXPECT_FALSE(function.uses_internal_signals());
+
+  std::vector<uint8_t> stack(function.max_stack_depth());
+  std::vector<int32_t> input_nets = {0, 1, 2};
+  for (int64_t i = 0; i < 8; ++i) {
+    std::vector<uint8_t> values = {static_cast<uint8_t>(i & 1),
+                                   static_cast<uint8_t>((i >> 1) & 1),
+                                   static_cast<uint8_t>((i >> 2) & 1)};
+    EXPECT_EQ(function.Evaluate<uint8_t>(values, input_nets,
+                                         /*internals=*/{}, stack.data()),
+              !((values[0] && values[1]) || values[2]))
+        << "i = " << i;
+  }
+}
+
+TEST(CompiledNetlistTest, UnknownIdentifier) {
+  XLS_ASSERT_OK_AND_ASSIGN(CellLibrary cell_library, MakeFakeCellLibrary());
+  XLS_ASSERT_OK_AND_ASSIGN(const CellLibraryEntry* entry,
+                           cell_library.GetEntry("AND"));
+  XLS_ASSERT_OK_AND_ASSIGN(function::Ast ast,
+                           function::Parser::ParseFunction("A&Q"));
+  EXPECT_THAT(CompiledFunction::Compile(*entry, ast, /*internal_signals=*/{}),
+              StatusIs(absl::StatusCode::kNotFound,
+                       HasSubstr("Identifier \"Q\" not found")));
+}
+
+TEST(CompiledNetlistTest, LevelizesOutOfOrderCells) {
+  // The cells are listed in reverse topological order.
+  std::string netlist_text = R"(
+module main(i0, i1, i2, o0, o1);
+  input i0, i1, i2;
+  output o0, o1;
+  wire inv0_out, inv1_out;
+
+  AND and0 ( .A(inv1_out), .B(i2), .Z(o0) );
+  INV inv1 ( .A(inv0_out), .ZN(inv1_out) );
+  INV inv0 ( .A(i0), .ZN(inv0_out) );
+  assign o1 = i1;
+endmodule
+)";
+  XLS_ASSERT_OK_AND_ASSIGN(CellLibrary cell_library, MakeFakeCellLibrary());
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<rtl::Netlist> netlist,
+                           ParseNetlist(&cell_library, netlist_text));
+  XLS_ASSERT_OK_AND_ASSIGN(const rtl::Module* module,
+                           netlist->GetModule("main"));
+
+  CompiledNetlist compiled_netlist(netlist.get());
+  XLS_ASSERT_OK_AND_ASSIGN(const CompiledModule* compiled,
+                           compiled_netlist.GetModule(module));
+  EXPECT_EQ(compiled->level_count(), 3);
+  std::vector<std::string> cell_order;
+  for (const CompiledModule::Step& step : compiled->steps()) {
+    if (step.cell != nullptr) {
+      cell_order.push_back(step.cell->name());
+    }
+  }
+  EXPECT_THAT(cell_order, ElementsAre("inv0", "inv1", "and0"));
+
+  // Compiled modules are cached.
+  XLS_ASSERT_OK_AND_ASSIGN(const CompiledModule* compiled_again,
+                           compiled_netlist.GetModule(module));
+  EXPECT_EQ(compiled, compiled_again);
+
+  EXPECT_THAT(compiled->Run({true, false, true}),
+              IsOkAndHolds(ElementsAre(true, false)));
+  EXPECT_THAT(compiled->Run({false, true, true}),
+              IsOkAndHolds(ElementsAre(false, true)));
+  EXPECT_THAT(compiled->Run({true, true, false}),
+              IsOkAndHolds(ElementsAre(false, true)));
+}
+
+TEST(CompiledNetlistTest, RunBatchMatchesRun) {
+  std::string netlist_text = R"(
+module submodule_0 (a, b, o);
+  input a, b;
+  output o;
+
+  XOR xor0 ( .A(a), .B(b), .Z(o) );
+endmodule
+
+module main(i0, i1, i2, i3, o0, o1);
+  input i0, i1, i2, i3;
+  output o0, o1;
+  wire and0_out, and1_out, sub_out;
+
+  AND and0 ( .A(i0), .B(i1), .Z(and0_out) );
+  STATETABLE_AND and1 ( .A(i2), .B(i3), .Z(and1_out) );
+  submodule_0 sub ( .a(and0_out), .b(and1_out), .o(sub_out) );
+  INV inv0 ( .A(sub_out), .ZN(o0) );
+  OR or0 ( .A(i0), .B(i3), .Z(o1) );
+endmodule
+)";
+  XLS_ASSERT_OK_AND_ASSIGN(CellLibrary cell_library, MakeFakeCellLibrary());
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<rtl::Netlist> netlist,
+                           ParseNetlist(&cell_library, netlist_text));
+  XLS_ASSERT_OK_AND_ASSIGN(const rtl::Module* module,
+                           netlist->GetModule("main"));
+  CompiledNetlist compiled_netlist(netlist.get());
+  XLS_ASSERT_OK_AND_ASSIGN(const CompiledModule* compiled,
+                           compiled_netlist.GetModule(module));
+
+  // Lane i of input j holds bit j of i, so the 64 lanes cover every input
+  // combination several times over.
+  std::vector<uint64_t> inputs(4, 0);
+  for (int64_t lane = 0; lane < 64; ++lane) {
+    for (int64_t j = 0; j < inputs.size(); ++j) {
+      inputs[j] |= static_cast<uint64_t>((lane >> j) & 1) << lane;
+    }
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(std::vector<uint64_t> outputs,
+                           compiled->RunBatch(inputs));
+  ASSERT_EQ(outputs.size(), 2);
+  for (int64_t lane = 0; lane < 64; ++lane) {
+    std::array<bool, 4> lane_inputs;
+    for (int64_t j = 0; j < inputs.size(); ++j) {
+      lane_inputs[j] = (inputs[j] >> lane) & 1;
+    }
+    XLS_ASSERT_OK_AND_ASSIGN(std::vector<bool> expected,
+                             compiled->Run(lane_inputs));
+    for (int64_t j = 0; j < outputs.size(); ++j) {
+      EXPECT_EQ((outputs[j] >> lane) & 1, expected[j])
+          << "lane = " << lane << ", output = " << j;
+    }
+  }
+}
+
+TEST(CompiledNetlistTest, EvaluateWithPinnedNets) {
+  // The register output p0 is pinned, so o0 follows its value rather than
+  // that of i0 flowing through the flop.
+  std::string netlist_text = R"(
+module main(clk, i0, i1, o0, o1);
+  input clk, i0, i1;
+  output o0, o1;
+  wire p0;
+
+  DFF p0_reg ( .D(i0), .CLK(clk), .Q(p0) );
+  AND and0 ( .A(p0), .B(i1), .Z(o0) );
+  OR or0 ( .A(i0), .B(i1), .Z(o1) );
+endmodule
+)";
+  XLS_ASSERT_OK_AND_ASSIGN(CellLibrary cell_library, MakeFakeCellLibrary());
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<rtl::Netlist> netlist,
+                           ParseNetlist(&cell_library, netlist_text));
+  XLS_ASSERT_OK_AND_ASSIGN(const rtl::Module* module,
+                           netlist->GetModule("main"));
+  CompiledNetlist compiled_netlist(netlist.get());
+  XLS_ASSERT_OK_AND_ASSIGN(const CompiledModule* compiled,
+                           compiled_netlist.GetModule(module));
+  auto net_index = [&](const std::string& name) -> int32_t {
+    return compiled->GetNetIndex(module->ResolveNet(name).value()).value();
+  };
+
+  std::vector<bool> pinned(compiled->net_count(), false);
+  pinned[net_index("p0")] = true;
+  std::vector<uint64_t> values = compiled->NewState<uint64_t>();
+  values[net_index("i0")] = 0b0101;
+  values[net_index("i1")] = 0b0011;
+  values[net_index("p0")] = 0b1110;
+  XLS_ASSERT_OK(compiled->EvaluateWithPinnedNets(&values, pinned));
+  EXPECT_EQ(values[net_index("p0")], 0b1110);
+  EXPECT_EQ(values[net_index("o0")], 0b0010);
+  EXPECT_EQ(values[net_index("o1")], 0b0111);
+
+  // Without pinning the flop passes i0 through.
+  XLS_ASSERT_OK(compiled->Evaluate(&values));
+  EXPECT_EQ(values[net_index("p0")], 0b0101);
+  EXPECT_EQ(values[net_index("o0")], 0b0001);
+
+  EXPECT_THAT(compiled->EvaluateWithPinnedNets(&values, {true}),
+              StatusIs(absl::StatusCode::kInternal));
+}
+
+TEST(CompiledNetlistTest, CombinationalCycle) {
+  std::string netlist_text = R"(
+module main(i0, o0);
+  input i0;
+  output o0;
+  wire a, b;
+
+  AND and0 ( .A(i0), .B(b), .Z(a) );
+  INV inv0 ( .A(a), .ZN(b) );
+  INV inv1 ( .A(b), .ZN(o0) );
+endmodule
+)";
+  XLS_ASSERT_OK_AND_ASSIGN(CellLibrary cell_library, MakeFakeCellLibrary());
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<rtl::Netlist> netlist,
+                           ParseNetlist(&cell_library, netlist_text));
+  XLS_ASSERT_OK_AND_ASSIGN(const rtl::Module* module,
+                           netlist->GetModule("main"));
+  CompiledNetlist compiled_netlist(netlist.get());
+  EXPECT_THAT(compiled_netlist.GetModule(module),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("combinational cycle")));
+}
+
+TEST(CompiledNetlistTest, UndrivenCellInput) {
+  std::string netlist_text = R"(
+module main(i0, o0);
+  input i0;
+  output o0;
+  wire floating;
+
+  AND and0 ( .A(i0), .B(floating), .Z(o0) );
+endmodule
+)";
+  XLS_ASSERT_OK_AND_ASSIGN(CellLibrary cell_library, MakeFakeCellLibrary());
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<rtl::Netlist> netlist,
+                           ParseNetlist(&cell_library, netlist_text));
+  XLS_ASSERT_OK_AND_ASSIGN(const rtl::Module* module,
+                           netlist->GetModule("main"));
+  CompiledNetlist compiled_netlist(netlist.get());
+  EXPECT_THAT(compiled_netlist.GetModule(module),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("cell and0, input floating")));
+}
+
+}  // namespace
+}  // namespace netlist
+}  // namespace xls
@@ -14,6 +14,8 @@
 
 #include "xls/netlist/function_extractor.h"
 
+#include <algorithm>
+
 #include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -34,6 +36,7 @@ namespace {
 constexpr const char kDirectionKey[] = "direction";
 constexpr const char kFunctionKey[] = "function";
 constexpr const char kNextStateKey[] = "next_state";
+constexpr const char kClockedOnKey[] = "clocked_on";
 constexpr const char kStateFunctionKey[] = "state_function";
 constexpr const char kInputValue[] = "input";
 constexpr const char kOutputValue[] = "output";
@@ -222,6 +225,7 @@ absl::Status ExtractFromPin(const cell_lib::Block& pin,
 // equivalent to being the "function" of an output pin. All known FF cells have
 // a single output pin, so we check for that.
 // If so, then we replace that function with the one from the next_state field.
+// The "clocked_on" field is recorded as the clock name; see ExtractFromCell.
 absl::Status ExtractFromFf(const cell_lib::Block& ff,
                            CellLibraryEntryProto* entry_proto) {
   entry_proto->set_kind(netlist::CellKindProto::FLOP);
@@ -232,6 +236,8 @@ absl::Status ExtractFromFf(const cell_lib::Block& ff,
       XLS_RET_CHECK(entry_proto->output_pin_list().pins_size() == 1);
       entry_proto->mutable_output_pin_list()->mutable_pins(0)->set_function(
           next_state_function);
+    } else if (kv_entry && kv_entry->key == kClockedOnKey) {
+      entry_proto->set_clock_name(kv_entry->value);
     }
   }
 
@@ -261,6 +267,20 @@ absl::Status ExtractFromCell(const cell_lib::Block& cell,
     }
   }
 
+  // A flop clocked on a single input pin takes that pin as its clock; it is
+  // connected through Cell::clock() rather than as a data input. Flops clocked
+  // on an expression (e.g., "CLK'" or "CLK & EN") keep the clock as an input.
+  if (entry_proto->has_clock_name()) {
+    auto* input_names = entry_proto->mutable_input_names();
+    auto it = std::find(input_names->begin(), input_names->end(),
+                        entry_proto->clock_name());
+    if (it == input_names->end()) {
+      entry_proto->clear_clock_name();
+    } else {
+      input_names->erase(it);
+    }
+  }
+
   return absl::OkStatus();
 }
 
@@ -272,7 +292,9 @@ absl::StatusOr<CellLibraryProto> ExtractFunctions(
   absl::flat_hash_set<std::string> kind_allowlist(
       {"library", "cell", "pin", "direction", "function", "ff", "next_state",
        "statetable"});
-  cell_lib::Parser parser(&scanner);
+  // The contents of other blocks (e.g., timing and power tables, which make up
+  // the bulk of most libraries) are dropped as soon as they're parsed.
+  cell_lib::Parser parser(&scanner, std::move(kind_allowlist));
 
   XLS_ASSIGN_OR_RETURN(std::unique_ptr<cell_lib::Block> block,
                        parser.ParseLibrary());
@@ -13,7 +13,9 @@
 // limitations under the License.
 
 // Simple driver function for FunctionExtractor; preprocesses a netlist into a
-// CellLibraryProto for colocation with the original library.
+// CellLibraryProto for colocation with the original library, and/or into a
+// cell library cache directory (see cell_library_cache.h) shared by the tools
+// that accept one.
 
 #include "google/protobuf/text_format.h"
 #include "absl/flags/flag.h"
@@ -24,26 +26,39 @@
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/netlist/cell_library.h"
+#include "xls/netlist/cell_library_cache.h"
 #include "xls/netlist/function_extractor.h"
 #include "xls/netlist/netlist.pb.h"
 
 ABSL_FLAG(std::string, cell_library, "", "Cell library to preprocess.");
 ABSL_FLAG(std::string, output_path, "",
           "Path to the file in which to write the output.");
+ABSL_FLAG(std::string, cell_library_cache_dir, "",
+          "Cell library cache directory in which to store (or from which to "
+          "load) the extracted proto. At least one of this or --output_path "
+          "must be specified.");
 ABSL_FLAG(bool, output_textproto, false,
           "If true, write the output as a text-format protobuf.");
 
 namespace xls::netlist::function {
 
 absl::Status RealMain(const std::string& cell_library_path,
+                      const std::string& cache_dir,
                       const std::string& output_path, bool output_textproto) {
-  XLS_ASSIGN_OR_RETURN(std::string cell_library_text,
-                       GetFileContents(cell_library_path));
-  XLS_ASSIGN_OR_RETURN(
-      auto char_stream,
-      netlist::cell_lib::CharStream::FromText(cell_library_text));
-  XLS_ASSIGN_OR_RETURN(netlist::CellLibraryProto lib_proto,
-                       netlist::function::ExtractFunctions(&char_stream));
+  netlist::CellLibraryProto lib_proto;
+  if (!cache_dir.empty()) {
+    XLS_ASSIGN_OR_RETURN(lib_proto, netlist::LoadCellLibraryProtoWithCache(
+                                        cell_library_path, cache_dir));
+  } else {
+    XLS_ASSIGN_OR_RETURN(
+        auto char_stream,
+        netlist::cell_lib::CharStream::FromPath(cell_library_path));
+    XLS_ASSIGN_OR_RETURN(lib_proto,
+                         netlist::function::ExtractFunctions(&char_stream));
+  }
+  if (output_path.empty()) {
+    return absl::OkStatus();
+  }
 
   if (output_textproto) {
     std::string output;
@@ -61,11 +76,14 @@ int main(int argc, char* argv[]) {
   std::string cell_library_path = absl::GetFlag(FLAGS_cell_library);
   XLS_QCHECK(!cell_library_path.empty()) << "--cell_library must be specified.";
 
+  std::string cache_dir = absl::GetFlag(FLAGS_cell_library_cache_dir);
   std::string output_path = absl::GetFlag(FLAGS_output_path);
-  XLS_QCHECK(!output_path.empty()) << "--output_path must be specified.";
+  XLS_QCHECK(!output_path.empty() || !cache_dir.empty())
+      << "--output_path and/or --cell_library_cache_dir must be specified.";
 
   XLS_QCHECK_OK(xls::netlist::function::RealMain(
-      cell_library_path, output_path, absl::GetFlag(FLAGS_output_textproto)));
+      cell_library_path, cache_dir, output_path,
+      absl::GetFlag(FLAGS_output_textproto)));
 
   return 0;
 }
@@ -103,6 +103,59 @@ library (blah) {
   ASSERT_EQ(output_pin.function(), "i0|i1");
 }
 
+TEST(FunctionExtractorTest, ExtractsFlopClock) {
+  std::string lib = R"(
+library (blah) {
+  cell (cell_1) {
+    pin (d) {
+      direction: input;
+    }
+    pin (clk) {
+      direction: input;
+    }
+    pin (q) {
+      direction: output;
+      function: "iq";
+    }
+    ff (iq, iqn) {
+      next_state: "d";
+      clocked_on: "clk";
+    }
+  }
+  cell (cell_2) {
+    pin (d) {
+      direction: input;
+    }
+    pin (clk) {
+      direction: input;
+    }
+    pin (q) {
+      direction: output;
+      function: "iq";
+    }
+    ff (iq, iqn) {
+      next_state: "d";
+      clocked_on: "!clk";
+    }
+  }
+})";
+
+  XLS_ASSERT_OK_AND_ASSIGN(auto stream, cell_lib::CharStream::FromText(lib));
+  XLS_ASSERT_OK_AND_ASSIGN(CellLibraryProto proto, ExtractFunctions(&stream));
+  ASSERT_EQ(proto.entries_size(), 2);
+
+  // The clock pin is removed from the data inputs.
+  const CellLibraryEntryProto& entry = proto.entries(0);
+  EXPECT_EQ(entry.clock_name(), "clk");
+  ASSERT_EQ(entry.input_names_size(), 1);
+  EXPECT_EQ(entry.input_names(0), "d");
+
+  // A clock expression is not a pin, so the cell has no clock name.
+  const CellLibraryEntryProto& inverted_entry = proto.entries(1);
+  EXPECT_FALSE(inverted_entry.has_clock_name());
+  EXPECT_EQ(inverted_entry.input_names_size(), 2);
+}
+
 TEST(FunctionExtractorTest, HandlesStatetables) {
   std::string lib = R"(
 library (blah) {
@@ -14,22 +14,23 @@
 #ifndef XLS_NETLIST_INTERPRETER_H_
 #define XLS_NETLIST_INTERPRETER_H_
 
-#include <deque>
+#include <cstdint>
 #include <string>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
-#include "xls/ir/type.h"
-#include "xls/ir/value.h"
-#include "xls/netlist/function_parser.h"
+#include "absl/types/span.h"
+#include "xls/netlist/compiled_netlist.h"
 #include "xls/netlist/netlist.h"
 
 namespace xls {
 namespace netlist {
 
 // Interprets Netlists/Modules given a set of input values and returns the
-// resulting value.
+// resulting value. Each module is compiled (see CompiledNetlist) on first use
+// and the compiled form is reused by later calls, so the netlist must not be
+// modified after the interpreter has been used.
 class Interpreter {
  public:
   explicit Interpreter(rtl::Netlist* netlist);
@@ -44,25 +45,25 @@ class Interpreter {
       const absl::flat_hash_map<const rtl::NetRef, bool>& inputs,
       absl::Span<const std::string> dump_cells = {});
 
- private:
-  // Returns true if the specified NetRef is an output of the given cell.
-  bool IsCellOutput(const rtl::Cell& cell, const rtl::NetRef ref);
-
-  absl::Status InterpretCell(
-      const rtl::Cell& cell,
-      absl::flat_hash_map<const rtl::NetRef, bool>* processed_wires);
-
-  absl::StatusOr<bool> InterpretFunction(
-      const rtl::Cell& cell, const function::Ast& ast,
-      const absl::flat_hash_map<const rtl::NetRef, bool>& processed_wires);
+  // As InterpretModule but evaluates 64 input vectors at once: bit i of each
+  // input and output value holds the value of the net in the i-th vector.
+  absl::StatusOr<absl::flat_hash_map<const rtl::NetRef, uint64_t>>
+  InterpretModuleBatch(
+      const rtl::Module* module,
+      const absl::flat_hash_map<const rtl::NetRef, uint64_t>& inputs,
+      absl::Span<const std::string> dump_cells = {});
 
-  // Returns the value of the internal/output pin from the cell (defined by a
-  // "statetable" attribute under the conditions defined in "processed_wires".
-  absl::StatusOr<bool> InterpretStateTable(
-      const rtl::Cell& cell, const std::string& pin_name,
-      const absl::flat_hash_map<const rtl::NetRef, bool>& processed_wires);
+ private:
+  // Common implementation of InterpretModule and InterpretModuleBatch. T is
+  // the type holding net values during evaluation (see NetValueTraits) and
+  // ValueT the type of the input and output values.
+  template <typename T, typename ValueT>
+  absl::StatusOr<absl::flat_hash_map<const rtl::NetRef, ValueT>> Interpret(
+      const rtl::Module* module,
+      const absl::flat_hash_map<const rtl::NetRef, ValueT>& inputs,
+      absl::Span<const std::string> dump_cells);
 
-  rtl::Netlist* netlist_;
+  CompiledNetlist compiled_netlist_;
 };
 
 }  // namespace netlist
@@ -14,9 +14,14 @@
 
 #include "xls/netlist/lib_parser.h"
 
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
 #include "absl/status/statusor.h"
 #include "absl/strings/str_join.h"
 #include "xls/common/logging/logging.h"
+#include "xls/common/status/error_code_to_status.h"
 
 namespace xls {
 namespace netlist {
@@ -24,12 +29,32 @@ namespace cell_lib {
 
 /* static */ absl::StatusOr<CharStream> CharStream::FromPath(
     absl::string_view path) {
-  std::ifstream file_stream{std::string(path)};
-  if (file_stream.is_open()) {
-    return CharStream(std::move(file_stream));
+  FileDescriptor fd(open(std::string(path).c_str(), O_RDONLY | O_CLOEXEC));
+  if (fd.get() == -1) {
+    return absl::NotFoundError(
+        absl::StrCat("Could not open file at path: ", path));
+  }
+  return CharStream(std::move(fd));
+}
+
+void CharStream::Refill() {
+  if (cursor_ > 0) {
+    buffer_[0] = buffer_[cursor_ - 1];
+  }
+  cursor_ = 1;
+  limit_ = 1;
+  while (true) {
+    ssize_t n = read(fd_.get(), &buffer_[1], buffer_.size() - 1);
+    if (n >= 0) {
+      limit_ += n;
+      return;
+    }
+    if (errno != EINTR) {
+      status_ = ErrnoToStatus(errno).SetPrepend()
+                << "Error reading cell library: ";
+      return;
+    }
   }
-  return absl::NotFoundError(
-      absl::StrCat("Could not open file at path: ", path));
 }
 
 /* static */ absl::StatusOr<CharStream> CharStream::FromText(std::string text) {
@@ -20,7 +20,7 @@
 #ifndef XLS_NETLIST_LIB_PARSER_H_
 #define XLS_NETLIST_LIB_PARSER_H_
 
-#include <fstream>
+#include <cstdint>
 #include <string>
 
 #include "absl/container/flat_hash_set.h"
@@ -29,6 +29,7 @@
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/optional.h"
+#include "xls/common/file/file_descriptor.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/status/status_macros.h"
 
@@ -50,31 +51,25 @@ struct Pos {
 // interface.
 class CharStream {
  public:
+  // Streams the file at the given path, reading it in blocks of kBlockSize
+  // bytes so that only one block of the file is held in memory at a time.
   static absl::StatusOr<CharStream> FromPath(absl::string_view path);
   static absl::StatusOr<CharStream> FromText(std::string text);
 
-  ~CharStream() {
-    if (if_.has_value()) {
-      if_->close();
-    }
-  }
+  static constexpr int64_t kBlockSize = 1 << 20;
 
   CharStream(CharStream&& other) = default;
 
   Pos GetPos() const { return pos_; }
-  bool AtEof() const {
-    if (if_.has_value()) {
-      return if_->eof();
-    }
-    return cursor_ >= text_.size();
-  }
+  bool AtEof() const { return cursor_ >= limit_; }
+
+  // Returns the error which ended the stream early if reading the file failed.
+  // AtEof() is also true in that case, so callers must check this to tell a
+  // truncated stream from the real end of the file.
+  const absl::Status& status() const { return status_; }
   char PeekCharOrDie() {
-    if (if_.has_value()) {
-      XLS_DCHECK(!if_->eof());
-      return if_->peek();
-    }
-    XLS_DCHECK_LT(cursor_, text_.size());
-    return text_[cursor_];
+    XLS_DCHECK_LT(cursor_, limit_);
+    return buffer_[cursor_];
   }
   char PopCharOrDie() {
     char c = PeekCharOrDie();
@@ -110,10 +105,16 @@ class CharStream {
   }
 
  private:
-  CharStream(std::ifstream file_stream) : if_(std::move(file_stream)) {}
-  CharStream(std::string text) : text_(std::move(text)) {}
+  explicit CharStream(FileDescriptor fd) : fd_(std::move(fd)) {
+    buffer_.resize(kBlockSize + 1);
+    Refill();
+  }
+  explicit CharStream(std::string text)
+      : buffer_(std::move(text)), limit_(buffer_.size()) {}
 
+  // Only the most recently popped character can be ungotten.
   void Unget(char c) {
+    XLS_DCHECK_GT(cursor_, 0);
     cursor_--;
     if (c == '\n') {
       pos_.lineno--;
@@ -121,9 +122,6 @@ class CharStream {
     } else {
       pos_.colno--;
     }
-    if (if_.has_value()) {
-      if_->unget();
-    }
   }
 
   void BumpPos(char c) {
@@ -135,18 +133,30 @@ class CharStream {
     } else {
       pos_.colno++;
     }
+    if (cursor_ == limit_ && fd_.get() != -1) {
+      Refill();
+    }
   }
 
+  // Reads the next block of the file into buffer_[1...]. The last popped
+  // character is kept in buffer_[0] so that it can still be ungotten. On end
+  // of file (or a read error) nothing is read, so AtEof() becomes true. A read
+  // error is recorded in status_.
+  void Refill();
+
   Pos pos_ = {0, 0};
 
-  // We have both ifstream mode and text mode data, we store both inline.
+  // The file being streamed, if any. Text streams hold the entire text in
+  // buffer_.
+  FileDescriptor fd_;
 
-  // ifstream mode
-  absl::optional<std::ifstream> if_;
+  // The error, if any, from reading the file.
+  absl::Status status_;
 
-  // text mode
-  std::string text_;
+  // The characters in buffer_[cursor_, limit_) are yet to be popped.
+  std::string buffer_;
   int64_t cursor_ = 0;
+  int64_t limit_ = 0;
   int64_t last_colno_ = 0;
 };
 
@@ -222,12 +232,16 @@ class Scanner {
     if (lookahead_.has_value()) {
       return &lookahead_.value();
     }
+    XLS_RETURN_IF_ERROR(cs_->status());
     XLS_RETURN_IF_ERROR(PeekInternal());
     return Peek();
   }
 
   bool AtEof() const { return !lookahead_.has_value() && cs_->AtEof(); }
 
+  // Returns the error, if any, from reading the underlying character stream.
+  const absl::Status& status() const { return cs_->status(); }
+
   Pos GetPos() {
     if (lookahead_.has_value()) {
       return lookahead_.value().pos();
@@ -367,7 +381,12 @@ class Parser {
 
   absl::StatusOr<std::unique_ptr<Block>> ParseLibrary() {
     XLS_RETURN_IF_ERROR(DropIdentifierOrError("library"));
-    return ParseBlock("library");
+    XLS_ASSIGN_OR_RETURN(std::unique_ptr<Block> library,
+                         ParseBlock("library"));
+    // A read error ends the stream early, possibly right after a complete
+    // block, so check for one explicitly.
+    XLS_RETURN_IF_ERROR(scanner_->status());
+    return library;
   }
 
  private:
@@ -19,6 +19,9 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "xls/common/file/temp_directory.h"
+#include "xls/common/file/temp_file.h"
 #include "xls/common/status/matchers.h"
 
 namespace xls {
@@ -26,6 +29,9 @@ namespace netlist {
 namespace cell_lib {
 namespace {
 
+using ::testing::HasSubstr;
+using status_testing::StatusIs;
+
 TEST(LibParserTest, ScanSimple) {
   std::string text = "{}()";
   XLS_ASSERT_OK_AND_ASSIGN(auto cs, CharStream::FromText(text));
@@ -159,6 +165,44 @@ library (foo) {
             "))");
 }
 
+TEST(LibParserTest, StreamFromPathAcrossBlocks) {
+  // Slide a comment (and its lone '*', which must be ungotten) across the
+  // boundary between the first and second blocks read from the file.
+  for (int64_t padding = CharStream::kBlockSize - 24;
+       padding <= CharStream::kBlockSize; ++padding) {
+    std::string text = absl::StrCat(
+        "library (foo) {", std::string(padding, ' '),
+        "/* a * b */ cell (c) {\n  pin (o) { direction : output; }\n}\n}");
+    XLS_ASSERT_OK_AND_ASSIGN(TempFile temp_file,
+                             TempFile::CreateWithContent(text));
+    XLS_ASSERT_OK_AND_ASSIGN(auto cs,
+                             CharStream::FromPath(temp_file.path().string()));
+    Scanner scanner(&cs);
+    Parser parser(&scanner);
+    XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Block> library,
+                             parser.ParseLibrary());
+    EXPECT_EQ(library->ToString(),
+              "(block library (foo) ("
+              "(block cell (c) ((block pin (o) ((direction \"output\")))))"
+              "))")
+        << "padding: " << padding;
+    EXPECT_TRUE(scanner.AtEof());
+  }
+}
+
+TEST(LibParserTest, ReadErrorIsReported) {
+  // Opening a directory succeeds but reading from it fails.
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory temp_dir, TempDirectory::Create());
+  XLS_ASSERT_OK_AND_ASSIGN(auto cs,
+                           CharStream::FromPath(temp_dir.path().string()));
+  EXPECT_TRUE(cs.AtEof());
+  Scanner scanner(&cs);
+  Parser parser(&scanner);
+  EXPECT_THAT(parser.ParseLibrary().status(),
+              StatusIs(absl::StatusCode::kFailedPrecondition,
+                       HasSubstr("Error reading cell library")));
+}
+
 }  // namespace
 }  // namespace cell_lib
 }  // namespace netlist
@@ -14,6 +14,7 @@
 
 #include "xls/netlist/netlist.h"
 
+#include <algorithm>
 #include <variant>
 
 #include "absl/status/status.h"
@@ -38,7 +39,7 @@ const CellLibraryEntry* Module::AsCellLibraryEntry() const {
     std::vector<std::string> input_names;
     input_names.reserve(inputs_.size());
     for (const auto& input : inputs_) {
-      input_names.push_back(input->name());
+      input_names.push_back(std::string(input->name()));
     }
     CellLibraryEntry::OutputPinToFunction output_pins;
     output_pins.reserve(outputs_.size());
@@ -68,45 +69,65 @@ absl::StatusOr<NetRef> Module::ResolveNumber(int64_t number) const {
 }
 
 absl::StatusOr<NetRef> Module::ResolveNet(absl::string_view name) const {
-  for (const auto& net : nets_) {
-    if (net->name() == name) {
-      return net.get();
-    }
+  auto it = nets_by_name_.find(name);
+  if (it == nets_by_name_.end()) {
+    return absl::NotFoundError(absl::StrCat("Could not find net: ", name));
   }
-
-  return absl::NotFoundError(absl::StrCat("Could not find net: ", name));
+  return it->second;
 }
 
 absl::StatusOr<Cell*> Module::ResolveCell(absl::string_view name) const {
-  for (const auto& cell : cells_) {
-    if (cell->name() == name) {
-      return cell.get();
-    }
+  auto it = cells_by_name_.find(name);
+  if (it == cells_by_name_.end()) {
+    return absl::NotFoundError(
+        absl::StrCat("Could not find cell with name: ", name));
   }
-  return absl::NotFoundError(
-      absl::StrCat("Could not find cell with name: ", name));
+  return it->second;
 }
 
 absl::StatusOr<Cell*> Module::AddCell(Cell cell) {
-  auto status_or_cell = ResolveCell(cell.name());
-  if (status_or_cell.status().ok()) {
+  if (cells_by_name_.contains(cell.name())) {
     return absl::InvalidArgumentError(
         absl::StrCat("Module already has a cell with name: ", cell.name()));
   }
 
-  cells_.push_back(std::make_unique<Cell>(cell));
-  return cells_.back().get();
+  cells_.push_back(std::make_unique<Cell>(std::move(cell)));
+  Cell* cell_ptr = cells_.back().get();
+  cells_by_name_[cell_ptr->name()] = cell_ptr;
+  return cell_ptr;
+}
+
+absl::string_view Module::InternName(absl::string_view name) {
+  constexpr int64_t kNameBlockSize = 64 * 1024;
+  if (name.size() > name_block_remaining_) {
+    // Names longer than a block get a block of their own; the remainder of the
+    // current block is not worth abandoning for them.
+    if (name.size() > kNameBlockSize / 4) {
+      name_blocks_.push_back(std::make_unique<char[]>(name.size()));
+      std::copy(name.begin(), name.end(), name_blocks_.back().get());
+      return absl::string_view(name_blocks_.back().get(), name.size());
+    }
+    name_blocks_.push_back(std::make_unique<char[]>(kNameBlockSize));
+    name_block_next_ = name_blocks_.back().get();
+    name_block_remaining_ = kNameBlockSize;
+  }
+  std::copy(name.begin(), name.end(), name_block_next_);
+  absl::string_view result(name_block_next_, name.size());
+  name_block_next_ += name.size();
+  name_block_remaining_ -= name.size();
+  return result;
 }
 
 absl::Status Module::AddNetDecl(NetDeclKind kind, absl::string_view name) {
-  auto status_or_net = ResolveNet(name);
-  if (status_or_net.status().ok()) {
+  if (nets_by_name_.contains(name)) {
     return absl::InvalidArgumentError(
         absl::StrCat("Module already has a net/wire decl with name: ", name));
   }
 
-  nets_.emplace_back(std::make_unique<NetDef>(name));
+  nets_.emplace_back(
+      std::make_unique<NetDef>(InternName(name), nets_.size()));
   NetRef ref = nets_.back().get();
+  nets_by_name_[ref->name()] = ref;
   switch (kind) {
     case NetDeclKind::kInput:
       inputs_.push_back(ref);
@@ -267,15 +288,15 @@ absl::StatusOr<std::vector<Cell*>> NetDef::GetConnectedCellsSans(
 }
 
 void Netlist::AddModule(std::unique_ptr<Module> module) {
+  modules_by_name_.emplace(module->name(), module.get());
   modules_.emplace_back(std::move(module));
 }
 
 absl::StatusOr<const Module*> Netlist::GetModule(
-    const std::string& module_name) const {
-  for (const auto& module : modules_) {
-    if (module->name() == module_name) {
-      return module.get();
-    }
+    absl::string_view module_name) const {
+  auto it = modules_by_name_.find(module_name);
+  if (it != modules_by_name_.end()) {
+    return it->second;
   }
   return absl::NotFoundError(
       absl::StrFormat("Module %s not found in netlist.", module_name));
@@ -101,9 +101,14 @@ class Cell {
 // future.
 class NetDef {
  public:
-  explicit NetDef(absl::string_view name) : name_(name) {}
+  // The name is not copied: it must outlive the net. Nets created by a Module
+  // name themselves with strings interned in the module.
+  NetDef(absl::string_view name, int64_t id) : name_(name), id_(id) {}
 
-  const std::string& name() const { return name_; }
+  absl::string_view name() const { return name_; }
+
+  // The index of this net in its module's nets().
+  int64_t id() const { return id_; }
 
   // Called to note that a cell is connected to this net.
   void NoteConnectedCell(Cell* cell) { connected_cells_.push_back(cell); }
@@ -118,7 +123,8 @@ class NetDef {
       Cell* to_remove) const;
 
  private:
-  std::string name_;
+  absl::string_view name_;
+  int64_t id_;
   std::vector<Cell*> connected_cells_;
 };
 
@@ -255,6 +261,10 @@ class Module {
     bool is_declared_ = false;
   };
 
+  // Copies the given name into name_blocks_ and returns a view of the copy,
+  // which remains valid for the lifetime of the module.
+  absl::string_view InternName(absl::string_view name);
+
   std::string name_;
   std::vector<std::unique_ptr<Port>> ports_;
   std::vector<NetRef> inputs_;
@@ -263,6 +273,17 @@ class Module {
   absl::flat_hash_map<NetRef, NetRef> assigns_;
   std::vector<std::unique_ptr<NetDef>> nets_;
   std::vector<std::unique_ptr<Cell>> cells_;
+
+  // Net names are packed into large blocks rather than held in a std::string
+  // per net; flattened netlists have millions of nets.
+  std::vector<std::unique_ptr<char[]>> name_blocks_;
+  char* name_block_next_ = nullptr;
+  int64_t name_block_remaining_ = 0;
+
+  // Indices for name resolution, keyed by the names of the nets and cells
+  // themselves.
+  absl::flat_hash_map<absl::string_view, NetRef> nets_by_name_;
+  absl::flat_hash_map<absl::string_view, Cell*> cells_by_name_;
   NetRef zero_;
   NetRef one_;
   NetRef dummy_;
@@ -274,7 +295,8 @@ class Module {
 class Netlist {
  public:
   void AddModule(std::unique_ptr<Module> module);
-  absl::StatusOr<const Module*> GetModule(const std::string& module_name) const;
+  absl::StatusOr<const Module*> GetModule(
+      absl::string_view module_name) const;
   const absl::Span<const std::unique_ptr<Module>> modules() { return modules_; }
   absl::StatusOr<const CellLibraryEntry*> GetOrCreateLut4CellEntry(
       int64_t lut_mask);
@@ -285,6 +307,7 @@ class Netlist {
   // bit LUT_INIT parameter).
   absl::flat_hash_map<uint16_t, CellLibraryEntry> lut_cells_;
   std::vector<std::unique_ptr<Module>> modules_;
+  absl::flat_hash_map<std::string, Module*> modules_by_name_;
 };
 
 }  // namespace rtl
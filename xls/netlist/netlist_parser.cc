@@ -76,6 +76,15 @@ std::string TokenKindToString(TokenKind kind) {
   return absl::StrCat("<invalid-kind-%d>", static_cast<int>(kind));
 }
 
+/* static */ absl::StatusOr<std::unique_ptr<Scanner>> Scanner::FromFile(
+    const std::filesystem::path& path) {
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<MemoryMappedFile> file,
+                       MemoryMappedFile::Open(path));
+  auto scanner = std::make_unique<Scanner>(file->contents());
+  scanner->file_ = std::move(file);
+  return scanner;
+}
+
 std::string Token::ToString() const {
   if (kind == TokenKind::kName) {
     return absl::StrFormat("Token{kName, @%s, \"%s\"}", pos.ToHumanString(),
@@ -189,8 +198,8 @@ absl::StatusOr<Token> Scanner::Pop() {
 }
 
 absl::StatusOr<Token> Scanner::ScanNumber(char startc, Pos pos) {
-  std::string chars;
-  chars.push_back(startc);
+  // The token's characters are contiguous in the text, ending at index_.
+  const int64_t start = index_ - 1;
   bool seen_separator = false;
   auto is_hex_char = [](char c) {
     return absl::ascii_isxdigit(absl::ascii_toupper(c));
@@ -205,20 +214,19 @@ absl::StatusOr<Token> Scanner::ScanNumber(char startc, Pos pos) {
   while (!AtEofInternal()) {
     char c = PeekCharOrDie();
     if (is_hex_char(c)) {
-      chars.push_back(PopCharOrDie());
+      DropCharOrDie();
     } else if (c == '\'' && !seen_separator) {
       // If we see a base separator, pop it, then the optional signedness
       // indicator (s|S), then the base indicator (d|b|o|h|D|B|O|H).
-      chars.push_back(PopCharOrDie());
+      DropCharOrDie();
       XLS_RET_CHECK(!AtEofInternal()) << "Saw EOF while scanning number base!";
-      chars.push_back(PopCharOrDie());
-      if (chars.back() == 's' || chars.back() == 'S') {
+      c = PopCharOrDie();
+      if (c == 's' || c == 'S') {
         XLS_RET_CHECK(!AtEofInternal())
             << "Saw EOF while scanning number base (post-signedness)!";
-        chars.push_back(PopCharOrDie());
+        c = PopCharOrDie();
       }
 
-      c = chars.back();
       XLS_RET_CHECK(c == 'd' || c == 'b' || c == 'o' || c == 'h' || c == 'D' ||
                     c == 'B' || c == 'O' || c == 'H')
           << "Expected [dbohDBOH], saw '" << c << "'";
@@ -229,23 +237,23 @@ absl::StatusOr<Token> Scanner::ScanNumber(char startc, Pos pos) {
     }
   }
 
-  return Token{TokenKind::kNumber, pos, chars};
+  return Token{TokenKind::kNumber, pos, text_.substr(start, index_ - start)};
 }
 
 absl::StatusOr<Token> Scanner::ScanName(char startc, Pos pos, bool is_escaped) {
-  std::string chars;
-  chars.push_back(startc);
+  // The token's characters are contiguous in the text, ending at index_.
+  const int64_t start = index_ - 1;
   while (!AtEofInternal()) {
     char c = PeekCharOrDie();
     bool is_whitespace = c == ' ' || c == '\t' || c == '\n';
     if ((is_escaped && !is_whitespace) || isalpha(c) || isdigit(c) ||
         c == '_') {
-      chars.push_back(PopCharOrDie());
+      DropCharOrDie();
     } else {
       break;
     }
   }
-  return Token{TokenKind::kName, pos, chars};
+  return Token{TokenKind::kName, pos, text_.substr(start, index_ - start)};
 }
 
 absl::StatusOr<Token> Scanner::PeekInternal() {
@@ -298,7 +306,7 @@ absl::StatusOr<Token> Scanner::PeekInternal() {
   }
 }
 
-absl::StatusOr<std::string> Parser::PopNameOrError() {
+absl::StatusOr<absl::string_view> Parser::PopNameOrError() {
   XLS_ASSIGN_OR_RETURN(Token token, scanner_->Pop());
   if (token.kind == TokenKind::kName) {
     return token.value;
@@ -348,8 +356,8 @@ absl::StatusOr<int64_t> Parser::PopNumberOrError() {
     int64_t result;
     if (!absl::SimpleAtoi(token.value, &result)) {
       return absl::InternalError(
-          "Number token's value cannot be parsed as an int64_t: " +
-          token.value);
+          absl::StrCat("Number token's value cannot be parsed as an int64_t: ",
+                       token.value));
     }
     return result;
   }
@@ -357,7 +365,7 @@ absl::StatusOr<int64_t> Parser::PopNumberOrError() {
                                     token.ToString());
 }
 
-absl::StatusOr<absl::variant<std::string, int64_t>>
+absl::StatusOr<absl::variant<absl::string_view, int64_t>>
 Parser::PopNameOrNumberOrError() {
   TokenKind kind = scanner_->Peek()->kind;
   if (kind == TokenKind::kName) {
@@ -391,8 +399,8 @@ absl::StatusOr<std::vector<std::string>> Parser::PopParenNameList() {
       XLS_RETURN_IF_ERROR(DropTokenOrError(TokenKind::kCloseParen));
       break;
     }
-    XLS_ASSIGN_OR_RETURN(std::string name, PopNameOrError());
-    results.push_back(name);
+    XLS_ASSIGN_OR_RETURN(absl::string_view name, PopNameOrError());
+    results.push_back(std::string(name));
     must_end = !TryDropToken(TokenKind::kComma);
   }
   return results;
@@ -409,7 +417,7 @@ absl::Status Parser::DropKeywordOrError(absl::string_view target) {
 
 absl::StatusOr<const CellLibraryEntry*> Parser::ParseCellModule(
     Netlist& netlist) {
-  XLS_ASSIGN_OR_RETURN(std::string name, PopNameOrError());
+  XLS_ASSIGN_OR_RETURN(absl::string_view name, PopNameOrError());
   auto status_or_module = netlist.GetModule(name);
   if (status_or_module.ok()) {
     return status_or_module.value()->AsCellLibraryEntry();
@@ -417,10 +425,10 @@ absl::StatusOr<const CellLibraryEntry*> Parser::ParseCellModule(
   if (name == "SB_LUT4") {
     XLS_RETURN_IF_ERROR(DropTokenOrError(TokenKind::kStartParams));
     XLS_RETURN_IF_ERROR(DropTokenOrError(TokenKind::kDot));
-    XLS_ASSIGN_OR_RETURN(std::string param_name, PopNameOrError());
+    XLS_ASSIGN_OR_RETURN(absl::string_view param_name, PopNameOrError());
     if (param_name != "LUT_INIT") {
-      return absl::InvalidArgumentError(
-          "Expected a single .LUT_INIT named parameter, got: " + param_name);
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Expected a single .LUT_INIT named parameter, got: ", param_name));
     }
     XLS_RETURN_IF_ERROR(DropTokenOrError(TokenKind::kOpenParen));
     XLS_ASSIGN_OR_RETURN(int64_t lut_mask, PopNumberOrError());
@@ -432,18 +440,18 @@ absl::StatusOr<const CellLibraryEntry*> Parser::ParseCellModule(
 }
 
 absl::StatusOr<NetRef> Parser::ParseNetRef(Module* module) {
-  using TokenT = absl::variant<std::string, int64_t>;
+  using TokenT = absl::variant<absl::string_view, int64_t>;
   XLS_ASSIGN_OR_RETURN(TokenT token, PopNameOrNumberOrError());
   if (absl::holds_alternative<int64_t>(token)) {
     int64_t value = absl::get<int64_t>(token);
     return module->AddOrResolveNumber(value);
   }
 
-  std::string name = absl::get<std::string>(token);
+  absl::string_view name = absl::get<absl::string_view>(token);
   if (TryDropToken(TokenKind::kOpenBracket)) {
     XLS_ASSIGN_OR_RETURN(int64_t index, PopNumberOrError());
     XLS_RETURN_IF_ERROR(DropTokenOrError(TokenKind::kCloseBracket));
-    absl::StrAppend(&name, "[", index, "]");
+    return module->ResolveNet(absl::StrCat(name, "[", index, "]"));
   }
   return module->ResolveNet(name);
 }
@@ -453,20 +461,22 @@ absl::Status Parser::ParseInstance(Module* module, Netlist& netlist) {
   const Pos pos = peek.pos;
 
   XLS_ASSIGN_OR_RETURN(const CellLibraryEntry* cle, ParseCellModule(netlist));
-  XLS_ASSIGN_OR_RETURN(std::string name, PopNameOrError());
+  XLS_ASSIGN_OR_RETURN(absl::string_view name, PopNameOrError());
   XLS_RETURN_IF_ERROR(DropTokenOrError(TokenKind::kOpenParen));
   // LRM 23.3.2 Calls these "named parameter assignments".
   absl::flat_hash_map<std::string, NetRef> named_parameter_assignments;
   while (true) {
     XLS_RETURN_IF_ERROR(DropTokenOrError(TokenKind::kDot));
-    XLS_ASSIGN_OR_RETURN(std::string pin_name, PopNameOrError());
+    XLS_ASSIGN_OR_RETURN(absl::string_view pin_name, PopNameOrError());
     XLS_RETURN_IF_ERROR(DropTokenOrError(TokenKind::kOpenParen));
     XLS_ASSIGN_OR_RETURN(NetRef net, ParseNetRef(module));
     XLS_RETURN_IF_ERROR(DropTokenOrError(TokenKind::kCloseParen));
     XLS_VLOG(3) << "Adding named parameter assignment: " << pin_name;
-    bool is_new = named_parameter_assignments.insert({pin_name, net}).second;
+    bool is_new =
+        named_parameter_assignments.emplace(std::string(pin_name), net).second;
     if (!is_new) {
-      return absl::InvalidArgumentError("Duplicate port seen: " + pin_name);
+      return absl::InvalidArgumentError(
+          absl::StrCat("Duplicate port seen: ", pin_name));
     }
     if (!TryDropToken(TokenKind::kComma)) {
       break;
@@ -550,9 +560,9 @@ absl::StatusOr<absl::optional<Parser::Range>> Parser::ParseOptionalRange(
 
 absl::Status Parser::ParseNetDecl(Module* module, NetDeclKind kind) {
   XLS_ASSIGN_OR_RETURN(auto range, ParseOptionalRange());
-  std::vector<std::string> names;
+  std::vector<absl::string_view> names;
   do {
-    XLS_ASSIGN_OR_RETURN(std::string name, PopNameOrError());
+    XLS_ASSIGN_OR_RETURN(absl::string_view name, PopNameOrError());
     names.push_back(name);
   } while (TryDropToken(TokenKind::kComma));
 
@@ -565,7 +575,7 @@ absl::Status Parser::ParseNetDecl(Module* module, NetDeclKind kind) {
         "Multiple declarations for a ranged net is not yet supported.");
   }
 
-  for (const std::string& name : names) {
+  for (absl::string_view name : names) {
     if (kind == NetDeclKind::kInput || kind == NetDeclKind::kOutput) {
       int64_t width = 1;
       if (range.has_value()) {
@@ -598,7 +608,7 @@ absl::Status Parser::ParseOneAssignment(Module* module,
   }
   XLS_RET_CHECK(lhs_high >= lhs_low);
 
-  using TokenT = absl::variant<std::string, int64_t>;
+  using TokenT = absl::variant<absl::string_view, int64_t>;
   XLS_ASSIGN_OR_RETURN(TokenT token, PopNameOrNumberOrError());
   if (absl::holds_alternative<int64_t>(token)) {
     int64_t rhs_value = absl::get<int64_t>(token);
@@ -632,7 +642,7 @@ absl::Status Parser::ParseOneAssignment(Module* module,
     }
 
   } else {
-    std::string rhs_name = absl::get<std::string>(token);
+    absl::string_view rhs_name = absl::get<absl::string_view>(token);
     XLS_ASSIGN_OR_RETURN(auto rhs_range, ParseOptionalRange(false));
 
     // Extract the range from the rhs wire.
@@ -657,13 +667,13 @@ absl::Status Parser::ParseOneAssignment(Module* module,
       if (lhs_range.has_value()) {
         lhs_wire_name = absl::StrFormat("%s[%d]", lhs_name, lhs_low);
       } else {
-        lhs_wire_name = lhs_name;
+        lhs_wire_name = std::string(lhs_name);
       }
       std::string rhs_wire_name;
       if (rhs_range.has_value()) {
         rhs_wire_name = absl::StrFormat("%s[%d]", rhs_name, rhs_low);
       } else {
-        rhs_wire_name = rhs_name;
+        rhs_wire_name = std::string(rhs_name);
       }
       XLS_RETURN_IF_ERROR(module->AddAssignDecl(lhs_wire_name, rhs_wire_name));
       lhs_low++;
@@ -697,10 +707,10 @@ absl::Status Parser::ParseAssignDecl(Module* module) {
   // than doing the wrong thing.  Support can be added in the future, if needed.
 
   if (TryDropToken(TokenKind::kOpenBrace)) {
-    std::vector<std::pair<std::string, absl::optional<Range>>> lhs;
+    std::vector<std::pair<absl::string_view, absl::optional<Range>>> lhs;
     // Parse the left-hand side.
     do {
-      XLS_ASSIGN_OR_RETURN(std::string name, PopNameOrError());
+      XLS_ASSIGN_OR_RETURN(absl::string_view name, PopNameOrError());
       XLS_ASSIGN_OR_RETURN(auto range, ParseOptionalRange(false));
       lhs.push_back({name, range});
     } while (TryDropToken(TokenKind::kComma));
@@ -724,7 +734,7 @@ absl::Status Parser::ParseAssignDecl(Module* module) {
     XLS_RETURN_IF_ERROR(DropTokenOrError(TokenKind::kCloseBrace));
   } else {
     // Parse the left-hand side.
-    XLS_ASSIGN_OR_RETURN(std::string lhs_name, PopNameOrError());
+    XLS_ASSIGN_OR_RETURN(absl::string_view lhs_name, PopNameOrError());
     XLS_ASSIGN_OR_RETURN(auto lhs_range, ParseOptionalRange(false));
     // Parse the right-hand side.
     XLS_RETURN_IF_ERROR(DropTokenOrError(TokenKind::kEquals));
@@ -751,9 +761,26 @@ absl::Status Parser::ParseModuleStatement(Module* module, Netlist& netlist) {
   return ParseInstance(module, netlist);
 }
 
-absl::StatusOr<std::unique_ptr<Module>> Parser::ParseModule(Netlist& netlist) {
+absl::Status Parser::SkipModuleBody() {
+  // Names and numbers are views of the scanned text, so skipping a module only
+  // costs the scan itself.
+  while (true) {
+    XLS_ASSIGN_OR_RETURN(Token token, scanner_->Pop());
+    if (token.kind == TokenKind::kName && token.value == "endmodule") {
+      return absl::OkStatus();
+    }
+  }
+}
+
+absl::StatusOr<std::unique_ptr<Module>> Parser::ParseModule(
+    Netlist& netlist, const absl::flat_hash_set<std::string>* module_names) {
   XLS_RETURN_IF_ERROR(DropKeywordOrError("module"));
-  XLS_ASSIGN_OR_RETURN(std::string module_name, PopNameOrError());
+  XLS_ASSIGN_OR_RETURN(absl::string_view module_name, PopNameOrError());
+  if (module_names != nullptr && !module_names->contains(module_name)) {
+    XLS_VLOG(2) << "Skipping module " << module_name;
+    XLS_RETURN_IF_ERROR(SkipModuleBody());
+    return nullptr;
+  }
   XLS_ASSIGN_OR_RETURN(std::vector<std::string> module_ports,
                        PopParenNameList());
   XLS_RETURN_IF_ERROR(DropTokenOrError(TokenKind::kSemicolon));
@@ -782,6 +809,21 @@ absl::StatusOr<std::unique_ptr<Netlist>> Parser::ParseNetlist(
   return std::move(netlist);
 }
 
+absl::StatusOr<std::unique_ptr<Netlist>> Parser::ParseNetlist(
+    CellLibrary* cell_library, Scanner* scanner,
+    const absl::flat_hash_set<std::string>& module_names) {
+  auto netlist = std::make_unique<Netlist>();
+  Parser p(cell_library, scanner);
+  while (!scanner->AtEof()) {
+    XLS_ASSIGN_OR_RETURN(std::unique_ptr<Module> module,
+                         p.ParseModule(*netlist, &module_names));
+    if (module != nullptr) {
+      netlist->AddModule(std::move(module));
+    }
+  }
+  return std::move(netlist);
+}
+
 }  // namespace rtl
 }  // namespace netlist
 }  // namespace xls
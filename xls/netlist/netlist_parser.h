@@ -16,8 +16,16 @@
 #define XLS_NETLIST_NETLIST_PARSER_H_
 
 #include <sys/types.h>
+
+#include <filesystem>
+#include <memory>
+#include <string>
+
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "xls/common/file/memory_mapped_file.h"
 #include "xls/netlist/netlist.h"
 
 namespace xls {
@@ -55,10 +63,12 @@ struct Pos {
 };
 
 // Represents a scanned token (that comes from scanning a character stream).
+// The value of a name or number token refers to the scanned text, so it is
+// only valid for the lifetime of the Scanner.
 struct Token {
   TokenKind kind;
   Pos pos;
-  std::string value;
+  absl::string_view value;
 
   std::string ToString() const;
 };
@@ -68,6 +78,12 @@ class Scanner {
  public:
   explicit Scanner(absl::string_view text) : text_(text) {}
 
+  // Returns a scanner over the contents of the given file. The file is mapped
+  // into memory rather than read, so scanning a large netlist does not need a
+  // heap copy of its text.
+  static absl::StatusOr<std::unique_ptr<Scanner>> FromFile(
+      const std::filesystem::path& path);
+
   absl::StatusOr<Token> Peek();
 
   absl::StatusOr<Token> Pop();
@@ -101,6 +117,8 @@ class Scanner {
   // whether the character stream index has reached the end of the text.
   bool AtEofInternal() const { return index_ >= text_.size(); }
 
+  // Backs text_ for scanners created by FromFile().
+  std::unique_ptr<MemoryMappedFile> file_;
   absl::string_view text_;
   int64_t index_ = 0;
   int64_t lineno_ = 0;
@@ -115,6 +133,13 @@ class Parser {
   static absl::StatusOr<std::unique_ptr<Netlist>> ParseNetlist(
       CellLibrary* cell_library, Scanner* scanner);
 
+  // As above, but only the modules named in module_names are built; the
+  // bodies of all other modules are scanned past without being parsed. Any
+  // module instantiated by a selected module must be selected as well.
+  static absl::StatusOr<std::unique_ptr<Netlist>> ParseNetlist(
+      CellLibrary* cell_library, Scanner* scanner,
+      const absl::flat_hash_set<std::string>& module_names);
+
  private:
   explicit Parser(CellLibrary* cell_library, Scanner* scanner)
       : cell_library_(cell_library), scanner_(scanner) {}
@@ -151,22 +176,31 @@ class Parser {
   // Parses a module-level statement (e.g. wire decl or cell instantiation).
   absl::Status ParseModuleStatement(Module* module, Netlist& netlist);
 
-  // Parses a module definition (e.g. at the top of the file).
-  absl::StatusOr<std::unique_ptr<Module>> ParseModule(Netlist& netlist);
+  // Parses a module definition (e.g. at the top of the file). If module_names
+  // is given and does not contain the module's name, the module is skipped and
+  // nullptr is returned.
+  absl::StatusOr<std::unique_ptr<Module>> ParseModule(
+      Netlist& netlist,
+      const absl::flat_hash_set<std::string>* module_names = nullptr);
+
+  // Drops tokens up to and including the "endmodule" keyword.
+  absl::Status SkipModuleBody();
 
   // Parses a reference to an already- declared net.
   absl::StatusOr<NetRef> ParseNetRef(Module* module);
 
   // Pops a name token and returns its contents or gives an error status if a
-  // name token is not immediately present in the stream.
-  absl::StatusOr<std::string> PopNameOrError();
+  // name token is not immediately present in the stream. The contents refer to
+  // the scanned text.
+  absl::StatusOr<absl::string_view> PopNameOrError();
 
   // Pops a name token and returns its value or gives an error status if a
   // number token is not immediately present in the stream.
   absl::StatusOr<int64_t> PopNumberOrError();
 
   // Pops either a name or number token or returns an error.
-  absl::StatusOr<absl::variant<std::string, int64_t>> PopNameOrNumberOrError();
+  absl::StatusOr<absl::variant<absl::string_view, int64_t>>
+  PopNameOrNumberOrError();
 
   // Drops a token of kind target from the head of the stream or gives an error
   // status.
@@ -23,6 +23,7 @@
 #include "absl/container/flat_hash_set.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/substitute.h"
+#include "xls/common/file/temp_file.h"
 #include "xls/common/status/matchers.h"
 #include "xls/netlist/fake_cell_library.h"
 
@@ -31,6 +32,7 @@ namespace netlist {
 namespace rtl {
 namespace {
 
+using status_testing::IsOkAndHolds;
 using status_testing::StatusIs;
 using ::testing::HasSubstr;
 
@@ -439,6 +441,88 @@ endmodule)";
   TestAssignHelper(m);
 }
 
+TEST(NetlistParserTest, ParseFromFile) {
+  std::string netlist = R"(module main(i, o);
+  input i;
+  output o;
+  INV inv_0(.A(i), .ZN(o));
+endmodule)";
+  XLS_ASSERT_OK_AND_ASSIGN(TempFile temp_file,
+                           TempFile::CreateWithContent(netlist, ".v"));
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Scanner> scanner,
+                           Scanner::FromFile(temp_file.path()));
+  XLS_ASSERT_OK_AND_ASSIGN(CellLibrary cell_library, MakeFakeCellLibrary());
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Netlist> n,
+                           Parser::ParseNetlist(&cell_library, scanner.get()));
+  // Names are copied out of the mapped text, so they outlive the scanner.
+  scanner.reset();
+  XLS_ASSERT_OK_AND_ASSIGN(const Module* m, n->GetModule("main"));
+  XLS_ASSERT_OK_AND_ASSIGN(Cell * c, m->ResolveCell("inv_0"));
+  EXPECT_EQ(c->inputs()[0].netref->name(), "i");
+  EXPECT_EQ(c->outputs()[0].netref->name(), "o");
+}
+
+TEST(NetlistParserTest, NetIdsAreNetIndices) {
+  std::string netlist = R"(module main(a, o);
+  input [1:0] a;
+  output o;
+  wire w;
+  AND and_0(.A(a[0]), .B(a[1]), .Z(w));
+  INV inv_0(.A(w), .ZN(o));
+endmodule)";
+  Scanner scanner(netlist);
+  XLS_ASSERT_OK_AND_ASSIGN(CellLibrary cell_library, MakeFakeCellLibrary());
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Netlist> n,
+                           Parser::ParseNetlist(&cell_library, &scanner));
+  XLS_ASSERT_OK_AND_ASSIGN(const Module* m, n->GetModule("main"));
+  for (int64_t i = 0; i < m->nets().size(); ++i) {
+    EXPECT_EQ(m->nets()[i]->id(), i);
+    EXPECT_THAT(m->ResolveNet(m->nets()[i]->name()),
+                IsOkAndHolds(m->nets()[i].get()));
+  }
+}
+
+TEST(NetlistParserTest, ParseSelectedModules) {
+  std::string netlist = R"(
+module unused(a, o);
+  input a;
+  output o;
+  // endmodule
+  /* endmodule */
+  NOT_A_CELL bogus(.A(a), .Z(o));
+endmodule
+
+module sub(a, o);
+  input a;
+  output o;
+  INV inv_0(.A(a), .ZN(o));
+endmodule
+
+module main(i, o);
+  input i;
+  output o;
+  sub sub_0(.a(i), .o(o));
+endmodule)";
+  XLS_ASSERT_OK_AND_ASSIGN(CellLibrary cell_library, MakeFakeCellLibrary());
+  {
+    // The unused module refers to a cell that doesn't exist.
+    Scanner scanner(netlist);
+    EXPECT_THAT(Parser::ParseNetlist(&cell_library, &scanner),
+                StatusIs(absl::StatusCode::kNotFound,
+                         HasSubstr("NOT_A_CELL")));
+  }
+  Scanner scanner(netlist);
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<Netlist> n,
+      Parser::ParseNetlist(&cell_library, &scanner, {"sub", "main"}));
+  EXPECT_EQ(n->modules().size(), 2);
+  EXPECT_THAT(n->GetModule("unused"),
+              StatusIs(absl::StatusCode::kNotFound));
+  XLS_ASSERT_OK_AND_ASSIGN(const Module* m, n->GetModule("main"));
+  XLS_ASSERT_OK_AND_ASSIGN(Cell * c, m->ResolveCell("sub_0"));
+  EXPECT_EQ(c->cell_library_entry()->name(), "sub");
+}
+
 }  // namespace
 }  // namespace rtl
 }  // namespace netlist
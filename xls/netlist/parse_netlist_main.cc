@@ -12,17 +12,26 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
 #include "absl/flags/flag.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_format.h"
 #include "xls/common/file/filesystem.h"
 #include "xls/common/init_xls.h"
 #include "xls/common/logging/logging.h"
+#include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/netlist/find_logic_clouds.h"
 #include "xls/netlist/netlist_parser.h"
 
 ABSL_FLAG(bool, show_clusters, false, "Show the logic clusters found.");
+ABSL_FLAG(std::vector<std::string>, modules, {},
+          "Comma-separated names of the modules to parse; the bodies of all "
+          "other modules are skipped. Modules instantiated by a named module "
+          "must be named as well. If empty, all modules are parsed.");
 
 namespace xls {
 namespace {
@@ -38,11 +47,21 @@ absl::Status RealMain(absl::string_view netlist_path,
                          netlist::CellLibrary::FromProto(cell_library_proto));
   }
 
-  XLS_ASSIGN_OR_RETURN(std::string netlist_text, GetFileContents(netlist_path));
-  netlist::rtl::Scanner scanner(netlist_text);
-  XLS_ASSIGN_OR_RETURN(
-      std::unique_ptr<netlist::rtl::Netlist> netlist,
-      netlist::rtl::Parser::ParseNetlist(&cell_library, &scanner));
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<netlist::rtl::Scanner> scanner,
+                       netlist::rtl::Scanner::FromFile(netlist_path));
+  std::vector<std::string> module_names = absl::GetFlag(FLAGS_modules);
+  std::unique_ptr<netlist::rtl::Netlist> netlist;
+  if (module_names.empty()) {
+    XLS_ASSIGN_OR_RETURN(netlist, netlist::rtl::Parser::ParseNetlist(
+                                      &cell_library, scanner.get()));
+  } else {
+    XLS_ASSIGN_OR_RETURN(
+        netlist, netlist::rtl::Parser::ParseNetlist(
+                     &cell_library, scanner.get(),
+                     absl::flat_hash_set<std::string>(module_names.begin(),
+                                                      module_names.end())));
+  }
+  XLS_RET_CHECK(!netlist->modules().empty()) << "No modules were parsed.";
   netlist::rtl::Module* module = netlist->modules()[0].get();
   std::cout << "nets:  " << module->nets().size() << std::endl;
   std::cout << "cells: " << module->cells().size() << std::endl;
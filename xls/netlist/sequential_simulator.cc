@@ -0,0 +1,193 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/netlist/sequential_simulator.h"
+
+#include <algorithm>
+#include <string>
+
+#include "absl/container/inlined_vector.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_format.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/netlist/cell_library.h"
+
+namespace xls {
+namespace netlist {
+
+/* static */ absl::StatusOr<std::unique_ptr<SequentialSimulator>>
+SequentialSimulator::Create(const rtl::Netlist* netlist,
+                            const rtl::Module* module) {
+  auto simulator = absl::WrapUnique(new SequentialSimulator(netlist));
+  XLS_ASSIGN_OR_RETURN(simulator->module_,
+                       simulator->compiled_netlist_.GetModule(module));
+
+  int32_t state_size = 0;
+  for (const CompiledModule::Step& flop : simulator->module_->flops()) {
+    rtl::NetRef clock = flop.cell->clock().value();
+    if (!simulator->clock_.has_value()) {
+      simulator->clock_ = clock;
+    } else if (simulator->clock_.value() != clock) {
+      return absl::UnimplementedError(absl::StrFormat(
+          "Module %s has flops clocked by different nets (%s and %s); only a "
+          "single clock is supported",
+          module->name(), simulator->clock_.value()->name(), clock->name()));
+    }
+    simulator->state_offsets_.push_back(state_size);
+    const CellLibraryEntry* entry = flop.cell->cell_library_entry();
+    state_size += entry->state_table().has_value()
+                      ? entry->state_table()->internal_signals().size()
+                      : flop.output_count;
+  }
+  if (simulator->clock_.has_value() &&
+      std::find(module->inputs().begin(), module->inputs().end(),
+                simulator->clock_.value()) == module->inputs().end()) {
+    return absl::UnimplementedError(absl::StrFormat(
+        "Clock %s of module %s is not a module input",
+        simulator->clock_.value()->name(), module->name()));
+  }
+
+  for (rtl::NetRef input : module->inputs()) {
+    if (simulator->clock_.has_value() && input == simulator->clock_.value()) {
+      continue;
+    }
+    XLS_ASSIGN_OR_RETURN(int32_t index, simulator->module_->GetNetIndex(input));
+    simulator->inputs_.push_back(input);
+    simulator->input_nets_.push_back(index);
+  }
+  simulator->state_.resize(state_size);
+  simulator->next_state_.resize(state_size);
+  simulator->stack_.resize(simulator->module_->max_stack_depth());
+  XLS_RETURN_IF_ERROR(simulator->Reset());
+  return simulator;
+}
+
+absl::Status SequentialSimulator::Reset() {
+  values_ = module_->NewState<uint8_t>();
+  std::fill(state_.begin(), state_.end(), 0);
+  cycle_ = 0;
+  return SetFlopOutputs();
+}
+
+absl::Status SequentialSimulator::SetFlopOutputs() {
+  absl::Span<const CompiledModule::Step> flops = module_->flops();
+  for (int64_t i = 0; i < flops.size(); ++i) {
+    const CompiledModule::Step& flop = flops[i];
+    absl::Span<const uint8_t> state =
+        absl::MakeConstSpan(state_).subspan(state_offsets_[i]);
+    absl::Span<const int32_t> inputs = module_->input_nets().subspan(
+        flop.input_offset, flop.input_count);
+    bool has_state_table =
+        flop.cell->cell_library_entry()->state_table().has_value();
+    for (int32_t j = 0; j < flop.output_count; ++j) {
+      int32_t net = module_->output_nets()[flop.output_offset + j];
+      if (has_state_table) {
+        values_[net] =
+            module_->output_functions()[flop.output_offset + j]
+                ->Evaluate<uint8_t>(values_, inputs, state, stack_.data());
+      } else {
+        values_[net] = state[j];
+      }
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status SequentialSimulator::ClockFlops() {
+  absl::Span<const CompiledModule::Step> flops = module_->flops();
+  StateTable::InputStimulus stimulus;
+  for (int64_t i = 0; i < flops.size(); ++i) {
+    const CompiledModule::Step& flop = flops[i];
+    absl::Span<const int32_t> inputs = module_->input_nets().subspan(
+        flop.input_offset, flop.input_count);
+    uint8_t* next_state = next_state_.data() + state_offsets_[i];
+    const CellLibraryEntry* entry = flop.cell->cell_library_entry();
+    if (!entry->state_table().has_value()) {
+      for (int32_t j = 0; j < flop.output_count; ++j) {
+        next_state[j] =
+            module_->output_functions()[flop.output_offset + j]
+                ->Evaluate<uint8_t>(values_, inputs, /*internals=*/{},
+                                    stack_.data());
+      }
+      continue;
+    }
+
+    // The internal signals are indexed in the iteration order of the state
+    // table's signal set, matching CompiledNetlist.
+    const StateTable& state_table = entry->state_table().value();
+    stimulus.clear();
+    for (int32_t j = 0; j < flop.input_count; ++j) {
+      stimulus[flop.cell->inputs()[j].name] = values_[inputs[j]];
+    }
+    int64_t signal_index = 0;
+    for (const std::string& signal : state_table.internal_signals()) {
+      stimulus[signal] = state_[state_offsets_[i] + signal_index++];
+    }
+    signal_index = 0;
+    for (const std::string& signal : state_table.internal_signals()) {
+      XLS_ASSIGN_OR_RETURN(bool value,
+                           state_table.GetSignalValue(stimulus, signal),
+                           _ << "evaluating flop " << flop.cell->name());
+      next_state[signal_index++] = value;
+    }
+  }
+  // Every flop's state was recomputed above, so the buffers can be swapped.
+  state_.swap(next_state_);
+  return SetFlopOutputs();
+}
+
+absl::StatusOr<std::vector<bool>> SequentialSimulator::Step(
+    absl::Span<const bool> inputs) {
+  if (inputs.size() != input_nets_.size()) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Expected %d input values, got %d", input_nets_.size(),
+        inputs.size()));
+  }
+  for (int64_t i = 0; i < inputs.size(); ++i) {
+    values_[input_nets_[i]] = inputs[i];
+  }
+  XLS_RETURN_IF_ERROR(module_->Evaluate(&values_));
+  std::vector<bool> outputs;
+  outputs.reserve(module_->module_outputs().size());
+  for (int32_t net : module_->module_outputs()) {
+    outputs.push_back(values_[net]);
+  }
+  XLS_RETURN_IF_ERROR(ClockFlops());
+  ++cycle_;
+  return outputs;
+}
+
+absl::StatusOr<std::vector<std::vector<bool>>> SequentialSimulator::Run(
+    absl::Span<const std::vector<bool>> stimulus) {
+  std::vector<std::vector<bool>> outputs;
+  outputs.reserve(stimulus.size());
+  absl::InlinedVector<bool, 64> cycle_inputs;
+  for (const std::vector<bool>& values : stimulus) {
+    cycle_inputs.assign(values.begin(), values.end());
+    XLS_ASSIGN_OR_RETURN(std::vector<bool> cycle_outputs, Step(cycle_inputs),
+                         _ << "in cycle " << cycle_);
+    outputs.push_back(std::move(cycle_outputs));
+  }
+  return outputs;
+}
+
+absl::StatusOr<bool> SequentialSimulator::GetNetValue(rtl::NetRef net) const {
+  XLS_ASSIGN_OR_RETURN(int32_t index, module_->GetNetIndex(net));
+  return values_[index] != 0;
+}
+
+}  // namespace netlist
+}  // namespace xls
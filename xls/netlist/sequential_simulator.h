@@ -0,0 +1,115 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_NETLIST_SEQUENTIAL_SIMULATOR_H_
+#define XLS_NETLIST_SEQUENTIAL_SIMULATOR_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "xls/netlist/compiled_netlist.h"
+#include "xls/netlist/netlist.h"
+
+namespace xls {
+namespace netlist {
+
+// Simulates a netlist module over clock cycles. Flops (cells whose cell library
+// entry has a clock_name()) hold state between cycles. Each cycle evaluates the
+// combinational logic once, in the levelized order of the module compiled with
+// CompiledNetlist::FlopMode::kSequential, and then clocks every flop.
+//
+// A flop either computes its next state with the functions of its output pins
+// (e.g., "D" for a Liberty "ff" group) or holds its state in state table
+// internal signals. In the latter case the table is presented with the flop's
+// inputs and the current values of its internal signals once per cycle, and
+// the outputs are functions of the internal signals.
+//
+// All flops must be clocked by the same module input. The clock is implied by
+// the cycle structure, so it is not part of the stimulus.
+class SequentialSimulator {
+ public:
+  // Creates a simulator for the given module of the netlist with all flops
+  // reset to zero. The netlist must outlive the simulator.
+  static absl::StatusOr<std::unique_ptr<SequentialSimulator>> Create(
+      const rtl::Netlist* netlist, const rtl::Module* module);
+
+  // The inputs which take a value each cycle: the inputs of the module other
+  // than the clock, in the order of rtl::Module::inputs().
+  absl::Span<const rtl::NetRef> inputs() const { return inputs_; }
+
+  // The clock input of the module, if the module contains flops.
+  const absl::optional<rtl::NetRef>& clock() const { return clock_; }
+
+  // Resets the state of all flops to zero.
+  absl::Status Reset();
+
+  // Simulates one clock cycle: applies the given input values (in the order of
+  // inputs()), evaluates the combinational logic, and clocks the flops.
+  // Returns the values of the module outputs as sampled before the clock edge,
+  // in the order of rtl::Module::outputs().
+  absl::StatusOr<std::vector<bool>> Step(absl::Span<const bool> inputs);
+
+  // Simulates one cycle per element of `stimulus` and returns the outputs of
+  // each cycle (see Step()).
+  absl::StatusOr<std::vector<std::vector<bool>>> Run(
+      absl::Span<const std::vector<bool>> stimulus);
+
+  // Returns the current value of the given net. Flop outputs hold the state
+  // clocked in at the end of the last cycle; all other nets hold their values
+  // from the last cycle, before the clock edge.
+  absl::StatusOr<bool> GetNetValue(rtl::NetRef net) const;
+
+  // The number of cycles simulated since the simulator was created or reset.
+  int64_t cycle() const { return cycle_; }
+
+ private:
+  explicit SequentialSimulator(const rtl::Netlist* netlist)
+      : compiled_netlist_(netlist, CompiledNetlist::FlopMode::kSequential) {}
+
+  // Sets the output nets of every flop from its state.
+  absl::Status SetFlopOutputs();
+
+  // Computes the next state of every flop from the current net values and then
+  // updates the state and the flop outputs.
+  absl::Status ClockFlops();
+
+  CompiledNetlist compiled_netlist_;
+  const CompiledModule* module_ = nullptr;
+  std::vector<rtl::NetRef> inputs_;
+  std::vector<int32_t> input_nets_;
+  absl::optional<rtl::NetRef> clock_;
+
+  // Net values indexed by net index. Nets other than the module inputs and
+  // flop outputs are recomputed every cycle.
+  std::vector<uint8_t> values_;
+
+  // The state of each flop is held in state_[state_offsets_[i]...]: one value
+  // per state table internal signal for state table flops and one value per
+  // output for other flops.
+  std::vector<int32_t> state_offsets_;
+  std::vector<uint8_t> state_;
+  std::vector<uint8_t> next_state_;
+  std::vector<uint8_t> stack_;
+  int64_t cycle_ = 0;
+};
+
+}  // namespace netlist
+}  // namespace xls
+
+#endif  // XLS_NETLIST_SEQUENTIAL_SIMULATOR_H_
@@ -0,0 +1,224 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/netlist/sequential_simulator.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "google/protobuf/text_format.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "xls/common/status/matchers.h"
+#include "xls/netlist/cell_library.h"
+#include "xls/netlist/fake_cell_library.h"
+#include "xls/netlist/netlist.h"
+#include "xls/netlist/netlist.pb.h"
+#include "xls/netlist/netlist_parser.h"
+
+namespace xls {
+namespace netlist {
+namespace {
+
+using status_testing::IsOkAndHolds;
+using status_testing::StatusIs;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+
+absl::StatusOr<std::unique_ptr<rtl::Netlist>> ParseNetlist(
+    CellLibrary* cell_library, const std::string& text) {
+  rtl::Scanner scanner(text);
+  return rtl::Parser::ParseNetlist(cell_library, &scanner);
+}
+
+TEST(SequentialSimulatorTest, Pipeline) {
+  // o0 is the AND of the inputs delayed by two cycles; o1 is combinational.
+  std::string netlist_text = R"(
+module main(clk, i0, i1, o0, o1);
+  input clk, i0, i1;
+  output o0, o1;
+  wire and_out, p0, p0_inv, p1;
+
+  AND and0 ( .A(i0), .B(i1), .Z(and_out) );
+  DFF p0_reg ( .D(and_out), .CLK(clk), .Q(p0) );
+  INV inv0 ( .A(p0), .ZN(p0_inv) );
+  DFF p1_reg ( .D(p0_inv), .CLK(clk), .Q(p1) );
+  INV inv1 ( .A(p1), .ZN(o0) );
+  OR or0 ( .A(i0), .B(i1), .Z(o1) );
+endmodule
+)";
+  XLS_ASSERT_OK_AND_ASSIGN(CellLibrary cell_library, MakeFakeCellLibrary());
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<rtl::Netlist> netlist,
+                           ParseNetlist(&cell_library, netlist_text));
+  XLS_ASSERT_OK_AND_ASSIGN(const rtl::Module* module,
+                           netlist->GetModule("main"));
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<SequentialSimulator> simulator,
+                           SequentialSimulator::Create(netlist.get(), module));
+  ASSERT_TRUE(simulator->clock().has_value());
+  EXPECT_EQ(simulator->clock().value()->name(), "clk");
+  ASSERT_EQ(simulator->inputs().size(), 2);
+  EXPECT_EQ(simulator->inputs()[0]->name(), "i0");
+  EXPECT_EQ(simulator->inputs()[1]->name(), "i1");
+
+  // The registers reset to zero, so o0 is one in the first cycle and p0's
+  // reset value in the second.
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::vector<std::vector<bool>> outputs,
+      simulator->Run({{true, true}, {false, true}, {true, true}, {false, false},
+                      {false, false}}));
+  EXPECT_THAT(outputs, ElementsAre(ElementsAre(true, true),
+                                   ElementsAre(false, true),
+                                   ElementsAre(true, true),
+                                   ElementsAre(false, false),
+                                   ElementsAre(true, false)));
+  EXPECT_EQ(simulator->cycle(), 5);
+
+  XLS_ASSERT_OK(simulator->Reset());
+  EXPECT_EQ(simulator->cycle(), 0);
+  XLS_ASSERT_OK_AND_ASSIGN(rtl::NetRef p1, module->ResolveNet("p1"));
+  EXPECT_THAT(simulator->GetNetValue(p1), IsOkAndHolds(false));
+  EXPECT_THAT(simulator->Step({true, true}),
+              IsOkAndHolds(ElementsAre(true, true)));
+  EXPECT_THAT(simulator->GetNetValue(p1), IsOkAndHolds(true));
+
+  EXPECT_THAT(simulator->Step({true}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Expected 2 input values, got 1")));
+}
+
+TEST(SequentialSimulatorTest, FeedbackThroughFlop) {
+  // A toggle flop: the loop through the inverter is broken by the register.
+  std::string netlist_text = R"(
+module main(clk, o0);
+  input clk;
+  output o0;
+  wire q, q_inv;
+
+  DFF toggle_reg ( .D(q_inv), .CLK(clk), .Q(q) );
+  INV inv0 ( .A(q), .ZN(q_inv) );
+  assign o0 = q;
+endmodule
+)";
+  XLS_ASSERT_OK_AND_ASSIGN(CellLibrary cell_library, MakeFakeCellLibrary());
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<rtl::Netlist> netlist,
+                           ParseNetlist(&cell_library, netlist_text));
+  XLS_ASSERT_OK_AND_ASSIGN(const rtl::Module* module,
+                           netlist->GetModule("main"));
+
+  // Evaluated combinationally the loop is a cycle.
+  CompiledNetlist combinational(netlist.get());
+  EXPECT_THAT(combinational.GetModule(module),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("combinational cycle")));
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<SequentialSimulator> simulator,
+                           SequentialSimulator::Create(netlist.get(), module));
+  EXPECT_TRUE(simulator->inputs().empty());
+  XLS_ASSERT_OK_AND_ASSIGN(std::vector<std::vector<bool>> outputs,
+                           simulator->Run({{}, {}, {}, {}}));
+  EXPECT_THAT(outputs, ElementsAre(ElementsAre(false), ElementsAre(true),
+                                   ElementsAre(false), ElementsAre(true)));
+}
+
+TEST(SequentialSimulatorTest, StateTableFlop) {
+  // A flop with an enable whose state is held in the internal signal IQ.
+  std::string entry_text = R"(
+kind: FLOP
+name: "EDFF"
+input_names: "D"
+input_names: "EN"
+clock_name: "CLK"
+output_pin_list {
+  pins { name: "Q" function: "IQ" }
+}
+state_table {
+  input_names: "D"
+  input_names: "EN"
+  internal_names: "IQ"
+  rows {
+    input_signals { key: "D" value: STATE_TABLE_SIGNAL_DONTCARE }
+    input_signals { key: "EN" value: STATE_TABLE_SIGNAL_LOW }
+    internal_signals { key: "IQ" value: STATE_TABLE_SIGNAL_DONTCARE }
+    next_internal_signals { key: "IQ" value: STATE_TABLE_SIGNAL_NOCHANGE }
+  }
+  rows {
+    input_signals { key: "D" value: STATE_TABLE_SIGNAL_HIGH }
+    input_signals { key: "EN" value: STATE_TABLE_SIGNAL_HIGH }
+    internal_signals { key: "IQ" value: STATE_TABLE_SIGNAL_DONTCARE }
+    next_internal_signals { key: "IQ" value: STATE_TABLE_SIGNAL_HIGH }
+  }
+  rows {
+    input_signals { key: "D" value: STATE_TABLE_SIGNAL_LOW }
+    input_signals { key: "EN" value: STATE_TABLE_SIGNAL_HIGH }
+    internal_signals { key: "IQ" value: STATE_TABLE_SIGNAL_DONTCARE }
+    next_internal_signals { key: "IQ" value: STATE_TABLE_SIGNAL_LOW }
+  }
+}
+)";
+  CellLibraryEntryProto entry_proto;
+  ASSERT_TRUE(
+      google::protobuf::TextFormat::ParseFromString(entry_text, &entry_proto));
+  XLS_ASSERT_OK_AND_ASSIGN(CellLibraryEntry entry,
+                           CellLibraryEntry::FromProto(entry_proto));
+  XLS_ASSERT_OK_AND_ASSIGN(CellLibrary cell_library, MakeFakeCellLibrary());
+  XLS_ASSERT_OK(cell_library.AddEntry(entry));
+
+  std::string netlist_text = R"(
+module main(clk, d, en, o0);
+  input clk, d, en;
+  output o0;
+
+  EDFF reg0 ( .D(d), .EN(en), .CLK(clk), .Q(o0) );
+endmodule
+)";
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<rtl::Netlist> netlist,
+                           ParseNetlist(&cell_library, netlist_text));
+  XLS_ASSERT_OK_AND_ASSIGN(const rtl::Module* module,
+                           netlist->GetModule("main"));
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<SequentialSimulator> simulator,
+                           SequentialSimulator::Create(netlist.get(), module));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::vector<std::vector<bool>> outputs,
+      simulator->Run({{true, false}, {true, true}, {false, false},
+                      {false, false}, {false, true}, {true, false}}));
+  EXPECT_THAT(outputs, ElementsAre(ElementsAre(false), ElementsAre(false),
+                                   ElementsAre(true), ElementsAre(true),
+                                   ElementsAre(true), ElementsAre(false)));
+}
+
+TEST(SequentialSimulatorTest, MultipleClocks) {
+  std::string netlist_text = R"(
+module main(clk0, clk1, i0, o0);
+  input clk0, clk1, i0;
+  output o0;
+  wire p0;
+
+  DFF p0_reg ( .D(i0), .CLK(clk0), .Q(p0) );
+  DFF p1_reg ( .D(p0), .CLK(clk1), .Q(o0) );
+endmodule
+)";
+  XLS_ASSERT_OK_AND_ASSIGN(CellLibrary cell_library, MakeFakeCellLibrary());
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<rtl::Netlist> netlist,
+                           ParseNetlist(&cell_library, netlist_text));
+  XLS_ASSERT_OK_AND_ASSIGN(const rtl::Module* module,
+                           netlist->GetModule("main"));
+  EXPECT_THAT(SequentialSimulator::Create(netlist.get(), module),
+              StatusIs(absl::StatusCode::kUnimplemented,
+                       HasSubstr("clocked by different nets")));
+}
+
+}  // namespace
+}  // namespace netlist
+}  // namespace xls
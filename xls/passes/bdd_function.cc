@@ -14,6 +14,9 @@
 
 #include "xls/passes/bdd_function.h"
 
+#include <algorithm>
+#include <functional>
+#include <numeric>
 #include <vector>
 
 #include "absl/container/flat_hash_set.h"
@@ -80,8 +83,11 @@ BddNodeVector ToBddNodeVector(const SaturatingBddNodeVector& input) {
 class SaturatingBddEvaluator
     : public AbstractEvaluator<SaturatingBddNodeIndex, SaturatingBddEvaluator> {
  public:
-  SaturatingBddEvaluator(int64_t path_limit, BinaryDecisionDiagram* bdd)
-      : path_limit_(path_limit), bdd_(bdd) {}
+  SaturatingBddEvaluator(int64_t path_limit, int64_t memory_limit_bytes,
+                         BinaryDecisionDiagram* bdd)
+      : path_limit_(path_limit),
+        memory_limit_bytes_(memory_limit_bytes),
+        bdd_(bdd) {}
 
   SaturatingBddNodeIndex One() const { return bdd_->one(); }
 
@@ -92,7 +98,7 @@ class SaturatingBddEvaluator
       return TooManyPaths();
     }
     BddNodeIndex result = bdd_->Not(absl::get<BddNodeIndex>(input));
-    if (path_limit_ > 0 && bdd_->path_count(result) > path_limit_) {
+    if (IsSaturated(result)) {
       return TooManyPaths();
     }
     return result;
@@ -106,7 +112,7 @@ class SaturatingBddEvaluator
     }
     BddNodeIndex result =
         bdd_->And(absl::get<BddNodeIndex>(a), absl::get<BddNodeIndex>(b));
-    if (path_limit_ > 0 && bdd_->path_count(result) > path_limit_) {
+    if (IsSaturated(result)) {
       return TooManyPaths();
     }
     return result;
@@ -120,14 +126,23 @@ class SaturatingBddEvaluator
     }
     BddNodeIndex result =
         bdd_->Or(absl::get<BddNodeIndex>(a), absl::get<BddNodeIndex>(b));
-    if (path_limit_ > 0 && bdd_->path_count(result) > path_limit_) {
+    if (IsSaturated(result)) {
       return TooManyPaths();
     }
     return result;
   }
 
  private:
+  // Returns true if the given result exceeds the path limit or the BDD exceeds
+  // the memory limit.
+  bool IsSaturated(BddNodeIndex result) const {
+    return (path_limit_ > 0 && bdd_->path_count(result) > path_limit_) ||
+           (memory_limit_bytes_ > 0 &&
+            bdd_->GetMemoryUsageBytes() > memory_limit_bytes_);
+  }
+
   int64_t path_limit_;
+  int64_t memory_limit_bytes_;
   BinaryDecisionDiagram* bdd_;
 };
 
@@ -254,56 +269,188 @@ bool ShouldEvaluate(Node* node) {
 
 /* static */ absl::StatusOr<std::unique_ptr<BddFunction>> BddFunction::Run(
     FunctionBase* f, int64_t path_limit,
-    absl::Span<const Op> do_not_evaluate_ops) {
+    absl::Span<const Op> do_not_evaluate_ops, int64_t memory_limit_bytes) {
   XLS_VLOG(1) << absl::StreamFormat("BddFunction::Run(%s):", f->name());
   XLS_VLOG_LINES(5, f->DumpIr());
 
-  auto bdd_function = absl::WrapUnique(new BddFunction(f));
-  SaturatingBddEvaluator evaluator(path_limit, &bdd_function->bdd());
-  absl::flat_hash_set<Op> do_not_evaluate_ops_set;
-  for (Op op : do_not_evaluate_ops) {
-    do_not_evaluate_ops_set.insert(op);
+  auto bdd_function = absl::WrapUnique(new BddFunction(
+      f, path_limit, do_not_evaluate_ops, memory_limit_bytes));
+  bdd_function->AssignParamVariables();
+  XLS_VLOG(3) << "BDD expressions:";
+  XLS_RETURN_IF_ERROR(bdd_function->EvaluateNodes(TopoSort(f).AsVector()));
+  return std::move(bdd_function);
+}
+
+absl::Status BddFunction::Update(absl::Span<Node* const> stale_nodes,
+                                 absl::Span<Node* const> removed_nodes) {
+  XLS_VLOG(1) << absl::StreamFormat(
+      "BddFunction::Update(%s): %d stale nodes, %d removed nodes",
+      func_base_->name(), stale_nodes.size(), removed_nodes.size());
+  for (Node* node : removed_nodes) {
+    node_map_.erase(node);
+    saturated_expressions_.erase(node);
+  }
+  for (Node* node : stale_nodes) {
+    node_map_.erase(node);
+    saturated_expressions_.erase(node);
+  }
+  return EvaluateNodes(stale_nodes);
+}
+
+void BddFunction::MaybeCollectGarbageOrReorder() {
+  // Reorder (which includes collection) when the BDD has doubled in size since
+  // the last reordering. Collect when the BDD has doubled in size since the
+  // last collection. When over the memory limit collect earlier, but only once
+  // the BDD has grown appreciably to avoid repeatedly collecting when little
+  // can be reclaimed.
+  bool over_memory_limit = memory_limit_bytes_ > 0 &&
+                           bdd_.GetMemoryUsageBytes() > memory_limit_bytes_;
+  bool reorder = bdd_.size() >= std::max(kMinReorderSize,
+                                         2 * size_after_reorder_);
+  if (!reorder &&
+      bdd_.size() < std::max(kMinGarbageCollectionSize, 2 * size_after_gc_) &&
+      !(over_memory_limit && bdd_.size() > size_after_gc_ * 9 / 8)) {
+    return;
+  }
+  std::vector<BddNodeIndex> roots;
+  for (const auto& [node, bdd_nodes] : node_map_) {
+    roots.insert(roots.end(), bdd_nodes.begin(), bdd_nodes.end());
+  }
+  if (reorder) {
+    bdd_.Sift(roots);
+    size_after_reorder_ = bdd_.size();
+  } else {
+    bdd_.GarbageCollect(roots);
+  }
+  size_after_gc_ = bdd_.size();
+}
+
+namespace {
+
+// Returns the parameters of 'f' grouped such that parameters in the same group
+// are (transitively) combined by some node. For example, the parameters x and
+// y of and(x, y) or of add(not(x), y) are in the same group. The groups are
+// ordered by their first parameter.
+std::vector<std::vector<Param*>> GroupCombinedParams(FunctionBase* f) {
+  std::vector<Param*> params;
+  absl::flat_hash_map<Node*, int64_t> param_indices;
+  for (Param* param : f->params()) {
+    if (param->GetType()->IsBits()) {
+      param_indices[param] = params.size();
+      params.push_back(param);
+    }
+  }
+
+  // Union-find over the parameter indices.
+  std::vector<int64_t> parents(params.size());
+  std::iota(parents.begin(), parents.end(), 0);
+  std::function<int64_t(int64_t)> find = [&](int64_t i) {
+    return parents[i] == i ? i : parents[i] = find(parents[i]);
+  };
+
+  // The (representatives of the) parameter groups each node depends on.
+  absl::flat_hash_map<Node*, std::vector<int64_t>> node_groups;
+  for (Node* node : TopoSort(f)) {
+    std::vector<int64_t> groups;
+    if (param_indices.contains(node)) {
+      groups.push_back(param_indices.at(node));
+    }
+    for (Node* operand : node->operands()) {
+      for (int64_t group : node_groups.at(operand)) {
+        groups.push_back(find(group));
+      }
+    }
+    std::sort(groups.begin(), groups.end());
+    groups.erase(std::unique(groups.begin(), groups.end()), groups.end());
+    // Aggregates place their operands side by side rather than combining
+    // them.
+    bool combines = node->operand_count() > 1 && node->op() != Op::kConcat &&
+                    node->op() != Op::kTuple && node->op() != Op::kArray;
+    if (combines && groups.size() > 1) {
+      for (int64_t group : groups) {
+        parents[find(group)] = find(groups.front());
+      }
+      groups = {find(groups.front())};
+    }
+    node_groups[node] = std::move(groups);
+  }
+
+  absl::flat_hash_map<int64_t, int64_t> group_positions;
+  std::vector<std::vector<Param*>> result;
+  for (int64_t i = 0; i < params.size(); ++i) {
+    auto [it, inserted] = group_positions.insert({find(i), result.size()});
+    if (inserted) {
+      result.emplace_back();
+    }
+    result[it->second].push_back(params[i]);
+  }
+  return result;
+}
+
+}  // namespace
+
+void BddFunction::AssignParamVariables() {
+  for (const std::vector<Param*>& group : GroupCombinedParams(func_base_)) {
+    int64_t max_bit_count = 0;
+    for (Param* param : group) {
+      node_map_[param].resize(param->BitCountOrDie());
+      saturated_expressions_.insert(param);
+      max_bit_count = std::max(max_bit_count, param->BitCountOrDie());
+    }
+    for (int64_t bit_index = 0; bit_index < max_bit_count; ++bit_index) {
+      for (Param* param : group) {
+        if (bit_index < param->BitCountOrDie()) {
+          node_map_[param][bit_index] = bdd_.NewVariable();
+        }
+      }
+    }
   }
+}
+
+absl::Status BddFunction::EvaluateNodes(absl::Span<Node* const> nodes) {
+  SaturatingBddEvaluator evaluator(path_limit_, memory_limit_bytes_, &bdd_);
 
   // Create and return a vector containing newly defined BDD variables.
   auto create_new_node_vector = [&](Node* n) {
     SaturatingBddNodeVector v;
     for (int64_t i = 0; i < n->BitCountOrDie(); ++i) {
-      v.push_back(bdd_function->bdd().NewVariable());
+      v.push_back(bdd_.NewVariable());
     }
-    bdd_function->saturated_expressions_.insert(n);
+    saturated_expressions_.insert(n);
     return v;
   };
 
-  XLS_VLOG(3) << "BDD expressions:";
-  absl::flat_hash_map<Node*, SaturatingBddNodeVector> values;
-  for (Node* node : TopoSort(f)) {
-    if (!node->GetType()->IsBits()) {
+  for (Node* node : nodes) {
+    // Parameters may already have been assigned variables (see
+    // AssignParamVariables).
+    if (!node->GetType()->IsBits() || node_map_.contains(node)) {
       continue;
     }
+    SaturatingBddNodeVector value;
     // If we shouldn't evaluate this node, the node is to be modeled as
     // variables, or the node includes some non-bits-typed operands, then just
     // create a vector of new BDD variables for this node.
-    if (!ShouldEvaluate(node) || do_not_evaluate_ops_set.contains(node->op()) ||
+    if (!ShouldEvaluate(node) || do_not_evaluate_ops_.contains(node->op()) ||
         std::any_of(node->operands().begin(), node->operands().end(),
                     [](Node* o) { return !o->GetType()->IsBits(); })) {
-      values[node] = create_new_node_vector(node);
+      value = create_new_node_vector(node);
     } else {
       std::vector<SaturatingBddNodeVector> operand_values;
       for (Node* operand : node->operands()) {
-        operand_values.push_back(values.at(operand));
+        const BddNodeVector& operand_vector = node_map_.at(operand);
+        operand_values.emplace_back(operand_vector.begin(),
+                                    operand_vector.end());
       }
       XLS_ASSIGN_OR_RETURN(
-          values[node],
-          AbstractEvaluate(node, operand_values, &evaluator,
-                           /*default_handler=*/create_new_node_vector));
+          value, AbstractEvaluate(node, operand_values, &evaluator,
+                                  /*default_handler=*/create_new_node_vector));
 
       // Associate a new BDD variable with each bit that exceeded the path
       // limit.
-      for (SaturatingBddNodeIndex& value : values.at(node)) {
-        if (absl::holds_alternative<TooManyPaths>(value)) {
-          bdd_function->saturated_expressions_.insert(node);
-          value = bdd_function->bdd().NewVariable();
+      for (SaturatingBddNodeIndex& bit : value) {
+        if (absl::holds_alternative<TooManyPaths>(bit)) {
+          saturated_expressions_.insert(node);
+          bit = bdd_.NewVariable();
         }
       }
     }
@@ -311,19 +458,18 @@ bool ShouldEvaluate(Node* node) {
     for (int64_t i = 0; i < node->BitCountOrDie(); ++i) {
       XLS_VLOG(5) << absl::StreamFormat(
           "    bit %d : %s", i,
-          bdd_function->bdd().ToStringDnf(
-              absl::get<BddNodeIndex>(values.at(node)[i]),
-              /*minterm_limit=*/15));
+          bdd_.ToStringDnf(absl::get<BddNodeIndex>(value[i]),
+                           /*minterm_limit=*/15));
     }
-  }
+    // At this point any TooManyPaths sentinel values have been replaced with
+    // new BDD variables.
+    node_map_[node] = ToBddNodeVector(value);
 
-  // Copy over the vector and BDD variables into the node map which is exposed
-  // via the BddFunction interface. At this point any TooManyPaths sentinel
-  // values have been replaced with new Bdd variables.
-  for (const auto& pair : values) {
-    bdd_function->node_map_[pair.first] = ToBddNodeVector(pair.second);
+    // Only the expressions in the node map are live between evaluations of
+    // nodes.
+    MaybeCollectGarbageOrReorder();
   }
-  return std::move(bdd_function);
+  return absl::OkStatus();
 }
 
 absl::StatusOr<Value> BddFunction::Evaluate(
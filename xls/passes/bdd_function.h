@@ -16,7 +16,10 @@
 #define XLS_PASSES_BDD_FUNCTION_H_
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/types/span.h"
 #include "xls/common/logging/logging.h"
 #include "xls/data_structures/binary_decision_diagram.h"
 #include "xls/data_structures/leaf_type_tree.h"
@@ -52,9 +55,30 @@ class BddFunction {
   // 'do_not_evaluate_ops', its bits are modeled as BDD variables. Otherwise,
   // bits are represented as BDD nodes whose values are determined by the values
   // of other BDD nodes.
+  //
+  // The bits of parameters which are combined by some node are interleaved in
+  // the initial variable order (bit 0 of each parameter, then bit 1 and so on)
+  // as this yields compact BDDs for bitwise datapaths and comparisons.
+  // Whenever the BDD has doubled in size the variables are reordered by
+  // sifting (see BinaryDecisionDiagram::Sift).
+  //
+  // BDD nodes which are no longer referenced by any XLS node's expression are
+  // periodically garbage collected. If 'memory_limit_bytes' is non-zero and
+  // the (estimated) memory used by the BDD exceeds it, bits are modeled as new
+  // BDD variables in the same way as bits exceeding the path limit until
+  // garbage collection brings the BDD back under the limit. This trades
+  // precision for bounded memory use on large functions.
   static absl::StatusOr<std::unique_ptr<BddFunction>> Run(
       FunctionBase* f, int64_t path_limit = 0,
-      absl::Span<const Op> do_not_evaluate_ops = {});
+      absl::Span<const Op> do_not_evaluate_ops = {},
+      int64_t memory_limit_bytes = 0);
+
+  // Recomputes the BDD expressions of 'stale_nodes' after the function was
+  // modified and forgets the expressions of 'removed_nodes' (which are not
+  // dereferenced). 'stale_nodes' must be in topological order and must include
+  // all transitive users of any node whose expression may have changed.
+  absl::Status Update(absl::Span<Node* const> stale_nodes,
+                      absl::Span<Node* const> removed_nodes);
 
   // Returns the underlying BDD.
   const BinaryDecisionDiagram& bdd() const { return bdd_; }
@@ -74,11 +98,46 @@ class BddFunction {
   absl::StatusOr<Value> Evaluate(absl::Span<const Value> args) const;
 
  private:
-  explicit BddFunction(FunctionBase* f) : func_base_(f) {}
+  // The BDD is not garbage collected until it has at least this many nodes.
+  static constexpr int64_t kMinGarbageCollectionSize = 64 * 1024;
+
+  // The variables of the BDD are not reordered until it has at least this
+  // many nodes.
+  static constexpr int64_t kMinReorderSize = 16 * 1024;
+
+  BddFunction(FunctionBase* f, int64_t path_limit,
+              absl::Span<const Op> do_not_evaluate_ops,
+              int64_t memory_limit_bytes)
+      : func_base_(f),
+        path_limit_(path_limit),
+        memory_limit_bytes_(memory_limit_bytes),
+        do_not_evaluate_ops_(do_not_evaluate_ops.begin(),
+                             do_not_evaluate_ops.end()) {}
+
+  // Reorders the variables of or garbage collects the BDD with the
+  // expressions in the node map as roots if it has grown sufficiently since
+  // the last reordering or collection.
+  void MaybeCollectGarbageOrReorder();
+
+  // Creates the variables for the bits of the parameters, interleaving the bits
+  // of parameters which are combined with each other.
+  void AssignParamVariables();
+
+  // Computes the BDD expressions of the given nodes. The expressions of the
+  // operands of each node must already be computed.
+  absl::Status EvaluateNodes(absl::Span<Node* const> nodes);
 
   FunctionBase* func_base_;
+  int64_t path_limit_;
+  int64_t memory_limit_bytes_;
+  absl::flat_hash_set<Op> do_not_evaluate_ops_;
   BinaryDecisionDiagram bdd_;
 
+  // The number of BDD nodes after the last garbage collection and the last
+  // reordering.
+  int64_t size_after_gc_ = 0;
+  int64_t size_after_reorder_ = 0;
+
   // A map from XLS Node to vector of BDD nodes representing the XLS Node's
   // expression.
   NodeMap node_map_;
@@ -112,6 +112,96 @@ TEST_F(BddFunctionTest, Parity) {
   }
 }
 
+TEST_F(BddFunctionTest, MemoryLimit) {
+  // Equality of the two halves of a value whose bits are ordered x0..x31 in
+  // the BDD requires a number of BDD nodes exponential in the bit width.
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(32));
+  fb.AndReduce(
+      fb.Not(fb.Xor(fb.BitSlice(x, 0, 16), fb.BitSlice(x, 16, 16))));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  const int64_t kMemoryLimit = 64 * 1024;
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<BddFunction> limited,
+      BddFunction::Run(f, /*path_limit=*/0, /*do_not_evaluate_ops=*/{},
+                       /*memory_limit_bytes=*/kMemoryLimit));
+  EXPECT_LT(limited->bdd().GetMemoryUsageBytes(), 2 * kMemoryLimit);
+
+  // Precision is lost but the results are still correct.
+  EXPECT_TRUE(limited->bdd().IsVariableBaseNode(
+      limited->GetBddNode(f->return_value(), 0)));
+  std::minstd_rand engine;
+  for (int64_t i = 0; i < 100; ++i) {
+    std::vector<Value> inputs = RandomFunctionArguments(f, &engine);
+    if (i % 2 == 0) {
+      uint64_t half = inputs[0].bits().ToUint64().value() & 0xffff;
+      inputs[0] = Value(UBits(half << 16 | half, 32));
+    }
+    XLS_ASSERT_OK_AND_ASSIGN(
+        Value expected, DropInterpreterEvents(InterpretFunction(f, inputs)));
+    EXPECT_THAT(limited->Evaluate(inputs), IsOkAndHolds(expected));
+  }
+}
+
+TEST_F(BddFunctionTest, InterleavedParams) {
+  // The bits of the two parameters are interleaved in the variable order so
+  // their equality has a BDD linear in the bit width.
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(32));
+  BValue y = fb.Param("y", p->GetBitsType(32));
+  fb.AndReduce(fb.Not(fb.Xor(x, y)));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<BddFunction> bdd_function,
+                           BddFunction::Run(f));
+  EXPECT_LT(bdd_function->bdd().size(), 10000);
+  EXPECT_FALSE(bdd_function->bdd().IsVariableBaseNode(
+      bdd_function->GetBddNode(f->return_value(), 0)));
+  for (int64_t i = 0; i < 32; ++i) {
+    EXPECT_EQ(bdd_function->bdd().GetVariableLevel(
+                  bdd_function->bdd()
+                      .GetNode(bdd_function->GetBddNode(y.node(), i))
+                      .variable),
+              2 * i + 1);
+  }
+  EXPECT_THAT(bdd_function->Evaluate({Value(UBits(0x12345678, 32)),
+                                      Value(UBits(0x12345678, 32))}),
+              IsOkAndHolds(Value(UBits(1, 1))));
+  EXPECT_THAT(bdd_function->Evaluate({Value(UBits(0x12345678, 32)),
+                                      Value(UBits(0x12345679, 32))}),
+              IsOkAndHolds(Value(UBits(0, 1))));
+}
+
+TEST_F(BddFunctionTest, Reordering) {
+  // The BDD of the equality of the two halves of a value is exponential in the
+  // initial variable order but linear after reordering.
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(32));
+  BValue eq = fb.AndReduce(
+      fb.Not(fb.Xor(fb.BitSlice(x, 0, 16), fb.BitSlice(x, 16, 16))));
+  fb.Or(eq, fb.BitSlice(x, 0, 1));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<BddFunction> bdd_function,
+                           BddFunction::Run(f));
+  EXPECT_LT(bdd_function->bdd().size(), 1000);
+  std::minstd_rand engine;
+  for (int64_t i = 0; i < 100; ++i) {
+    std::vector<Value> inputs = RandomFunctionArguments(f, &engine);
+    if (i % 2 == 0) {
+      uint64_t half = inputs[0].bits().ToUint64().value() & 0xffff;
+      inputs[0] = Value(UBits(half << 16 | half, 32));
+    }
+    XLS_ASSERT_OK_AND_ASSIGN(
+        Value expected, DropInterpreterEvents(InterpretFunction(f, inputs)));
+    EXPECT_THAT(bdd_function->Evaluate(inputs), IsOkAndHolds(expected));
+  }
+}
+
 TEST_F(BddFunctionTest, BenchmarkTest) {
   // Run samples through various bechmarks and verify against the interpreter.
   //
@@ -28,47 +28,75 @@ namespace xls {
 
 absl::StatusOr<ReachedFixpoint> BddQueryEngine::Populate(FunctionBase* f) {
   XLS_ASSIGN_OR_RETURN(bdd_function_,
-                       BddFunction::Run(f, path_limit_, do_not_evaluate_ops_));
-  // Construct the Bits objects indication which bit values are statically known
-  // for each node and what those values are (0 or 1) if known.
-  BinaryDecisionDiagram& bdd = this->bdd();
+                       BddFunction::Run(f, path_limit_, do_not_evaluate_ops_,
+                                        memory_limit_bytes_));
+  tracker_.Record(f);
   ReachedFixpoint rf = ReachedFixpoint::Unchanged;
   for (Node* node : f->nodes()) {
-    if (node->GetType()->IsBits()) {
-      absl::InlinedVector<bool, 1> known_bits;
-      absl::InlinedVector<bool, 1> bits_values;
-      for (int64_t i = 0; i < node->BitCountOrDie(); ++i) {
-        if (GetBddNode(TreeBitLocation(node, i)) == bdd.zero()) {
-          known_bits.push_back(true);
-          bits_values.push_back(false);
-        } else if (GetBddNode(TreeBitLocation(node, i)) == bdd.one()) {
-          known_bits.push_back(true);
-          bits_values.push_back(true);
-        } else {
-          known_bits.push_back(false);
-          bits_values.push_back(false);
-        }
-      }
-      if (!known_bits_.contains(node)) {
-        known_bits_[node] = Bits(known_bits.size());
-        bits_values_[node] = Bits(bits_values.size());
-      }
-      Bits new_known_bits(known_bits);
-      Bits new_bits_values(bits_values);
-      // TODO(taktoa): check for inconsistency
-      Bits ored_known_bits = bits_ops::Or(known_bits_[node], new_known_bits);
-      Bits ored_bits_values = bits_ops::Or(bits_values_[node], new_bits_values);
-      if ((ored_known_bits != known_bits_[node]) ||
-          (ored_bits_values != bits_values_[node])) {
-        rf = ReachedFixpoint::Changed;
-      }
-      known_bits_[node] = ored_known_bits;
-      bits_values_[node] = ored_bits_values;
+    if (node->GetType()->IsBits() && UpdateKnownBits(node)) {
+      rf = ReachedFixpoint::Changed;
     }
   }
   return rf;
 }
 
+absl::StatusOr<ReachedFixpoint> BddQueryEngine::Update(
+    FunctionBase* f, absl::Span<Node* const> invalidated) {
+  if (bdd_function_ == nullptr) {
+    return Populate(f);
+  }
+  NodeStructureTracker::Changes changes = tracker_.Update(f, invalidated);
+  XLS_RETURN_IF_ERROR(
+      bdd_function_->Update(changes.stale_nodes, changes.removed_nodes));
+  for (Node* node : changes.removed_nodes) {
+    known_bits_.erase(node);
+    bits_values_.erase(node);
+  }
+  for (Node* node : changes.stale_nodes) {
+    known_bits_.erase(node);
+    bits_values_.erase(node);
+    if (node->GetType()->IsBits()) {
+      UpdateKnownBits(node);
+    }
+  }
+  return changes.stale_nodes.empty() ? ReachedFixpoint::Unchanged
+                                     : ReachedFixpoint::Changed;
+}
+
+bool BddQueryEngine::UpdateKnownBits(Node* node) {
+  // Construct the Bits objects indication which bit values are statically known
+  // for each node and what those values are (0 or 1) if known.
+  BinaryDecisionDiagram& bdd = this->bdd();
+  absl::InlinedVector<bool, 1> known_bits;
+  absl::InlinedVector<bool, 1> bits_values;
+  for (int64_t i = 0; i < node->BitCountOrDie(); ++i) {
+    if (GetBddNode(TreeBitLocation(node, i)) == bdd.zero()) {
+      known_bits.push_back(true);
+      bits_values.push_back(false);
+    } else if (GetBddNode(TreeBitLocation(node, i)) == bdd.one()) {
+      known_bits.push_back(true);
+      bits_values.push_back(true);
+    } else {
+      known_bits.push_back(false);
+      bits_values.push_back(false);
+    }
+  }
+  if (!known_bits_.contains(node)) {
+    known_bits_[node] = Bits(known_bits.size());
+    bits_values_[node] = Bits(bits_values.size());
+  }
+  Bits new_known_bits(known_bits);
+  Bits new_bits_values(bits_values);
+  // TODO(taktoa): check for inconsistency
+  Bits ored_known_bits = bits_ops::Or(known_bits_[node], new_known_bits);
+  Bits ored_bits_values = bits_ops::Or(bits_values_[node], new_bits_values);
+  bool changed = (ored_known_bits != known_bits_[node]) ||
+                 (ored_bits_values != bits_values_[node]);
+  known_bits_[node] = ored_known_bits;
+  bits_values_[node] = ored_bits_values;
+  return changed;
+}
+
 bool BddQueryEngine::AtMostOneTrue(
     absl::Span<TreeBitLocation const> bits) const {
   BddNodeIndex result = bdd().zero();
@@ -39,15 +39,24 @@ class BddQueryEngine : public QueryEngine {
   // 'path_limit' is the maximum number of paths from the BDD node to the
   // terminals 0 and 1 to allow for a BDD expression before truncating it. If a
   // node's op is in 'do_not_evaluate_ops', its bits are modeled as BDD
-  // variables. See BddFunction for details.
+  // variables. 'memory_limit_bytes' bounds the memory used by the BDD (zero
+  // means no limit). See BddFunction for details.
   explicit BddQueryEngine(int64_t path_limit = 0,
-                          absl::Span<const Op> do_not_evaluate_ops = {})
+                          absl::Span<const Op> do_not_evaluate_ops = {},
+                          int64_t memory_limit_bytes = 0)
       : path_limit_(path_limit),
+        memory_limit_bytes_(memory_limit_bytes),
         do_not_evaluate_ops_(do_not_evaluate_ops.begin(),
                              do_not_evaluate_ops.end()) {}
 
   absl::StatusOr<ReachedFixpoint> Populate(FunctionBase* f) override;
 
+  // Updates the BDD expressions and known bits of the nodes affected by
+  // modifications of 'f' since the last call to Populate or Update. The BDD
+  // itself is retained so unchanged nodes keep their expressions.
+  absl::StatusOr<ReachedFixpoint> Update(
+      FunctionBase* f, absl::Span<Node* const> invalidated = {}) override;
+
   bool IsTracked(Node* node) const override {
     return known_bits_.contains(node);
   }
@@ -93,6 +102,10 @@ class BddQueryEngine : public QueryEngine {
   // A implies B  <=>  !(A && !B)
   bool Implies(const BddNodeIndex& a, const BddNodeIndex& b) const;
 
+  // Merges the bits of the given node which are known according to the BDD into
+  // known_bits_ and bits_values_. Returns true if any information was added.
+  bool UpdateKnownBits(Node* node);
+
   // Returns true if the expression of the given BDD node exceeds the path
   // limit.
   // TODO(meheff): This should be part of the BDD itself where a query can be
@@ -105,6 +118,9 @@ class BddQueryEngine : public QueryEngine {
   // The maximum number of paths in expression in the BDD before truncating.
   int64_t path_limit_;
 
+  // The limit on the memory used by the BDD. Zero means no limit.
+  int64_t memory_limit_bytes_;
+
   // If something is in this list, its bits are modelled as BDD variables.
   // See BddFunction for details.
   std::vector<Op> do_not_evaluate_ops_;
@@ -116,6 +132,9 @@ class BddQueryEngine : public QueryEngine {
   absl::flat_hash_map<Node*, Bits> bits_values_;
 
   std::unique_ptr<BddFunction> bdd_function_;
+
+  // Structure of the nodes at the last Populate or Update call.
+  NodeStructureTracker tracker_;
 };
 
 }  // namespace xls
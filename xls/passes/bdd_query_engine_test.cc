@@ -25,11 +25,14 @@
 #include "xls/ir/function.h"
 #include "xls/ir/function_builder.h"
 #include "xls/ir/ir_test_base.h"
+#include "xls/ir/nodes.h"
 #include "xls/ir/package.h"
 
 namespace xls {
 namespace {
 
+using status_testing::IsOkAndHolds;
+
 class BddQueryEngineTest : public IrTestBase {
  protected:
   // Convenience methods for testing implication, equality, and inverse for
@@ -290,5 +293,40 @@ TEST_F(BddQueryEngineTest, BitValuesImplyNodeValuePredicateAlwaysFalse) {
   EXPECT_FALSE(result.has_value());
 }
 
+TEST_F(BddQueryEngineTest, UpdateAfterModification) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
+fn f(x: bits[8], y: bits[8]) -> bits[8] {
+  literal.1: bits[8] = literal(value=0x0f)
+  and.2: bits[8] = and(x, literal.1)
+  and.3: bits[8] = and(y, literal.1)
+  ret xor.4: bits[8] = xor(and.2, and.3)
+}
+)",
+                                                       p.get()));
+  BddQueryEngine query_engine;
+  XLS_ASSERT_OK(query_engine.Populate(f).status());
+  EXPECT_EQ(query_engine.ToString(f->return_value()), "0b0000_XXXX");
+
+  // Make both sides of the comparison the same value.
+  Node* and_node = FindNode("and.3", f);
+  XLS_ASSERT_OK(and_node->ReplaceOperandNumber(0, f->param(0)));
+  EXPECT_THAT(query_engine.Update(f), IsOkAndHolds(ReachedFixpoint::Changed));
+  EXPECT_EQ(query_engine.ToString(f->return_value()), "0b0000_0000");
+  EXPECT_TRUE(query_engine.KnownEquals(
+      TreeBitLocation(and_node, 0), TreeBitLocation(FindNode("and.2", f), 0)));
+
+  // Remove a node and add a new one in its place.
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Node * not_node,
+      f->MakeNode<UnOp>(absl::nullopt, FindNode("and.2", f), Op::kNot));
+  XLS_ASSERT_OK(and_node->ReplaceUsesWith(not_node));
+  XLS_ASSERT_OK(f->RemoveNode(and_node));
+  EXPECT_THAT(query_engine.Update(f), IsOkAndHolds(ReachedFixpoint::Changed));
+  EXPECT_TRUE(query_engine.IsTracked(not_node));
+  EXPECT_EQ(query_engine.ToString(not_node), "0b1111_XXXX");
+  EXPECT_EQ(query_engine.ToString(f->return_value()), "0b1111_1111");
+}
+
 }  // namespace
 }  // namespace xls
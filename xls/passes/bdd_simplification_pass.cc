@@ -36,6 +36,7 @@
 #include "xls/passes/bdd_query_engine.h"
 #include "xls/passes/post_dominator_analysis.h"
 #include "xls/passes/query_engine.h"
+#include "xls/passes/shared_query_engines.h"
 
 namespace xls {
 
@@ -324,18 +325,22 @@ absl::StatusOr<bool> SimplifyNode(Node* node, const QueryEngine& query_engine,
 
 absl::StatusOr<bool> BddSimplificationPass::RunOnFunctionBaseInternal(
     FunctionBase* f, const PassOptions& options, PassResults* results) const {
-  BddQueryEngine query_engine(BddFunction::kDefaultPathLimit);
-  XLS_RETURN_IF_ERROR(query_engine.Populate(f).status());
+  SharedQueryEngines local_query_engines(options.bdd_memory_limit_bytes);
+  SharedQueryEngines* query_engines = options.shared_query_engines != nullptr
+                                          ? options.shared_query_engines
+                                          : &local_query_engines;
+  XLS_ASSIGN_OR_RETURN(BddQueryEngine * query_engine,
+                       query_engines->GetBddQueryEngine(f));
 
   bool modified = false;
   for (Node* node : TopoSort(f)) {
     XLS_ASSIGN_OR_RETURN(bool node_modified,
-                         SimplifyNode(node, query_engine, opt_level_));
+                         SimplifyNode(node, *query_engine, opt_level_));
     modified |= node_modified;
   }
 
   XLS_ASSIGN_OR_RETURN(bool selects_collapsed,
-                       CollapseSelectChains(f, query_engine));
+                       CollapseSelectChains(f, *query_engine));
 
   return modified || selects_collapsed;
 }
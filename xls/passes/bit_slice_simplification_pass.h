@@ -15,8 +15,11 @@
 #ifndef XLS_PASSES_BIT_SLICE_SIMPLIFICATION_PASS_H_
 #define XLS_PASSES_BIT_SLICE_SIMPLIFICATION_PASS_H_
 
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/statusor.h"
+#include "absl/types/optional.h"
 #include "xls/ir/function.h"
+#include "xls/ir/op.h"
 #include "xls/passes/passes.h"
 
 namespace xls {
@@ -30,6 +33,11 @@ class BitSliceSimplificationPass : public FunctionBasePass {
         opt_level_(opt_level) {}
   ~BitSliceSimplificationPass() override {}
 
+  absl::optional<absl::flat_hash_set<Op>> TriggerOps() const override {
+    return absl::flat_hash_set<Op>(
+        {Op::kBitSlice, Op::kDynamicBitSlice, Op::kBitSliceUpdate});
+  }
+
  protected:
   int64_t opt_level_;
   absl::StatusOr<bool> RunOnFunctionBaseInternal(
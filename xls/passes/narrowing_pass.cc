@@ -24,6 +24,7 @@
 #include "xls/ir/ternary.h"
 #include "xls/passes/query_engine.h"
 #include "xls/passes/range_query_engine.h"
+#include "xls/passes/shared_query_engines.h"
 #include "xls/passes/ternary_query_engine.h"
 #include "xls/passes/union_query_engine.h"
 
@@ -526,20 +527,21 @@ void RangeAnalysisLog(FunctionBase* f,
 
 absl::StatusOr<bool> NarrowingPass::RunOnFunctionBaseInternal(
     FunctionBase* f, const PassOptions& options, PassResults* results) const {
-  std::unique_ptr<TernaryQueryEngine> ternary_query_engine =
-      std::make_unique<TernaryQueryEngine>();
-  std::unique_ptr<RangeQueryEngine> range_query_engine =
-      std::make_unique<RangeQueryEngine>();
+  SharedQueryEngines local_query_engines;
+  SharedQueryEngines* query_engines = options.shared_query_engines != nullptr
+                                          ? options.shared_query_engines
+                                          : &local_query_engines;
+  XLS_ASSIGN_OR_RETURN(TernaryQueryEngine * ternary_query_engine,
+                       query_engines->GetTernaryQueryEngine(f));
+  XLS_ASSIGN_OR_RETURN(RangeQueryEngine * range_query_engine,
+                       query_engines->GetRangeQueryEngine(f));
 
   if (XLS_VLOG_IS_ON(3)) {
     RangeAnalysisLog(f, *ternary_query_engine, *range_query_engine);
   }
 
-  std::vector<std::unique_ptr<QueryEngine>> engines;
-  engines.push_back(std::move(ternary_query_engine));
-  engines.push_back(std::move(range_query_engine));
-  UnionQueryEngine query_engine(std::move(engines));
-  XLS_RETURN_IF_ERROR(query_engine.Populate(f).status());
+  UnionQueryEngine query_engine(
+      std::vector<QueryEngine*>{ternary_query_engine, range_query_engine});
 
   bool modified = false;
   for (Node* node : TopoSort(f)) {
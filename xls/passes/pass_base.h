@@ -38,6 +38,8 @@
 
 namespace xls {
 
+class SharedQueryEngines;
+
 // This file defines a set of base classes for building XLS compiler passes and
 // pass pipelines. The base classes are templated allowing polymorphism of the
 // data types the pass operates on.
@@ -57,6 +59,24 @@ struct PassOptions {
   // both run_only_passes and skip_passes are present, then only passes which
   // are present in run_only_passes and not present in skip_passes will be run.
   std::vector<std::string> skip_passes;
+
+  // Maximum number of threads to use within a single pass. Passes which
+  // operate on each function and proc separately may process independent
+  // functions and procs concurrently. Results do not depend on the number of
+  // threads.
+  int64_t thread_count = 1;
+
+  // If non-null, passes should obtain query engines from this object rather
+  // than constructing and populating their own so the analysis results are
+  // incrementally updated across passes instead of recomputed. Set by compound
+  // passes which repeatedly run analysis-based passes over the same IR.
+  SharedQueryEngines* shared_query_engines = nullptr;
+
+  // Approximate limit on the memory used by the binary decision diagram of a
+  // single function or proc in BDD-based passes. Beyond the limit the BDD
+  // analysis loses precision rather than consuming more memory. Zero means no
+  // limit.
+  int64_t bdd_memory_limit_bytes = int64_t{1} << 30;
 };
 
 // An object containing information about the invocation of a pass (single call
@@ -70,8 +90,20 @@ struct PassInvocation {
 
   // The run duration of the pass.
   absl::Duration run_duration;
+
+  // The number of nodes in the IR before and after the pass was run.
+  int64_t node_count_before = 0;
+  int64_t node_count_after = 0;
+
+  // Growth of the peak resident set size of the process while the pass was
+  // running, in bytes. Zero if the pass stayed below the previous peak.
+  int64_t peak_rss_delta_bytes = 0;
 };
 
+// Returns the peak resident set size of the process in bytes, or zero if it
+// could not be determined.
+int64_t GetPeakRssBytes();
+
 // A object to which metadata may be written in each pass invocation. This data
 // structure is passed by mutable pointer to PassBase::Run.
 struct PassResults {
@@ -82,14 +114,15 @@ struct PassResults {
 // Base class for all compiler passes. Template parameters:
 //
 //   IrT : The data type that the pass operates on (e.g., xls::Package). The
-//     type should define 'DumpIr' and 'name' methods used for dumping and
-//     logging in compound passes. A pass which strictly operate on the XLS IR
-//     may use the xls::Package type as the IrT template argument. Passes which
-//     operate on the IR and a schedule may be instantiated on a data structure
-//     containing both an xls::Package and a schedule. Roughly, IrT should
-//     contain the IR and (optionally) any metadata generated or transformed by
-//     the passes which is necessary for the passes to function (e.g., not just
-//     telemetry or logging info which should be held in ResultT).
+//     type should define 'DumpIr', 'name' and 'GetNodeCount' methods used for
+//     dumping, logging and profiling in compound passes. A pass which strictly
+//     operate on the XLS IR may use the xls::Package type as the IrT template
+//     argument. Passes which operate on the IR and a schedule may be
+//     instantiated on a data structure containing both an xls::Package and a
+//     schedule. Roughly, IrT should contain the IR and (optionally) any
+//     metadata generated or transformed by the passes which is necessary for
+//     the passes to function (e.g., not just telemetry or logging info which
+//     should be held in ResultT).
 //
 //   OptionsT : Options type passed as an immutable object to each invocation of
 //     PassBase::Run. This type should be derived from PassOptions because
@@ -223,6 +256,42 @@ class CompoundPassBase : public PassBase<IrT, OptionsT, ResultsT> {
   bool IsCompound() const override { return true; }
 
  protected:
+  // Returns the invariant checkers passed in from parent compound passes
+  // followed by the checkers contained by this pass itself.
+  std::vector<const InvariantChecker*> MergeInvariantCheckers(
+      absl::Span<const InvariantChecker* const> invariant_checkers) const {
+    std::vector<const InvariantChecker*> checkers(invariant_checkers.begin(),
+                                                  invariant_checkers.end());
+    checkers.insert(checkers.end(), invariant_checker_ptrs_.begin(),
+                    invariant_checker_ptrs_.end());
+    return checkers;
+  }
+
+  // Runs the given invariant checkers. 'str_context' is appended to the
+  // message of any error returned by a checker.
+  absl::Status RunInvariantCheckers(
+      absl::Span<const InvariantChecker* const> checkers, IrT* ir,
+      const OptionsT& options, ResultsT* results,
+      absl::string_view str_context) const {
+    for (const auto& checker : checkers) {
+      absl::Status status = checker->Run(ir, options, results);
+      if (!status.ok()) {
+        return absl::Status(status.code(), absl::StrCat(status.message(), "; [",
+                                                        str_context, "]"));
+      }
+    }
+    return absl::OkStatus();
+  }
+
+  // Runs a single pass contained in this compound pass as a step of
+  // RunNested. Handles the run_only_passes and skip_passes options, records
+  // the invocation in 'results', dumps the IR and runs the invariant checkers
+  // afterwards. Returns true if the pass changed the IR.
+  absl::StatusOr<bool> RunContainedPass(
+      Pass* pass, IrT* ir, const OptionsT& options, ResultsT* results,
+      absl::string_view top_level_name,
+      absl::Span<const InvariantChecker* const> checkers) const;
+
   // Dump the IR to a file in the given directory. Name is determined by the
   // various arguments passed in. File names will be lexographically ordered by
   // package name and ordinal.
@@ -282,110 +351,116 @@ absl::StatusOr<bool> CompoundPassBase<IrT, OptionsT, ResultsT>::RunNested(
   XLS_VLOG(2) << "Start of compound pass " << this->short_name() << ":";
   XLS_VLOG_LINES(5, ir->DumpIr());
 
-  // Invariant checkers may be passed in from parent compound passes or
-  // contained by this pass itself. Merge them together.
-  std::vector<const InvariantChecker*> checkers(invariant_checkers.begin(),
-                                                invariant_checkers.end());
-  checkers.insert(checkers.end(), invariant_checker_ptrs_.begin(),
-                  invariant_checker_ptrs_.end());
-  auto run_invariant_checkers =
-      [&](absl::string_view str_context) -> absl::Status {
-    for (const auto& checker : checkers) {
-      absl::Status status = checker->Run(ir, options, results);
-      if (!status.ok()) {
-        return absl::Status(status.code(), absl::StrCat(status.message(), "; [",
-                                                        str_context, "]"));
-      }
-    }
-    return absl::OkStatus();
-  };
-  XLS_RETURN_IF_ERROR(run_invariant_checkers(
+  std::vector<const InvariantChecker*> checkers =
+      MergeInvariantCheckers(invariant_checkers);
+  XLS_RETURN_IF_ERROR(RunInvariantCheckers(
+      checkers, ir, options, results,
       absl::StrCat("start of compound pass '", this->long_name(), "'")));
 
   bool changed = false;
   for (const auto& pass : passes_) {
-    XLS_VLOG(1) << absl::StreamFormat("Running %s (%s) pass on package %s",
-                                      pass->long_name(), pass->short_name(),
-                                      ir->name());
-
-    if (!pass->IsCompound() && options.run_only_passes.has_value() &&
-        std::find_if(options.run_only_passes->begin(),
-                     options.run_only_passes->end(),
-                     [&](const std::string& name) {
-                       return pass->short_name() == name;
-                     }) == options.run_only_passes->end()) {
-      XLS_VLOG(1) << "Skipping pass. Not contained in run_only_passes option.";
-      continue;
-    }
+    XLS_ASSIGN_OR_RETURN(bool pass_changed,
+                         RunContainedPass(pass.get(), ir, options, results,
+                                          top_level_name, checkers));
+    changed |= pass_changed;
+  }
+  return changed;
+}
 
-    if (std::find_if(options.skip_passes.begin(), options.skip_passes.end(),
-                     [&](const std::string& name) {
-                       return pass->short_name() == name;
-                     }) != options.skip_passes.end()) {
-      XLS_VLOG(1) << "Skipping pass. Contained in skip_passes option.";
-      continue;
-    }
+template <typename IrT, typename OptionsT, typename ResultsT>
+absl::StatusOr<bool>
+CompoundPassBase<IrT, OptionsT, ResultsT>::RunContainedPass(
+    Pass* pass, IrT* ir, const OptionsT& options, ResultsT* results,
+    absl::string_view top_level_name,
+    absl::Span<const InvariantChecker* const> checkers) const {
+  XLS_VLOG(1) << absl::StreamFormat("Running %s (%s) pass on package %s",
+                                    pass->long_name(), pass->short_name(),
+                                    ir->name());
+
+  if (!pass->IsCompound() && options.run_only_passes.has_value() &&
+      std::find_if(options.run_only_passes->begin(),
+                   options.run_only_passes->end(),
+                   [&](const std::string& name) {
+                     return pass->short_name() == name;
+                   }) == options.run_only_passes->end()) {
+    XLS_VLOG(1) << "Skipping pass. Not contained in run_only_passes option.";
+    return false;
+  }
+
+  if (std::find_if(options.skip_passes.begin(), options.skip_passes.end(),
+                   [&](const std::string& name) {
+                     return pass->short_name() == name;
+                   }) != options.skip_passes.end()) {
+    XLS_VLOG(1) << "Skipping pass. Contained in skip_passes option.";
+    return false;
+  }
 
 #ifdef DEBUG
-    // Verify that the IR should change iff Run returns true. This is slow, so
-    // do not check it in optimized builds.
-    std::string ir_before = ir->DumpIr();
+  // Verify that the IR should change iff Run returns true. This is slow, so
+  // do not check it in optimized builds.
+  std::string ir_before = ir->DumpIr();
 #endif
-    absl::Time start = absl::Now();
-    bool pass_changed;
-    if (pass->IsCompound()) {
-      XLS_ASSIGN_OR_RETURN(
-          pass_changed,
-          (down_cast<CompoundPassBase<IrT, OptionsT, ResultsT>*>(pass.get())
-               ->RunNested(ir, options, results, top_level_name, checkers)));
-    } else {
-      XLS_ASSIGN_OR_RETURN(pass_changed, pass->Run(ir, options, results));
-    }
-    absl::Duration duration = absl::Now() - start;
+  int64_t node_count_before = ir->GetNodeCount();
+  int64_t peak_rss_before = GetPeakRssBytes();
+  absl::Time start = absl::Now();
+  bool pass_changed;
+  if (pass->IsCompound()) {
+    XLS_ASSIGN_OR_RETURN(
+        pass_changed,
+        (down_cast<CompoundPassBase<IrT, OptionsT, ResultsT>*>(pass)
+             ->RunNested(ir, options, results, top_level_name, checkers)));
+  } else {
+    XLS_ASSIGN_OR_RETURN(pass_changed, pass->Run(ir, options, results));
+  }
+  absl::Duration duration = absl::Now() - start;
 #ifdef DEBUG
-    std::string ir_after = ir->DumpIr();
-    if (pass_changed) {
-      if (ir_before == ir_after) {
-        return absl::InternalError(absl::StrFormat(
-            "Pass %s indicated IR changed, but IR is unchanged:\n\n%s",
-            pass->short_name(), ir_before));
-      }
-    } else {
-      if (ir_before != ir_after) {
-        return absl::InternalError(
-            absl::StrFormat("Pass %s indicated IR unchanged, but IR is "
-                            "changed:\n\n[Before]\n%s  !=\n[after]\n%s",
-                            pass->short_name(), ir_before, ir_after));
-      }
+  std::string ir_after = ir->DumpIr();
+  if (pass_changed) {
+    if (ir_before == ir_after) {
+      return absl::InternalError(absl::StrFormat(
+          "Pass %s indicated IR changed, but IR is unchanged:\n\n%s",
+          pass->short_name(), ir_before));
     }
-#endif
-    changed |= pass_changed;
-    XLS_VLOG(1) << absl::StreamFormat(
-        "[elapsed %s] Pass %s %s.", FormatDuration(duration),
-        pass->short_name(),
-        (pass_changed ? "changed IR" : "did not change IR"));
-    if (!pass->IsCompound()) {
-      results->invocations.push_back(
-          {pass->short_name(), pass_changed, duration});
+  } else {
+    if (ir_before != ir_after) {
+      return absl::InternalError(
+          absl::StrFormat("Pass %s indicated IR unchanged, but IR is "
+                          "changed:\n\n[Before]\n%s  !=\n[after]\n%s",
+                          pass->short_name(), ir_before, ir_after));
     }
-    if (!options.ir_dump_path.empty()) {
-      XLS_RETURN_IF_ERROR(DumpIr(options.ir_dump_path, ir, top_level_name,
-                                 absl::StrCat("after_", pass->short_name()),
-                                 /*ordinal=*/results->invocations.size(),
-                                 /*changed=*/pass_changed));
-    }
-    absl::Time checker_start = absl::Now();
-    XLS_RETURN_IF_ERROR(run_invariant_checkers(
-        absl::StrFormat("after '%s' pass, dynamic pass #%d", pass->long_name(),
-                        results->invocations.size() - 1)));
-    XLS_VLOG(1) << absl::StreamFormat(
-        "Ran invariant checkers [elapsed %s]",
-        FormatDuration(absl::Now() - checker_start));
-
-    XLS_VLOG(5) << "After " << pass->long_name() << ":";
-    XLS_VLOG_LINES(5, ir->DumpIr());
   }
-  return changed;
+#endif
+  XLS_VLOG(1) << absl::StreamFormat(
+      "[elapsed %s] Pass %s %s.", FormatDuration(duration), pass->short_name(),
+      (pass_changed ? "changed IR" : "did not change IR"));
+  if (!pass->IsCompound()) {
+    PassInvocation invocation;
+    invocation.pass_name = pass->short_name();
+    invocation.ir_changed = pass_changed;
+    invocation.run_duration = duration;
+    invocation.node_count_before = node_count_before;
+    invocation.node_count_after = ir->GetNodeCount();
+    invocation.peak_rss_delta_bytes = GetPeakRssBytes() - peak_rss_before;
+    results->invocations.push_back(std::move(invocation));
+  }
+  if (!options.ir_dump_path.empty()) {
+    XLS_RETURN_IF_ERROR(DumpIr(options.ir_dump_path, ir, top_level_name,
+                               absl::StrCat("after_", pass->short_name()),
+                               /*ordinal=*/results->invocations.size(),
+                               /*changed=*/pass_changed));
+  }
+  absl::Time checker_start = absl::Now();
+  XLS_RETURN_IF_ERROR(RunInvariantCheckers(
+      checkers, ir, options, results,
+      absl::StrFormat("after '%s' pass, dynamic pass #%d", pass->long_name(),
+                      results->invocations.size() - 1)));
+  XLS_VLOG(1) << absl::StreamFormat(
+      "Ran invariant checkers [elapsed %s]",
+      FormatDuration(absl::Now() - checker_start));
+
+  XLS_VLOG(5) << "After " << pass->long_name() << ":";
+  XLS_VLOG_LINES(5, ir->DumpIr());
+  return pass_changed;
 }
 
 }  // namespace xls
@@ -0,0 +1,115 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/passes/pass_profile.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "google/protobuf/util/json_util.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/time/time.h"
+#include "xls/common/file/filesystem.h"
+
+namespace xls {
+
+PassProfileProto PassResultsToProfileProto(const PassResults& results) {
+  PassProfileProto profile;
+  std::vector<PassSummaryProto> summaries;
+  absl::flat_hash_map<std::string, int64_t> summary_index;
+  for (const PassInvocation& invocation : results.invocations) {
+    PassInvocationProto* proto = profile.add_invocations();
+    proto->set_pass_name(invocation.pass_name);
+    proto->set_ir_changed(invocation.ir_changed);
+    proto->set_run_duration_us(
+        absl::ToInt64Microseconds(invocation.run_duration));
+    proto->set_node_count_before(invocation.node_count_before);
+    proto->set_node_count_after(invocation.node_count_after);
+    proto->set_peak_rss_delta_bytes(invocation.peak_rss_delta_bytes);
+
+    auto [it, inserted] =
+        summary_index.insert({invocation.pass_name, summaries.size()});
+    if (inserted) {
+      summaries.emplace_back();
+      summaries.back().set_pass_name(invocation.pass_name);
+    }
+    PassSummaryProto& summary = summaries[it->second];
+    summary.set_invocation_count(summary.invocation_count() + 1);
+    summary.set_changed_count(summary.changed_count() +
+                              (invocation.ir_changed ? 1 : 0));
+    summary.set_total_duration_us(summary.total_duration_us() +
+                                  proto->run_duration_us());
+    summary.set_node_count_delta(summary.node_count_delta() +
+                                 invocation.node_count_after -
+                                 invocation.node_count_before);
+    summary.set_max_peak_rss_delta_bytes(
+        std::max(summary.max_peak_rss_delta_bytes(),
+                 invocation.peak_rss_delta_bytes));
+  }
+  // Stable sort so passes with equal run times remain in first-run order.
+  std::stable_sort(summaries.begin(), summaries.end(),
+                   [](const PassSummaryProto& a, const PassSummaryProto& b) {
+                     return a.total_duration_us() > b.total_duration_us();
+                   });
+  for (PassSummaryProto& summary : summaries) {
+    *profile.add_summaries() = std::move(summary);
+  }
+  return profile;
+}
+
+std::string FormatPassProfileSummary(const PassProfileProto& profile) {
+  int64_t total_us = 0;
+  for (const PassSummaryProto& summary : profile.summaries()) {
+    total_us += summary.total_duration_us();
+  }
+  std::string out = absl::StrFormat("%-32s %6s %8s %12s %7s %10s %12s\n",
+                                    "Pass", "Runs", "Changed", "Time (ms)",
+                                    "Time %", "Nodes +/-", "Max RSS +KiB");
+  for (const PassSummaryProto& summary : profile.summaries()) {
+    double percent =
+        total_us == 0 ? 0.0
+                      : 100.0 * summary.total_duration_us() / total_us;
+    absl::StrAppendFormat(
+        &out, "%-32s %6d %8d %12.3f %6.1f%% %+10d %12d\n", summary.pass_name(),
+        summary.invocation_count(), summary.changed_count(),
+        summary.total_duration_us() / 1000.0, percent,
+        summary.node_count_delta(), summary.max_peak_rss_delta_bytes() / 1024);
+  }
+  absl::StrAppendFormat(&out, "%-32s %6d %8s %12.3f\n", "Total",
+                        profile.invocations_size(), "",
+                        total_us / 1000.0);
+  return out;
+}
+
+absl::Status WritePassProfile(const std::filesystem::path& path,
+                              const PassResults& results) {
+  PassProfileProto profile = PassResultsToProfileProto(results);
+  if (path.extension() != ".json") {
+    return SetTextProtoFile(path, profile);
+  }
+  std::string json;
+  google::protobuf::util::JsonPrintOptions print_options;
+  print_options.add_whitespace = true;
+  print_options.preserve_proto_field_names = true;
+  auto status = google::protobuf::util::MessageToJsonString(profile, &json,
+                                                            print_options);
+  if (!status.ok()) {
+    return absl::InternalError(std::string{status.message()});
+  }
+  return SetFileContents(path, json);
+}
+
+}  // namespace xls
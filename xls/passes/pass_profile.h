@@ -0,0 +1,42 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_PASSES_PASS_PROFILE_H_
+#define XLS_PASSES_PASS_PROFILE_H_
+
+#include <filesystem>
+#include <string>
+
+#include "absl/status/status.h"
+#include "xls/passes/pass_base.h"
+#include "xls/passes/pass_profile.pb.h"
+
+namespace xls {
+
+// Converts the invocations recorded in the given results into a profile proto
+// including per-pass summaries sorted by decreasing total run time.
+PassProfileProto PassResultsToProfileProto(const PassResults& results);
+
+// Returns a human-readable table of the summaries in the given profile.
+std::string FormatPassProfileSummary(const PassProfileProto& profile);
+
+// Writes the profile of the given results to the given path. The profile is
+// written as JSON if the path has a ".json" extension and as a text proto
+// otherwise.
+absl::Status WritePassProfile(const std::filesystem::path& path,
+                              const PassResults& results);
+
+}  // namespace xls
+
+#endif  // XLS_PASSES_PASS_PROFILE_H_
@@ -0,0 +1,118 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/passes/pass_profile.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/time/time.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/file/temp_file.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/ir_parser.h"
+#include "xls/passes/dce_pass.h"
+#include "xls/passes/passes.h"
+
+namespace xls {
+namespace {
+
+using status_testing::IsOkAndHolds;
+using ::testing::HasSubstr;
+
+PassInvocation MakeInvocation(absl::string_view name, bool changed,
+                              int64_t duration_us, int64_t nodes_before,
+                              int64_t nodes_after) {
+  PassInvocation invocation;
+  invocation.pass_name = std::string(name);
+  invocation.ir_changed = changed;
+  invocation.run_duration = absl::Microseconds(duration_us);
+  invocation.node_count_before = nodes_before;
+  invocation.node_count_after = nodes_after;
+  return invocation;
+}
+
+TEST(PassProfileTest, SummariesSortedByTotalTime) {
+  PassResults results;
+  results.invocations.push_back(MakeInvocation("dce", true, 10, 20, 15));
+  results.invocations.push_back(MakeInvocation("cse", false, 25, 15, 15));
+  results.invocations.push_back(MakeInvocation("dce", true, 30, 15, 12));
+  results.invocations.push_back(MakeInvocation("bdd", false, 5, 12, 12));
+
+  PassProfileProto profile = PassResultsToProfileProto(results);
+  ASSERT_EQ(profile.invocations_size(), 4);
+  EXPECT_EQ(profile.invocations(1).pass_name(), "cse");
+  EXPECT_EQ(profile.invocations(1).run_duration_us(), 25);
+  EXPECT_FALSE(profile.invocations(1).ir_changed());
+
+  ASSERT_EQ(profile.summaries_size(), 3);
+  EXPECT_EQ(profile.summaries(0).pass_name(), "dce");
+  EXPECT_EQ(profile.summaries(0).invocation_count(), 2);
+  EXPECT_EQ(profile.summaries(0).changed_count(), 2);
+  EXPECT_EQ(profile.summaries(0).total_duration_us(), 40);
+  EXPECT_EQ(profile.summaries(0).node_count_delta(), -8);
+  EXPECT_EQ(profile.summaries(1).pass_name(), "cse");
+  EXPECT_EQ(profile.summaries(2).pass_name(), "bdd");
+
+  std::string table = FormatPassProfileSummary(profile);
+  EXPECT_LT(table.find("dce"), table.find("cse"));
+  EXPECT_LT(table.find("cse"), table.find("bdd"));
+  EXPECT_THAT(table, HasSubstr("Total"));
+}
+
+TEST(PassProfileTest, CompoundPassRecordsNodeCounts) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> p, Parser::ParsePackage(R"(
+package p
+
+fn f(x: bits[8]) -> bits[8] {
+  not.1: bits[8] = not(x)
+  neg.2: bits[8] = neg(not.1)
+  ret identity.3: bits[8] = identity(x)
+}
+)"));
+  CompoundPass pass("compound", "Compound pass");
+  pass.Add<DeadCodeEliminationPass>();
+  pass.Add<DeadCodeEliminationPass>();
+  PassResults results;
+  EXPECT_THAT(pass.Run(p.get(), PassOptions(), &results), IsOkAndHolds(true));
+
+  ASSERT_EQ(results.invocations.size(), 2);
+  EXPECT_EQ(results.invocations[0].node_count_before, 4);
+  EXPECT_EQ(results.invocations[0].node_count_after, 2);
+  EXPECT_TRUE(results.invocations[0].ir_changed);
+  EXPECT_EQ(results.invocations[1].node_count_before, 2);
+  EXPECT_EQ(results.invocations[1].node_count_after, 2);
+  EXPECT_FALSE(results.invocations[1].ir_changed);
+  EXPECT_GE(results.invocations[0].peak_rss_delta_bytes, 0);
+}
+
+TEST(PassProfileTest, WriteProfile) {
+  PassResults results;
+  results.invocations.push_back(MakeInvocation("dce", true, 10, 20, 15));
+
+  XLS_ASSERT_OK_AND_ASSIGN(TempFile json_file, TempFile::Create(".json"));
+  XLS_ASSERT_OK(WritePassProfile(json_file.path(), results));
+  XLS_ASSERT_OK_AND_ASSIGN(std::string json,
+                           GetFileContents(json_file.path()));
+  EXPECT_THAT(json, HasSubstr("\"pass_name\": \"dce\""));
+
+  XLS_ASSERT_OK_AND_ASSIGN(TempFile text_file, TempFile::Create(".textproto"));
+  XLS_ASSERT_OK(WritePassProfile(text_file.path(), results));
+  PassProfileProto profile;
+  XLS_ASSERT_OK(ParseTextProtoFile(text_file.path(), &profile));
+  EXPECT_EQ(profile.summaries_size(), 1);
+  EXPECT_EQ(profile.summaries(0).node_count_delta(), -5);
+}
+
+}  // namespace
+}  // namespace xls
@@ -14,13 +14,142 @@
 
 #include "xls/passes/passes.h"
 
+#include <algorithm>
+#include <numeric>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
+#include "xls/common/casts.h"
 #include "xls/common/logging/logging.h"
+#include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/common/thread_pool.h"
+#include "xls/ir/block.h"
+#include "xls/ir/channel.h"
+#include "xls/ir/function.h"
+#include "xls/ir/instantiation.h"
+#include "xls/ir/node.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/proc.h"
 
 namespace xls {
+namespace {
+
+// Returns the function called by the given node, or nullptr if the node does
+// not call a function.
+FunctionBase* GetCalledFunction(Node* node) {
+  switch (node->op()) {
+    case Op::kInvoke:
+      return node->As<Invoke>()->to_apply();
+    case Op::kMap:
+      return node->As<Map>()->to_apply();
+    case Op::kCountedFor:
+      return node->As<CountedFor>()->body();
+    case Op::kDynamicCountedFor:
+      return node->As<DynamicCountedFor>()->body();
+    default:
+      return nullptr;
+  }
+}
+
+// Partitions the functions, procs and blocks of the package into groups such
+// that nothing in one group calls or instantiates anything in another group.
+// The groups, and the elements of each group, are in package order.
+std::vector<std::vector<FunctionBase*>> GetIndependentFunctionBaseGroups(
+    Package* p) {
+  std::vector<FunctionBase*> function_bases = p->GetFunctionBases();
+  absl::flat_hash_map<FunctionBase*, int64_t> indices;
+  for (int64_t i = 0; i < function_bases.size(); ++i) {
+    indices[function_bases[i]] = i;
+  }
+  // Union-find over the indices of the function bases.
+  std::vector<int64_t> parents(function_bases.size());
+  std::iota(parents.begin(), parents.end(), 0);
+  auto find_root = [&](int64_t i) {
+    while (parents[i] != i) {
+      parents[i] = parents[parents[i]];
+      i = parents[i];
+    }
+    return i;
+  };
+  auto merge = [&](int64_t i, FunctionBase* other) {
+    int64_t a = find_root(i);
+    int64_t b = find_root(indices.at(other));
+    parents[std::max(a, b)] = std::min(a, b);
+  };
+  for (int64_t i = 0; i < function_bases.size(); ++i) {
+    FunctionBase* f = function_bases[i];
+    for (Node* node : f->nodes()) {
+      if (FunctionBase* callee = GetCalledFunction(node)) {
+        merge(i, callee);
+      }
+    }
+    if (f->IsBlock()) {
+      for (Instantiation* instantiation :
+           f->AsBlockOrDie()->GetInstantiations()) {
+        if (instantiation->kind() == InstantiationKind::kBlock) {
+          merge(i, down_cast<BlockInstantiation*>(instantiation)
+                       ->instantiated_block());
+        }
+      }
+    }
+  }
+  std::vector<std::vector<FunctionBase*>> groups;
+  absl::flat_hash_map<int64_t, int64_t> root_to_group;
+  for (int64_t i = 0; i < function_bases.size(); ++i) {
+    auto [it, inserted] = root_to_group.insert({find_root(i), groups.size()});
+    if (inserted) {
+      groups.emplace_back();
+    }
+    groups[it->second].push_back(function_bases[i]);
+  }
+  return groups;
+}
+
+// Renumbers the nodes with ids greater than or equal to 'first_id' so that ids
+// are assigned densely in package order rather than in the order in which
+// concurrently running passes allocated them. The relative order of ids within
+// each function/proc is preserved.
+void RenumberNewNodes(Package* p, int64_t first_id) {
+  std::vector<Node*> new_nodes;
+  for (FunctionBase* f : p->GetFunctionBases()) {
+    std::vector<Node*> f_new_nodes;
+    for (Node* node : f->nodes()) {
+      if (node->id() >= first_id) {
+        f_new_nodes.push_back(node);
+      }
+    }
+    std::sort(f_new_nodes.begin(), f_new_nodes.end(),
+              [](Node* a, Node* b) { return a->id() < b->id(); });
+    new_nodes.insert(new_nodes.end(), f_new_nodes.begin(), f_new_nodes.end());
+  }
+  // The user lists of nodes are sorted by id and Node::SetId relies on the
+  // lists being sorted when it is called. To keep them sorted at every step,
+  // first move the new nodes above all existing ids (largest id first), then
+  // down to their final ids (smallest id first).
+  int64_t temp_id = p->next_node_id();
+  for (int64_t i = new_nodes.size() - 1; i >= 0; --i) {
+    new_nodes[i]->SetId(temp_id + i);
+  }
+  for (int64_t i = 0; i < new_nodes.size(); ++i) {
+    new_nodes[i]->SetId(first_id + i);
+  }
+  p->set_next_node_id(first_id + new_nodes.size());
+}
+
+// Returns the functions, procs and channels of the package. Used to check that
+// passes which run concurrently do not modify package-level state.
+std::pair<std::vector<FunctionBase*>, std::vector<Channel*>>
+GetPackageMembers(Package* p) {
+  return {p->GetFunctionBases(),
+          std::vector<Channel*>(p->channels().begin(), p->channels().end())};
+}
+
+}  // namespace
 
 absl::StatusOr<bool> FunctionBasePass::RunOnFunctionBase(
     FunctionBase* f, const PassOptions& options, PassResults* results) const {
@@ -41,12 +170,52 @@ absl::StatusOr<bool> FunctionBasePass::RunOnFunctionBase(
 absl::StatusOr<bool> FunctionBasePass::RunInternal(Package* p,
                                                    const PassOptions& options,
                                                    PassResults* results) const {
+  auto run_on_function_bases =
+      [&](absl::Span<FunctionBase* const> function_bases)
+      -> absl::StatusOr<bool> {
+    bool changed = false;
+    for (FunctionBase* f : function_bases) {
+      XLS_ASSIGN_OR_RETURN(bool function_changed,
+                           RunOnFunctionBaseInternal(f, options, results));
+      changed |= function_changed;
+    }
+    return changed;
+  };
+  if (options.thread_count <= 1 || !SupportsParallelRun()) {
+    return run_on_function_bases(p->GetFunctionBases());
+  }
+  std::vector<std::vector<FunctionBase*>> groups =
+      GetIndependentFunctionBaseGroups(p);
+  if (groups.size() <= 1) {
+    return run_on_function_bases(p->GetFunctionBases());
+  }
+
+#ifndef NDEBUG
+  auto members_before = GetPackageMembers(p);
+#endif
+  int64_t first_new_node_id = p->next_node_id();
+  std::vector<absl::StatusOr<bool>> group_changed(groups.size(), false);
+  {
+    ThreadPool pool(std::min<int64_t>(options.thread_count, groups.size()));
+    for (int64_t i = 0; i < groups.size(); ++i) {
+      pool.Schedule(
+          [&, i] { group_changed[i] = run_on_function_bases(groups[i]); });
+    }
+    pool.WaitForIdle();
+  }
+#ifndef NDEBUG
+  XLS_RET_CHECK(GetPackageMembers(p) == members_before) << absl::StreamFormat(
+      "Pass %s modified the functions, procs or channels of the package while "
+      "running concurrently. It must override SupportsParallelRun() to return "
+      "false.",
+      short_name());
+#endif
   bool changed = false;
-  for (FunctionBase* f : p->GetFunctionBases()) {
-    XLS_ASSIGN_OR_RETURN(bool function_changed,
-                         RunOnFunctionBaseInternal(f, options, results));
-    changed |= function_changed;
+  for (const absl::StatusOr<bool>& group_result : group_changed) {
+    XLS_RETURN_IF_ERROR(group_result.status());
+    changed |= group_result.value();
   }
+  RenumberNewNodes(p, first_new_node_id);
   return changed;
 }
 
@@ -114,4 +283,198 @@ absl::StatusOr<bool> ProcPass::RunInternal(Package* p,
   return changed;
 }
 
+namespace {
+
+// A snapshot of the graph structure of a package: the op and operand ids of
+// every node, keyed by node id, and the ids of the nodes with implicit uses
+// (the return value of each function and the next token and state of each
+// proc). Used to determine which nodes were touched by a pass.
+class PackageSnapshot {
+ public:
+  explicit PackageSnapshot(Package* p) { structure_ = Capture(p); }
+
+  // Updates the snapshot to the current state of the package and returns the
+  // ops of the nodes touched since the previous snapshot.
+  absl::flat_hash_set<Op> Update(Package* p) {
+    PackageStructure current = Capture(p);
+    absl::flat_hash_map<int64_t, Node*> nodes_by_id;
+    for (FunctionBase* f : p->GetFunctionBases()) {
+      for (Node* node : f->nodes()) {
+        nodes_by_id[node->id()] = node;
+      }
+    }
+    absl::flat_hash_set<Node*> touched;
+    auto touch_if_present = [&](int64_t id) {
+      auto it = nodes_by_id.find(id);
+      if (it != nodes_by_id.end()) {
+        touched.insert(it->second);
+      }
+    };
+    for (const auto& [id, structure] : current.nodes) {
+      auto it = structure_.nodes.find(id);
+      if (it == structure_.nodes.end() || it->second != structure) {
+        touched.insert(nodes_by_id.at(id));
+      }
+    }
+    // Operands of removed nodes lost a user.
+    for (const auto& [id, structure] : structure_.nodes) {
+      if (current.nodes.contains(id)) {
+        continue;
+      }
+      for (int64_t operand_id : structure.operand_ids) {
+        touch_if_present(operand_id);
+      }
+    }
+    // Nodes which became or stopped being a return value or next state gained
+    // or lost an implicit use. All nodes of new function bases are new and so
+    // already touched.
+    for (const auto& [f, root_ids] : current.root_ids) {
+      auto it = structure_.root_ids.find(f);
+      if (it == structure_.root_ids.end() || it->second == root_ids) {
+        continue;
+      }
+      for (int64_t id : it->second) {
+        touch_if_present(id);
+      }
+      for (int64_t id : root_ids) {
+        touch_if_present(id);
+      }
+    }
+    absl::flat_hash_set<Op> touched_ops;
+    for (Node* node : touched) {
+      touched_ops.insert(node->op());
+      for (Node* user : node->users()) {
+        touched_ops.insert(user->op());
+      }
+    }
+    structure_ = std::move(current);
+    return touched_ops;
+  }
+
+ private:
+  struct NodeStructure {
+    Op op;
+    std::vector<int64_t> operand_ids;
+
+    bool operator==(const NodeStructure& other) const {
+      return op == other.op && operand_ids == other.operand_ids;
+    }
+    bool operator!=(const NodeStructure& other) const {
+      return !(*this == other);
+    }
+  };
+
+  struct PackageStructure {
+    absl::flat_hash_map<int64_t, NodeStructure> nodes;
+    // Ids of the nodes with implicit uses, keyed by function base.
+    absl::flat_hash_map<FunctionBase*, std::vector<int64_t>> root_ids;
+  };
+
+  static PackageStructure Capture(Package* p) {
+    PackageStructure package_structure;
+    for (FunctionBase* f : p->GetFunctionBases()) {
+      for (Node* node : f->nodes()) {
+        NodeStructure& structure = package_structure.nodes[node->id()];
+        structure.op = node->op();
+        for (Node* operand : node->operands()) {
+          structure.operand_ids.push_back(operand->id());
+        }
+      }
+      std::vector<int64_t>& root_ids = package_structure.root_ids[f];
+      if (f->IsFunction()) {
+        root_ids.push_back(f->AsFunctionOrDie()->return_value()->id());
+      } else if (f->IsProc()) {
+        Proc* proc = f->AsProcOrDie();
+        root_ids.push_back(proc->NextToken()->id());
+        root_ids.push_back(proc->NextState()->id());
+      }
+    }
+    return package_structure;
+  }
+
+  PackageStructure structure_;
+};
+
+}  // namespace
+
+absl::StatusOr<bool> WorklistFixedPointCompoundPass::RunNested(
+    Package* p, const PassOptions& options, PassResults* results,
+    absl::string_view top_level_name,
+    absl::Span<const InvariantChecker* const> invariant_checkers) const {
+  XLS_VLOG(1) << "Running " << short_name()
+              << " worklist fixed-point compound pass on package " << p->name();
+  std::vector<const InvariantChecker*> checkers =
+      MergeInvariantCheckers(invariant_checkers);
+  XLS_RETURN_IF_ERROR(RunInvariantCheckers(
+      checkers, p, options, results,
+      absl::StrCat("start of compound pass '", long_name(), "'")));
+
+  // The state of each contained pass. 'stale' indicates the IR has changed
+  // since the pass last ran, and 'touched_ops' holds the ops of the nodes
+  // touched since then.
+  struct PassState {
+    bool has_run = false;
+    bool stale = false;
+    absl::flat_hash_set<Op> touched_ops;
+  };
+  std::vector<PassState> states(passes_.size());
+  auto needs_to_run = [&](int64_t i) {
+    const PassState& state = states[i];
+    if (!state.has_run) {
+      return true;
+    }
+    if (!state.stale) {
+      return false;
+    }
+    const auto* function_base_pass =
+        dynamic_cast<const FunctionBasePass*>(passes_[i].get());
+    if (function_base_pass == nullptr) {
+      return true;
+    }
+    absl::optional<absl::flat_hash_set<Op>> trigger_ops =
+        function_base_pass->TriggerOps();
+    if (!trigger_ops.has_value()) {
+      return true;
+    }
+    for (Op op : state.touched_ops) {
+      if (trigger_ops->contains(op)) {
+        return true;
+      }
+    }
+    return false;
+  };
+
+  PackageSnapshot snapshot(p);
+  bool changed = false;
+  bool iteration_changed = true;
+  while (iteration_changed) {
+    iteration_changed = false;
+    for (int64_t i = 0; i < passes_.size(); ++i) {
+      Pass* pass = passes_[i].get();
+      if (!needs_to_run(i)) {
+        XLS_VLOG(1) << absl::StreamFormat(
+            "Skipping pass %s. No relevant changes since it last ran.",
+            pass->short_name());
+        continue;
+      }
+      states[i] = PassState();
+      states[i].has_run = true;
+      XLS_ASSIGN_OR_RETURN(
+          bool pass_changed,
+          RunContainedPass(pass, p, options, results, top_level_name,
+                           checkers));
+      if (pass_changed) {
+        absl::flat_hash_set<Op> touched_ops = snapshot.Update(p);
+        for (PassState& state : states) {
+          state.stale = true;
+          state.touched_ops.insert(touched_ops.begin(), touched_ops.end());
+        }
+        iteration_changed = true;
+        changed = true;
+      }
+    }
+  }
+  return changed;
+}
+
 }  // namespace xls
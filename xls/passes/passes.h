@@ -23,10 +23,13 @@
 #include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/status/statusor.h"
 #include "absl/time/time.h"
+#include "absl/types/optional.h"
 #include "xls/ir/function.h"
+#include "xls/ir/op.h"
 #include "xls/ir/package.h"
 #include "xls/ir/proc.h"
 #include "xls/passes/pass_base.h"
@@ -59,9 +62,29 @@ class FunctionBasePass : public Pass {
                                          const PassOptions& options,
                                          PassResults* results) const;
 
+  // Returns the ops for which a newly added or modified node, or a user of
+  // such a node, can enable a transformation by this pass. Used by
+  // WorklistFixedPointCompoundPass to skip the pass when the IR has changed
+  // only in ways the pass cannot exploit. The default value absl::nullopt
+  // indicates that any change to the IR may enable the pass.
+  virtual absl::optional<absl::flat_hash_set<Op>> TriggerOps() const {
+    return absl::nullopt;
+  }
+
+  // Returns whether functions and procs may be processed concurrently when
+  // options.thread_count is greater than one. Passes which modify package-level
+  // state (e.g., add or remove functions, procs or channels) or write to
+  // 'results' must override this to return false.
+  virtual bool SupportsParallelRun() const { return true; }
+
  protected:
   // Iterates over each function and proc in the package calling
-  // RunOnFunctionBase.
+  // RunOnFunctionBase. If options.thread_count is greater than one and
+  // SupportsParallelRun() returns true, functions and procs which do not call
+  // each other are processed concurrently. In this case
+  // RunOnFunctionBaseInternal must only modify the function/proc it is given
+  // and must not write to 'results'. Debug builds check that the functions,
+  // procs and channels of the package are unchanged after a concurrent run.
   absl::StatusOr<bool> RunInternal(Package* p, const PassOptions& options,
                                    PassResults* results) const override;
 
@@ -101,6 +124,30 @@ class ProcPass : public Pass {
       Proc* proc, const PassOptions& options, PassResults* results) const = 0;
 };
 
+// A fixed-point compound pass which only reruns passes that may make progress.
+// After each contained pass which changes the IR, the set of touched nodes is
+// determined by comparing the package against a snapshot of its structure.
+// Touched nodes are those which were added, had their operands changed, lost a
+// user, or became or stopped being a function's return value or a proc's next
+// token or state, along with the users of these nodes. A contained pass is
+// then skipped in later iterations if the IR has not changed since it last
+// ran, or if it is a FunctionBasePass with TriggerOps and no touched node has
+// one of those ops. The result is the same fixed point as
+// FixedPointCompoundPass, reached with fewer invocations of passes which would
+// rediscover "unchanged".
+class WorklistFixedPointCompoundPass : public FixedPointCompoundPass {
+ public:
+  WorklistFixedPointCompoundPass(absl::string_view short_name,
+                                 absl::string_view long_name)
+      : FixedPointCompoundPass(short_name, long_name) {}
+
+  absl::StatusOr<bool> RunNested(
+      Package* p, const PassOptions& options, PassResults* results,
+      absl::string_view top_level_name,
+      absl::Span<const InvariantChecker* const> invariant_checkers)
+      const override;
+};
+
 }  // namespace xls
 
 #endif  // XLS_PASSES_PASSES_H_
@@ -16,6 +16,7 @@
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
 #include "xls/common/casts.h"
@@ -24,11 +25,15 @@
 #include "xls/common/status/status_macros.h"
 #include "xls/examples/sample_packages.h"
 #include "xls/ir/bits.h"
+#include "xls/ir/channel.h"
 #include "xls/ir/function.h"
 #include "xls/ir/function_builder.h"
 #include "xls/ir/ir_parser.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/op.h"
 #include "xls/ir/package.h"
 #include "xls/ir/type.h"
+#include "xls/ir/verifier.h"
 
 namespace xls {
 namespace {
@@ -432,5 +437,274 @@ TEST(PassesTest, TestTransformNodesToFixedPointWhileRemovingNodes) {
               IsOkAndHolds(false));
 }
 
+// Function base pass which records that it was run via a shared vector of
+// strings and has the given trigger ops.
+class TriggeredRecordingPass : public FunctionBasePass {
+ public:
+  TriggeredRecordingPass(std::string name, std::vector<std::string>* record,
+                         absl::optional<absl::flat_hash_set<Op>> trigger_ops)
+      : FunctionBasePass(name, name),
+        record_(record),
+        trigger_ops_(std::move(trigger_ops)) {}
+
+  absl::optional<absl::flat_hash_set<Op>> TriggerOps() const override {
+    return trigger_ops_;
+  }
+
+ protected:
+  absl::StatusOr<bool> RunOnFunctionBaseInternal(
+      FunctionBase* f, const PassOptions& options,
+      PassResults* results) const override {
+    record_->push_back(short_name());
+    return false;
+  }
+
+ private:
+  std::vector<std::string>* record_;
+  absl::optional<absl::flat_hash_set<Op>> trigger_ops_;
+};
+
+template <typename FixedPointPassT>
+void AddTriggeredPasses(FixedPointPassT* pass,
+                        std::vector<std::string>* record) {
+  pass->template Add<TriggeredRecordingPass>(
+      "tuple", record, absl::flat_hash_set<Op>({Op::kTupleIndex}));
+  pass->template Add<TriggeredRecordingPass>(
+      "neg", record, absl::flat_hash_set<Op>({Op::kNeg}));
+  pass->template Add<TriggeredRecordingPass>("any", record, absl::nullopt);
+  pass->template Add<NaiveDcePass>();
+}
+
+TEST(PassesTest, FixedPointRerunsAllPasses) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> p, Parser::ParsePackage(R"(
+package test
+
+fn f(x: bits[8]) -> bits[8] {
+  not.1: bits[8] = not(x)
+  ret neg.2: bits[8] = neg(x)
+}
+)"));
+  std::vector<std::string> record;
+  FixedPointCompoundPass pass("fp", "Fixed point");
+  AddTriggeredPasses(&pass, &record);
+  PassResults results;
+  EXPECT_THAT(pass.Run(p.get(), PassOptions(), &results), IsOkAndHolds(true));
+  EXPECT_THAT(record,
+              ElementsAre("tuple", "neg", "any", "tuple", "neg", "any"));
+}
+
+TEST(PassesTest, WorklistFixedPointSkipsUntriggeredPasses) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> p, Parser::ParsePackage(R"(
+package test
+
+fn f(x: bits[8]) -> bits[8] {
+  not.1: bits[8] = not(x)
+  ret neg.2: bits[8] = neg(x)
+}
+)"));
+  std::vector<std::string> record;
+  WorklistFixedPointCompoundPass pass("wfp", "Worklist fixed point");
+  AddTriggeredPasses(&pass, &record);
+  PassResults results;
+  EXPECT_THAT(pass.Run(p.get(), PassOptions(), &results), IsOkAndHolds(true));
+  // Removing not.1 touches its operand 'x' and the users of 'x' so only the
+  // passes triggered by neg or by any change are rerun.
+  EXPECT_THAT(record, ElementsAre("tuple", "neg", "any", "neg", "any"));
+  EXPECT_EQ(p->GetFunction("f").value()->node_count(), 2);
+
+  // Nothing changes on a second run so every pass is run exactly once.
+  record.clear();
+  EXPECT_THAT(pass.Run(p.get(), PassOptions(), &results), IsOkAndHolds(false));
+  EXPECT_THAT(record, ElementsAre("tuple", "neg", "any"));
+}
+
+TEST(PassesTest, WorklistFixedPointSkipsPassesWhenIrUnchanged) {
+  std::unique_ptr<Package> p = BuildShift0().first;
+
+  std::vector<std::string> record;
+  WorklistFixedPointCompoundPass pass("wfp", "Worklist fixed point");
+  pass.Add<RecordingPass>("foo", &record);
+  pass.Add<NaiveDcePass>();
+  pass.Add<RecordingPass>("bar", &record);
+  PassResults results;
+  EXPECT_THAT(pass.Run(p.get(), PassOptions(), &results), IsOkAndHolds(true));
+  // The dead code is removed in the first iteration. In the second iteration
+  // only 'foo' has not observed the change.
+  EXPECT_THAT(record, ElementsAre("foo", "bar", "foo"));
+}
+
+// Pass which makes the node with the given name the return value of each
+// function, without otherwise changing the graph.
+class SetReturnValuePass : public FunctionBasePass {
+ public:
+  explicit SetReturnValuePass(std::string node_name)
+      : FunctionBasePass("set_ret", "Set return value"),
+        node_name_(std::move(node_name)) {}
+
+ protected:
+  absl::StatusOr<bool> RunOnFunctionBaseInternal(
+      FunctionBase* f, const PassOptions& options,
+      PassResults* results) const override {
+    if (!f->IsFunction()) {
+      return false;
+    }
+    Function* function = f->AsFunctionOrDie();
+    XLS_ASSIGN_OR_RETURN(Node * node, function->GetNode(node_name_));
+    if (function->return_value() == node) {
+      return false;
+    }
+    XLS_RETURN_IF_ERROR(function->set_return_value(node));
+    return true;
+  }
+
+ private:
+  std::string node_name_;
+};
+
+TEST(PassesTest, WorklistFixedPointTouchesChangedReturnValue) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> p, Parser::ParsePackage(R"(
+package test
+
+fn f(x: bits[8]) -> bits[8] {
+  not.1: bits[8] = not(x)
+  ret neg.2: bits[8] = neg(x)
+}
+)"));
+  std::vector<std::string> record;
+  WorklistFixedPointCompoundPass pass("wfp", "Worklist fixed point");
+  pass.Add<TriggeredRecordingPass>("not", &record,
+                                   absl::flat_hash_set<Op>({Op::kNot}));
+  pass.Add<TriggeredRecordingPass>("neg", &record,
+                                   absl::flat_hash_set<Op>({Op::kNeg}));
+  pass.Add<TriggeredRecordingPass>(
+      "tuple", &record, absl::flat_hash_set<Op>({Op::kTupleIndex}));
+  pass.Add<SetReturnValuePass>("not.1");
+  PassResults results;
+  EXPECT_THAT(pass.Run(p.get(), PassOptions(), &results), IsOkAndHolds(true));
+  // Moving the return value adds and removes no nodes and changes no
+  // operands, but the old and new return values are touched.
+  EXPECT_THAT(record, ElementsAre("not", "neg", "tuple", "not", "neg"));
+}
+
+// Pass which negates the return value of each function.
+class NegateReturnValuePass : public FunctionBasePass {
+ public:
+  NegateReturnValuePass() : FunctionBasePass("negate_ret", "Negate return") {}
+
+ protected:
+  absl::StatusOr<bool> RunOnFunctionBaseInternal(
+      FunctionBase* f, const PassOptions& options,
+      PassResults* results) const override {
+    if (!f->IsFunction()) {
+      return false;
+    }
+    Function* function = f->AsFunctionOrDie();
+    XLS_ASSIGN_OR_RETURN(Node * neg, function->MakeNode<UnOp>(
+                                         absl::nullopt,
+                                         function->return_value(), Op::kNeg));
+    XLS_RETURN_IF_ERROR(function->set_return_value(neg));
+    return true;
+  }
+};
+
+const char kIndependentFunctionsPackage[] = R"(
+package independent
+
+fn a(x: bits[8]) -> bits[8] {
+  ret not.1: bits[8] = not(x)
+}
+
+fn b(x: bits[16]) -> bits[16] {
+  ret not.2: bits[16] = not(x)
+}
+
+fn c(x: bits[8]) -> bits[8] {
+  ret not.3: bits[8] = not(x)
+}
+
+fn d(x: bits[8]) -> bits[8] {
+  ret invoke.4: bits[8] = invoke(x, to_apply=c)
+}
+)";
+
+TEST(PassesTest, MultithreadedFunctionBasePassIsDeterministic) {
+  auto run_with_threads = [](int64_t thread_count) -> std::string {
+    std::unique_ptr<Package> p =
+        Parser::ParsePackage(kIndependentFunctionsPackage).value();
+    PassOptions options;
+    options.thread_count = thread_count;
+    PassResults results;
+    for (int64_t i = 0; i < 3; ++i) {
+      EXPECT_THAT(NegateReturnValuePass().Run(p.get(), options, &results),
+                  IsOkAndHolds(true));
+    }
+    XLS_EXPECT_OK(VerifyPackage(p.get()));
+    for (FunctionBase* f : p->GetFunctionBases()) {
+      EXPECT_EQ(f->node_count(), 5);
+    }
+    return p->DumpIr();
+  };
+  std::string two_threads = run_with_threads(2);
+  EXPECT_EQ(run_with_threads(1), two_threads);
+  EXPECT_EQ(run_with_threads(3), two_threads);
+  EXPECT_EQ(run_with_threads(8), two_threads);
+  // New nodes are numbered densely in package order.
+  EXPECT_THAT(two_threads, HasSubstr("ret neg.17: bits[8] = neg(neg.13"));
+}
+
+// A pass which adds a channel to the package when run on the function 'a'.
+class AddChannelPass : public FunctionBasePass {
+ public:
+  explicit AddChannelPass(bool supports_parallel_run)
+      : FunctionBasePass("add_channel", "Add channel"),
+        supports_parallel_run_(supports_parallel_run) {}
+
+  bool SupportsParallelRun() const override { return supports_parallel_run_; }
+
+ protected:
+  absl::StatusOr<bool> RunOnFunctionBaseInternal(
+      FunctionBase* f, const PassOptions& options,
+      PassResults* results) const override {
+    if (f->name() != "a") {
+      return false;
+    }
+    Package* p = f->package();
+    XLS_RETURN_IF_ERROR(
+        p->CreateStreamingChannel(absl::StrFormat("ch%d", p->channels().size()),
+                                  ChannelOps::kSendOnly, p->GetBitsType(8))
+            .status());
+    return true;
+  }
+
+ private:
+  bool supports_parallel_run_;
+};
+
+TEST(PassesTest, PassWithoutParallelSupportRunsSerially) {
+  std::unique_ptr<Package> p =
+      Parser::ParsePackage(kIndependentFunctionsPackage).value();
+  PassOptions options;
+  options.thread_count = 4;
+  PassResults results;
+  EXPECT_THAT(AddChannelPass(/*supports_parallel_run=*/false)
+                  .Run(p.get(), options, &results),
+              IsOkAndHolds(true));
+  EXPECT_EQ(p->channels().size(), 1);
+}
+
+#ifndef NDEBUG
+TEST(PassesTest, ParallelRunModifyingPackageIsDetected) {
+  std::unique_ptr<Package> p =
+      Parser::ParsePackage(kIndependentFunctionsPackage).value();
+  PassOptions options;
+  options.thread_count = 4;
+  PassResults results;
+  EXPECT_THAT(AddChannelPass(/*supports_parallel_run=*/true)
+                  .Run(p.get(), options, &results),
+              StatusIs(absl::StatusCode::kInternal,
+                       HasSubstr("must override SupportsParallelRun()")));
+}
+#endif
+
 }  // namespace
 }  // namespace xls
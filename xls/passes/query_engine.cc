@@ -14,8 +14,10 @@
 
 #include "xls/passes/query_engine.h"
 
+#include "absl/container/flat_hash_set.h"
 #include "xls/common/logging/logging.h"
 #include "xls/ir/bits_ops.h"
+#include "xls/ir/node_iterator.h"
 #include "xls/ir/ternary.h"
 
 namespace xls {
@@ -45,6 +47,65 @@ std::vector<TreeBitLocation> ToTreeBitLocations(absl::Span<Node* const> preds) {
 
 }  // namespace
 
+/* static */ NodeStructureTracker::NodeStructure
+NodeStructureTracker::GetStructure(Node* node) {
+  NodeStructure structure{node->id(), node->GetType(), {}};
+  structure.operand_ids.reserve(node->operand_count());
+  for (Node* operand : node->operands()) {
+    structure.operand_ids.push_back(operand->id());
+  }
+  return structure;
+}
+
+void NodeStructureTracker::Record(FunctionBase* f) {
+  nodes_.clear();
+  for (Node* node : f->nodes()) {
+    nodes_[node] = GetStructure(node);
+  }
+}
+
+NodeStructureTracker::Changes NodeStructureTracker::Update(
+    FunctionBase* f, absl::Span<Node* const> invalidated) {
+  Changes changes;
+  absl::flat_hash_set<Node*> stale(invalidated.begin(), invalidated.end());
+  absl::flat_hash_map<Node*, NodeStructure> new_nodes;
+  new_nodes.reserve(f->node_count());
+  for (Node* node : f->nodes()) {
+    NodeStructure structure = GetStructure(node);
+    auto it = nodes_.find(node);
+    if (it == nodes_.end() || it->second.id != structure.id ||
+        it->second.type != structure.type ||
+        it->second.operand_ids != structure.operand_ids) {
+      stale.insert(node);
+    }
+    new_nodes[node] = std::move(structure);
+  }
+  for (const auto& [node, _] : nodes_) {
+    if (!new_nodes.contains(node)) {
+      changes.removed_nodes.push_back(node);
+    }
+  }
+  nodes_ = std::move(new_nodes);
+
+  // Visiting the nodes in topological order guarantees every node's operands
+  // are visited before the node itself so a single pass suffices to propagate
+  // staleness to all transitive users.
+  for (Node* node : TopoSort(f)) {
+    if (!stale.contains(node)) {
+      for (Node* operand : node->operands()) {
+        if (stale.contains(operand)) {
+          stale.insert(node);
+          break;
+        }
+      }
+    }
+    if (stale.contains(node)) {
+      changes.stale_nodes.push_back(node);
+    }
+  }
+  return changes;
+}
+
 bool QueryEngine::AtMostOneNodeTrue(absl::Span<Node* const> preds) const {
   return AtMostOneTrue(ToTreeBitLocations(preds));
 }
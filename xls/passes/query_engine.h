@@ -15,10 +15,16 @@
 #ifndef XLS_PASSES_QUERY_ENGINE_H_
 #define XLS_PASSES_QUERY_ENGINE_H_
 
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/types/span.h"
 #include "absl/types/variant.h"
 #include "xls/data_structures/leaf_type_tree.h"
 #include "xls/ir/bits.h"
+#include "xls/ir/function_base.h"
 #include "xls/ir/node.h"
 #include "xls/ir/ternary.h"
 
@@ -59,6 +65,42 @@ class TreeBitLocation {
 
 enum class ReachedFixpoint { Unchanged, Changed, Unknown };
 
+// Records the structure (id, type and operands) of the nodes of a function base
+// so a query engine can determine which of its facts are stale after the IR
+// has been modified.
+class NodeStructureTracker {
+ public:
+  struct Changes {
+    // Nodes whose facts must be recomputed in topological order. These are the
+    // nodes which are new or whose type or operands changed, the explicitly
+    // invalidated nodes, and all of their transitive users.
+    std::vector<Node*> stale_nodes;
+
+    // Previously recorded nodes which are no longer in the function base. These
+    // pointers may dangle and must not be dereferenced.
+    std::vector<Node*> removed_nodes;
+  };
+
+  // Records the current structure of all nodes in 'f'.
+  void Record(FunctionBase* f);
+
+  // Returns the changes in 'f' since the last call to Record or Update and
+  // records the current structure. Nodes in 'invalidated' are considered
+  // changed even if their structure is unchanged.
+  Changes Update(FunctionBase* f, absl::Span<Node* const> invalidated);
+
+ private:
+  struct NodeStructure {
+    int64_t id;
+    Type* type;
+    std::vector<int64_t> operand_ids;
+  };
+
+  static NodeStructure GetStructure(Node* node);
+
+  absl::flat_hash_map<Node*, NodeStructure> nodes_;
+};
+
 // An abstract base class providing an interface for answering queries about the
 // values of and relationship between bits in an XLS function. Information
 // provided include statically known bit values and implications between bits in
@@ -77,6 +119,18 @@ class QueryEngine {
 
   virtual absl::StatusOr<ReachedFixpoint> Populate(FunctionBase* f) = 0;
 
+  // Brings the engine up to date after 'f' (which was previously populated)
+  // was modified. Facts about new nodes, nodes whose operands changed, the
+  // nodes in 'invalidated', and their transitive users are recomputed from
+  // scratch. Facts about other nodes are retained and facts about removed nodes
+  // are discarded. Nodes whose behavior changed without a change in operands or
+  // type must be passed in 'invalidated'.
+  virtual absl::StatusOr<ReachedFixpoint> Update(
+      FunctionBase* f, absl::Span<Node* const> invalidated = {}) {
+    return absl::UnimplementedError(
+        "Query engine does not support incremental updates");
+  }
+
   // Returns whether any information is available for this node.
   virtual bool IsTracked(Node* node) const = 0;
 
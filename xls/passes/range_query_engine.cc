@@ -360,6 +360,31 @@ IntervalSet MinimizeIntervals(IntervalSet intervals, int64_t size) {
 absl::StatusOr<ReachedFixpoint> RangeQueryEngine::Populate(FunctionBase* f) {
   RangeQueryVisitor visitor(this);
   XLS_RETURN_IF_ERROR(f->Accept(&visitor));
+  tracker_.Record(f);
+  return visitor.GetReachedFixpoint();
+}
+
+absl::StatusOr<ReachedFixpoint> RangeQueryEngine::Update(
+    FunctionBase* f, absl::Span<Node* const> invalidated) {
+  NodeStructureTracker::Changes changes = tracker_.Update(f, invalidated);
+  auto forget = [&](Node* node) {
+    known_bits_.erase(node);
+    known_bit_values_.erase(node);
+    interval_sets_.erase(node);
+  };
+  for (Node* node : changes.removed_nodes) {
+    forget(node);
+  }
+  for (Node* node : changes.stale_nodes) {
+    forget(node);
+  }
+
+  // Stale nodes are in topological order so the operands of each node are
+  // up to date when the node is visited.
+  RangeQueryVisitor visitor(this);
+  for (Node* node : changes.stale_nodes) {
+    XLS_RETURN_IF_ERROR(node->VisitSingleNode(&visitor));
+  }
   return visitor.GetReachedFixpoint();
 }
 
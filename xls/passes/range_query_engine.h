@@ -47,6 +47,11 @@ class RangeQueryEngine : public QueryEngine {
   // given `FunctionBase*`;
   absl::StatusOr<ReachedFixpoint> Populate(FunctionBase* f) override;
 
+  // Recomputes the ranges of the nodes affected by modifications of 'f' since
+  // the last call to Populate or Update.
+  absl::StatusOr<ReachedFixpoint> Update(
+      FunctionBase* f, absl::Span<Node* const> invalidated = {}) override;
+
   bool IsTracked(Node* node) const override {
     return known_bits_.contains(node);
   }
@@ -121,6 +126,7 @@ class RangeQueryEngine : public QueryEngine {
   absl::flat_hash_map<Node*, Bits> known_bits_;
   absl::flat_hash_map<Node*, Bits> known_bit_values_;
   absl::flat_hash_map<Node*, IntervalSetTree> interval_sets_;
+  NodeStructureTracker tracker_;
 };
 
 // Reduce the size of the given `IntervalSet` to the given size.
@@ -1012,5 +1012,34 @@ TEST_F(RangeQueryEngineTest, ZeroExtend) {
             BitsLTT(expr.node(), {Interval(UBits(500, 40), UBits(700, 40))}));
 }
 
+TEST_F(RangeQueryEngineTest, UpdateAfterModification) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+
+  BValue x = fb.Param("x", fb.package()->GetBitsType(20));
+  BValue y = fb.Literal(UBits(15, 20));
+  BValue expr = fb.Add(x, y);
+
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+  RangeQueryEngine engine;
+  engine.SetIntervalSetTree(
+      x.node(), BitsLTT(x.node(), {Interval(UBits(0, 20), UBits(48, 20))}));
+  XLS_ASSERT_OK(engine.Populate(f));
+  EXPECT_EQ("0b0000_0000_0000_00XX_XXXX", engine.ToString(expr.node()));
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Node * new_literal,
+      f->MakeNode<Literal>(absl::nullopt, Value(UBits(200, 20))));
+  XLS_ASSERT_OK(expr.node()->ReplaceOperandNumber(1, new_literal));
+  XLS_ASSERT_OK(f->RemoveNode(y.node()));
+  XLS_ASSERT_OK(engine.Update(f));
+
+  // The range of 'x' is retained and the sum is in [200, 248].
+  IntervalSet expected(20);
+  expected.AddInterval(Interval(UBits(200, 20), UBits(248, 20)));
+  EXPECT_EQ(engine.GetIntervalSetTree(expr.node()).Get({}), expected);
+  EXPECT_EQ("0b0000_0000_0000_11XX_XXXX", engine.ToString(expr.node()));
+}
+
 }  // namespace
 }  // namespace xls
@@ -33,6 +33,7 @@
 #include "xls/ir/node_util.h"
 #include "xls/ir/nodes.h"
 #include "xls/passes/post_dominator_analysis.h"
+#include "xls/passes/shared_query_engines.h"
 #include "xls/passes/ternary_query_engine.h"
 
 namespace xls {
@@ -1058,12 +1059,16 @@ absl::StatusOr<bool> SpecializeSelectArms(FunctionBase* func) {
 absl::StatusOr<bool> SelectSimplificationPass::RunOnFunctionBaseInternal(
     FunctionBase* func, const PassOptions& options,
     PassResults* results) const {
-  TernaryQueryEngine query_engine;
-  XLS_RETURN_IF_ERROR(query_engine.Populate(func).status());
+  SharedQueryEngines local_query_engines;
+  SharedQueryEngines* query_engines = options.shared_query_engines != nullptr
+                                          ? options.shared_query_engines
+                                          : &local_query_engines;
+  XLS_ASSIGN_OR_RETURN(TernaryQueryEngine * query_engine,
+                       query_engines->GetTernaryQueryEngine(func));
   bool changed = false;
   for (Node* node : TopoSort(func)) {
     XLS_ASSIGN_OR_RETURN(bool node_changed,
-                         SimplifyNode(node, query_engine, opt_level_));
+                         SimplifyNode(node, *query_engine, opt_level_));
     changed = changed | node_changed;
   }
 
@@ -1090,7 +1095,7 @@ absl::StatusOr<bool> SelectSimplificationPass::RunOnFunctionBaseInternal(
       // ok. TernaryQueryEngine::IsTracked will return false for new nodes which
       // have not been analyzed.
       XLS_ASSIGN_OR_RETURN(std::vector<OneHotSelect*> new_ohses,
-                           MaybeSplitOneHotSelect(ohs, query_engine));
+                           MaybeSplitOneHotSelect(ohs, *query_engine));
       if (!new_ohses.empty()) {
         changed = true;
         worklist.insert(worklist.end(), new_ohses.begin(), new_ohses.end());
@@ -0,0 +1,74 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/passes/shared_query_engines.h"
+
+#include "xls/common/status/status_macros.h"
+#include "xls/passes/bdd_function.h"
+
+namespace xls {
+namespace {
+
+// Populates the given engine if it does not exist yet, otherwise updates it
+// with the modifications of 'f' since it was last populated or updated.
+template <typename EngineT, typename MakeEngineT>
+absl::StatusOr<EngineT*> GetUpToDateEngine(std::unique_ptr<EngineT>* engine,
+                                           FunctionBase* f,
+                                           MakeEngineT make_engine) {
+  if (*engine == nullptr) {
+    *engine = make_engine();
+    XLS_RETURN_IF_ERROR((*engine)->Populate(f).status());
+  } else {
+    XLS_RETURN_IF_ERROR((*engine)->Update(f).status());
+  }
+  return engine->get();
+}
+
+}  // namespace
+
+SharedQueryEngines::FunctionBaseEngines* SharedQueryEngines::GetEngines(
+    FunctionBase* f) {
+  absl::MutexLock lock(&mutex_);
+  std::unique_ptr<FunctionBaseEngines>& engines = engines_[f];
+  if (engines == nullptr) {
+    engines = std::make_unique<FunctionBaseEngines>();
+  }
+  return engines.get();
+}
+
+absl::StatusOr<TernaryQueryEngine*> SharedQueryEngines::GetTernaryQueryEngine(
+    FunctionBase* f) {
+  return GetUpToDateEngine(&GetEngines(f)->ternary, f, [] {
+    return std::make_unique<TernaryQueryEngine>();
+  });
+}
+
+absl::StatusOr<RangeQueryEngine*> SharedQueryEngines::GetRangeQueryEngine(
+    FunctionBase* f) {
+  return GetUpToDateEngine(&GetEngines(f)->range, f, [] {
+    return std::make_unique<RangeQueryEngine>();
+  });
+}
+
+absl::StatusOr<BddQueryEngine*> SharedQueryEngines::GetBddQueryEngine(
+    FunctionBase* f) {
+  return GetUpToDateEngine(&GetEngines(f)->bdd, f, [&] {
+    return std::make_unique<BddQueryEngine>(BddFunction::kDefaultPathLimit,
+                                            /*do_not_evaluate_ops=*/
+                                            absl::Span<const Op>(),
+                                            bdd_memory_limit_bytes_);
+  });
+}
+
+}  // namespace xls
@@ -0,0 +1,76 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_PASSES_SHARED_QUERY_ENGINES_H_
+#define XLS_PASSES_SHARED_QUERY_ENGINES_H_
+
+#include <cstdint>
+#include <memory>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "xls/ir/function_base.h"
+#include "xls/passes/bdd_query_engine.h"
+#include "xls/passes/range_query_engine.h"
+#include "xls/passes/ternary_query_engine.h"
+
+namespace xls {
+
+// A set of query engines for the function bases of a package which may be
+// shared by several passes. The first request for an engine of a function base
+// populates the engine. Later requests incrementally update the engine with the
+// modifications made to the function base in the meantime (see
+// QueryEngine::Update) rather than recomputing it from scratch. Engines of
+// different function bases may be requested concurrently.
+//
+// Passes should request an engine from the SharedQueryEngines object given in
+// PassOptions, if any, and otherwise from a local SharedQueryEngines object.
+class SharedQueryEngines {
+ public:
+  // 'bdd_memory_limit_bytes' is the memory limit of the BDD query engines (see
+  // BddFunction::Run). Zero means no limit.
+  explicit SharedQueryEngines(int64_t bdd_memory_limit_bytes = 0)
+      : bdd_memory_limit_bytes_(bdd_memory_limit_bytes) {}
+
+  absl::StatusOr<TernaryQueryEngine*> GetTernaryQueryEngine(FunctionBase* f);
+  absl::StatusOr<RangeQueryEngine*> GetRangeQueryEngine(FunctionBase* f);
+
+  // Returns a BDD query engine with the default path limit
+  // (BddFunction::kDefaultPathLimit) and the memory limit given at
+  // construction.
+  absl::StatusOr<BddQueryEngine*> GetBddQueryEngine(FunctionBase* f);
+
+ private:
+  struct FunctionBaseEngines {
+    std::unique_ptr<TernaryQueryEngine> ternary;
+    std::unique_ptr<RangeQueryEngine> range;
+    std::unique_ptr<BddQueryEngine> bdd;
+  };
+
+  // Returns the engines of the given function base. The returned object is
+  // only accessed by the (single) thread running passes on the function base.
+  FunctionBaseEngines* GetEngines(FunctionBase* f);
+
+  int64_t bdd_memory_limit_bytes_;
+
+  absl::Mutex mutex_;
+  absl::flat_hash_map<FunctionBase*, std::unique_ptr<FunctionBaseEngines>>
+      engines_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace xls
+
+#endif  // XLS_PASSES_SHARED_QUERY_ENGINES_H_
@@ -0,0 +1,78 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/passes/shared_query_engines.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/function.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/package.h"
+#include "xls/ir/value.h"
+
+namespace xls {
+namespace {
+
+class SharedQueryEnginesTest : public IrTestBase {};
+
+TEST_F(SharedQueryEnginesTest, EnginesAreReusedAndUpdated) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
+fn f(x: bits[8]) -> bits[8] {
+  literal.1: bits[8] = literal(value=0x0f)
+  ret and.2: bits[8] = and(x, literal.1)
+}
+)",
+                                                       p.get()));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * g, ParseFunction(R"(
+fn g(y: bits[8]) -> bits[8] {
+  ret neg.3: bits[8] = neg(y)
+}
+)",
+                                                       p.get()));
+  SharedQueryEngines engines;
+  XLS_ASSERT_OK_AND_ASSIGN(TernaryQueryEngine * ternary,
+                           engines.GetTernaryQueryEngine(f));
+  EXPECT_EQ(ternary->ToString(f->return_value()), "0b0000_XXXX");
+  XLS_ASSERT_OK_AND_ASSIGN(TernaryQueryEngine * g_ternary,
+                           engines.GetTernaryQueryEngine(g));
+  EXPECT_NE(ternary, g_ternary);
+
+  // Modify the function. Engines requested afterwards reflect the change.
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Node * new_mask,
+      f->MakeNode<Literal>(absl::nullopt, Value(UBits(0x01, 8))));
+  XLS_ASSERT_OK(f->return_value()->ReplaceOperandNumber(1, new_mask));
+  XLS_ASSERT_OK(f->RemoveNode(FindNode("literal.1", f)));
+
+  XLS_ASSERT_OK_AND_ASSIGN(TernaryQueryEngine * updated_ternary,
+                           engines.GetTernaryQueryEngine(f));
+  EXPECT_EQ(ternary, updated_ternary);
+  EXPECT_EQ(updated_ternary->ToString(f->return_value()), "0b0000_000X");
+
+  XLS_ASSERT_OK_AND_ASSIGN(RangeQueryEngine * range,
+                           engines.GetRangeQueryEngine(f));
+  EXPECT_TRUE(range->IsTracked(new_mask));
+  XLS_ASSERT_OK_AND_ASSIGN(BddQueryEngine * bdd, engines.GetBddQueryEngine(f));
+  EXPECT_EQ(bdd->ToString(f->return_value()), "0b0000_000X");
+  XLS_ASSERT_OK_AND_ASSIGN(BddQueryEngine * same_bdd,
+                           engines.GetBddQueryEngine(f));
+  EXPECT_EQ(bdd, same_bdd);
+}
+
+}  // namespace
+}  // namespace xls
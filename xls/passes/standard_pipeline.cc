@@ -38,6 +38,7 @@
 #include "xls/passes/narrowing_pass.h"
 #include "xls/passes/reassociation_pass.h"
 #include "xls/passes/select_simplification_pass.h"
+#include "xls/passes/shared_query_engines.h"
 #include "xls/passes/strength_reduction_pass.h"
 #include "xls/passes/table_switch_pass.h"
 #include "xls/passes/tuple_simplification_pass.h"
@@ -47,10 +48,10 @@
 
 namespace xls {
 
-class SimplificationPass : public FixedPointCompoundPass {
+class SimplificationPass : public WorklistFixedPointCompoundPass {
  public:
   explicit SimplificationPass(int64_t opt_level)
-      : FixedPointCompoundPass("simp", "Simplification") {
+      : WorklistFixedPointCompoundPass("simp", "Simplification") {
     Add<ConstantFoldingPass>();
     Add<DeadCodeEliminationPass>();
     Add<CanonicalizationPass>();
@@ -85,6 +86,24 @@ class SimplificationPass : public FixedPointCompoundPass {
     Add<DeadCodeEliminationPass>();
     Add<CsePass>();
   }
+
+  // The query engines used by the select, array and narrowing passes are
+  // shared across all iterations and are updated incrementally.
+  absl::StatusOr<bool> RunNested(
+      Package* p, const PassOptions& options, PassResults* results,
+      absl::string_view top_level_name,
+      absl::Span<const InvariantChecker* const> invariant_checkers)
+      const override {
+    if (options.shared_query_engines != nullptr) {
+      return WorklistFixedPointCompoundPass::RunNested(
+          p, options, results, top_level_name, invariant_checkers);
+    }
+    SharedQueryEngines query_engines(options.bdd_memory_limit_bytes);
+    PassOptions nested_options = options;
+    nested_options.shared_query_engines = &query_engines;
+    return WorklistFixedPointCompoundPass::RunNested(
+        p, nested_options, results, top_level_name, invariant_checkers);
+  }
 };
 
 std::unique_ptr<CompoundPass> CreateStandardPassPipeline(int64_t opt_level) {
@@ -14,7 +14,10 @@
 #ifndef XLS_PASSES_TABLE_SWITCH_PASS_H_
 #define XLS_PASSES_TABLE_SWITCH_PASS_H_
 
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/statusor.h"
+#include "absl/types/optional.h"
+#include "xls/ir/op.h"
 #include "xls/passes/passes.h"
 
 namespace xls {
@@ -37,6 +40,11 @@ class TableSwitchPass : public FunctionBasePass {
   TableSwitchPass()
       : FunctionBasePass("table_switch", "Table switch conversion") {}
 
+  // Chains are rooted at selects whose selectors are comparisons.
+  absl::optional<absl::flat_hash_set<Op>> TriggerOps() const override {
+    return absl::flat_hash_set<Op>({Op::kSel, Op::kEq, Op::kNe});
+  }
+
  protected:
   absl::StatusOr<bool> RunOnFunctionBaseInternal(
       FunctionBase* f, const PassOptions& options,
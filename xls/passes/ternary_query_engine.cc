@@ -14,7 +14,9 @@
 
 #include "xls/passes/ternary_query_engine.h"
 
+#include <functional>
 #include <limits>
+#include <vector>
 
 #include "absl/container/inlined_vector.h"
 #include "absl/status/statusor.h"
@@ -61,6 +63,28 @@ Bits TernaryVectorToValueBits(const TernaryEvaluator::Vector& ternary_vector) {
   return Bits(bits);
 }
 
+// Evaluates the given bits-typed node using the ternary values of its operands
+// returned by 'get_operand_value'.
+static absl::StatusOr<TernaryEvaluator::Vector> EvaluateNode(
+    Node* node, TernaryEvaluator* evaluator,
+    const std::function<TernaryEvaluator::Vector(Node*)>& get_operand_value) {
+  auto create_unknown_vector = [](Node* n) {
+    return TernaryEvaluator::Vector(n->BitCountOrDie(), TernaryValue::kUnknown);
+  };
+  if (IsExpensiveToEvaluate(node) ||
+      std::any_of(node->operands().begin(), node->operands().end(),
+                  [](Node* o) { return !o->GetType()->IsBits(); })) {
+    return create_unknown_vector(node);
+  }
+
+  std::vector<TernaryEvaluator::Vector> operand_values;
+  for (Node* operand : node->operands()) {
+    operand_values.push_back(get_operand_value(operand));
+  }
+  return AbstractEvaluate(node, operand_values, evaluator,
+                          /*default_handler=*/create_unknown_vector);
+}
+
 absl::StatusOr<ReachedFixpoint> TernaryQueryEngine::Populate(FunctionBase* f) {
   TernaryEvaluator evaluator;
   absl::flat_hash_map<Node*, TernaryEvaluator::Vector> values;
@@ -68,26 +92,12 @@ absl::StatusOr<ReachedFixpoint> TernaryQueryEngine::Populate(FunctionBase* f) {
     if (!node->GetType()->IsBits()) {
       continue;
     }
-    auto create_unknown_vector = [](Node* n) {
-      return TernaryEvaluator::Vector(n->BitCountOrDie(),
-                                      TernaryValue::kUnknown);
-    };
-    if (IsExpensiveToEvaluate(node) ||
-        std::any_of(node->operands().begin(), node->operands().end(),
-                    [](Node* o) { return !o->GetType()->IsBits(); })) {
-      values[node] = create_unknown_vector(node);
-      continue;
-    }
-
-    std::vector<TernaryEvaluator::Vector> operand_values;
-    for (Node* operand : node->operands()) {
-      operand_values.push_back(values.at(operand));
-    }
     XLS_ASSIGN_OR_RETURN(
         values[node],
-        AbstractEvaluate(node, operand_values, &evaluator,
-                         /*default_handler=*/create_unknown_vector));
+        EvaluateNode(node, &evaluator,
+                     [&](Node* operand) { return values.at(operand); }));
   }
+  tracker_.Record(f);
 
   ReachedFixpoint rf = ReachedFixpoint::Unchanged;
   for (Node* node : f->nodes()) {
@@ -112,6 +122,36 @@ absl::StatusOr<ReachedFixpoint> TernaryQueryEngine::Populate(FunctionBase* f) {
   return rf;
 }
 
+absl::StatusOr<ReachedFixpoint> TernaryQueryEngine::Update(
+    FunctionBase* f, absl::Span<Node* const> invalidated) {
+  NodeStructureTracker::Changes changes = tracker_.Update(f, invalidated);
+  for (Node* node : changes.removed_nodes) {
+    known_bits_.erase(node);
+    bits_values_.erase(node);
+  }
+  for (Node* node : changes.stale_nodes) {
+    known_bits_.erase(node);
+    bits_values_.erase(node);
+  }
+
+  TernaryEvaluator evaluator;
+  for (Node* node : changes.stale_nodes) {
+    if (!node->GetType()->IsBits()) {
+      continue;
+    }
+    XLS_ASSIGN_OR_RETURN(
+        TernaryEvaluator::Vector value,
+        EvaluateNode(node, &evaluator, [&](Node* operand) {
+          return ternary_ops::FromKnownBits(known_bits_.at(operand),
+                                            bits_values_.at(operand));
+        }));
+    known_bits_[node] = TernaryVectorToKnownBits(value);
+    bits_values_[node] = TernaryVectorToValueBits(value);
+  }
+  return changes.stale_nodes.empty() ? ReachedFixpoint::Unchanged
+                                     : ReachedFixpoint::Changed;
+}
+
 bool TernaryQueryEngine::AtMostOneTrue(
     absl::Span<TreeBitLocation const> bits) const {
   int64_t maybe_one_count = 0;
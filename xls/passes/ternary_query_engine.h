@@ -34,6 +34,8 @@ class TernaryQueryEngine : public QueryEngine {
   TernaryQueryEngine() {}
 
   absl::StatusOr<ReachedFixpoint> Populate(FunctionBase* f) override;
+  absl::StatusOr<ReachedFixpoint> Update(
+      FunctionBase* f, absl::Span<Node* const> invalidated = {}) override;
 
   bool IsTracked(Node* node) const override {
     return known_bits_.contains(node);
@@ -75,6 +77,9 @@ class TernaryQueryEngine : public QueryEngine {
 
   // Holds the values of statically known bits of nodes in the function.
   absl::flat_hash_map<Node*, Bits> bits_values_;
+
+  // Structure of the nodes at the last Populate or Update call.
+  NodeStructureTracker tracker_;
 };
 
 }  // namespace xls
@@ -130,5 +130,49 @@ TEST_F(TernaryQueryEngineTest, Ne) {
   EXPECT_THAT(RunOnBinaryOp("0b011", "0b011", make_ne), IsOkAndHolds("0b0"));
 }
 
+TEST_F(TernaryQueryEngineTest, UpdateAfterModification) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
+fn f(x: bits[8]) -> bits[8] {
+  literal.1: bits[8] = literal(value=0x0f)
+  and.2: bits[8] = and(x, literal.1)
+  literal.3: bits[8] = literal(value=0x30)
+  ret or.4: bits[8] = or(and.2, literal.3)
+}
+)",
+                                                       p.get()));
+  TernaryQueryEngine query_engine;
+  XLS_ASSERT_OK(query_engine.Populate(f).status());
+  EXPECT_EQ(query_engine.ToString(f->return_value()), "0b0011_XXXX");
+
+  // Narrow the mask and remove the old mask.
+  Node* and_node = FindNode("and.2", f);
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Node * new_mask,
+      f->MakeNode<Literal>(absl::nullopt, Value(UBits(0x03, 8))));
+  XLS_ASSERT_OK(and_node->ReplaceOperandNumber(1, new_mask));
+  XLS_ASSERT_OK(f->RemoveNode(FindNode("literal.1", f)));
+
+  EXPECT_THAT(query_engine.Update(f), IsOkAndHolds(ReachedFixpoint::Changed));
+  EXPECT_TRUE(query_engine.IsTracked(new_mask));
+  EXPECT_EQ(query_engine.ToString(and_node), "0b0000_00XX");
+  EXPECT_EQ(query_engine.ToString(f->return_value()), "0b0011_00XX");
+
+  // The result matches populating from scratch.
+  TernaryQueryEngine fresh_query_engine;
+  XLS_ASSERT_OK(fresh_query_engine.Populate(f).status());
+  for (Node* node : f->nodes()) {
+    EXPECT_EQ(query_engine.ToString(node), fresh_query_engine.ToString(node));
+  }
+
+  // Without further modifications nothing is recomputed unless explicitly
+  // invalidated.
+  EXPECT_THAT(query_engine.Update(f),
+              IsOkAndHolds(ReachedFixpoint::Unchanged));
+  EXPECT_THAT(query_engine.Update(f, {and_node}),
+              IsOkAndHolds(ReachedFixpoint::Changed));
+  EXPECT_EQ(query_engine.ToString(f->return_value()), "0b0011_00XX");
+}
+
 }  // namespace
 }  // namespace xls
@@ -15,8 +15,11 @@
 #ifndef XLS_PASSES_TUPLE_SIMPLIFICATION_PASS_H_
 #define XLS_PASSES_TUPLE_SIMPLIFICATION_PASS_H_
 
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/statusor.h"
+#include "absl/types/optional.h"
 #include "xls/ir/function.h"
+#include "xls/ir/op.h"
 #include "xls/passes/passes.h"
 
 namespace xls {
@@ -29,6 +32,10 @@ class TupleSimplificationPass : public FunctionBasePass {
       : FunctionBasePass("tuple_simp", "Tuple simplification") {}
   ~TupleSimplificationPass() override {}
 
+  absl::optional<absl::flat_hash_set<Op>> TriggerOps() const override {
+    return absl::flat_hash_set<Op>({Op::kTuple, Op::kTupleIndex});
+  }
+
  protected:
   absl::StatusOr<bool> RunOnFunctionBaseInternal(
       FunctionBase* f, const PassOptions& options,
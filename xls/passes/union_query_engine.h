@@ -37,10 +37,20 @@ namespace xls {
 class UnionQueryEngine : public QueryEngine {
  public:
   explicit UnionQueryEngine(std::vector<std::unique_ptr<QueryEngine>> engines) {
-    engines_ = std::move(engines);
+    owned_engines_ = std::move(engines);
+    for (const std::unique_ptr<QueryEngine>& engine : owned_engines_) {
+      engines_.push_back(engine.get());
+    }
   }
 
+  // Constructs a union of engines which are owned elsewhere. The engines must
+  // outlive this object.
+  explicit UnionQueryEngine(std::vector<QueryEngine*> engines)
+      : engines_(std::move(engines)) {}
+
   absl::StatusOr<ReachedFixpoint> Populate(FunctionBase* f) override;
+  absl::StatusOr<ReachedFixpoint> Update(
+      FunctionBase* f, absl::Span<Node* const> invalidated = {}) override;
 
   bool IsTracked(Node* node) const override;
 
@@ -66,7 +76,8 @@ class UnionQueryEngine : public QueryEngine {
  private:
   absl::flat_hash_map<Node*, Bits> known_bits_;
   absl::flat_hash_map<Node*, Bits> known_bit_values_;
-  std::vector<std::unique_ptr<QueryEngine>> engines_;
+  std::vector<std::unique_ptr<QueryEngine>> owned_engines_;
+  std::vector<QueryEngine*> engines_;
 };
 
 }  // namespace xls
@@ -14,8 +14,11 @@
 #ifndef XLS_PASSES_USELESS_ASSERT_REMOVAL_PASS_H_
 #define XLS_PASSES_USELESS_ASSERT_REMOVAL_PASS_H_
 
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/statusor.h"
+#include "absl/types/optional.h"
 #include "xls/ir/function.h"
+#include "xls/ir/op.h"
 #include "xls/passes/passes.h"
 
 namespace xls {
@@ -29,6 +32,10 @@ class UselessAssertRemovalPass : public FunctionBasePass {
                          "Remove useless (always true) asserts") {}
   ~UselessAssertRemovalPass() override {}
 
+  absl::optional<absl::flat_hash_set<Op>> TriggerOps() const override {
+    return absl::flat_hash_set<Op>({Op::kAssert});
+  }
+
  protected:
   absl::StatusOr<bool> RunOnFunctionBaseInternal(
       FunctionBase* f, const PassOptions& options,
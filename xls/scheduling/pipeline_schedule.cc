@@ -14,17 +14,30 @@
 
 #include "xls/scheduling/pipeline_schedule.h"
 
+#include <deque>
+#include <memory>
+#include <random>
+#include <set>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "xls/common/logging/log_lines.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/status/ret_check.h"
+#include "xls/common/thread_pool.h"
 #include "xls/data_structures/binary_search.h"
+#include "xls/data_structures/difference_constraints.h"
 #include "xls/ir/node_iterator.h"
+#include "xls/ir/op.h"
 #include "xls/scheduling/function_partition.h"
 #include "xls/scheduling/schedule_bounds.h"
+#include "xls/scheduling/structural_hash.h"
 
 namespace xls {
 namespace {
@@ -56,6 +69,12 @@ absl::Status SplitAfterCycle(FunctionBase* f, int64_t cycle,
       partitionable_nodes.push_back(node);
     }
   }
+  // Nodes pinned to a single cycle (e.g., to their cycle in a previous
+  // schedule) are never partitionable. If every node is on one side of the
+  // boundary already there is nothing to cut.
+  if (partitionable_nodes.empty()) {
+    return absl::OkStatus();
+  }
 
   std::pair<std::vector<Node*>, std::vector<Node*>> partitions =
       sched::MinCostFunctionPartition(f, partitionable_nodes);
@@ -89,13 +108,38 @@ absl::StatusOr<int64_t> CountInteriorPipelineRegisters(
   return registers;
 }
 
+// Returns bounds in which each node has a range of exactly one cycle by
+// partitioning the nodes at each cycle boundary in the given order, along with
+// the resulting number of interior pipeline registers.
+absl::StatusOr<std::pair<sched::ScheduleBounds, int64_t>> RunCutOrder(
+    FunctionBase* f, absl::Span<const int64_t> cut_order,
+    const DelayEstimator& delay_estimator,
+    const sched::ScheduleBounds& initial_bounds) {
+  XLS_VLOG(3) << absl::StreamFormat("Trying cycle order: {%s}",
+                                    absl::StrJoin(cut_order, ", "));
+  sched::ScheduleBounds bounds = initial_bounds;
+  // Partition the nodes at each cycle boundary. For each iteration, this
+  // splits the nodes into those which must be scheduled at or before the
+  // cycle and those which must be scheduled after. Upon loop completion each
+  // node will have a range of exactly one cycle.
+  for (int64_t cycle : cut_order) {
+    XLS_RETURN_IF_ERROR(SplitAfterCycle(f, cycle, delay_estimator, &bounds));
+    XLS_RETURN_IF_ERROR(bounds.PropagateLowerBounds());
+    XLS_RETURN_IF_ERROR(bounds.PropagateUpperBounds());
+  }
+  XLS_ASSIGN_OR_RETURN(int64_t register_count,
+                       CountInteriorPipelineRegisters(f, bounds));
+  return std::make_pair(std::move(bounds), register_count);
+}
+
 // Schedules the given function into a pipeline with the given clock
 // period. Attempts to split nodes into stages such that the total number of
 // flops in the pipeline stages is minimized without violating the target clock
 // period.
 absl::StatusOr<ScheduleCycleMap> ScheduleToMinimizeRegisters(
     FunctionBase* f, int64_t pipeline_stages,
-    const DelayEstimator& delay_estimator, sched::ScheduleBounds* bounds) {
+    const DelayEstimator& delay_estimator, const SchedulingOptions& options,
+    sched::ScheduleBounds* bounds) {
   XLS_VLOG(3) << "ScheduleToMinimizeRegisters()";
   XLS_VLOG(3) << "  pipeline stages = " << pipeline_stages;
   XLS_VLOG_LINES(4, f->DumpIr());
@@ -103,39 +147,195 @@ absl::StatusOr<ScheduleCycleMap> ScheduleToMinimizeRegisters(
   XLS_VLOG(4) << "Initial bounds:";
   XLS_VLOG_LINES(4, bounds->ToString());
 
+  auto bounds_to_cycle_map = [&]() -> absl::StatusOr<ScheduleCycleMap> {
+    ScheduleCycleMap cycle_map;
+    for (Node* node : f->nodes()) {
+      XLS_RET_CHECK_EQ(bounds->lb(node), bounds->ub(node)) << node->GetName();
+      cycle_map[node] = bounds->lb(node);
+    }
+    return cycle_map;
+  };
+  // If every node is already fixed to one cycle (e.g., the whole function
+  // matched a previous schedule) no cut order can do better than another.
+  if (absl::c_all_of(f->nodes(), [&](Node* node) {
+        return bounds->lb(node) == bounds->ub(node);
+      })) {
+    return bounds_to_cycle_map();
+  }
+
   // Try a number of different orderings of cycle boundary at which the min-cut
-  // is performed and keep the best one.
+  // is performed and keep the best one. Each trial works on its own copy of the
+  // bounds so trials may run concurrently. Ties are broken in favor of the
+  // earliest order in `cut_orders` so the result does not depend on the thread
+  // count.
+  std::vector<std::vector<int64_t>> cut_orders =
+      GetMinCutCycleOrders(pipeline_stages - 1);
   int64_t best_register_count;
   absl::optional<sched::ScheduleBounds> best_bounds;
-  for (const std::vector<int64_t>& cut_order :
-       GetMinCutCycleOrders(pipeline_stages - 1)) {
-    XLS_VLOG(3) << absl::StreamFormat("Trying cycle order: {%s}",
-                                      absl::StrJoin(cut_order, ", "));
-    sched::ScheduleBounds trial_bounds = *bounds;
-    // Partition the nodes at each cycle boundary. For each iteration, this
-    // splits the nodes into those which must be scheduled at or before the
-    // cycle and those which must be scheduled after. Upon loop completion each
-    // node will have a range of exactly one cycle.
-    for (int64_t cycle : cut_order) {
-      XLS_RETURN_IF_ERROR(
-          SplitAfterCycle(f, cycle, delay_estimator, &trial_bounds));
-      XLS_RETURN_IF_ERROR(trial_bounds.PropagateLowerBounds());
-      XLS_RETURN_IF_ERROR(trial_bounds.PropagateUpperBounds());
-    }
-    XLS_ASSIGN_OR_RETURN(int64_t trial_register_count,
-                         CountInteriorPipelineRegisters(f, trial_bounds));
-    if (!best_bounds.has_value() ||
-        best_register_count > trial_register_count) {
-      best_bounds = std::move(trial_bounds);
-      best_register_count = trial_register_count;
+  std::unique_ptr<ThreadPool> pool;
+  if (options.thread_count() > 1) {
+    pool = std::make_unique<ThreadPool>(options.thread_count());
+  }
+  // Runs the cut orders in [begin, end) and folds the results into the best
+  // bounds found so far. Only one batch of bounds is held at a time.
+  auto run_trials = [&](int64_t begin, int64_t end) -> absl::Status {
+    std::vector<absl::StatusOr<std::pair<sched::ScheduleBounds, int64_t>>>
+        trials(end - begin, absl::UnknownError("Cut order not evaluated"));
+    for (int64_t i = begin; i < end; ++i) {
+      auto run_trial = [&, i] {
+        trials[i - begin] =
+            RunCutOrder(f, cut_orders[i], delay_estimator, *bounds);
+      };
+      if (pool == nullptr) {
+        run_trial();
+      } else {
+        pool->Schedule(run_trial);
+      }
+    }
+    if (pool != nullptr) {
+      pool->WaitForIdle();
+    }
+    for (absl::StatusOr<std::pair<sched::ScheduleBounds, int64_t>>& trial :
+         trials) {
+      XLS_RETURN_IF_ERROR(trial.status());
+      if (!best_bounds.has_value() || best_register_count > trial->second) {
+        best_bounds = std::move(trial->first);
+        best_register_count = trial->second;
+      }
+    }
+    return absl::OkStatus();
+  };
+  XLS_RETURN_IF_ERROR(run_trials(0, cut_orders.size()));
+
+  // If given a time budget, keep trying random cut orders (one batch per
+  // thread at a time) until the budget is exhausted or no new orders can be
+  // found.
+  if (options.cut_order_time_budget_ms().has_value() && pipeline_stages > 3) {
+    absl::Time deadline =
+        absl::Now() +
+        absl::Milliseconds(options.cut_order_time_budget_ms().value());
+    absl::flat_hash_set<std::vector<int64_t>> seen(cut_orders.begin(),
+                                                   cut_orders.end());
+    std::mt19937_64 bit_gen(/*seed=*/0);
+    std::vector<int64_t> order = cut_orders.front();
+    int64_t batch_size = std::max<int64_t>(1, options.thread_count());
+    int64_t consecutive_duplicates = 0;
+    while (absl::Now() < deadline && consecutive_duplicates < 100) {
+      int64_t begin = cut_orders.size();
+      while (cut_orders.size() - begin < batch_size &&
+             consecutive_duplicates < 100) {
+        std::shuffle(order.begin(), order.end(), bit_gen);
+        if (seen.insert(order).second) {
+          cut_orders.push_back(order);
+          consecutive_duplicates = 0;
+        } else {
+          ++consecutive_duplicates;
+        }
+      }
+      XLS_RETURN_IF_ERROR(run_trials(begin, cut_orders.size()));
     }
+    XLS_VLOG(3) << absl::StreamFormat("Tried %d cut orders within %dms",
+                                      cut_orders.size(),
+                                      *options.cut_order_time_budget_ms());
   }
+
   *bounds = std::move(*best_bounds);
+  return bounds_to_cycle_map();
+}
 
-  ScheduleCycleMap cycle_map;
+// Adds SDC timing constraints to `system` which separate `node` into a later
+// cycle than `source` for each node reachable from `source` where the chained
+// combinational delay from the start of `source` to the end of the node exceeds
+// the clock period. Only the earliest such nodes on each path are constrained;
+// nodes further downstream are separated transitively by the dependency
+// constraints.
+absl::Status AddTimingConstraints(
+    Node* source, int64_t clock_period_ps,
+    const DelayEstimator& delay_estimator,
+    const absl::flat_hash_map<Node*, int64_t>& topo_index,
+    const absl::flat_hash_map<Node*, sdc::VariableId>& cycle_vars,
+    sdc::DifferenceConstraintSystem* system) {
+  XLS_ASSIGN_OR_RETURN(int64_t source_delay,
+                       delay_estimator.GetOperationDelayInPs(source));
+  // Chained delay of the nodes within one clock period of `source`, visited in
+  // topological order so all in-window operands of a node are visited before
+  // the node itself.
+  absl::flat_hash_map<Node*, int64_t> path_delay;
+  path_delay[source] = source_delay;
+  std::set<std::pair<int64_t, Node*>> worklist;
+  worklist.insert({topo_index.at(source), source});
+  while (!worklist.empty()) {
+    Node* node = worklist.begin()->second;
+    worklist.erase(worklist.begin());
+    int64_t delay = path_delay.at(node);
+    if (delay > clock_period_ps) {
+      system->AddConstraint(cycle_vars.at(source), cycle_vars.at(node), 1);
+      continue;
+    }
+    for (Node* user : node->users()) {
+      XLS_ASSIGN_OR_RETURN(int64_t user_delay,
+                           delay_estimator.GetOperationDelayInPs(user));
+      auto [it, inserted] = path_delay.insert({user, delay + user_delay});
+      if (!inserted) {
+        it->second = std::max(it->second, delay + user_delay);
+      }
+      worklist.insert({topo_index.at(user), user});
+    }
+  }
+  return absl::OkStatus();
+}
+
+// Schedules the given function by solving a system of difference constraints
+// which minimizes the number of pipeline register bits. Each node n has a cycle
+// variable s_n and each node with users a lifetime-end variable e_n with
+// e_n >= s_u for each user u. The objective is the sum over nodes of
+// bit_count(n) * (e_n - s_n), which is the number of interior pipeline
+// register bits. `bounds` supplies the per-node cycle ranges which encode the
+// pipeline length and the I/O stage pinning.
+absl::StatusOr<ScheduleCycleMap> ScheduleWithSdc(
+    FunctionBase* f, int64_t clock_period_ps,
+    const DelayEstimator& delay_estimator,
+    const sched::ScheduleBounds& bounds) {
+  XLS_VLOG(3) << "ScheduleWithSdc()";
+  XLS_VLOG_LINES(4, f->DumpIr());
+
+  sdc::DifferenceConstraintSystem system;
+  absl::flat_hash_map<Node*, sdc::VariableId> cycle_vars;
+  absl::flat_hash_map<Node*, int64_t> topo_index;
+  int64_t index = 0;
+  for (Node* node : TopoSort(f)) {
+    topo_index[node] = index++;
+    sdc::VariableId var = system.AddVariable(node->GetName());
+    cycle_vars[node] = var;
+    system.AddLowerBound(var, bounds.lb(node));
+    system.AddUpperBound(var, bounds.ub(node));
+    for (Node* operand : node->operands()) {
+      system.AddConstraint(cycle_vars.at(operand), var, 0);
+    }
+  }
   for (Node* node : f->nodes()) {
-    XLS_RET_CHECK_EQ(bounds->lb(node), bounds->ub(node)) << node->GetName();
-    cycle_map[node] = bounds->lb(node);
+    XLS_RETURN_IF_ERROR(AddTimingConstraints(node, clock_period_ps,
+                                             delay_estimator, topo_index,
+                                             cycle_vars, &system));
+    int64_t bit_count = node->GetType()->GetFlatBitCount();
+    if (bit_count == 0 || node->users().empty()) {
+      continue;
+    }
+    sdc::VariableId lifetime_end =
+        system.AddVariable(absl::StrCat(node->GetName(), "_end"));
+    system.AddConstraint(cycle_vars.at(node), lifetime_end, 0);
+    for (Node* user : node->users()) {
+      system.AddConstraint(cycle_vars.at(user), lifetime_end, 0);
+    }
+    system.AddObjectiveCoefficient(lifetime_end, bit_count);
+    system.AddObjectiveCoefficient(cycle_vars.at(node), -bit_count);
+  }
+
+  XLS_ASSIGN_OR_RETURN(std::vector<int64_t> solution,
+                       sdc::MinimizeDifferenceConstraints(system));
+  ScheduleCycleMap cycle_map;
+  for (const auto& [node, var] : cycle_vars) {
+    cycle_map[node] = solution[static_cast<int64_t>(var)];
   }
   return cycle_map;
 }
@@ -302,6 +502,13 @@ absl::StatusOr<int64_t> FindMinimumClockPeriod(
   // path of the entire function. It's possible this upper bound is the best you
   // can do if there exists a single operation with delay equal to the
   // critical-path delay of the function.
+  // No clock period shorter than the slowest single operation is feasible.
+  int64_t max_node_delay = 0;
+  for (Node* node : f->nodes()) {
+    XLS_ASSIGN_OR_RETURN(int64_t node_delay,
+                         delay_estimator.GetOperationDelayInPs(node));
+    max_node_delay = std::max(max_node_delay, node_delay);
+  }
   int64_t search_start = (function_cp + pipeline_stages - 1) / pipeline_stages;
   int64_t search_end = function_cp;
   XLS_VLOG(4) << absl::StreamFormat("Binary searching over interval [%d, %d]",
@@ -312,13 +519,8 @@ absl::StatusOr<int64_t> FindMinimumClockPeriod(
                            [&](int64_t clk_period_ps) -> absl::StatusOr<bool> {
                              // If any node does not fit in the clock period,
                              // fail outright.
-                             for (Node* node : f->nodes()) {
-                               XLS_ASSIGN_OR_RETURN(
-                                   int64_t node_delay,
-                                   delay_estimator.GetOperationDelayInPs(node));
-                               if (node_delay > clk_period_ps) {
-                                 return false;
-                               }
+                             if (max_node_delay > clk_period_ps) {
+                               return false;
                              }
                              XLS_ASSIGN_OR_RETURN(
                                  sched::ScheduleBounds bounds,
@@ -355,6 +557,102 @@ std::vector<int64_t> MiddleFirstOrder(int64_t first, int64_t last) {
   return ret;
 }
 
+// Tightens the bounds of the given node to exactly the given cycle and
+// propagates the change. Returns a ResourceExhausted error if the resulting
+// bounds are infeasible.
+absl::Status PinNode(Node* node, int64_t cycle, sched::ScheduleBounds* bounds) {
+  XLS_RETURN_IF_ERROR(bounds->TightenNodeLb(node, cycle));
+  XLS_RETURN_IF_ERROR(bounds->TightenNodeUb(node, cycle));
+  XLS_RETURN_IF_ERROR(bounds->PropagateLowerBounds());
+  return bounds->PropagateUpperBounds();
+}
+
+// Pins each node of the function which matches a node of the previous
+// schedule by structural hash to the cycle of that node by tightening
+// `bounds`, and returns the pinned nodes. Nodes whose previous cycle is outside
+// of their bounds are not pinned. If the pinned cycles are jointly infeasible
+// (e.g., a new node on a path between two pinned nodes violates timing) the
+// nodes are pinned one at a time in topological order and each pin which
+// conflicts with the pins before it is dropped.
+absl::StatusOr<absl::flat_hash_set<Node*>> PinPreviouslyScheduledNodes(
+    FunctionBase* f, const PipelineScheduleProto& previous,
+    sched::ScheduleBounds* bounds) {
+  // Cycles of the previous schedule by node hash. Structurally identical nodes
+  // (e.g., duplicate side-effecting operations) are matched in order.
+  absl::flat_hash_map<uint64_t, std::deque<int64_t>> previous_cycles;
+  for (const StageProto& stage : previous.stages()) {
+    if (stage.node_hashes_size() != stage.nodes_size()) {
+      return absl::InvalidArgumentError(
+          "Previous schedule does not include structural node hashes.");
+    }
+    for (uint64_t hash : stage.node_hashes()) {
+      previous_cycles[hash].push_back(stage.stage());
+    }
+  }
+
+  absl::flat_hash_map<Node*, uint64_t> hashes =
+      sched::ComputeStructuralHashes(f);
+  // The candidate pins in topological order.
+  std::vector<std::pair<Node*, int64_t>> candidates;
+  ScheduleCycleMap pinned;
+  for (Node* node : TopoSort(f)) {
+    auto it = previous_cycles.find(hashes.at(node));
+    if (it == previous_cycles.end() || it->second.empty()) {
+      continue;
+    }
+    int64_t cycle = it->second.front();
+    it->second.pop_front();
+    if (cycle < bounds->lb(node) || cycle > bounds->ub(node) ||
+        absl::c_any_of(node->operands(), [&](Node* operand) {
+          return pinned.contains(operand) && pinned.at(operand) > cycle;
+        })) {
+      continue;
+    }
+    pinned[node] = cycle;
+    candidates.push_back({node, cycle});
+  }
+
+  // Try all of the pins at once first as they are usually consistent.
+  absl::flat_hash_set<Node*> pinned_nodes;
+  sched::ScheduleBounds pinned_bounds = *bounds;
+  absl::Status status = [&]() -> absl::Status {
+    for (const auto& [node, cycle] : candidates) {
+      XLS_RETURN_IF_ERROR(pinned_bounds.TightenNodeLb(node, cycle));
+      XLS_RETURN_IF_ERROR(pinned_bounds.TightenNodeUb(node, cycle));
+    }
+    XLS_RETURN_IF_ERROR(pinned_bounds.PropagateLowerBounds());
+    return pinned_bounds.PropagateUpperBounds();
+  }();
+  if (status.ok()) {
+    for (const auto& [node, cycle] : candidates) {
+      pinned_nodes.insert(node);
+    }
+  } else {
+    if (!absl::IsResourceExhausted(status)) {
+      return status;
+    }
+    pinned_bounds = *bounds;
+    for (const auto& [node, cycle] : candidates) {
+      sched::ScheduleBounds trial_bounds = pinned_bounds;
+      absl::Status pin_status = PinNode(node, cycle, &trial_bounds);
+      if (absl::IsResourceExhausted(pin_status)) {
+        XLS_VLOG(2) << absl::StreamFormat(
+            "Not reusing cycle %d of node %s from the previous schedule: %s",
+            cycle, node->GetName(), pin_status.message());
+        continue;
+      }
+      XLS_RETURN_IF_ERROR(pin_status);
+      pinned_bounds = std::move(trial_bounds);
+      pinned_nodes.insert(node);
+    }
+  }
+  XLS_VLOG(2) << absl::StreamFormat(
+      "Reusing the cycles of %d of %d nodes from the previous schedule",
+      pinned_nodes.size(), f->node_count());
+  *bounds = std::move(pinned_bounds);
+  return pinned_nodes;
+}
+
 }  // namespace
 
 std::vector<std::vector<int64_t>> GetMinCutCycleOrders(int64_t length) {
@@ -453,6 +751,14 @@ std::vector<Node*> PipelineSchedule::GetLiveOutOfCycle(int64_t c) const {
 /*static*/ absl::StatusOr<PipelineSchedule> PipelineSchedule::Run(
     FunctionBase* f, const DelayEstimator& delay_estimator,
     const SchedulingOptions& options) {
+  if (options.initiation_interval() < 1) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Initiation interval must be positive, got %d",
+                        options.initiation_interval()));
+  }
+  // Delays are queried many times for each node (e.g., on every probe of the
+  // clock period search and on every bounds propagation) so memoize them.
+  CachingDelayEstimator caching_delay_estimator(delay_estimator);
   int64_t clock_period_ps;
   if (options.clock_period_ps().has_value()) {
     clock_period_ps = *options.clock_period_ps();
@@ -474,22 +780,35 @@ std::vector<Node*> PipelineSchedule::GetLiveOutOfCycle(int64_t c) const {
     // A pipeline length is specified, but no target clock period. Determine
     // the minimum clock period for which the function can be scheduled in the
     // given pipeline length.
-    XLS_ASSIGN_OR_RETURN(
-        clock_period_ps,
-        FindMinimumClockPeriod(f, *options.pipeline_stages(), delay_estimator));
+    XLS_ASSIGN_OR_RETURN(clock_period_ps,
+                         FindMinimumClockPeriod(f, *options.pipeline_stages(),
+                                                caching_delay_estimator));
   }
 
   XLS_ASSIGN_OR_RETURN(
       sched::ScheduleBounds bounds,
       ConstructBounds(f, clock_period_ps, TopoSort(f).AsVector(),
-                      options.pipeline_stages(), delay_estimator));
+                      options.pipeline_stages(), caching_delay_estimator));
   int64_t schedule_length = bounds.max_lower_bound() + 1;
+  // Nodes pinned to their cycle in the previous schedule. These are also kept
+  // fixed by retiming and by balancing of shared operations.
+  absl::flat_hash_set<Node*> pinned_nodes;
+  if (options.previous_schedule().has_value()) {
+    XLS_ASSIGN_OR_RETURN(pinned_nodes,
+                         PinPreviouslyScheduledNodes(
+                             f, *options.previous_schedule(), &bounds));
+  }
 
   ScheduleCycleMap cycle_map;
   if (options.strategy() == SchedulingStrategy::MINIMIZE_REGISTERS) {
-    XLS_ASSIGN_OR_RETURN(cycle_map,
-                         ScheduleToMinimizeRegisters(f, schedule_length,
-                                                     delay_estimator, &bounds));
+    XLS_ASSIGN_OR_RETURN(
+        cycle_map,
+        ScheduleToMinimizeRegisters(f, schedule_length, caching_delay_estimator,
+                                    options, &bounds));
+  } else if (options.strategy() == SchedulingStrategy::SDC) {
+    XLS_ASSIGN_OR_RETURN(
+        cycle_map, ScheduleWithSdc(f, clock_period_ps, caching_delay_estimator,
+                                   bounds));
   } else {
     XLS_RET_CHECK(options.strategy() == SchedulingStrategy::ASAP);
     XLS_RET_CHECK(!options.pipeline_stages().has_value());
@@ -499,7 +818,22 @@ std::vector<Node*> PipelineSchedule::GetLiveOutOfCycle(int64_t c) const {
     }
   }
   auto schedule = PipelineSchedule(f, cycle_map, options.pipeline_stages());
-  XLS_RETURN_IF_ERROR(schedule.VerifyTiming(clock_period_ps, delay_estimator));
+  if (options.retiming_register_budget_percent().has_value()) {
+    int64_t register_bit_budget =
+        schedule.CountInteriorRegisterBits() *
+        (100 + *options.retiming_register_budget_percent()) / 100;
+    XLS_ASSIGN_OR_RETURN(schedule,
+                         RetimeSchedule(schedule, caching_delay_estimator,
+                                        register_bit_budget, pinned_nodes));
+  }
+  if (options.initiation_interval() > 1) {
+    XLS_ASSIGN_OR_RETURN(
+        schedule, BalanceSharedOperations(
+                      schedule, caching_delay_estimator, clock_period_ps,
+                      options.initiation_interval(), pinned_nodes));
+  }
+  XLS_RETURN_IF_ERROR(
+      schedule.VerifyTiming(clock_period_ps, caching_delay_estimator));
   XLS_VLOG_LINES(3, "Schedule\n" + schedule.ToString());
   return schedule;
 }
@@ -596,17 +930,295 @@ absl::Status PipelineSchedule::VerifyTiming(
   return absl::OkStatus();
 }
 
+absl::StatusOr<int64_t> PipelineSchedule::ComputeMaxStageDelay(
+    const DelayEstimator& delay_estimator) const {
+  // The critical-path delay from the start of the stage to the end of each
+  // node, counting only operands in the same stage.
+  absl::flat_hash_map<Node*, int64_t> node_cp;
+  int64_t max_stage_delay = 0;
+  for (Node* node : TopoSort(function_base_)) {
+    int64_t cp_to_node_start = 0;
+    for (Node* operand : node->operands()) {
+      if (cycle(operand) == cycle(node)) {
+        cp_to_node_start = std::max(cp_to_node_start, node_cp.at(operand));
+      }
+    }
+    XLS_ASSIGN_OR_RETURN(int64_t node_delay,
+                         delay_estimator.GetOperationDelayInPs(node));
+    node_cp[node] = cp_to_node_start + node_delay;
+    max_stage_delay = std::max(max_stage_delay, node_cp[node]);
+  }
+  return max_stage_delay;
+}
+
+int64_t PipelineSchedule::CountInteriorRegisterBits() const {
+  int64_t register_bits = 0;
+  for (const auto& [node, node_cycle] : cycle_map_) {
+    int64_t latest_use = node_cycle;
+    for (Node* user : node->users()) {
+      latest_use = std::max(latest_use, cycle(user));
+    }
+    register_bits +=
+        node->GetType()->GetFlatBitCount() * (latest_use - node_cycle);
+  }
+  return register_bits;
+}
+
 PipelineScheduleProto PipelineSchedule::ToProto() const {
   PipelineScheduleProto proto;
   proto.set_function(function_base_->name());
+  absl::flat_hash_map<Node*, uint64_t> hashes =
+      sched::ComputeStructuralHashes(function_base_);
   for (int i = 0; i < cycle_to_nodes_.size(); i++) {
     StageProto* stage = proto.add_stages();
     stage->set_stage(i);
-    for (const Node* node : cycle_to_nodes_[i]) {
+    for (Node* node : cycle_to_nodes_[i]) {
       stage->add_nodes(node->GetName());
+      stage->add_node_hashes(hashes.at(node));
     }
   }
   return proto;
 }
 
+absl::StatusOr<PipelineSchedule> RetimeSchedule(
+    const PipelineSchedule& schedule, const DelayEstimator& delay_estimator,
+    int64_t register_bit_budget,
+    const absl::flat_hash_set<Node*>& fixed_nodes) {
+  FunctionBase* f = schedule.function_base();
+  CachingDelayEstimator caching_delay_estimator(delay_estimator);
+  XLS_ASSIGN_OR_RETURN(int64_t stage_delay,
+                       schedule.ComputeMaxStageDelay(caching_delay_estimator));
+  int64_t max_node_delay = 0;
+  for (Node* node : f->nodes()) {
+    XLS_ASSIGN_OR_RETURN(int64_t node_delay,
+                         caching_delay_estimator.GetOperationDelayInPs(node));
+    max_node_delay = std::max(max_node_delay, node_delay);
+  }
+  XLS_VLOG(3) << absl::StreamFormat(
+      "RetimeSchedule(): max stage delay %dps, max node delay %dps, register "
+      "bit budget %d",
+      stage_delay, max_node_delay, register_bit_budget);
+
+  // Returns the schedule with the minimum number of pipeline register bits in
+  // which no stage exceeds the given delay, or nullopt if no such schedule
+  // exists within the register budget. Moving a pipeline boundary across a
+  // node is a change of the node's cycle, so the space of retimings is exactly
+  // the space of schedules of the same length with the same I/O stages.
+  std::vector<Node*> topo_sort = TopoSort(f).AsVector();
+  auto schedule_for_stage_delay = [&](int64_t max_delay)
+      -> absl::StatusOr<absl::optional<ScheduleCycleMap>> {
+    absl::StatusOr<sched::ScheduleBounds> bounds =
+        ConstructBounds(f, max_delay, topo_sort, schedule.length(),
+                        caching_delay_estimator);
+    if (absl::IsResourceExhausted(bounds.status())) {
+      return absl::nullopt;
+    }
+    XLS_RETURN_IF_ERROR(bounds.status());
+    for (Node* node : fixed_nodes) {
+      absl::Status status =
+          PinNode(node, schedule.cycle(node), &bounds.value());
+      if (absl::IsResourceExhausted(status)) {
+        return absl::nullopt;
+      }
+      XLS_RETURN_IF_ERROR(status);
+    }
+    XLS_ASSIGN_OR_RETURN(ScheduleCycleMap cycle_map,
+                         ScheduleWithSdc(f, max_delay, caching_delay_estimator,
+                                         bounds.value()));
+    if (PipelineSchedule(f, cycle_map, schedule.length())
+            .CountInteriorRegisterBits() > register_bit_budget) {
+      return absl::nullopt;
+    }
+    return cycle_map;
+  };
+
+  // The achievable stage delay decreases monotonically with the register
+  // budget so binary search for the smallest achievable delay. The search
+  // only proceeds if the current stage delay is itself achievable within the
+  // budget.
+  if (max_node_delay >= stage_delay) {
+    return schedule;
+  }
+  XLS_ASSIGN_OR_RETURN(absl::optional<ScheduleCycleMap> cycle_map,
+                       schedule_for_stage_delay(stage_delay));
+  if (!cycle_map.has_value()) {
+    return schedule;
+  }
+  XLS_ASSIGN_OR_RETURN(
+      int64_t min_stage_delay,
+      BinarySearchMinTrueWithStatus(
+          max_node_delay, stage_delay,
+          [&](int64_t max_delay) -> absl::StatusOr<bool> {
+            XLS_ASSIGN_OR_RETURN(absl::optional<ScheduleCycleMap> result,
+                                 schedule_for_stage_delay(max_delay));
+            return result.has_value();
+          }));
+  XLS_ASSIGN_OR_RETURN(cycle_map, schedule_for_stage_delay(min_stage_delay));
+  XLS_RET_CHECK(cycle_map.has_value());
+  XLS_VLOG(3) << absl::StreamFormat("Retimed max stage delay: %dps -> %dps",
+                                    stage_delay, min_stage_delay);
+  PipelineSchedule retimed(f, *std::move(cycle_map), schedule.length());
+  XLS_RETURN_IF_ERROR(
+      retimed.VerifyTiming(min_stage_delay, caching_delay_estimator));
+  return retimed;
+}
+
+bool IsShareableOperation(Node* node) {
+  switch (node->op()) {
+    case Op::kUMul:
+    case Op::kSMul:
+    case Op::kUDiv:
+    case Op::kSDiv:
+    case Op::kUMod:
+    case Op::kSMod:
+      return true;
+    default:
+      return false;
+  }
+}
+
+namespace {
+
+// Returns a key identifying the kind of functional unit which can implement
+// the given shareable operation.
+std::string SharedUnitKey(Node* node) {
+  std::vector<std::string> operand_types;
+  for (Node* operand : node->operands()) {
+    operand_types.push_back(operand->GetType()->ToString());
+  }
+  return absl::StrFormat("%s(%s) -> %s", OpToString(node->op()),
+                         absl::StrJoin(operand_types, ", "),
+                         node->GetType()->ToString());
+}
+
+// Returns the shareable operations of the function grouped by the kind of
+// functional unit which implements them. Groups are ordered by first
+// appearance in a topological sort and each group is topologically sorted.
+std::vector<std::vector<Node*>> GroupShareableOperations(FunctionBase* f) {
+  std::vector<std::vector<Node*>> groups;
+  absl::flat_hash_map<std::string, int64_t> group_index;
+  for (Node* node : TopoSort(f)) {
+    if (!IsShareableOperation(node)) {
+      continue;
+    }
+    auto [it, inserted] =
+        group_index.insert({SharedUnitKey(node), groups.size()});
+    if (inserted) {
+      groups.emplace_back();
+    }
+    groups[it->second].push_back(node);
+  }
+  return groups;
+}
+
+}  // namespace
+
+std::vector<std::vector<Node*>> BindSharedOperations(
+    const PipelineSchedule& schedule, int64_t initiation_interval) {
+  XLS_CHECK_GE(initiation_interval, 1);
+  std::vector<std::vector<Node*>> units;
+  for (const std::vector<Node*>& group :
+       GroupShareableOperations(schedule.function_base())) {
+    // The j-th operation in each phase (cycle modulo the initiation interval)
+    // is bound to the j-th unit.
+    std::vector<std::vector<Node*>> group_units;
+    std::vector<int64_t> phase_count(initiation_interval, 0);
+    for (Node* node : group) {
+      int64_t unit = phase_count[schedule.cycle(node) % initiation_interval]++;
+      if (unit == group_units.size()) {
+        group_units.emplace_back();
+      }
+      group_units[unit].push_back(node);
+    }
+    for (std::vector<Node*>& unit : group_units) {
+      if (unit.size() > 1) {
+        units.push_back(std::move(unit));
+      }
+    }
+  }
+  return units;
+}
+
+absl::StatusOr<PipelineSchedule> BalanceSharedOperations(
+    const PipelineSchedule& schedule, const DelayEstimator& delay_estimator,
+    int64_t clock_period_ps, int64_t initiation_interval,
+    const absl::flat_hash_set<Node*>& fixed_nodes) {
+  XLS_RET_CHECK_GE(initiation_interval, 1);
+  FunctionBase* f = schedule.function_base();
+  if (initiation_interval == 1) {
+    return schedule;
+  }
+  CachingDelayEstimator caching_delay_estimator(delay_estimator);
+  ScheduleCycleMap cycle_map;
+  for (Node* node : f->nodes()) {
+    cycle_map[node] = schedule.cycle(node);
+  }
+
+  for (const std::vector<Node*>& group : GroupShareableOperations(f)) {
+    if (group.size() < 2) {
+      continue;
+    }
+    // The number of units needed for the group is the largest number of its
+    // operations in any one phase.
+    std::vector<int64_t> phase_count(initiation_interval, 0);
+    for (Node* node : group) {
+      ++phase_count[cycle_map.at(node) % initiation_interval];
+    }
+    for (Node* node : group) {
+      if (node->users().empty() || f->HasImplicitUse(node) ||
+          fixed_nodes.contains(node)) {
+        continue;
+      }
+      // The node may be placed in any cycle from that of its latest operand
+      // to that of its earliest user.
+      int64_t earliest = 0;
+      for (Node* operand : node->operands()) {
+        earliest = std::max(earliest, cycle_map.at(operand));
+      }
+      int64_t latest = schedule.length() - 1;
+      for (Node* user : node->users()) {
+        latest = std::min(latest, cycle_map.at(user));
+      }
+      const int64_t original_cycle = cycle_map.at(node);
+      const int64_t original_phase = original_cycle % initiation_interval;
+
+      // Candidate cycles strictly reduce the load on the node's current
+      // phase. Prefer the least loaded phase, then the nearest cycle.
+      std::vector<int64_t> candidates;
+      for (int64_t cycle = earliest; cycle <= latest; ++cycle) {
+        if (phase_count[cycle % initiation_interval] + 1 <
+            phase_count[original_phase]) {
+          candidates.push_back(cycle);
+        }
+      }
+      std::sort(candidates.begin(), candidates.end(),
+                [&](int64_t a, int64_t b) {
+                  return std::make_pair(
+                             phase_count[a % initiation_interval],
+                             std::abs(a - original_cycle)) <
+                         std::make_pair(
+                             phase_count[b % initiation_interval],
+                             std::abs(b - original_cycle));
+                });
+      for (int64_t cycle : candidates) {
+        cycle_map[node] = cycle;
+        PipelineSchedule trial(f, cycle_map, schedule.length());
+        XLS_ASSIGN_OR_RETURN(
+            int64_t stage_delay,
+            trial.ComputeMaxStageDelay(caching_delay_estimator));
+        if (stage_delay <= clock_period_ps) {
+          XLS_VLOG(3) << absl::StreamFormat(
+              "Moved shareable operation %s from cycle %d to %d",
+              node->GetName(), original_cycle, cycle);
+          --phase_count[original_phase];
+          ++phase_count[cycle % initiation_interval];
+          break;
+        }
+        cycle_map[node] = original_cycle;
+      }
+    }
+  }
+  return PipelineSchedule(f, cycle_map, schedule.length());
+}
+
 }  // namespace xls
@@ -16,6 +16,7 @@
 #define XLS_SCHEDULING_PIPELINE_SCHEDULE_H_
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "xls/delay_model/delay_estimator.h"
@@ -33,7 +34,13 @@ enum class SchedulingStrategy {
   ASAP,
 
   // Minimize the number of pipeline registers when scheduling.
-  MINIMIZE_REGISTERS
+  MINIMIZE_REGISTERS,
+
+  // Minimize the number of pipeline register bits optimally by formulating
+  // scheduling as a system of difference constraints (SDC) with dependency,
+  // timing and I/O stage constraints and a linear register-bit objective. The
+  // system is solved exactly with an in-tree min-cost flow solver.
+  SDC
 };
 
 // Returns the list of ordering of cycles (pipeline stages) in which to compute
@@ -96,11 +103,75 @@ class SchedulingOptions {
     return clock_margin_percent_;
   }
 
+  // Sets/gets the number of threads used to evaluate min-cut cycle orders
+  // concurrently when minimizing registers. The resulting schedule does not
+  // depend on the thread count.
+  SchedulingOptions& thread_count(int64_t value) {
+    thread_count_ = value;
+    return *this;
+  }
+  int64_t thread_count() const { return thread_count_; }
+
+  // Sets/gets the wall-clock budget in milliseconds for trying additional
+  // (randomly generated) min-cut cycle orders beyond those returned by
+  // GetMinCutCycleOrders when minimizing registers. If not set, only those
+  // orders are tried. Because the number of orders tried depends on timing,
+  // the schedule may vary between runs when a budget is given.
+  SchedulingOptions& cut_order_time_budget_ms(int64_t value) {
+    cut_order_time_budget_ms_ = value;
+    return *this;
+  }
+  absl::optional<int64_t> cut_order_time_budget_ms() const {
+    return cut_order_time_budget_ms_;
+  }
+
+  // Sets/gets whether the schedule is retimed after scheduling to minimize the
+  // maximum stage delay (see RetimeSchedule), and the permitted increase in
+  // pipeline register bits relative to the initial schedule as a percentage.
+  SchedulingOptions& retiming_register_budget_percent(int64_t value) {
+    retiming_register_budget_percent_ = value;
+    return *this;
+  }
+  absl::optional<int64_t> retiming_register_budget_percent() const {
+    return retiming_register_budget_percent_;
+  }
+
+  // Sets/gets the initiation interval of the pipeline: the number of cycles
+  // between successive inputs. With an initiation interval N greater than one,
+  // shareable operations (see IsShareableOperation) are moved within their
+  // slack so that they can be folded onto fewer functional units (see
+  // BindSharedOperations).
+  SchedulingOptions& initiation_interval(int64_t value) {
+    initiation_interval_ = value;
+    return *this;
+  }
+  int64_t initiation_interval() const { return initiation_interval_; }
+
+  // Sets/gets the schedule of a previous version of the function to reuse.
+  // Nodes which are structurally identical to a node in the previous schedule
+  // (see ComputeStructuralHashes) are pinned to the same cycle as before where
+  // feasible. Pins which conflict with earlier pins (in topological order) are
+  // dropped. Bounds are still computed for the whole function, but the min-cut
+  // scheduler only partitions the unpinned nodes. Pinned nodes also keep their
+  // cycle through retiming and balancing of shared operations.
+  SchedulingOptions& previous_schedule(PipelineScheduleProto value) {
+    previous_schedule_ = std::move(value);
+    return *this;
+  }
+  const absl::optional<PipelineScheduleProto>& previous_schedule() const {
+    return previous_schedule_;
+  }
+
  private:
   SchedulingStrategy strategy_;
   absl::optional<int64_t> clock_period_ps_;
   absl::optional<int64_t> pipeline_stages_;
   absl::optional<int64_t> clock_margin_percent_;
+  int64_t thread_count_ = 1;
+  absl::optional<int64_t> cut_order_time_budget_ms_;
+  absl::optional<int64_t> retiming_register_budget_percent_;
+  int64_t initiation_interval_ = 1;
+  absl::optional<PipelineScheduleProto> previous_schedule_;
 };
 
 // A map from node to cycle as a bare-bones representation of a schedule.
@@ -161,6 +232,15 @@ class PipelineSchedule {
   absl::Status VerifyTiming(int64_t clock_period_ps,
                             const DelayEstimator& delay_estimator) const;
 
+  // Returns the largest combinational delay through nodes scheduled in the
+  // same cycle. This is the minimum clock period the schedule can meet.
+  absl::StatusOr<int64_t> ComputeMaxStageDelay(
+      const DelayEstimator& delay_estimator) const;
+
+  // Returns the number of pipeline register bits on the interior of the
+  // pipeline, not counting any input or output flops.
+  int64_t CountInteriorRegisterBits() const;
+
   // Returns a protobuf holding this object's scheduling info.
   PipelineScheduleProto ToProto() const;
 
@@ -174,6 +254,46 @@ class PipelineSchedule {
   std::vector<std::vector<Node*>> cycle_to_nodes_;
 };
 
+// Retimes the given schedule by moving pipeline boundaries across nodes to
+// minimize the maximum stage delay. The length of the pipeline and the stages
+// of I/O nodes (parameters, receives, return value, sends) are unchanged, and
+// the number of interior pipeline register bits is at most
+// `register_bit_budget`. The result is the schedule of minimum register count
+// among those achieving the minimum feasible stage delay. If the stage delay
+// cannot be improved within the budget the returned schedule has the same
+// maximum stage delay as the given one. The nodes in `fixed_nodes` keep their
+// cycle.
+absl::StatusOr<PipelineSchedule> RetimeSchedule(
+    const PipelineSchedule& schedule, const DelayEstimator& delay_estimator,
+    int64_t register_bit_budget,
+    const absl::flat_hash_set<Node*>& fixed_nodes = {});
+
+// Returns true if the given node is an operation which is expensive enough to
+// be worth sharing a single functional unit between several instances of the
+// operation in a pipeline with an initiation interval greater than one
+// (multiplies, divides and modulos).
+bool IsShareableOperation(Node* node);
+
+// Binds the shareable operations of the schedule to functional units for a
+// pipeline with the given initiation interval. With an initiation interval N,
+// the stages s and s + N are active in the same cycle so operations can share
+// a unit only if their stages are distinct modulo N. Operations bound to the
+// same unit have the same opcode, result type and operand types. Each element
+// of the returned vector holds the operations (in topological order) bound to
+// a single unit; units holding a single operation are not returned.
+std::vector<std::vector<Node*>> BindSharedOperations(
+    const PipelineSchedule& schedule, int64_t initiation_interval);
+
+// Moves shareable operations within their slack to balance them across the
+// stages modulo the initiation interval, reducing the number of functional
+// units required by BindSharedOperations. Moves which would make any stage
+// exceed the given clock period are not made. The nodes in `fixed_nodes` are
+// not moved.
+absl::StatusOr<PipelineSchedule> BalanceSharedOperations(
+    const PipelineSchedule& schedule, const DelayEstimator& delay_estimator,
+    int64_t clock_period_ps, int64_t initiation_interval,
+    const absl::flat_hash_set<Node*>& fixed_nodes = {});
+
 }  // namespace xls
 
 #endif  // XLS_SCHEDULING_PIPELINE_SCHEDULE_H_
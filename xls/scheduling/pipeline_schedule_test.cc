@@ -18,6 +18,7 @@
 #include "gtest/gtest.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
 #include "xls/common/status/matchers.h"
 #include "xls/delay_model/delay_estimator.h"
 #include "xls/ir/bits.h"
@@ -36,6 +37,7 @@ namespace {
 using ::testing::ElementsAre;
 using ::testing::HasSubstr;
 using ::testing::UnorderedElementsAre;
+using xls::status_testing::IsOkAndHolds;
 using xls::status_testing::StatusIs;
 
 class TestDelayEstimator : public DelayEstimator {
@@ -242,6 +244,270 @@ TEST_F(PipelineScheduleTest, MinimizeRegisterBitslices) {
       UnorderedElementsAre(m::BitSlice(m::Param("x")), m::Neg(), m::Concat()));
 }
 
+// Returns the number of interior pipeline register bits in the schedule.
+int64_t PipelineRegisterBits(const PipelineSchedule& schedule) {
+  int64_t bits = 0;
+  for (Node* node : schedule.function_base()->nodes()) {
+    int64_t latest_use = schedule.cycle(node);
+    for (Node* user : node->users()) {
+      latest_use = std::max(latest_use, schedule.cycle(user));
+    }
+    bits += node->GetType()->GetFlatBitCount() *
+            (latest_use - schedule.cycle(node));
+  }
+  return bits;
+}
+
+TEST_F(PipelineScheduleTest, SdcMinimizeRegisterBitslices) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  auto x = fb.Param("x", p->GetBitsType(32));
+  auto y = fb.Param("y", p->GetBitsType(32));
+  auto x_slice = fb.BitSlice(x, /*start=*/8, /*width=*/8);
+  auto y_slice = fb.BitSlice(y, /*start=*/8, /*width=*/8);
+  auto neg_neg_y = fb.Negate(fb.Negate(y));
+  fb.Concat({x, x_slice, y_slice, neg_neg_y});
+
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      PipelineSchedule schedule,
+      PipelineSchedule::Run(
+          f, TestDelayEstimator(),
+          SchedulingOptions(SchedulingStrategy::SDC).clock_period_ps(1)));
+
+  EXPECT_EQ(schedule.length(), 2);
+  EXPECT_THAT(schedule.nodes_in_cycle(0),
+              UnorderedElementsAre(m::Param("x"), m::Param("y"),
+                                   m::BitSlice(m::Param("y")), m::Neg()));
+  EXPECT_THAT(
+      schedule.nodes_in_cycle(1),
+      UnorderedElementsAre(m::BitSlice(m::Param("x")), m::Neg(), m::Concat()));
+  EXPECT_EQ(PipelineRegisterBits(schedule), 32 + 8 + 32);
+}
+
+TEST_F(PipelineScheduleTest, SdcNoWorseThanMinCut) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  Type* u32 = p->GetBitsType(32);
+  auto x = fb.Param("x", u32);
+  auto y = fb.Param("y", u32);
+  auto z = fb.Param("z", u32);
+  auto w = fb.Param("w", p->GetBitsType(64));
+  auto w_slice = fb.BitSlice(w, /*start=*/0, /*width=*/4);
+  fb.Negate(fb.Concat({(fb.Not(fb.Negate(x | y)) - z) * x, z + z,
+                       fb.Not(fb.Not(fb.Not(w_slice))), w}));
+
+  XLS_ASSERT_OK_AND_ASSIGN(Function * func, fb.Build());
+
+  for (int64_t stages : {3, 4, 5}) {
+    XLS_ASSERT_OK_AND_ASSIGN(
+        PipelineSchedule min_cut,
+        PipelineSchedule::Run(
+            func, TestDelayEstimator(),
+            SchedulingOptions(SchedulingStrategy::MINIMIZE_REGISTERS)
+                .clock_period_ps(3)
+                .pipeline_stages(stages)));
+    XLS_ASSERT_OK_AND_ASSIGN(
+        PipelineSchedule sdc,
+        PipelineSchedule::Run(func, TestDelayEstimator(),
+                              SchedulingOptions(SchedulingStrategy::SDC)
+                                  .clock_period_ps(3)
+                                  .pipeline_stages(stages)));
+    EXPECT_EQ(sdc.length(), stages);
+    XLS_EXPECT_OK(sdc.VerifyTiming(3, TestDelayEstimator()));
+    EXPECT_LE(PipelineRegisterBits(sdc), PipelineRegisterBits(min_cut));
+  }
+}
+
+// Builds a function with a mix of wide and narrow values in a long chain of
+// operations so the cut order affects the pipeline register count.
+absl::StatusOr<Function*> BuildWideNarrowChain(Package* p,
+                                               absl::string_view name) {
+  FunctionBuilder fb(name, p);
+  BValue x = fb.Param("x", p->GetBitsType(32));
+  BValue y = fb.Param("y", p->GetBitsType(32));
+  BValue wide = x;
+  BValue narrow = fb.BitSlice(y, /*start=*/0, /*width=*/4);
+  for (int64_t i = 0; i < 8; ++i) {
+    wide = fb.Add(wide, fb.ZeroExtend(narrow, 32));
+    narrow = fb.Not(fb.BitSlice(wide, /*start=*/i, /*width=*/4));
+    if (i % 3 == 0) {
+      wide = fb.Negate(fb.Concat({fb.BitSlice(wide, 0, 16),
+                                  fb.BitSlice(y, 16, 16)}));
+    }
+  }
+  return fb.BuildWithReturnValue(fb.Concat({wide, narrow}));
+}
+
+TEST_F(PipelineScheduleTest, MinimizeRegistersThreadCountIndependent) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f,
+                           BuildWideNarrowChain(p.get(), TestName()));
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      PipelineSchedule serial,
+      PipelineSchedule::Run(
+          f, TestDelayEstimator(),
+          SchedulingOptions().clock_period_ps(2).pipeline_stages(12)));
+  XLS_ASSERT_OK_AND_ASSIGN(PipelineSchedule parallel,
+                           PipelineSchedule::Run(f, TestDelayEstimator(),
+                                                 SchedulingOptions()
+                                                     .clock_period_ps(2)
+                                                     .pipeline_stages(12)
+                                                     .thread_count(4)));
+  for (Node* node : f->nodes()) {
+    EXPECT_EQ(serial.cycle(node), parallel.cycle(node)) << node->GetName();
+  }
+}
+
+TEST_F(PipelineScheduleTest, MinimizeRegistersWithCutOrderTimeBudget) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f,
+                           BuildWideNarrowChain(p.get(), TestName()));
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      PipelineSchedule schedule,
+      PipelineSchedule::Run(
+          f, TestDelayEstimator(),
+          SchedulingOptions().clock_period_ps(2).pipeline_stages(12)));
+  for (int64_t thread_count : {1, 4}) {
+    XLS_ASSERT_OK_AND_ASSIGN(
+        PipelineSchedule budgeted,
+        PipelineSchedule::Run(f, TestDelayEstimator(),
+                              SchedulingOptions()
+                                  .clock_period_ps(2)
+                                  .pipeline_stages(12)
+                                  .thread_count(thread_count)
+                                  .cut_order_time_budget_ms(50)));
+    EXPECT_EQ(budgeted.length(), 12);
+    XLS_EXPECT_OK(budgeted.VerifyTiming(2, TestDelayEstimator()));
+    // The default cut orders are always tried first so additional orders can
+    // only improve the result.
+    EXPECT_LE(PipelineRegisterBits(budgeted), PipelineRegisterBits(schedule));
+  }
+}
+
+TEST_F(PipelineScheduleTest, RetimeBalancesStages) {
+  // A chain of six negates scheduled into two stages with a generous clock
+  // period. Every cut of the chain costs the same number of registers so the
+  // initial schedule need not be balanced.
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(32));
+  BValue chain = x;
+  for (int64_t i = 0; i < 6; ++i) {
+    chain = fb.Negate(chain);
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  ScheduleCycleMap cycle_map;
+  for (Node* node : f->nodes()) {
+    cycle_map[node] = node == f->return_value() ? 1 : 0;
+  }
+  PipelineSchedule schedule(f, cycle_map);
+  EXPECT_THAT(schedule.ComputeMaxStageDelay(TestDelayEstimator()),
+              IsOkAndHolds(5));
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      PipelineSchedule retimed,
+      RetimeSchedule(schedule, TestDelayEstimator(),
+                     schedule.CountInteriorRegisterBits()));
+  EXPECT_EQ(retimed.length(), 2);
+  EXPECT_THAT(retimed.ComputeMaxStageDelay(TestDelayEstimator()),
+              IsOkAndHolds(3));
+  EXPECT_EQ(retimed.CountInteriorRegisterBits(), 32);
+  EXPECT_EQ(retimed.cycle(x.node()), 0);
+  EXPECT_EQ(retimed.cycle(f->return_value()), 1);
+
+  // Fixed nodes keep their cycle which here prevents any improvement.
+  Node* fifth_negate = f->return_value()->operand(0);
+  XLS_ASSERT_OK_AND_ASSIGN(
+      PipelineSchedule fixed_retimed,
+      RetimeSchedule(schedule, TestDelayEstimator(),
+                     schedule.CountInteriorRegisterBits(),
+                     /*fixed_nodes=*/{fifth_negate}));
+  EXPECT_EQ(fixed_retimed.cycle(fifth_negate), 0);
+  EXPECT_THAT(fixed_retimed.ComputeMaxStageDelay(TestDelayEstimator()),
+              IsOkAndHolds(5));
+}
+
+TEST_F(PipelineScheduleTest, RetimeWithinRegisterBudget) {
+  // Four wide negates followed by a one-bit slice and two one-bit nots. The
+  // cheapest cut is after the slice (stage delays 4 and 2) while balancing the
+  // stages requires registering a wide value.
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(32));
+  BValue wide = x;
+  for (int64_t i = 0; i < 4; ++i) {
+    wide = fb.Negate(wide);
+  }
+  fb.Not(fb.Not(fb.BitSlice(wide, /*start=*/0, /*width=*/1)));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      PipelineSchedule schedule,
+      PipelineSchedule::Run(
+          f, TestDelayEstimator(),
+          SchedulingOptions().clock_period_ps(5).pipeline_stages(2)));
+  EXPECT_EQ(schedule.CountInteriorRegisterBits(), 1);
+  EXPECT_THAT(schedule.ComputeMaxStageDelay(TestDelayEstimator()),
+              IsOkAndHolds(4));
+
+  // Without additional registers the stage delay cannot be improved.
+  XLS_ASSERT_OK_AND_ASSIGN(
+      PipelineSchedule same_budget,
+      RetimeSchedule(schedule, TestDelayEstimator(),
+                     /*register_bit_budget=*/1));
+  EXPECT_THAT(same_budget.ComputeMaxStageDelay(TestDelayEstimator()),
+              IsOkAndHolds(4));
+  EXPECT_EQ(same_budget.CountInteriorRegisterBits(), 1);
+
+  // With room for a wide register the stages are balanced.
+  XLS_ASSERT_OK_AND_ASSIGN(
+      PipelineSchedule retimed,
+      RetimeSchedule(schedule, TestDelayEstimator(),
+                     /*register_bit_budget=*/32));
+  EXPECT_THAT(retimed.ComputeMaxStageDelay(TestDelayEstimator()),
+              IsOkAndHolds(3));
+  EXPECT_EQ(retimed.CountInteriorRegisterBits(), 32);
+
+  // Retiming can also be requested as part of scheduling.
+  XLS_ASSERT_OK_AND_ASSIGN(PipelineSchedule run_retimed,
+                           PipelineSchedule::Run(
+                               f, TestDelayEstimator(),
+                               SchedulingOptions()
+                                   .clock_period_ps(5)
+                                   .pipeline_stages(2)
+                                   .retiming_register_budget_percent(3200)));
+  EXPECT_THAT(run_retimed.ComputeMaxStageDelay(TestDelayEstimator()),
+              IsOkAndHolds(3));
+}
+
+TEST_F(PipelineScheduleTest, SdcLongPipelineLength) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  Type* u32 = p->GetBitsType(32);
+  auto x = fb.Param("x", u32);
+  auto bitslice = fb.BitSlice(x, /*start=*/7, /*width=*/20);
+  auto zext = fb.ZeroExtend(bitslice, /*new_bit_count=*/32);
+
+  XLS_ASSERT_OK_AND_ASSIGN(Function * func, fb.Build());
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      PipelineSchedule schedule,
+      PipelineSchedule::Run(
+          func, TestDelayEstimator(),
+          SchedulingOptions(SchedulingStrategy::SDC).pipeline_stages(100)));
+
+  EXPECT_EQ(schedule.length(), 100);
+  EXPECT_THAT(schedule.nodes_in_cycle(0),
+              UnorderedElementsAre(x.node(), bitslice.node()));
+  EXPECT_THAT(schedule.nodes_in_cycle(99), UnorderedElementsAre(zext.node()));
+  EXPECT_EQ(PipelineRegisterBits(schedule), 20 * 99);
+}
+
 TEST_F(PipelineScheduleTest, AsapScheduleComplex) {
   auto p = CreatePackage();
   FunctionBuilder fb(TestName(), p.get());
@@ -556,6 +822,32 @@ TEST_F(PipelineScheduleTest, ProcSchedule) {
   EXPECT_EQ(schedule.cycle(send.node()), 2);
 }
 
+TEST_F(PipelineScheduleTest, SdcProcSchedule) {
+  Package p("p");
+  Type* u16 = p.GetBitsType(16);
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * in_ch,
+      p.CreateStreamingChannel("in", ChannelOps::kReceiveOnly, u16));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * out_ch,
+      p.CreateStreamingChannel("out", ChannelOps::kSendOnly, u16));
+  TokenlessProcBuilder pb("the_proc", Value(UBits(42, 16)), "tkn", "st", &p);
+  BValue rcv = pb.Receive(in_ch);
+  BValue out = pb.Negate(pb.Not(pb.Negate(rcv)));
+  BValue send = pb.Send(out_ch, out);
+  XLS_ASSERT_OK_AND_ASSIGN(Proc * proc, pb.Build(pb.GetStateParam()));
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      PipelineSchedule schedule,
+      PipelineSchedule::Run(
+          proc, TestDelayEstimator(),
+          SchedulingOptions(SchedulingStrategy::SDC).clock_period_ps(1)));
+
+  EXPECT_EQ(schedule.length(), 3);
+  EXPECT_EQ(schedule.cycle(rcv.node()), 0);
+  EXPECT_EQ(schedule.cycle(send.node()), 2);
+}
+
 TEST_F(PipelineScheduleTest, ProcWithConditionalReceive) {
   // Test a proc with a conditional receive. The receive condition must be
   // scheduled in cycle 0 along with the receive.
@@ -659,5 +951,273 @@ TEST_F(PipelineScheduleTest, InsufficientGates) {
                                testing::HasSubstr("Impossible to schedule")));
 }
 
+TEST_F(PipelineScheduleTest, BindSharedOperations) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(32));
+  BValue mul0 = fb.UMul(x, x);
+  BValue mul1 = fb.UMul(mul0, x);
+  BValue mul2 = fb.UMul(mul1, x);
+  BValue mul3 = fb.UMul(mul2, x);
+  // A multiply of a different width can not share a unit with the others.
+  BValue narrow_mul = fb.UMul(fb.BitSlice(mul3, 0, 8), fb.BitSlice(x, 0, 8));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  ScheduleCycleMap cycle_map;
+  for (Node* node : f->nodes()) {
+    cycle_map[node] = 0;
+  }
+  cycle_map[mul1.node()] = 1;
+  cycle_map[mul2.node()] = 2;
+  cycle_map[mul3.node()] = 3;
+  for (Node* node : narrow_mul.node()->operands()) {
+    cycle_map[node] = 3;
+  }
+  cycle_map[narrow_mul.node()] = 3;
+  PipelineSchedule schedule(f, cycle_map, 4);
+
+  EXPECT_TRUE(BindSharedOperations(schedule, 1).empty());
+  EXPECT_THAT(
+      BindSharedOperations(schedule, 2),
+      ElementsAre(ElementsAre(mul0.node(), mul1.node()),
+                  ElementsAre(mul2.node(), mul3.node())));
+  EXPECT_THAT(BindSharedOperations(schedule, 3),
+              ElementsAre(ElementsAre(mul0.node(), mul1.node(), mul2.node())));
+  EXPECT_THAT(BindSharedOperations(schedule, 4),
+              ElementsAre(ElementsAre(mul0.node(), mul1.node(), mul2.node(),
+                                      mul3.node())));
+}
+
+TEST_F(PipelineScheduleTest, BalanceSharedOperations) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(32));
+  BValue y = fb.Param("y", p->GetBitsType(32));
+  BValue z = fb.Param("z", p->GetBitsType(32));
+  BValue a = fb.UMul(x, y);
+  BValue b = fb.UMul(x, z);
+  fb.Add(a, b);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  // Both multiplies are in the same stage so they need separate units.
+  ScheduleCycleMap cycle_map;
+  for (Node* node : f->nodes()) {
+    cycle_map[node] = 0;
+  }
+  cycle_map[f->return_value()] = 2;
+  PipelineSchedule schedule(f, cycle_map, 3);
+  EXPECT_TRUE(BindSharedOperations(schedule, 2).empty());
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      PipelineSchedule balanced,
+      BalanceSharedOperations(schedule, TestDelayEstimator(),
+                              /*clock_period_ps=*/1,
+                              /*initiation_interval=*/2));
+  XLS_ASSERT_OK(balanced.Verify());
+  // One of the multiplies is moved to the next stage.
+  EXPECT_THAT((std::vector<int64_t>{balanced.cycle(a.node()),
+                                    balanced.cycle(b.node())}),
+              UnorderedElementsAre(0, 1));
+  EXPECT_THAT(BindSharedOperations(balanced, 2),
+              ElementsAre(UnorderedElementsAre(a.node(), b.node())));
+
+  // The multiply can not be moved to the stage of the add without exceeding
+  // the clock period.
+  XLS_ASSERT_OK_AND_ASSIGN(
+      balanced, BalanceSharedOperations(schedule, TestDelayEstimator(),
+                                        /*clock_period_ps=*/1,
+                                        /*initiation_interval=*/3));
+  EXPECT_THAT((std::vector<int64_t>{balanced.cycle(a.node()),
+                                    balanced.cycle(b.node())}),
+              UnorderedElementsAre(0, 1));
+
+  // Fixed nodes are not moved.
+  XLS_ASSERT_OK_AND_ASSIGN(
+      balanced, BalanceSharedOperations(schedule, TestDelayEstimator(),
+                                        /*clock_period_ps=*/1,
+                                        /*initiation_interval=*/2,
+                                        /*fixed_nodes=*/{a.node()}));
+  EXPECT_EQ(balanced.cycle(a.node()), 0);
+  EXPECT_EQ(balanced.cycle(b.node()), 1);
+  XLS_ASSERT_OK_AND_ASSIGN(
+      balanced,
+      BalanceSharedOperations(schedule, TestDelayEstimator(),
+                              /*clock_period_ps=*/1,
+                              /*initiation_interval=*/2,
+                              /*fixed_nodes=*/{a.node(), b.node()}));
+  EXPECT_EQ(balanced.cycle(a.node()), 0);
+  EXPECT_EQ(balanced.cycle(b.node()), 0);
+}
+
+TEST_F(PipelineScheduleTest, InitiationIntervalSharesMultipliers) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(32));
+  BValue y = fb.Param("y", p->GetBitsType(32));
+  BValue z = fb.Param("z", p->GetBitsType(32));
+  fb.UMul(fb.Add(fb.UMul(x, y), fb.UMul(x, z)), z);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      PipelineSchedule ii1_schedule,
+      PipelineSchedule::Run(f, TestDelayEstimator(),
+                            SchedulingOptions().clock_period_ps(1)));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      PipelineSchedule ii3_schedule,
+      PipelineSchedule::Run(
+          f, TestDelayEstimator(),
+          SchedulingOptions().clock_period_ps(1).initiation_interval(3)));
+  EXPECT_EQ(ii3_schedule.length(), ii1_schedule.length());
+  // The two independent multiplies must both be in the first stage to meet
+  // timing, but the final multiply can share a unit with one of them.
+  std::vector<std::vector<Node*>> units = BindSharedOperations(ii3_schedule, 3);
+  ASSERT_EQ(units.size(), 1);
+  EXPECT_EQ(units.front().size(), 2);
+
+  EXPECT_THAT(PipelineSchedule::Run(
+                  f, TestDelayEstimator(),
+                  SchedulingOptions().clock_period_ps(1).initiation_interval(0))
+                  .status(),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Initiation interval must be positive")));
+}
+
+TEST_F(PipelineScheduleTest, IncrementalSchedule) {
+  // Build the function and an arbitrary (but valid) schedule for it which is
+  // not what the scheduler would produce.
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(32));
+  BValue y = fb.Param("y", p->GetBitsType(32));
+  BValue a = fb.Not(x);
+  BValue b = fb.Negate(y);
+  BValue c = fb.Add(a, b);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+  ScheduleCycleMap cycle_map;
+  cycle_map[x.node()] = 0;
+  cycle_map[y.node()] = 0;
+  cycle_map[a.node()] = 1;
+  cycle_map[b.node()] = 0;
+  cycle_map[c.node()] = 2;
+  PipelineScheduleProto previous =
+      PipelineSchedule(f, cycle_map, 3).ToProto();
+
+  // Build a modified version of the function in a separate package with an
+  // extra operation after the original return value and with `b` changed.
+  auto p2 = CreatePackage();
+  FunctionBuilder fb2(TestName(), p2.get());
+  BValue x2 = fb2.Param("x", p2->GetBitsType(32));
+  BValue y2 = fb2.Param("y", p2->GetBitsType(32));
+  BValue a2 = fb2.Not(x2);
+  BValue b2 = fb2.Not(y2);
+  BValue c2 = fb2.Add(a2, b2);
+  BValue d2 = fb2.Add(c2, fb2.Literal(UBits(1, 32)));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f2, fb2.Build());
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      PipelineSchedule schedule,
+      PipelineSchedule::Run(f2, TestDelayEstimator(),
+                            SchedulingOptions()
+                                .clock_period_ps(2)
+                                .pipeline_stages(3)
+                                .previous_schedule(previous)));
+  XLS_ASSERT_OK(schedule.Verify());
+  XLS_ASSERT_OK(schedule.VerifyTiming(2, TestDelayEstimator()));
+  // The unchanged node keeps its cycle. The changed nodes are rescheduled.
+  EXPECT_EQ(schedule.cycle(a2.node()), 1);
+  EXPECT_LE(schedule.cycle(b2.node()), schedule.cycle(c2.node()));
+  EXPECT_LE(schedule.cycle(c2.node()), schedule.cycle(d2.node()));
+
+  // Rescheduling the original function reproduces the previous schedule.
+  XLS_ASSERT_OK_AND_ASSIGN(
+      PipelineSchedule same_schedule,
+      PipelineSchedule::Run(f, TestDelayEstimator(),
+                            SchedulingOptions()
+                                .clock_period_ps(2)
+                                .pipeline_stages(3)
+                                .previous_schedule(previous)));
+  for (Node* node : f->nodes()) {
+    EXPECT_EQ(same_schedule.cycle(node), cycle_map.at(node)) << node;
+  }
+}
+
+TEST_F(PipelineScheduleTest, IncrementalScheduleInfeasiblePreviousCycles) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(32));
+  BValue a = fb.Not(x);
+  BValue b = fb.Negate(a);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+  ScheduleCycleMap cycle_map;
+  cycle_map[x.node()] = 0;
+  cycle_map[a.node()] = 0;
+  cycle_map[b.node()] = 0;
+  PipelineScheduleProto previous = PipelineSchedule(f, cycle_map).ToProto();
+
+  // Insert a node between `a` and `b`. With a clock period of two, `a` and
+  // `b` can no longer be in the same cycle.
+  auto p2 = CreatePackage();
+  FunctionBuilder fb2(TestName(), p2.get());
+  BValue x2 = fb2.Param("x", p2->GetBitsType(32));
+  BValue a2 = fb2.Not(x2);
+  BValue b2 = fb2.Negate(fb2.Not(a2));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f2, fb2.Build());
+  XLS_ASSERT_OK_AND_ASSIGN(
+      PipelineSchedule schedule,
+      PipelineSchedule::Run(
+          f2, TestDelayEstimator(),
+          SchedulingOptions().clock_period_ps(2).previous_schedule(previous)));
+  XLS_ASSERT_OK(schedule.Verify());
+  XLS_ASSERT_OK(schedule.VerifyTiming(2, TestDelayEstimator()));
+  EXPECT_EQ(schedule.length(), 2);
+  EXPECT_EQ(schedule.cycle(b2.node()), 1);
+
+  // Schedules without structural hashes can not be reused.
+  for (StageProto& stage : *previous.mutable_stages()) {
+    stage.clear_node_hashes();
+  }
+  EXPECT_THAT(
+      PipelineSchedule::Run(
+          f2, TestDelayEstimator(),
+          SchedulingOptions().clock_period_ps(2).previous_schedule(previous))
+          .status(),
+      StatusIs(absl::StatusCode::kInvalidArgument,
+               HasSubstr("does not include structural node hashes")));
+}
+
+TEST_F(PipelineScheduleTest, IncrementalScheduleDropsConflictingPins) {
+  // A chain of three nots. Each previous cycle is within the bounds of its
+  // node but with a clock period of two the three nots can not all be in the
+  // same cycle. Only the last pin conflicts with the pins before it so only it
+  // is dropped.
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(32));
+  BValue a = fb.Not(x);
+  BValue b = fb.Not(a);
+  BValue c = fb.Not(b);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+  ScheduleCycleMap cycle_map;
+  cycle_map[x.node()] = 0;
+  cycle_map[a.node()] = 1;
+  cycle_map[b.node()] = 1;
+  cycle_map[c.node()] = 1;
+  PipelineScheduleProto previous =
+      PipelineSchedule(f, cycle_map, 3).ToProto();
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      PipelineSchedule schedule,
+      PipelineSchedule::Run(f, TestDelayEstimator(),
+                            SchedulingOptions()
+                                .clock_period_ps(2)
+                                .pipeline_stages(3)
+                                .previous_schedule(previous)));
+  XLS_ASSERT_OK(schedule.Verify());
+  XLS_ASSERT_OK(schedule.VerifyTiming(2, TestDelayEstimator()));
+  EXPECT_EQ(schedule.cycle(a.node()), 1);
+  EXPECT_EQ(schedule.cycle(b.node()), 1);
+  EXPECT_EQ(schedule.cycle(c.node()), 2);
+}
+
 }  // namespace
 }  // namespace xls
@@ -0,0 +1,151 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/scheduling/structural_hash.h"
+
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "xls/ir/format_strings.h"
+#include "xls/ir/function.h"
+#include "xls/ir/instantiation.h"
+#include "xls/ir/node_iterator.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/op.h"
+#include "xls/ir/register.h"
+
+namespace xls {
+namespace sched {
+namespace {
+
+// Parameters of the 64-bit FNV-1a hash. Unlike absl::Hash, the FNV hash is
+// not seeded per process so the hash values may be persisted.
+constexpr uint64_t kFnvOffsetBasis = 0xcbf29ce484222325ULL;
+constexpr uint64_t kFnvPrime = 0x100000001b3ULL;
+
+uint64_t FnvHashInt(uint64_t value, uint64_t hash) {
+  for (int64_t i = 0; i < 8; ++i) {
+    hash ^= (value >> (8 * i)) & 0xff;
+    hash *= kFnvPrime;
+  }
+  return hash;
+}
+
+// Strings are prefixed with their length so adjacent strings can't run
+// together.
+uint64_t FnvHashString(absl::string_view data, uint64_t hash) {
+  hash = FnvHashInt(data.size(), hash);
+  for (char c : data) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= kFnvPrime;
+  }
+  return hash;
+}
+
+// Returns a hash of the opcode, type and attributes of the node, but not of
+// its name, id or operands.
+uint64_t NodeSignatureHash(Node* node) {
+  uint64_t hash = FnvHashString(OpToString(node->op()), kFnvOffsetBasis);
+  hash = FnvHashString(node->GetType()->ToString(), hash);
+  hash = FnvHashInt(node->operand_count(), hash);
+  // Attributes which are implied by the type (e.g., the width of an extend
+  // or a multiply) or by the operand count are not hashed again.
+  switch (node->op()) {
+    case Op::kParam:
+      return FnvHashString(node->As<Param>()->name(), hash);
+    case Op::kLiteral:
+      return FnvHashString(node->As<Literal>()->value().ToString(), hash);
+    case Op::kBitSlice:
+      hash = FnvHashInt(node->As<BitSlice>()->start(), hash);
+      return FnvHashInt(node->As<BitSlice>()->width(), hash);
+    case Op::kTupleIndex:
+      return FnvHashInt(node->As<TupleIndex>()->index(), hash);
+    case Op::kOneHot:
+      return FnvHashInt(
+          static_cast<uint64_t>(node->As<OneHot>()->priority()), hash);
+    case Op::kSel:
+      return FnvHashInt(node->As<Select>()->default_value().has_value(),
+                        hash);
+    case Op::kInvoke:
+      return FnvHashString(node->As<Invoke>()->to_apply()->name(), hash);
+    case Op::kMap:
+      return FnvHashString(node->As<Map>()->to_apply()->name(), hash);
+    case Op::kCountedFor: {
+      CountedFor* counted_for = node->As<CountedFor>();
+      hash = FnvHashInt(counted_for->trip_count(), hash);
+      hash = FnvHashInt(counted_for->stride(), hash);
+      return FnvHashString(counted_for->body()->name(), hash);
+    }
+    case Op::kDynamicCountedFor:
+      return FnvHashString(node->As<DynamicCountedFor>()->body()->name(),
+                           hash);
+    case Op::kReceive:
+      return FnvHashInt(node->As<Receive>()->channel_id(), hash);
+    case Op::kSend:
+      return FnvHashInt(node->As<Send>()->channel_id(), hash);
+    case Op::kAssert: {
+      Assert* assert_node = node->As<Assert>();
+      hash = FnvHashString(assert_node->message(), hash);
+      hash = FnvHashInt(assert_node->label().has_value(), hash);
+      return FnvHashString(assert_node->label().value_or(""), hash);
+    }
+    case Op::kCover:
+      return FnvHashString(node->As<Cover>()->label(), hash);
+    case Op::kTrace:
+      return FnvHashString(
+          StepsToXlsFormatString(node->As<Trace>()->format()), hash);
+    case Op::kInputPort:
+      return FnvHashString(node->As<InputPort>()->name(), hash);
+    case Op::kOutputPort:
+      return FnvHashString(node->As<OutputPort>()->name(), hash);
+    case Op::kRegisterRead:
+      return FnvHashString(node->As<RegisterRead>()->GetRegister()->name(),
+                           hash);
+    case Op::kRegisterWrite: {
+      RegisterWrite* reg_write = node->As<RegisterWrite>();
+      hash = FnvHashString(reg_write->GetRegister()->name(), hash);
+      hash = FnvHashInt(reg_write->load_enable().has_value(), hash);
+      return FnvHashInt(reg_write->reset().has_value(), hash);
+    }
+    case Op::kInstantiationInput: {
+      InstantiationInput* input = node->As<InstantiationInput>();
+      hash = FnvHashString(input->instantiation()->name(), hash);
+      return FnvHashString(input->port_name(), hash);
+    }
+    case Op::kInstantiationOutput: {
+      InstantiationOutput* output = node->As<InstantiationOutput>();
+      hash = FnvHashString(output->instantiation()->name(), hash);
+      return FnvHashString(output->port_name(), hash);
+    }
+    default:
+      return hash;
+  }
+}
+
+}  // namespace
+
+absl::flat_hash_map<Node*, uint64_t> ComputeStructuralHashes(FunctionBase* f) {
+  absl::flat_hash_map<Node*, uint64_t> hashes;
+  for (Node* node : TopoSort(f)) {
+    uint64_t hash = NodeSignatureHash(node);
+    for (Node* operand : node->operands()) {
+      hash = FnvHashInt(hashes.at(operand), hash);
+    }
+    hashes[node] = hash;
+  }
+  return hashes;
+}
+
+}  // namespace sched
+}  // namespace xls
@@ -0,0 +1,40 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_SCHEDULING_STRUCTURAL_HASH_H_
+#define XLS_SCHEDULING_STRUCTURAL_HASH_H_
+
+#include <cstdint>
+
+#include "absl/container/flat_hash_map.h"
+#include "xls/ir/function_base.h"
+#include "xls/ir/node.h"
+
+namespace xls {
+namespace sched {
+
+// Returns a hash of each node in the function which depends only on the
+// structure of the node's fan-in cone: the opcode, type and attributes (e.g.,
+// literal values, slice bounds, channel ids) of the node and, recursively, of
+// its operands. Parameters are distinguished by name but the names of other
+// nodes and node ids do not affect the hash. Structurally identical nodes in
+// different functions (or different versions of the same function) therefore
+// have equal hashes. The hash is stable across processes and so may be stored
+// (e.g., in a PipelineScheduleProto) and compared against later.
+absl::flat_hash_map<Node*, uint64_t> ComputeStructuralHashes(FunctionBase* f);
+
+}  // namespace sched
+}  // namespace xls
+
+#endif  // XLS_SCHEDULING_STRUCTURAL_HASH_H_
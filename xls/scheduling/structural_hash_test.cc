@@ -0,0 +1,124 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/scheduling/structural_hash.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/function.h"
+#include "xls/ir/ir_test_base.h"
+
+namespace xls {
+namespace sched {
+namespace {
+
+class StructuralHashTest : public IrTestBase {
+ protected:
+  // Returns the structural hash of the node with the given name.
+  uint64_t HashOf(Function* f, absl::string_view name) {
+    absl::flat_hash_map<Node*, uint64_t> hashes = ComputeStructuralHashes(f);
+    return hashes.at(FindNode(name, f));
+  }
+};
+
+TEST_F(StructuralHashTest, NamesAndIdsDoNotMatter) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
+fn f(x: bits[32], y: bits[32]) -> bits[32] {
+  add.1: bits[32] = add(x, y, id=1)
+  literal.2: bits[32] = literal(value=3, id=2)
+  ret umul.3: bits[32] = umul(add.1, literal.2, id=3)
+}
+)",
+                                                       p.get()));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * g, ParseFunction(R"(
+fn g(x: bits[32], y: bits[32]) -> bits[32] {
+  three: bits[32] = literal(value=3, id=10)
+  sum: bits[32] = add(x, y, id=20)
+  ret product: bits[32] = umul(sum, three, id=30)
+}
+)",
+                                                       p.get()));
+  EXPECT_EQ(HashOf(f, "x"), HashOf(g, "x"));
+  EXPECT_EQ(HashOf(f, "add.1"), HashOf(g, "sum"));
+  EXPECT_EQ(HashOf(f, "literal.2"), HashOf(g, "three"));
+  EXPECT_EQ(HashOf(f, "umul.3"), HashOf(g, "product"));
+
+  EXPECT_NE(HashOf(f, "x"), HashOf(f, "y"));
+  EXPECT_NE(HashOf(f, "add.1"), HashOf(f, "umul.3"));
+}
+
+TEST_F(StructuralHashTest, ChangesPropagateToUsers) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
+fn f(x: bits[32], y: bits[32]) -> (bits[32], bits[32]) {
+  literal.1: bits[32] = literal(value=3, id=1)
+  add.2: bits[32] = add(x, literal.1, id=2)
+  sub.3: bits[32] = sub(x, y, id=3)
+  ret tuple.4: (bits[32], bits[32]) = tuple(add.2, sub.3, id=4)
+}
+)",
+                                                       p.get()));
+  // Same as above (in a different package) but with a different literal
+  // value.
+  auto p2 = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * g, ParseFunction(R"(
+fn g(x: bits[32], y: bits[32]) -> (bits[32], bits[32]) {
+  literal.1: bits[32] = literal(value=4, id=1)
+  add.2: bits[32] = add(x, literal.1, id=2)
+  sub.3: bits[32] = sub(x, y, id=3)
+  ret tuple.4: (bits[32], bits[32]) = tuple(add.2, sub.3, id=4)
+}
+)",
+                                                       p2.get()));
+  EXPECT_NE(HashOf(f, "literal.1"), HashOf(g, "literal.1"));
+  EXPECT_NE(HashOf(f, "add.2"), HashOf(g, "add.2"));
+  EXPECT_NE(HashOf(f, "tuple.4"), HashOf(g, "tuple.4"));
+  EXPECT_EQ(HashOf(f, "sub.3"), HashOf(g, "sub.3"));
+}
+
+TEST_F(StructuralHashTest, AttributesAndOperandOrderMatter) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
+fn f(x: bits[32], y: bits[32]) -> bits[8] {
+  bit_slice.1: bits[8] = bit_slice(x, start=0, width=8, id=1)
+  bit_slice.2: bits[8] = bit_slice(x, start=8, width=8, id=2)
+  sub.3: bits[32] = sub(x, y, id=3)
+  sub.4: bits[32] = sub(y, x, id=4)
+  ret add.5: bits[8] = add(bit_slice.1, bit_slice.2, id=5)
+}
+)",
+                                                       p.get()));
+  EXPECT_NE(HashOf(f, "bit_slice.1"), HashOf(f, "bit_slice.2"));
+  EXPECT_NE(HashOf(f, "sub.3"), HashOf(f, "sub.4"));
+}
+
+TEST_F(StructuralHashTest, OperandRolesMatter) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
+fn f(p: bits[1], x: bits[8], y: bits[8]) -> (bits[8], bits[8]) {
+  sel.1: bits[8] = sel(p, cases=[x, y], id=1)
+  sel.2: bits[8] = sel(p, cases=[x], default=y, id=2)
+  ret tuple.3: (bits[8], bits[8]) = tuple(sel.1, sel.2, id=3)
+}
+)",
+                                                       p.get()));
+  // Same op, type and operands; only the role of the last operand differs.
+  EXPECT_NE(HashOf(f, "sel.1"), HashOf(f, "sel.2"));
+}
+
+}  // namespace
+}  // namespace sched
+}  // namespace xls
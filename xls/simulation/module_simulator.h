@@ -19,6 +19,7 @@
 #include "absl/status/statusor.h"
 #include "xls/codegen/module_signature.h"
 #include "xls/codegen/vast.h"
+#include "xls/ir/block.h"
 #include "xls/ir/value.h"
 #include "xls/simulation/module_testbench.h"
 #include "xls/simulation/verilog_simulator.h"
@@ -37,12 +38,15 @@ class ModuleSimulator {
   //  signature: Proto describing the interface of the module.
   //  verilog_text: Verilog text containing the module to test.
   //  simulator: Verilog simulator to use.
+  //  block: Block from which the module was generated. Required by simulators
+  //    which simulate blocks rather than Verilog, such as "native".
   ModuleSimulator(const ModuleSignature& signature,
                   absl::string_view verilog_text,
-                  const VerilogSimulator* simulator)
+                  const VerilogSimulator* simulator, Block* block = nullptr)
       : signature_(signature),
         verilog_text_(verilog_text),
-        simulator_(simulator) {}
+        simulator_(simulator),
+        block_(block) {}
 
   // Simulates the module with the given inputs as Bits types. Returns a
   // map containing the outputs by port name.
@@ -77,6 +81,7 @@ class ModuleSimulator {
   ModuleSignature signature_;
   std::string verilog_text_;
   const VerilogSimulator* simulator_;
+  Block* block_;
 };
 
 }  // namespace verilog
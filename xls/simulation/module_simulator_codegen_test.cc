@@ -29,6 +29,7 @@
 #include "xls/ir/package.h"
 #include "xls/scheduling/pipeline_schedule.h"
 #include "xls/simulation/module_simulator.h"
+#include "xls/simulation/verilog_simulators.h"
 #include "xls/simulation/verilog_test_base.h"
 
 namespace xls {
@@ -510,6 +511,80 @@ TEST_P(ModuleSimulatorCodegenTest, ConstructArrayCombinationalModule) {
   EXPECT_EQ(output, Value::UBitsArray({1, 2, 3}, 8).value());
 }
 
+TEST(ModuleSimulatorNativeTest, PipelinedAddWithValidBatched) {
+  Package package("PipelinedAddWithValidBatched");
+  FunctionBuilder fb("x_plus_y_plus_z_plus_x", &package);
+  Type* u32 = package.GetBitsType(32);
+  auto x = fb.Param("x", u32);
+  auto y = fb.Param("y", u32);
+  auto z = fb.Param("z", u32);
+  auto out = x + y + z + x;
+
+  XLS_ASSERT_OK_AND_ASSIGN(Function * func, fb.BuildWithReturnValue(out));
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      PipelineSchedule schedule,
+      PipelineSchedule::Run(func, TestDelayEstimator(),
+                            SchedulingOptions().pipeline_stages(5)));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      ModuleGeneratorResult result,
+      ToPipelineModuleText(
+          schedule, func,
+          BuildPipelineOptions().valid_control("valid_in", "valid_out")));
+  XLS_ASSERT_OK_AND_ASSIGN(Block * block,
+                           package.GetBlock(result.signature.module_name()));
+  XLS_ASSERT_OK_AND_ASSIGN(VerilogSimulator * native,
+                           GetVerilogSimulator("native"));
+
+  ModuleSimulator simulator(result.signature, result.verilog_text, native,
+                            block);
+  std::vector<absl::flat_hash_map<std::string, Bits>> input_batches(7);
+  for (int64_t i = 0; i < input_batches.size(); ++i) {
+    input_batches[i]["x"] = UBits(i, 32);
+    input_batches[i]["y"] = UBits(100, 32);
+    input_batches[i]["z"] = UBits(3 * i, 32);
+  }
+  std::vector<absl::flat_hash_map<std::string, Bits>> outputs;
+  XLS_ASSERT_OK_AND_ASSIGN(outputs, simulator.RunBatched(input_batches));
+
+  ASSERT_EQ(outputs.size(), input_batches.size());
+  for (int64_t i = 0; i < outputs.size(); ++i) {
+    ASSERT_TRUE(outputs[i].contains("out"));
+    EXPECT_EQ(outputs[i].at("out"), UBits(5 * i + 100, 32)) << "set " << i;
+  }
+
+  // The Verilog text alone cannot be simulated natively.
+  ModuleSimulator no_block(result.signature, result.verilog_text, native);
+  EXPECT_THAT(no_block.RunBatched(input_batches),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("requires the block")));
+}
+
+TEST(ModuleSimulatorNativeTest, AddTwoTupleElementsCombinational) {
+  Package package("AddTwoTupleElementsCombinational");
+  FunctionBuilder fb("add_two_tuple_elements", &package);
+  Type* u8 = package.GetBitsType(8);
+  auto in = fb.Param("in", package.GetTupleType({u8, u8}));
+  auto out = fb.TupleIndex(in, 0) + fb.TupleIndex(in, 1);
+
+  XLS_ASSERT_OK_AND_ASSIGN(Function * func, fb.BuildWithReturnValue(out));
+  XLS_ASSERT_OK_AND_ASSIGN(ModuleGeneratorResult result,
+                           GenerateCombinationalModule(
+                               func, /*use_system_verilog=*/false));
+  XLS_ASSERT_OK_AND_ASSIGN(Block * block,
+                           package.GetBlock(result.signature.module_name()));
+  XLS_ASSERT_OK_AND_ASSIGN(VerilogSimulator * native,
+                           GetVerilogSimulator("native"));
+
+  ModuleSimulator simulator(result.signature, result.verilog_text, native,
+                            block);
+  EXPECT_THAT(simulator.RunAndReturnSingleOutput({{"in", UBits(0x1234, 16)}}),
+              IsOkAndHolds(UBits(0x46, 8)));
+  EXPECT_THAT(simulator.Run({{"in", Value::Tuple({Value(UBits(0x11, 8)),
+                                                  Value(UBits(0x78, 8))})}}),
+              IsOkAndHolds(Value(UBits(0x89, 8))));
+}
+
 INSTANTIATE_TEST_SUITE_P(ModuleSimulatorCodegenTestInstantiation,
                          ModuleSimulatorCodegenTest,
                          testing::ValuesIn(kDefaultSimulationTargets),
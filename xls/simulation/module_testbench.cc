@@ -14,7 +14,13 @@
 
 #include "xls/simulation/module_testbench.h"
 
+#include <memory>
+
 #include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_replace.h"
+#include "absl/types/optional.h"
+#include "xls/codegen/flattening.h"
 #include "xls/common/logging/log_lines.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/status/ret_check.h"
@@ -23,6 +29,8 @@
 #include "xls/ir/bits_ops.h"
 #include "xls/ir/ir_parser.h"
 #include "xls/ir/number_parser.h"
+#include "xls/ir/value_helpers.h"
+#include "xls/jit/block_jit.h"
 #include "xls/simulation/verilog_simulator.h"
 #include "xls/simulation/verilog_simulators.h"
 #include "re2/re2.h"
@@ -75,10 +83,12 @@ ModuleTestbench::ModuleTestbench(Module* module,
 
 ModuleTestbench::ModuleTestbench(absl::string_view verilog_text,
                                  const ModuleSignature& signature,
-                                 const VerilogSimulator* simulator)
+                                 const VerilogSimulator* simulator,
+                                 Block* block)
     : verilog_text_(verilog_text),
       module_name_(signature.module_name()),
-      simulator_(simulator) {
+      simulator_(simulator),
+      block_(block) {
   XLS_VLOG(3) << "Building ModuleTestbench for Verilog module:";
   XLS_VLOG_LINES(3, verilog_text_);
   XLS_VLOG(3) << "With signature:\n" << signature;
@@ -348,7 +358,132 @@ absl::Status ModuleTestbench::CheckOutput(absl::string_view stdout_str) const {
   return absl::OkStatus();
 }
 
+absl::Status ModuleTestbench::RunNative() {
+  if (block_ == nullptr) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Simulating module '%s' natively requires the block it was generated "
+        "from",
+        module_name_));
+  }
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<BlockJit> jit, BlockJit::Create(block_));
+
+  absl::flat_hash_map<std::string, InputPort*> input_ports;
+  absl::flat_hash_map<std::string, Value> inputs;
+  for (InputPort* port : block_->GetInputPorts()) {
+    input_ports[port->GetName()] = port;
+    inputs[port->GetName()] = ZeroOfType(port->GetType());
+  }
+  BlockJit::RegisterState reg_state = jit->InitialRegisterState();
+
+  // The evaluation of the current cycle, cleared whenever an input changes or
+  // the clock ticks.
+  absl::optional<BlockJit::CycleResult> current;
+  auto evaluate = [&]() -> absl::StatusOr<const BlockJit::CycleResult*> {
+    if (!current.has_value()) {
+      XLS_ASSIGN_OR_RETURN(current, jit->RunOneCycle(inputs, reg_state));
+      XLS_RETURN_IF_ERROR(InterpreterEventsToStatus(current->events));
+    }
+    return &current.value();
+  };
+  auto get_output = [&](absl::string_view port) -> absl::StatusOr<Bits> {
+    XLS_ASSIGN_OR_RETURN(const BlockJit::CycleResult* result, evaluate());
+    auto it = result->outputs.find(port);
+    if (it == result->outputs.end()) {
+      return absl::NotFoundError(absl::StrFormat(
+          "Block '%s' has no output port '%s'", block_->name(), port));
+    }
+    return FlattenValueToBits(it->second);
+  };
+
+  // As in the Verilog testbench, time advances by two units per cycle and
+  // actions occur at the falling edge of the clock, starting after the first
+  // rising edge.
+  std::string stdout_str;
+  int64_t cycle = 0;
+  auto tick = [&]() -> absl::Status {
+    XLS_RETURN_IF_ERROR(evaluate().status());
+    for (const std::string& message : current->events.trace_msgs) {
+      absl::StrAppend(&stdout_str, message, "\n");
+    }
+    reg_state = std::move(current->reg_state);
+    current.reset();
+    ++cycle;
+    return absl::OkStatus();
+  };
+  auto set_input = [&](const std::string& port,
+                       const Bits& value) -> absl::Status {
+    auto it = input_ports.find(port);
+    if (it == input_ports.end()) {
+      // The clock is not a port of the block.
+      return absl::OkStatus();
+    }
+    XLS_ASSIGN_OR_RETURN(inputs[port],
+                         UnflattenBitsToValue(value, it->second->GetType()));
+    current.reset();
+    return absl::OkStatus();
+  };
+
+  XLS_RETURN_IF_ERROR(tick());
+  for (const Action& action : actions_) {
+    if (cycle >= kSimulationCycleLimit) {
+      break;
+    }
+    XLS_RETURN_IF_ERROR(absl::visit(
+        Visitor{
+            [&](const AdvanceCycle& a) -> absl::Status {
+              for (int64_t i = 0;
+                   i < a.amount && cycle < kSimulationCycleLimit; ++i) {
+                XLS_RETURN_IF_ERROR(tick());
+              }
+              return absl::OkStatus();
+            },
+            [&](const SetInput& s) { return set_input(s.port, s.value); },
+            [&](const SetInputX& s) {
+              return set_input(s.port, Bits(GetPortWidth(s.port)));
+            },
+            [&](const WaitForOutput& w) -> absl::Status {
+              if (!absl::holds_alternative<Bits>(w.value)) {
+                // Outputs are never X.
+                return absl::OkStatus();
+              }
+              while (cycle < kSimulationCycleLimit) {
+                XLS_ASSIGN_OR_RETURN(Bits value, get_output(w.port));
+                if (value == absl::get<Bits>(w.value)) {
+                  break;
+                }
+                XLS_RETURN_IF_ERROR(tick());
+              }
+              return absl::OkStatus();
+            },
+            [&](const DisplayOutput& d) -> absl::Status {
+              std::string digits = "x";
+              auto it = expectations_.find({d.instance, d.port});
+              if (it == expectations_.end() ||
+                  !absl::holds_alternative<IsX>(it->second.expected)) {
+                XLS_ASSIGN_OR_RETURN(Bits value, get_output(d.port));
+                digits = absl::StrReplaceAll(
+                    value.ToRawDigits(FormatPreference::kHex), {{"_", ""}});
+              }
+              absl::StrAppendFormat(&stdout_str,
+                                    "%20d OUTPUT %s = %d'h%s (#%d)\n",
+                                    2 * cycle, d.port, GetPortWidth(d.port),
+                                    digits, d.instance);
+              return absl::OkStatus();
+            }},
+        action));
+  }
+  if (cycle >= kSimulationCycleLimit) {
+    absl::StrAppend(&stdout_str, GetTimeoutMessage(), "\n");
+  }
+
+  XLS_VLOG(2) << "Native simulation stdout:\n" << stdout_str;
+  return CheckOutput(stdout_str);
+}
+
 absl::Status ModuleTestbench::Run() {
+  if (simulator_->SimulatesBlocks()) {
+    return RunNative();
+  }
   VerilogFile file(/*use_system_verilog=*/false);
   Module* m = file.AddModule("testbench");
 
@@ -26,6 +26,7 @@
 #include "xls/codegen/module_signature.h"
 #include "xls/codegen/vast.h"
 #include "xls/ir/bits.h"
+#include "xls/ir/block.h"
 #include "xls/simulation/verilog_simulator.h"
 
 namespace xls {
@@ -43,10 +44,12 @@ class ModuleTestbench {
                   absl::optional<ResetProto> reset = absl::nullopt);
 
   // Constructor for testing a module defined in Verilog text with an interface
-  // described with a ModuleSignature.
+  // described with a ModuleSignature. `block` is the block from which the
+  // module was generated, if any; it is required by simulators which simulate
+  // blocks rather than Verilog (see VerilogSimulator::SimulatesBlocks).
   ModuleTestbench(absl::string_view verilog_text,
                   const ModuleSignature& signature,
-                  const VerilogSimulator* simulator);
+                  const VerilogSimulator* simulator, Block* block = nullptr);
 
   // Sets the given module input port to the given value in the current
   // cycle. The value is sticky and remains driven to this value across cycle
@@ -109,6 +112,12 @@ class ModuleTestbench {
   absl::Status Run();
 
  private:
+  // Runs the actions on the block with the BlockJit rather than on the Verilog
+  // text, producing output in the format of the Verilog testbench. X values are
+  // not modeled: registers start at zero, inputs which are unset or set to X
+  // are driven with zero, and expectations of X are considered met.
+  absl::Status RunNative();
+
   // Checks the stdout of a simulation run against expectations.
   absl::Status CheckOutput(absl::string_view stdout_str) const;
 
@@ -122,6 +131,7 @@ class ModuleTestbench {
   std::string verilog_text_;
   std::string module_name_;
   const VerilogSimulator* simulator_;
+  Block* block_ = nullptr;
   absl::optional<std::string> clk_name_;
 
   // Map of each input/output port name to its width.
@@ -29,7 +29,8 @@ namespace verilog {
 namespace {
 
 // Wrapper class around ModuleSimulator which uses the default Verilog
-// simulator.
+// simulator. The default simulator runs the Verilog text, so no block is
+// needed.
 class ModuleSimulatorWrapper : public ModuleSimulator {
  public:
   ModuleSimulatorWrapper(const ModuleSignature& signature,
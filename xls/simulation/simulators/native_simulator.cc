@@ -0,0 +1,61 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/module_initializer.h"
+#include "xls/simulation/verilog_simulator.h"
+#include "xls/tools/verilog_include.h"
+
+namespace xls {
+namespace verilog {
+namespace {
+
+// Simulator which compiles the XLS block a module was generated from and
+// evaluates it cycle by cycle on the host (see ModuleTestbench). No Verilog is
+// involved so the Verilog entry points are unsupported.
+class NativeSimulator : public VerilogSimulator {
+ public:
+  absl::StatusOr<std::pair<std::string, std::string>> Run(
+      absl::string_view text,
+      absl::Span<const VerilogInclude> includes) const override {
+    return absl::UnimplementedError(
+        "The native simulator cannot run Verilog text; simulate the block "
+        "through a ModuleTestbench or ModuleSimulator instead");
+  }
+
+  absl::Status RunSyntaxChecking(
+      absl::string_view text,
+      absl::Span<const VerilogInclude> includes) const override {
+    return absl::UnimplementedError(
+        "The native simulator cannot check Verilog syntax");
+  }
+
+  bool SimulatesBlocks() const override { return true; }
+};
+
+XLS_REGISTER_MODULE_INITIALIZER(native_simulator, {
+  XLS_CHECK_OK(GetVerilogSimulatorManagerSingleton().RegisterVerilogSimulator(
+      "native", std::make_unique<NativeSimulator>()));
+});
+
+}  // namespace
+}  // namespace verilog
+}  // namespace xls
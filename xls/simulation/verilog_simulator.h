@@ -54,6 +54,12 @@ class VerilogSimulator {
       absl::Span<const VerilogInclude> includes) const = 0;
   absl::Status RunSyntaxChecking(absl::string_view text) const;
 
+  // Returns true if the simulator evaluates the XLS block from which a module
+  // was generated rather than the module's Verilog text. Such simulators can
+  // only be driven through a ModuleTestbench (or ModuleSimulator) constructed
+  // with that block.
+  virtual bool SimulatesBlocks() const { return false; }
+
   // Simulation runner harness: runs the given Verilog text using the verilog
   // simulator infrastructure and returns observations of data values that arose
   // during simulation.
@@ -0,0 +1,222 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/solvers/random_simulation.h"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+
+#include "absl/strings/str_format.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/interpreter/ir_interpreter.h"
+#include "xls/interpreter/random_value.h"
+#include "xls/ir/node_iterator.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/value_helpers.h"
+#include "xls/jit/ir_jit.h"
+
+namespace xls {
+namespace solvers {
+
+std::vector<std::vector<Value>> GenerateSimulationArguments(
+    Function* f, const SimulationOptions& options) {
+  std::vector<std::function<Bits(int64_t)>> leaf_patterns = {
+      [](int64_t bit_count) { return Bits(bit_count); },
+      [](int64_t bit_count) { return Bits::AllOnes(bit_count); },
+      [](int64_t bit_count) {
+        return bit_count == 0 ? Bits() : UBits(1, bit_count);
+      },
+      [](int64_t bit_count) {
+        return bit_count == 0 ? Bits() : Bits::MinSigned(bit_count);
+      },
+      [](int64_t bit_count) {
+        return bit_count == 0 ? Bits() : Bits::MaxSigned(bit_count);
+      },
+  };
+
+  std::vector<std::vector<Value>> args;
+  for (const auto& pattern : leaf_patterns) {
+    std::vector<Value> vector;
+    for (Param* param : f->params()) {
+      vector.push_back(ValueOfType(param->GetType(), pattern));
+    }
+    args.push_back(std::move(vector));
+  }
+  if (f->params().size() > 1) {
+    for (int64_t i = 0; i < f->params().size(); ++i) {
+      std::vector<Value> vector;
+      for (int64_t j = 0; j < f->params().size(); ++j) {
+        Type* type = f->param(j)->GetType();
+        vector.push_back(i == j ? AllOnesOfType(type) : ZeroOfType(type));
+      }
+      args.push_back(std::move(vector));
+    }
+  }
+
+  std::minstd_rand engine(options.seed);
+  for (int64_t i = 0; i < options.random_vector_count; ++i) {
+    args.push_back(RandomFunctionArguments(f, &engine));
+  }
+  return args;
+}
+
+void AppendFlattenedBits(const Value& value, std::vector<bool>* bits) {
+  if (value.IsBits()) {
+    for (int64_t i = value.bits().bit_count() - 1; i >= 0; --i) {
+      bits->push_back(value.bits().Get(i));
+    }
+  } else if (value.IsTuple() || value.IsArray()) {
+    for (const Value& element : value.elements()) {
+      AppendFlattenedBits(element, bits);
+    }
+  }
+}
+
+absl::StatusOr<absl::flat_hash_map<Node*, BitSignatures>> ComputeSignatures(
+    Function* f, absl::Span<const std::vector<Value>> args) {
+  XLS_RET_CHECK_LE(args.size(), 64);
+  absl::flat_hash_map<Node*, BitSignatures> signatures;
+  for (Node* node : f->nodes()) {
+    signatures[node].resize(node->GetType()->GetFlatBitCount(), 0);
+  }
+
+  absl::flat_hash_map<Node*, Value> values;
+  std::vector<Value> operand_values;
+  std::vector<bool> bits;
+  for (int64_t lane = 0; lane < args.size(); ++lane) {
+    XLS_RET_CHECK_EQ(args[lane].size(), f->params().size());
+    values.clear();
+    for (Node* node : TopoSort(f)) {
+      Value value;
+      if (node->Is<Param>()) {
+        XLS_ASSIGN_OR_RETURN(int64_t index,
+                             f->GetParamIndex(node->As<Param>()));
+        value = args[lane][index];
+      } else {
+        operand_values.clear();
+        for (Node* operand : node->operands()) {
+          operand_values.push_back(values.at(operand));
+        }
+        XLS_ASSIGN_OR_RETURN(value, InterpretNode(node, operand_values));
+      }
+
+      bits.clear();
+      AppendFlattenedBits(value, &bits);
+      BitSignatures& signature = signatures.at(node);
+      XLS_RET_CHECK_EQ(bits.size(), signature.size()) << node->GetName();
+      for (int64_t i = 0; i < bits.size(); ++i) {
+        signature[i] |= static_cast<uint64_t>(bits[i]) << lane;
+      }
+      values[node] = std::move(value);
+    }
+  }
+  return signatures;
+}
+
+namespace {
+
+// Proposes equivalences between the nodes of the two functions from their
+// signatures on the given argument vectors.
+absl::StatusOr<std::vector<std::pair<Node*, Node*>>> ProposeEquivalences(
+    Function* lhs, Function* rhs, absl::Span<const std::vector<Value>> args) {
+  XLS_ASSIGN_OR_RETURN(auto lhs_signatures, ComputeSignatures(lhs, args));
+  XLS_ASSIGN_OR_RETURN(auto rhs_signatures, ComputeSignatures(rhs, args));
+
+  // The functions may live in different packages, so types are compared by
+  // their string form. The earliest lhs node with a given signature is the
+  // representative.
+  absl::flat_hash_map<std::pair<std::string, BitSignatures>, Node*>
+      lhs_by_signature;
+  for (Node* node : TopoSort(lhs)) {
+    lhs_by_signature.insert(
+        {{node->GetType()->ToString(), lhs_signatures.at(node)}, node});
+  }
+
+  std::vector<std::pair<Node*, Node*>> candidates;
+  for (Node* node : TopoSort(rhs)) {
+    if (node->Is<Param>() || node->Is<Literal>() ||
+        node->GetType()->GetFlatBitCount() == 0) {
+      continue;
+    }
+    auto it = lhs_by_signature.find(
+        {node->GetType()->ToString(), rhs_signatures.at(node)});
+    if (it != lhs_by_signature.end() && !it->second->Is<Literal>()) {
+      candidates.push_back({it->second, node});
+    }
+  }
+  return candidates;
+}
+
+}  // namespace
+
+absl::StatusOr<IrSimulationResult> SimulateIrEquivalence(
+    Function* lhs, Function* rhs, const SimulationOptions& options) {
+  XLS_RET_CHECK_EQ(lhs->params().size(), rhs->params().size());
+  for (int64_t i = 0; i < lhs->params().size(); ++i) {
+    XLS_RET_CHECK(
+        lhs->param(i)->GetType()->IsEqualTo(rhs->param(i)->GetType()))
+        << absl::StrFormat("Parameter %d types differ: %s vs. %s", i,
+                           lhs->param(i)->GetType()->ToString(),
+                           rhs->param(i)->GetType()->ToString());
+  }
+  XLS_RET_CHECK(lhs->return_value()->GetType()->IsEqualTo(
+      rhs->return_value()->GetType()));
+
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<IrJit> lhs_jit, IrJit::Create(lhs));
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<IrJit> rhs_jit, IrJit::Create(rhs));
+  std::vector<std::vector<Value>> args =
+      GenerateSimulationArguments(lhs, options);
+
+  IrSimulationResult result;
+  for (const std::vector<Value>& vector : args) {
+    XLS_ASSIGN_OR_RETURN(InterpreterResult<Value> lhs_result,
+                         lhs_jit->Run(vector));
+    XLS_ASSIGN_OR_RETURN(InterpreterResult<Value> rhs_result,
+                         rhs_jit->Run(vector));
+    ++result.vector_count;
+    if (lhs_result.value != rhs_result.value) {
+      result.counterexample = IrSimulationResult::Counterexample{
+          vector, lhs_result.value, rhs_result.value};
+      return result;
+    }
+  }
+  XLS_VLOG(1) << "No mismatch in " << result.vector_count
+              << " simulated vectors";
+
+  int64_t signature_vector_count = std::min<int64_t>(
+      {options.signature_vector_count, 64, static_cast<int64_t>(args.size())});
+  if (signature_vector_count > 0) {
+    // The signature vectors are taken from the end, i.e., the random vectors,
+    // as corner cases alone would make too many signals look alike.
+    XLS_ASSIGN_OR_RETURN(
+        result.candidate_equivalences,
+        ProposeEquivalences(
+            lhs, rhs,
+            absl::MakeConstSpan(args).last(signature_vector_count)));
+    if (result.candidate_equivalences.size() >
+        options.max_candidate_equivalences) {
+      result.candidate_equivalences.resize(
+          std::max<int64_t>(options.max_candidate_equivalences, 0));
+    }
+  }
+  return result;
+}
+
+}  // namespace solvers
+}  // namespace xls
@@ -0,0 +1,112 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Simulation front-end for the equivalence checkers. Before posing a query to
+// a solver, both sides of a check are simulated on corner-case and random
+// inputs: a mismatch is a counterexample found in milliseconds rather than
+// after a possibly long solver run. If no mismatch is found, the values
+// internal signals took during simulation ("signatures") are used to propose
+// pairs of signals that are likely equivalent; once proved, these serve as
+// lemmas that cut the final query into smaller pieces.
+#ifndef XLS_SOLVERS_RANDOM_SIMULATION_H_
+#define XLS_SOLVERS_RANDOM_SIMULATION_H_
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "xls/ir/function.h"
+#include "xls/ir/node.h"
+#include "xls/ir/value.h"
+
+namespace xls {
+namespace solvers {
+
+struct SimulationOptions {
+  // Number of random input vectors simulated after the corner cases.
+  int64_t random_vector_count = 4096;
+
+  // Seed for the random input vectors.
+  int64_t seed = 0;
+
+  // Number of input vectors, at most 64, on which internal signals are
+  // evaluated to compute their signatures. Zero disables the search for
+  // candidate equivalences.
+  int64_t signature_vector_count = 64;
+
+  // Maximum number of candidate equivalences proposed. Each costs a solver
+  // query to prove, so only the ones closest to the inputs are kept.
+  int64_t max_candidate_equivalences = 1024;
+};
+
+// Returns the argument vectors on which to simulate the given function: corner
+// cases first, then options.random_vector_count random vectors. The corner
+// cases set every Bits leaf of every parameter to zero, all ones, one, only
+// the MSB (the most negative signed value) and all but the MSB (the most
+// positive signed value), and then set each parameter in turn to all ones
+// with the others zero.
+std::vector<std::vector<Value>> GenerateSimulationArguments(
+    Function* f, const SimulationOptions& options);
+
+// Appends the bits of the given value to "bits" in the order of
+// IrTranslator::FlattenValue(..., /*little_endian=*/true): aggregate elements
+// in order, and the bits of each Bits leaf from the MSB down.
+void AppendFlattenedBits(const Value& value, std::vector<bool>* bits);
+
+// Bitwise simulation signatures of a node: for each bit of the node's
+// flattened value (in the order of AppendFlattenedBits), a word holding the
+// bit's value on input vector i in bit i.
+using BitSignatures = std::vector<uint64_t>;
+
+// Evaluates every node of the function with the interpreter on each of the
+// given argument vectors (at most 64) and returns the nodes' signatures.
+absl::StatusOr<absl::flat_hash_map<Node*, BitSignatures>> ComputeSignatures(
+    Function* f, absl::Span<const std::vector<Value>> args);
+
+// The outcome of simulating two functions against each other.
+struct IrSimulationResult {
+  // Number of input vectors simulated.
+  int64_t vector_count = 0;
+
+  // The first input vector on which the functions' results differ, if any.
+  struct Counterexample {
+    std::vector<Value> args;
+    Value lhs_result;
+    Value rhs_result;
+  };
+  absl::optional<Counterexample> counterexample;
+
+  // If no counterexample was found: pairs of (lhs, rhs) nodes of the same
+  // type whose values agreed on every signature vector, in topological order
+  // of the rhs nodes. These are candidates only; they must be proved before
+  // being relied upon. Parameters and literals aren't proposed, as the
+  // solver already relates them directly. At most
+  // options.max_candidate_equivalences are proposed.
+  std::vector<std::pair<Node*, Node*>> candidate_equivalences;
+};
+
+// Compiles both functions, which must have the same parameter types, with the
+// JIT and compares their results on the vectors of GenerateSimulationArguments
+// (generated for "lhs"). Stops at the first mismatch.
+absl::StatusOr<IrSimulationResult> SimulateIrEquivalence(
+    Function* lhs, Function* rhs, const SimulationOptions& options);
+
+}  // namespace solvers
+}  // namespace xls
+
+#endif  // XLS_SOLVERS_RANDOM_SIMULATION_H_
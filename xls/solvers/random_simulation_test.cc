@@ -0,0 +1,181 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/solvers/random_simulation.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/ir_parser.h"
+#include "xls/ir/package.h"
+
+namespace xls {
+namespace solvers {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::Pair;
+
+TEST(RandomSimulationTest, CornerCasesPrecedeRandomVectors) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> package,
+                           Parser::ParsePackage(R"(
+package p
+
+fn main(x: bits[4], y: (bits[3], bits[1])) -> bits[4] {
+  ret identity.1: bits[4] = identity(x)
+}
+)"));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, package->EntryFunction());
+  SimulationOptions options;
+  options.random_vector_count = 10;
+  std::vector<std::vector<Value>> args =
+      GenerateSimulationArguments(f, options);
+
+  // Five uniform patterns, one vector per parameter, then the random ones.
+  ASSERT_EQ(args.size(), 5 + 2 + 10);
+  auto tuple = [](int64_t a, int64_t b) {
+    return Value::Tuple({Value(UBits(a, 3)), Value(UBits(b, 1))});
+  };
+  EXPECT_THAT(args[0], ElementsAre(Value(UBits(0, 4)), tuple(0, 0)));
+  EXPECT_THAT(args[1], ElementsAre(Value(UBits(0xf, 4)), tuple(7, 1)));
+  EXPECT_THAT(args[2], ElementsAre(Value(UBits(1, 4)), tuple(1, 1)));
+  EXPECT_THAT(args[3], ElementsAre(Value(UBits(8, 4)), tuple(4, 1)));
+  EXPECT_THAT(args[4], ElementsAre(Value(UBits(7, 4)), tuple(3, 0)));
+  EXPECT_THAT(args[5], ElementsAre(Value(UBits(0xf, 4)), tuple(0, 0)));
+  EXPECT_THAT(args[6], ElementsAre(Value(UBits(0, 4)), tuple(7, 1)));
+
+  // The random vectors are reproducible from the seed.
+  EXPECT_EQ(GenerateSimulationArguments(f, options), args);
+}
+
+TEST(RandomSimulationTest, FlattenedBitOrder) {
+  std::vector<bool> bits;
+  AppendFlattenedBits(
+      Value::Tuple({Value(UBits(0b100, 3)), Value(UBits(1, 1))}), &bits);
+  EXPECT_THAT(bits, ElementsAre(true, false, false, true));
+}
+
+TEST(RandomSimulationTest, ComputeSignatures) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> package,
+                           Parser::ParsePackage(R"(
+package p
+
+fn main(x: bits[2], y: bits[2]) -> bits[2] {
+  ret and.1: bits[2] = and(x, y)
+}
+)"));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, package->EntryFunction());
+  std::vector<std::vector<Value>> args = {
+      {Value(UBits(0b11, 2)), Value(UBits(0b01, 2))},
+      {Value(UBits(0b10, 2)), Value(UBits(0b11, 2))},
+  };
+  XLS_ASSERT_OK_AND_ASSIGN(auto signatures, ComputeSignatures(f, args));
+  // Bit signatures are listed from the MSB down; bit i of each word is the
+  // value on vector i.
+  EXPECT_THAT(signatures.at(f->return_value()), ElementsAre(0b10, 0b01));
+  EXPECT_THAT(signatures.at(f->param(0)), ElementsAre(0b11, 0b01));
+}
+
+TEST(RandomSimulationTest, FindsCornerCaseMismatch) {
+  // The functions only differ when x is the most negative value, which random
+  // vectors are unlikely to hit but the corner cases cover.
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> lhs_package,
+                           Parser::ParsePackage(R"(
+package lhs
+
+fn main(x: bits[32]) -> bits[32] {
+  ret neg.1: bits[32] = neg(x)
+}
+)"));
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> rhs_package,
+                           Parser::ParsePackage(R"(
+package rhs
+
+fn main(x: bits[32]) -> bits[32] {
+  neg.1: bits[32] = neg(x)
+  literal.2: bits[32] = literal(value=0x80000000)
+  eq.3: bits[1] = eq(x, literal.2)
+  literal.4: bits[32] = literal(value=0)
+  ret sel.5: bits[32] = sel(eq.3, cases=[neg.1, literal.4])
+}
+)"));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * lhs, lhs_package->EntryFunction());
+  XLS_ASSERT_OK_AND_ASSIGN(Function * rhs, rhs_package->EntryFunction());
+  SimulationOptions options;
+  XLS_ASSERT_OK_AND_ASSIGN(IrSimulationResult result,
+                           SimulateIrEquivalence(lhs, rhs, options));
+  ASSERT_TRUE(result.counterexample.has_value());
+  EXPECT_EQ(result.vector_count, 4);
+  EXPECT_THAT(result.counterexample->args,
+              ElementsAre(Value(UBits(0x80000000, 32))));
+  EXPECT_EQ(result.counterexample->lhs_result, Value(UBits(0x80000000, 32)));
+  EXPECT_EQ(result.counterexample->rhs_result, Value(UBits(0, 32)));
+  EXPECT_TRUE(result.candidate_equivalences.empty());
+}
+
+TEST(RandomSimulationTest, ProposesEquivalences) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> lhs_package,
+                           Parser::ParsePackage(R"(
+package lhs
+
+fn main(x: bits[8], y: bits[8]) -> bits[8] {
+  add.1: bits[8] = add(x, y)
+  ret neg.2: bits[8] = neg(add.1)
+}
+)"));
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> rhs_package,
+                           Parser::ParsePackage(R"(
+package rhs
+
+fn main(x: bits[8], y: bits[8]) -> bits[8] {
+  add.1: bits[8] = add(y, x)
+  literal.2: bits[8] = literal(value=0)
+  ret sub.3: bits[8] = sub(literal.2, add.1)
+}
+)"));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * lhs, lhs_package->EntryFunction());
+  XLS_ASSERT_OK_AND_ASSIGN(Function * rhs, rhs_package->EntryFunction());
+  SimulationOptions options;
+  options.random_vector_count = 256;
+  XLS_ASSERT_OK_AND_ASSIGN(IrSimulationResult result,
+                           SimulateIrEquivalence(lhs, rhs, options));
+  EXPECT_FALSE(result.counterexample.has_value());
+  EXPECT_EQ(result.vector_count, 5 + 2 + 256);
+  EXPECT_THAT(
+      result.candidate_equivalences,
+      ElementsAre(
+          Pair(lhs->GetNode("add.1").value(), rhs->GetNode("add.1").value()),
+          Pair(lhs->return_value(), rhs->return_value())));
+
+  // Only the candidates closest to the inputs are kept.
+  options.max_candidate_equivalences = 1;
+  XLS_ASSERT_OK_AND_ASSIGN(result, SimulateIrEquivalence(lhs, rhs, options));
+  EXPECT_THAT(result.candidate_equivalences,
+              ElementsAre(Pair(lhs->GetNode("add.1").value(),
+                               rhs->GetNode("add.1").value())));
+
+  options.signature_vector_count = 0;
+  XLS_ASSERT_OK_AND_ASSIGN(result, SimulateIrEquivalence(lhs, rhs, options));
+  EXPECT_TRUE(result.candidate_equivalences.empty());
+}
+
+}  // namespace
+}  // namespace solvers
+}  // namespace xls
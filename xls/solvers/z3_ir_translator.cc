@@ -14,6 +14,10 @@
 
 #include "xls/solvers/z3_ir_translator.h"
 
+#include <algorithm>
+#include <limits>
+#include <vector>
+
 #include "absl/debugging/leak_check.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -179,13 +183,17 @@ class Z3AbstractEvaluator
 
 absl::StatusOr<std::unique_ptr<IrTranslator>> IrTranslator::CreateAndTranslate(
     Function* function) {
-  Z3_config config = Z3_mk_config();
-  Z3_set_param_value(config, "proof", "true");
-  auto translator = absl::WrapUnique(new IrTranslator(config, function));
+  std::unique_ptr<IrTranslator> translator = Create(function);
   XLS_RETURN_IF_ERROR(function->Accept(translator.get()));
   return translator;
 }
 
+std::unique_ptr<IrTranslator> IrTranslator::Create(Function* function) {
+  Z3_config config = Z3_mk_config();
+  Z3_set_param_value(config, "proof", "true");
+  return absl::WrapUnique(new IrTranslator(config, function));
+}
+
 absl::StatusOr<std::unique_ptr<IrTranslator>> IrTranslator::CreateAndTranslate(
     Z3_context ctx, Function* function,
     absl::Span<const Z3_ast> imported_params) {
@@ -226,6 +234,25 @@ Z3_ast IrTranslator::GetTranslation(const Node* source) {
   return translations_.at(source);
 }
 
+absl::StatusOr<Z3_ast> IrTranslator::TranslateNode(Node* node) {
+  XLS_RET_CHECK_EQ(node->function_base(), xls_function_);
+  absl::Status status = node->Accept(this);
+  if (!status.ok()) {
+    // Accept() marks a node visited before translating it and leaves the
+    // users of a failing operand marked as traversing. Rewind the traversal
+    // state to the translated nodes so a later query reaching the failure
+    // reports it again rather than finding an untranslated node.
+    ResetVisitedState();
+    for (Node* n : xls_function_->nodes()) {
+      if (translations_.contains(n)) {
+        MarkVisited(n);
+      }
+    }
+    return status;
+  }
+  return GetValue(node);
+}
+
 Z3_ast IrTranslator::GetReturnNode() {
   return GetTranslation(xls_function_->return_value());
 }
@@ -1220,40 +1247,98 @@ absl::StatusOr<Z3_ast> PredicateToObjective(Predicate p, Z3_ast a,
 
 absl::StatusOr<bool> TryProve(Function* f, Node* subject, Predicate p,
                               absl::Duration timeout) {
-  XLS_ASSIGN_OR_RETURN(auto translator, IrTranslator::CreateAndTranslate(f));
-  translator->SetTimeout(timeout);
-  Z3_ast value = translator->GetTranslation(subject);
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<SolverSession> session,
+                       SolverSession::Create(f));
+  session->SetTimeout(timeout);
+  return session->TryProve(subject, p);
+}
+
+absl::StatusOr<std::unique_ptr<SolverSession>> SolverSession::Create(
+    Function* f) {
+  return absl::WrapUnique(new SolverSession(IrTranslator::Create(f)));
+}
+
+SolverSession::SolverSession(std::unique_ptr<IrTranslator> translator)
+    : translator_(std::move(translator)),
+      solver_(CreateSolver(translator_->ctx(), /*num_threads=*/1)) {}
 
+SolverSession::~SolverSession() { Z3_solver_dec_ref(ctx(), solver_); }
+
+void SolverSession::SetTimeout(absl::Duration timeout) {
+  // Z3 takes the timeout as an unsigned int of milliseconds, with UINT_MAX
+  // meaning no limit.
+  int64_t timeout_ms = std::min<int64_t>(
+      absl::ToInt64Milliseconds(timeout), std::numeric_limits<unsigned>::max());
+  Z3_params params = Z3_mk_params(ctx());
+  Z3_params_inc_ref(ctx(), params);
+  Z3_params_set_uint(ctx(), params, Z3_mk_string_symbol(ctx(), "timeout"),
+                     static_cast<unsigned>(timeout_ms));
+  Z3_solver_set_params(ctx(), solver_, params);
+  Z3_params_dec_ref(ctx(), params);
+}
+
+absl::StatusOr<absl::optional<Z3_ast>> SolverSession::NegatedPredicate(
+    Node* subject, Predicate p) {
   // All token types are equal.
   if (subject->GetType()->IsToken() &&
       p.kind() == PredicateKind::kEqualToNode &&
       p.node()->GetType()->IsToken()) {
-    return true;
+    return absl::nullopt;
   }
-  if (translator->GetValueKind(value) != Z3_BV_SORT) {
+  XLS_ASSIGN_OR_RETURN(Z3_ast value, translator_->TranslateNode(subject));
+  if (p.kind() == PredicateKind::kEqualToNode) {
+    XLS_RETURN_IF_ERROR(translator_->TranslateNode(p.node()).status());
+  }
+  if (translator_->GetValueKind(value) != Z3_BV_SORT) {
     return absl::InvalidArgumentError(
         "Cannot prove properties of non-bits-typed node: " +
         subject->ToString());
   }
-  XLS_ASSIGN_OR_RETURN(Z3_ast objective,
-                       PredicateToObjective(p, value, translator.get()));
-  Z3_context ctx = translator->ctx();
-  XLS_VLOG(2) << "objective:\n" << Z3_ast_to_string(ctx, objective);
-  Z3_solver solver = solvers::z3::CreateSolver(ctx, 1);
-  Z3_solver_assert(ctx, solver, objective);
-  Z3_lbool satisfiable = Z3_solver_check(ctx, solver);
-  XLS_VLOG(2) << solvers::z3::SolverResultToString(ctx, solver, satisfiable)
-              << std::endl;
-  Z3_solver_dec_ref(ctx, solver);
+  return PredicateToObjective(p, value, translator_.get());
+}
 
-  if (Z3_solver_check(ctx, solver) == Z3_L_FALSE) {
-    // We posit the inverse of the predicate we want to check -- when that is
-    // unsatisfiable, the predicate has been proven (there was no way found that
-    // we could not satisfy its inverse).
-    return true;
+absl::Status SolverSession::Assume(Node* node, Predicate p) {
+  XLS_ASSIGN_OR_RETURN(absl::optional<Z3_ast> negated,
+                       NegatedPredicate(node, p));
+  if (negated.has_value()) {
+    Z3_solver_assert(ctx(), solver_, Z3_mk_not(ctx(), negated.value()));
   }
+  return absl::OkStatus();
+}
 
-  return false;
+absl::StatusOr<bool> SolverSession::TryProve(
+    Node* subject, Predicate p,
+    absl::Span<const std::pair<Node*, Predicate>> assumptions) {
+  XLS_ASSIGN_OR_RETURN(absl::optional<Z3_ast> objective,
+                       NegatedPredicate(subject, p));
+  if (!objective.has_value()) {
+    return true;
+  }
+  std::vector<Z3_ast> assumed;
+  for (const auto& [node, predicate] : assumptions) {
+    XLS_ASSIGN_OR_RETURN(absl::optional<Z3_ast> negated,
+                         NegatedPredicate(node, predicate));
+    if (negated.has_value()) {
+      assumed.push_back(Z3_mk_not(ctx(), negated.value()));
+    }
+  }
+  XLS_VLOG(2) << "objective:\n" << Z3_ast_to_string(ctx(), objective.value());
+
+  // We posit the inverse of the predicate we want to check -- when that is
+  // unsatisfiable, the predicate has been proven (there was no way found that
+  // we could not satisfy its inverse).
+  Z3_solver_push(ctx(), solver_);
+  for (Z3_ast assumption : assumed) {
+    Z3_solver_assert(ctx(), solver_, assumption);
+  }
+  Z3_solver_assert(ctx(), solver_, objective.value());
+  Z3_lbool satisfiable = Z3_solver_check(ctx(), solver_);
+  ++query_count_;
+  XLS_VLOG(2) << solvers::z3::SolverResultToString(ctx(), solver_,
+                                                   satisfiable)
+              << std::endl;
+  Z3_solver_pop(ctx(), solver_, 1);
+  return satisfiable == Z3_L_FALSE;
 }
 
 }  // namespace z3
@@ -18,8 +18,14 @@
 #ifndef XLS_TOOLS_Z3_IR_TRANSLATOR_H_
 #define XLS_TOOLS_Z3_IR_TRANSLATOR_H_
 
+#include <cstdint>
+#include <memory>
+#include <utility>
+
 #include "absl/status/statusor.h"
 #include "absl/time/time.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
 #include "xls/common/logging/logging.h"
 #include "xls/data_structures/leaf_type_tree.h"
 #include "xls/ir/function.h"
@@ -55,8 +61,16 @@ class IrTranslator : public DfsVisitorWithDefault {
   static absl::StatusOr<std::unique_ptr<IrTranslator>> CreateAndTranslate(
       Z3_context ctx, Function* function,
       absl::Span<const Z3_ast> imported_params);
+
+  // Creates a translator for the given function without translating any of
+  // its nodes; they're translated on demand by TranslateNode().
+  static std::unique_ptr<IrTranslator> Create(Function* function);
   ~IrTranslator() override;
 
+  // Translates "node" and, transitively, its operands, skipping any that have
+  // already been translated, and returns the translation of "node".
+  absl::StatusOr<Z3_ast> TranslateNode(Node* node);
+
   // Sets the amount of time to allow Z3 to execute before aborting.
   void SetTimeout(absl::Duration timeout);
 
@@ -289,6 +303,50 @@ class Predicate {
 absl::StatusOr<bool> TryProve(Function* f, Node* subject, Predicate p,
                               absl::Duration timeout);
 
+// A persistent solver session over a single function, for callers that issue
+// many related queries on the same IR (e.g., proving each of a function's
+// assertions). Nodes are translated on first use and their translations are
+// kept for the life of the session, and each query runs in its own solver
+// scope (push/pop), so later queries reuse both the translation and whatever
+// the solver learned about it.
+class SolverSession {
+ public:
+  static absl::StatusOr<std::unique_ptr<SolverSession>> Create(Function* f);
+  ~SolverSession();
+
+  // Sets the time limit for each subsequent query.
+  void SetTimeout(absl::Duration timeout);
+
+  // Restricts all subsequent queries to inputs for which "node" satisfies
+  // "p".
+  absl::Status Assume(Node* node, Predicate p);
+
+  // Attempts to prove that "subject" satisfies "p" over all inputs that meet
+  // the session's assumptions and the given per-query assumptions, which are
+  // dropped once the query completes.
+  absl::StatusOr<bool> TryProve(
+      Node* subject, Predicate p,
+      absl::Span<const std::pair<Node*, Predicate>> assumptions = {});
+
+  // Number of queries posed to the solver so far.
+  int64_t query_count() const { return query_count_; }
+
+  IrTranslator* translator() { return translator_.get(); }
+  Z3_context ctx() { return translator_->ctx(); }
+
+ private:
+  explicit SolverSession(std::unique_ptr<IrTranslator> translator);
+
+  // Returns the negation of "p" applied to "subject", or nullopt if "p" holds
+  // trivially (tokens are all equal).
+  absl::StatusOr<absl::optional<Z3_ast>> NegatedPredicate(Node* subject,
+                                                          Predicate p);
+
+  std::unique_ptr<IrTranslator> translator_;
+  Z3_solver solver_;
+  int64_t query_count_ = 0;
+};
+
 }  // namespace z3
 }  // namespace solvers
 }  // namespace xls
@@ -31,8 +31,10 @@ namespace {
 
 using solvers::z3::IrTranslator;
 using solvers::z3::Predicate;
+using solvers::z3::SolverSession;
 using solvers::z3::TryProve;
 using status_testing::IsOkAndHolds;
+using status_testing::StatusIs;
 
 class Z3IrTranslatorTest : public IrTestBase {};
 
@@ -1630,5 +1632,79 @@ fn f() -> bits[64] {
   }
 }
 
+TEST_F(Z3IrTranslatorTest, SolverSessionScopesAssumptions) {
+  const std::string program = R"(
+package p
+
+fn f(x: bits[8], y: bits[8]) -> bits[8] {
+  ret result: bits[8] = and(x, y)
+}
+)";
+
+  XLS_ASSERT_OK_AND_ASSIGN(auto p, ParsePackage(program));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, p->GetFunction("f"));
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<SolverSession> session,
+                           SolverSession::Create(f));
+  Node* result = FindNode("result", p.get());
+  Node* x = FindNode("x", p.get());
+  Node* y = FindNode("y", p.get());
+
+  EXPECT_THAT(session->TryProve(result, Predicate::EqualToZero()),
+              IsOkAndHolds(false));
+  EXPECT_THAT(session->TryProve(result, Predicate::EqualToZero(),
+                                {{x, Predicate::EqualToZero()}}),
+              IsOkAndHolds(true));
+  // The per-query assumption doesn't outlive its query.
+  EXPECT_THAT(session->TryProve(result, Predicate::EqualToZero()),
+              IsOkAndHolds(false));
+
+  XLS_ASSERT_OK(session->Assume(y, Predicate::EqualToZero()));
+  EXPECT_THAT(session->TryProve(result, Predicate::EqualToZero()),
+              IsOkAndHolds(true));
+  EXPECT_THAT(session->TryProve(result, Predicate::EqualTo(y)),
+              IsOkAndHolds(true));
+  EXPECT_EQ(session->query_count(), 5);
+}
+
+TEST_F(Z3IrTranslatorTest, SolverSessionTranslatesOnDemand) {
+  // udiv has no translation, but only queries that depend on it fail.
+  const std::string program = R"(
+package p
+
+fn f(x: bits[8], y: bits[8]) -> bits[8] {
+  quotient: bits[8] = udiv(x, y)
+  scaled: bits[8] = umul(quotient, y)
+  ret difference: bits[8] = sub(x, x)
+}
+)";
+
+  XLS_ASSERT_OK_AND_ASSIGN(auto p, ParsePackage(program));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, p->GetFunction("f"));
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<SolverSession> session,
+                           SolverSession::Create(f));
+  Node* difference = FindNode("difference", p.get());
+  EXPECT_THAT(session->TryProve(difference, Predicate::EqualToZero()),
+              IsOkAndHolds(true));
+  Node* quotient = FindNode("quotient", p.get());
+  EXPECT_THAT(session->TryProve(quotient, Predicate::EqualToZero()),
+              StatusIs(absl::StatusCode::kUnimplemented));
+
+  // A failed translation is reported again by later queries reaching it.
+  EXPECT_THAT(session->TryProve(quotient, Predicate::EqualToZero()),
+              StatusIs(absl::StatusCode::kUnimplemented));
+  EXPECT_THAT(session->TryProve(FindNode("scaled", p.get()),
+                                Predicate::EqualToZero()),
+              StatusIs(absl::StatusCode::kUnimplemented));
+  EXPECT_THAT(session->TryProve(difference, Predicate::EqualToZero()),
+              IsOkAndHolds(true));
+
+  // Translations are cached across queries.
+  XLS_ASSERT_OK_AND_ASSIGN(Z3_ast translation,
+                           session->translator()->TranslateNode(difference));
+  XLS_ASSERT_OK_AND_ASSIGN(Z3_ast retranslation,
+                           session->translator()->TranslateNode(difference));
+  EXPECT_EQ(translation, retranslation);
+}
+
 }  // namespace
 }  // namespace xls
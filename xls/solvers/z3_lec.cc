@@ -14,18 +14,28 @@
 
 #include "xls/solvers/z3_lec.h"
 
+#include <algorithm>
+#include <limits>
 #include <thread>  // NOLINT(build/c++11)
 
 #include "absl/base/internal/sysinfo.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/match.h"
+#include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/strip.h"
+#include "absl/synchronization/mutex.h"
 #include "xls/codegen/vast.h"
 #include "xls/common/status/ret_check.h"
+#include "xls/common/thread_pool.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/ir/bits_ops.h"
+#include "xls/ir/node_iterator.h"
 #include "xls/ir/node_util.h"
+#include "xls/jit/ir_jit.h"
+#include "xls/netlist/compiled_netlist.h"
 #include "xls/solvers/z3_utils.h"
 #include "../z3/src/api/z3_api.h"
 
@@ -85,9 +95,7 @@ Lec::Lec(Package* ir_package, Function* ir_function, Netlist* netlist,
       stage_(stage) {}
 
 Lec::~Lec() {
-  if (model_) {
-    Z3_model_dec_ref(ctx(), model_.value());
-  }
+  ClearModel();
   if (solver_) {
     Z3_solver_dec_ref(ctx(), solver_.value());
   }
@@ -111,7 +119,6 @@ absl::Status Lec::Init() {
   // Helpful for reading result output.
   Z3_ast x = Z3_mk_const(ctx(), Z3_mk_string_symbol(ctx(), "X"),
                          Z3_mk_bv_sort(ctx(), 1));
-  std::vector<Z3_ast> eq_nodes;
   for (const Node* node : ir_output_nodes_) {
     // Extract the individual bits out of each IR output node, and match those
     // up the corresponding netlist bits. The netlist outputs do not contain
@@ -124,6 +131,8 @@ absl::Status Lec::Init() {
         /*little_endian=*/true);
     XLS_ASSIGN_OR_RETURN(std::vector<Z3_ast> netlist_bits,
                          GetNetlistZ3ForIr(node));
+    XLS_ASSIGN_OR_RETURN(std::vector<NetRef> netrefs,
+                         GetComparedNetrefs(node));
     XLS_RET_CHECK(ir_bits.size() == netlist_bits.size());
 
     for (int i = 0; i < ir_bits.size(); i++) {
@@ -135,17 +144,31 @@ absl::Status Lec::Init() {
       } else {
         ir_outputs_.push_back(ir_bits[i]);
         netlist_outputs_.push_back(netlist_bits[i]);
-        eq_nodes.push_back(Z3_mk_eq(ctx(), ir_bits[i], netlist_bits[i]));
+        compared_bits_.push_back(
+            {node, i, ir_bits[i], netlist_bits[i], netrefs[i]});
       }
     }
   }
+  BuildSolver();
+
+  return absl::OkStatus();
+}
 
+void Lec::BuildSolver() {
+  if (solver_) {
+    Z3_solver_dec_ref(ctx(), solver_.value());
+  }
+  std::vector<Z3_ast> eq_nodes;
+  for (const ComparedBit& bit : compared_bits_) {
+    eq_nodes.push_back(Z3_mk_eq(ctx(), bit.ir, bit.netlist));
+  }
   Z3_ast eval_node = Z3_mk_and(ctx(), eq_nodes.size(), eq_nodes.data());
   eval_node = Z3_mk_not(ctx(), eval_node);
   solver_ = CreateSolver(ctx(), std::thread::hardware_concurrency());
   Z3_solver_assert(ctx(), solver_.value(), eval_node);
-
-  return absl::OkStatus();
+  for (Z3_ast constraint : constraints_) {
+    Z3_solver_assert(ctx(), solver_.value(), constraint);
+  }
 }
 
 absl::Status Lec::CollectIrInputs() {
@@ -263,24 +286,509 @@ absl::Status Lec::AddConstraints(Function* constraints) {
   Z3_ast eq_node = Z3_mk_eq(ctx(), constraint_translator->GetReturnNode(),
                             Z3_mk_int(ctx(), 1, Z3_mk_bv_sort(ctx(), 1)));
   Z3_solver_assert(ctx(), solver_.value(), eq_node);
+  constraints_.push_back(eq_node);
+  constraint_functions_.push_back(constraints);
   return absl::OkStatus();
 }
 
-bool Lec::Run() {
+void Lec::ClearModel() {
+  if (model_) {
+    Z3_model_dec_ref(ctx(), model_.value());
+    model_.reset();
+  }
+}
+
+bool Lec::Run(absl::optional<absl::Duration> timeout) {
   XLS_LOG(INFO) << "Beginning execution";
-  satisfiable_ = Z3_solver_check(ctx(), solver_.value()) == Z3_L_TRUE;
+  ClearModel();
+  last_check_ = CheckKind::kSolver;
+  if (timeout.has_value()) {
+    Z3_params params = Z3_mk_params(ctx());
+    Z3_params_inc_ref(ctx(), params);
+    Z3_params_set_uint(
+        ctx(), params, Z3_mk_string_symbol(ctx(), "timeout"),
+        std::clamp<int64_t>(absl::ToInt64Milliseconds(timeout.value()), 1,
+                            std::numeric_limits<unsigned>::max()));
+    Z3_solver_set_params(ctx(), solver_.value(), params);
+    Z3_params_dec_ref(ctx(), params);
+  }
+  Z3_lbool result = Z3_solver_check(ctx(), solver_.value());
+  satisfiable_ = result == Z3_L_TRUE;
   if (satisfiable_) {
     model_ = Z3_solver_get_model(ctx(), solver_.value());
     Z3_model_inc_ref(ctx(), model_.value());
   }
-  return !satisfiable_;
+  return result == Z3_L_FALSE;
+}
+
+bool Lec::RunParallel(const ParallelLecOptions& options) {
+  XLS_LOG(INFO) << "Beginning partitioned execution";
+  ClearModel();
+  last_check_ = CheckKind::kPartitioned;
+  absl::optional<absl::Time> deadline;
+  if (options.timeout.has_value()) {
+    deadline = absl::Now() + options.timeout.value();
+  }
+
+  // One query per output bit, asserting that the IR and netlist values of the
+  // bit differ. Z3 hash-conses terms, so bits computing identical functions
+  // produce the same miter AST and can share a query.
+  std::vector<Z3_ast> queries;
+  std::vector<int64_t> bit_to_query;
+  absl::flat_hash_map<unsigned, int64_t> query_by_ast_id;
+  for (const ComparedBit& bit : compared_bits_) {
+    Z3_ast miter = Z3_mk_not(ctx(), Z3_mk_eq(ctx(), bit.ir, bit.netlist));
+    auto [it, inserted] =
+        query_by_ast_id.insert({Z3_get_ast_id(ctx(), miter), queries.size()});
+    if (inserted) {
+      queries.push_back(miter);
+    }
+    bit_to_query.push_back(it->second);
+  }
+
+  struct QueryResult {
+    ConeStatus status = ConeStatus::kUnknown;
+    bool structurally_equal = false;
+  };
+  std::vector<QueryResult> query_results(queries.size());
+
+  // State shared by the workers. Z3 contexts aren't thread-safe, so every
+  // access to ctx() (translating queries out and counterexamples back in) also
+  // happens under the lock.
+  struct {
+    absl::Mutex mutex;
+    int64_t next_query ABSL_GUARDED_BY(mutex) = 0;
+    bool stop ABSL_GUARDED_BY(mutex) = false;
+    std::vector<Z3_context> active_contexts ABSL_GUARDED_BY(mutex);
+  } shared;
+
+  auto worker = [&]() {
+    Z3_config config = Z3_mk_config();
+    Z3_context worker_ctx = Z3_mk_context(config);
+    Z3_del_config(config);
+    std::vector<Z3_ast> constraints;
+    {
+      absl::MutexLock lock(&shared.mutex);
+      shared.active_contexts.push_back(worker_ctx);
+      for (Z3_ast constraint : constraints_) {
+        constraints.push_back(Z3_translate(ctx(), constraint, worker_ctx));
+      }
+    }
+
+    // Cones are translated into the same context one after another, so
+    // subterms they have in common are only represented once.
+    while (true) {
+      int64_t index;
+      Z3_ast query;
+      {
+        absl::MutexLock lock(&shared.mutex);
+        if (shared.stop || shared.next_query == queries.size()) {
+          break;
+        }
+        index = shared.next_query++;
+        query = Z3_translate(ctx(), queries[index], worker_ctx);
+      }
+
+      // Cheap structural check before resorting to the solver: if the two
+      // cones simplify to the same term, the miter folds to false.
+      query = Z3_simplify(worker_ctx, query);
+      if (Z3_is_eq_ast(worker_ctx, query, Z3_mk_false(worker_ctx))) {
+        query_results[index] = {ConeStatus::kProved,
+                                /*structurally_equal=*/true};
+        continue;
+      }
+
+      Z3_solver solver = CreateSolver(worker_ctx, /*num_threads=*/1);
+      if (deadline.has_value()) {
+        int64_t remaining_ms = std::min<int64_t>(
+            absl::ToInt64Milliseconds(deadline.value() - absl::Now()),
+            std::numeric_limits<unsigned>::max());
+        if (remaining_ms <= 0) {
+          Z3_solver_dec_ref(worker_ctx, solver);
+          break;
+        }
+        Z3_params params = Z3_mk_params(worker_ctx);
+        Z3_params_inc_ref(worker_ctx, params);
+        Z3_params_set_uint(worker_ctx, params,
+                           Z3_mk_string_symbol(worker_ctx, "timeout"),
+                           remaining_ms);
+        Z3_solver_set_params(worker_ctx, solver, params);
+        Z3_params_dec_ref(worker_ctx, params);
+      }
+      Z3_solver_assert(worker_ctx, solver, query);
+      for (Z3_ast constraint : constraints) {
+        Z3_solver_assert(worker_ctx, solver, constraint);
+      }
+
+      Z3_lbool result = Z3_solver_check(worker_ctx, solver);
+      if (result == Z3_L_FALSE) {
+        query_results[index].status = ConeStatus::kProved;
+      } else if (result == Z3_L_TRUE) {
+        query_results[index].status = ConeStatus::kFailed;
+        Z3_model model = Z3_solver_get_model(worker_ctx, solver);
+        Z3_model_inc_ref(worker_ctx, model);
+        absl::MutexLock lock(&shared.mutex);
+        if (!model_.has_value()) {
+          model_ = Z3_model_translate(worker_ctx, model, ctx());
+          Z3_model_inc_ref(ctx(), model_.value());
+        }
+        if (options.stop_at_first_failure) {
+          shared.stop = true;
+          for (Z3_context other_ctx : shared.active_contexts) {
+            if (other_ctx != worker_ctx) {
+              Z3_interrupt(other_ctx);
+            }
+          }
+        }
+        Z3_model_dec_ref(worker_ctx, model);
+      }
+      Z3_solver_dec_ref(worker_ctx, solver);
+    }
+
+    {
+      absl::MutexLock lock(&shared.mutex);
+      shared.active_contexts.erase(std::find(shared.active_contexts.begin(),
+                                             shared.active_contexts.end(),
+                                             worker_ctx));
+    }
+    Z3_del_context(worker_ctx);
+  };
+
+  int64_t worker_count = std::min<int64_t>(
+      std::max<int64_t>(options.thread_count, 1), queries.size());
+  if (worker_count > 0) {
+    ThreadPool pool(worker_count);
+    for (int64_t i = 0; i < worker_count; ++i) {
+      pool.Schedule(worker);
+    }
+    pool.WaitForIdle();
+  }
+
+  cone_results_.clear();
+  bool all_proved = true;
+  for (int64_t i = 0; i < compared_bits_.size(); ++i) {
+    const QueryResult& result = query_results[bit_to_query[i]];
+    cone_results_.push_back({compared_bits_[i].node,
+                             compared_bits_[i].bit_index, result.status,
+                             result.structurally_equal});
+    all_proved &= result.status == ConeStatus::kProved;
+  }
+  satisfiable_ = model_.has_value();
+  return all_proved;
+}
+
+absl::StatusOr<bool> Lec::Simulate(const SimulationOptions& options,
+                                   absl::Duration candidate_timeout,
+                                   absl::Time deadline) {
+  XLS_RET_CHECK(!CheckingSingleStage(schedule_, stage_))
+      << "Simulation is only supported for whole-function checks.";
+  XLS_LOG(INFO) << "Beginning simulation";
+  ClearModel();
+  last_check_ = CheckKind::kSimulation;
+  satisfiable_ = false;
+
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<IrJit> jit,
+                       IrJit::Create(ir_function_));
+  std::vector<std::unique_ptr<IrJit>> constraint_jits;
+  for (Function* constraints : constraint_functions_) {
+    XLS_ASSIGN_OR_RETURN(std::unique_ptr<IrJit> constraint_jit,
+                         IrJit::Create(constraints));
+    constraint_jits.push_back(std::move(constraint_jit));
+  }
+
+  // Flops are evaluated as pass-throughs, matching the netlist translation,
+  // and the input registers' outputs are pinned to the IR inputs' values.
+  netlist::CompiledNetlist compiled_netlist(netlist_);
+  XLS_ASSIGN_OR_RETURN(const netlist::CompiledModule* module,
+                       compiled_netlist.GetModule(module_));
+  struct InputNet {
+    int32_t net;
+    int64_t param_index;
+    int64_t bit_index;
+  };
+  std::vector<InputNet> input_nets;
+  std::vector<bool> pinned(module->net_count(), false);
+  for (int64_t i = 0; i < ir_function_->params().size(); ++i) {
+    for (const auto& [netref, bit_index] :
+         GetNetlistInputBits(ir_function_->param(i))) {
+      XLS_ASSIGN_OR_RETURN(int32_t net, module->GetNetIndex(netref));
+      input_nets.push_back({net, i, bit_index});
+      pinned[net] = true;
+    }
+  }
+  std::vector<int32_t> output_nets;
+  for (const ComparedBit& bit : compared_bits_) {
+    XLS_ASSIGN_OR_RETURN(int32_t net, module->GetNetIndex(bit.netref));
+    output_nets.push_back(net);
+  }
+
+  // Evaluates the netlist on up to 64 argument vectors at once.
+  auto evaluate_netlist = [&](absl::Span<const std::vector<Value>> args)
+      -> absl::StatusOr<std::vector<uint64_t>> {
+    std::vector<std::vector<bool>> param_bits(ir_function_->params().size());
+    std::vector<uint64_t> values = module->NewState<uint64_t>();
+    for (int64_t lane = 0; lane < args.size(); ++lane) {
+      for (int64_t i = 0; i < param_bits.size(); ++i) {
+        param_bits[i].clear();
+        AppendFlattenedBits(args[lane][i], &param_bits[i]);
+      }
+      for (const InputNet& input : input_nets) {
+        values[input.net] |=
+            static_cast<uint64_t>(param_bits[input.param_index]
+                                            [input.bit_index])
+            << lane;
+      }
+    }
+    XLS_RETURN_IF_ERROR(module->EvaluateWithPinnedNets(&values, pinned));
+    return values;
+  };
+
+  std::vector<std::vector<Value>> args =
+      GenerateSimulationArguments(ir_function_, options);
+  simulated_vector_count_ = 0;
+  std::vector<bool> result_bits;
+  for (int64_t start = 0; start < args.size(); start += 64) {
+    absl::Span<const std::vector<Value>> batch =
+        absl::MakeConstSpan(args).subspan(start, 64);
+    XLS_ASSIGN_OR_RETURN(std::vector<uint64_t> values,
+                         evaluate_netlist(batch));
+    std::vector<uint64_t> ir_words(compared_bits_.size(), 0);
+    uint64_t valid_lanes = 0;
+    for (int64_t lane = 0; lane < batch.size(); ++lane) {
+      bool valid = true;
+      for (const std::unique_ptr<IrJit>& constraint_jit : constraint_jits) {
+        XLS_ASSIGN_OR_RETURN(InterpreterResult<Value> satisfied,
+                             constraint_jit->Run(batch[lane]));
+        valid &= satisfied.value.bits().IsOne();
+      }
+      if (!valid) {
+        continue;
+      }
+      valid_lanes |= uint64_t{1} << lane;
+      XLS_ASSIGN_OR_RETURN(InterpreterResult<Value> result,
+                           jit->Run(batch[lane]));
+      result_bits.clear();
+      AppendFlattenedBits(result.value, &result_bits);
+      for (int64_t i = 0; i < compared_bits_.size(); ++i) {
+        ir_words[i] |= static_cast<uint64_t>(
+                           result_bits[compared_bits_[i].bit_index])
+                       << lane;
+      }
+    }
+    simulated_vector_count_ += batch.size();
+
+    uint64_t mismatched_lanes = 0;
+    for (int64_t i = 0; i < compared_bits_.size(); ++i) {
+      mismatched_lanes |= (ir_words[i] ^ values[output_nets[i]]) & valid_lanes;
+    }
+    if (mismatched_lanes != 0) {
+      int64_t lane = 0;
+      while (((mismatched_lanes >> lane) & 1) == 0) {
+        ++lane;
+      }
+      failing_vector_ = start + lane;
+      XLS_RETURN_IF_ERROR(SetModelFromArguments(batch[lane]));
+      satisfiable_ = true;
+      return false;
+    }
+  }
+  XLS_VLOG(1) << "No mismatch in " << simulated_vector_count_
+              << " simulated vectors";
+
+  int64_t signature_vector_count = std::min<int64_t>(
+      {options.signature_vector_count, 64, static_cast<int64_t>(args.size())});
+  if (signature_vector_count == 0) {
+    return true;
+  }
+
+  // Propose IR node bits and netlist nets with equal signatures as
+  // equivalence points. As with SimulateIrEquivalence(), the signature vectors
+  // are the last (random) ones. Nets that look constant are skipped: they'd
+  // match too many IR bits, and the solver handles constants well anyway.
+  absl::Span<const std::vector<Value>> signature_args =
+      absl::MakeConstSpan(args).last(signature_vector_count);
+  XLS_ASSIGN_OR_RETURN(auto ir_signatures,
+                       ComputeSignatures(ir_function_, signature_args));
+  XLS_ASSIGN_OR_RETURN(std::vector<uint64_t> net_signatures,
+                       evaluate_netlist(signature_args));
+  uint64_t lane_mask = signature_vector_count == 64
+                           ? std::numeric_limits<uint64_t>::max()
+                           : (uint64_t{1} << signature_vector_count) - 1;
+  absl::flat_hash_map<uint64_t, NetRef> net_by_signature;
+  for (int32_t net = 0; net < module->net_count(); ++net) {
+    uint64_t signature = net_signatures[net];
+    if (!pinned[net] && signature != 0 && signature != lane_mask) {
+      net_by_signature.insert({signature, module_->nets()[net].get()});
+    }
+  }
+
+  std::vector<std::pair<Z3_ast, Z3_ast>> candidates;
+  absl::flat_hash_set<NetRef> proposed_nets;
+  for (Node* node : TopoSort(ir_function_)) {
+    if (candidates.size() >= options.max_candidate_equivalences) {
+      break;
+    }
+    if (node->Is<Param>() || node->Is<Literal>()) {
+      continue;
+    }
+    std::vector<Z3_ast> ir_bits;
+    const BitSignatures& signatures = ir_signatures.at(node);
+    for (int64_t i = 0; i < signatures.size() &&
+                        candidates.size() < options.max_candidate_equivalences;
+         ++i) {
+      auto it = net_by_signature.find(signatures[i]);
+      if (it == net_by_signature.end() ||
+          !proposed_nets.insert(it->second).second) {
+        continue;
+      }
+      absl::StatusOr<Z3_ast> net_translation =
+          netlist_translator_->GetTranslation(it->second);
+      if (!net_translation.ok()) {
+        continue;
+      }
+      if (ir_bits.empty()) {
+        ir_bits = ir_translator_->FlattenValue(
+            node->GetType(), ir_translator_->GetTranslation(node),
+            /*little_endian=*/true);
+      }
+      candidates.push_back({net_translation.value(), ir_bits[i]});
+    }
+  }
+
+  std::vector<std::pair<Z3_ast, Z3_ast>> proved =
+      ProveEquivalences(ctx(), candidates, constraints_, candidate_timeout,
+                        deadline);
+  XLS_VLOG(1) << "Proved " << proved.size() << " of " << candidates.size()
+              << " candidate equivalence points";
+  equivalence_point_count_ += proved.size();
+  if (!proved.empty()) {
+    std::vector<Z3_ast> from;
+    std::vector<Z3_ast> to;
+    for (const auto& [netlist_term, ir_term] : proved) {
+      from.push_back(netlist_term);
+      to.push_back(ir_term);
+    }
+    for (ComparedBit& bit : compared_bits_) {
+      bit.netlist = Z3_substitute(ctx(), bit.netlist, from.size(),
+                                  from.data(), to.data());
+    }
+    BuildSolver();
+  }
+  return true;
+}
+
+absl::Status Lec::SetModelFromArguments(absl::Span<const Value> args) {
+  XLS_RET_CHECK_EQ(args.size(), ir_function_->params().size());
+  Z3_solver solver = CreateSolver(ctx(), /*num_threads=*/1);
+  Z3_sort bit_sort = Z3_mk_bv_sort(ctx(), 1);
+  std::vector<bool> arg_bits;
+  for (int64_t i = 0; i < args.size(); ++i) {
+    Param* param = ir_function_->param(i);
+    std::vector<Z3_ast> param_bits = ir_translator_->FlattenValue(
+        param->GetType(), ir_translator_->GetTranslation(param),
+        /*little_endian=*/true);
+    arg_bits.clear();
+    AppendFlattenedBits(args[i], &arg_bits);
+    XLS_RET_CHECK_EQ(param_bits.size(), arg_bits.size());
+    for (int64_t j = 0; j < param_bits.size(); ++j) {
+      Z3_solver_assert(
+          ctx(), solver,
+          Z3_mk_eq(ctx(), param_bits[j],
+                   Z3_mk_int(ctx(), arg_bits[j] ? 1 : 0, bit_sort)));
+    }
+  }
+  Z3_lbool result = Z3_solver_check(ctx(), solver);
+  if (result == Z3_L_TRUE) {
+    model_ = Z3_solver_get_model(ctx(), solver);
+    Z3_model_inc_ref(ctx(), model_.value());
+  }
+  Z3_solver_dec_ref(ctx(), solver);
+  XLS_RET_CHECK(result == Z3_L_TRUE);
+  return absl::OkStatus();
+}
+
+std::string Lec::ConeResultsToString() {
+  int64_t proved = 0;
+  int64_t structurally_equal = 0;
+  int64_t failed = 0;
+  int64_t unknown = 0;
+  for (const ConeResult& result : cone_results_) {
+    switch (result.status) {
+      case ConeStatus::kProved:
+        ++proved;
+        structurally_equal += result.structurally_equal ? 1 : 0;
+        break;
+      case ConeStatus::kFailed:
+        ++failed;
+        break;
+      case ConeStatus::kUnknown:
+        ++unknown;
+        break;
+    }
+  }
+  std::vector<std::string> output;
+  output.push_back(absl::StrFormat(
+      "Partitioned result; %d output bits: %d proved (%d structurally), "
+      "%d failed, %d unknown",
+      cone_results_.size(), proved, structurally_equal, failed, unknown));
+
+  // Results are grouped by node, since bits of the same node are contiguous.
+  for (int64_t i = 0; i < cone_results_.size();) {
+    const Node* node = cone_results_[i].node;
+    std::vector<int64_t> failed_bits;
+    std::vector<int64_t> unknown_bits;
+    for (; i < cone_results_.size() && cone_results_[i].node == node; ++i) {
+      if (cone_results_[i].status == ConeStatus::kFailed) {
+        failed_bits.push_back(cone_results_[i].bit_index);
+      } else if (cone_results_[i].status == ConeStatus::kUnknown) {
+        unknown_bits.push_back(cone_results_[i].bit_index);
+      }
+    }
+    std::string status = "proved";
+    if (!failed_bits.empty()) {
+      status = absl::StrCat("FAILED (bits ", absl::StrJoin(failed_bits, ", "),
+                            ")");
+    } else if (!unknown_bits.empty()) {
+      status = absl::StrCat("unknown (bits ",
+                            absl::StrJoin(unknown_bits, ", "), ")");
+    }
+    output.push_back(absl::StrCat("  ", node->GetName(), ": ", status));
+  }
+
+  if (satisfiable_) {
+    output.push_back(absl::StrCat(
+        "\n  Model:\n",
+        HexifyOutput(Z3_model_to_string(ctx(), model_.value()))));
+  }
+  return absl::StrJoin(output, "\n");
 }
 
 std::string Lec::ResultToString() {
   std::vector<std::string> output;
-  output.push_back(SolverResultToString(ctx(), solver_.value(),
-                                        satisfiable_ ? Z3_L_TRUE : Z3_L_FALSE,
-                                        /*hexify=*/true));
+  switch (last_check_) {
+    case CheckKind::kSolver:
+      output.push_back(SolverResultToString(
+          ctx(), solver_.value(), satisfiable_ ? Z3_L_TRUE : Z3_L_FALSE,
+          /*hexify=*/true));
+      break;
+    case CheckKind::kPartitioned:
+      output.push_back(ConeResultsToString());
+      break;
+    case CheckKind::kSimulation:
+      if (satisfiable_) {
+        output.push_back(absl::StrFormat(
+            "Simulation result; mismatch on vector %d of %d simulated\n\n"
+            "  Model:\n%s",
+            failing_vector_, simulated_vector_count_,
+            HexifyOutput(Z3_model_to_string(ctx(), model_.value()))));
+      } else {
+        output.push_back(absl::StrFormat(
+            "Simulation result; no mismatch in %d vectors, %d equivalence "
+            "points",
+            simulated_vector_count_, equivalence_point_count_));
+      }
+      break;
+  }
   if (satisfiable_) {
     for (const Node* node : ir_output_nodes_) {
       std::pair<std::string, std::string> outputs = GetComparisonStrings(node);
@@ -329,57 +837,60 @@ absl::Status Lec::BindNetlistInputs() {
 absl::flat_hash_map<std::string, Z3_ast> Lec::FlattenNetlistInputs() {
   absl::flat_hash_map<std::string, Z3_ast> netlist_inputs;
   for (const auto& pair : input_mapping_) {
-    // We need to reverse the entire bits vector, per item 1 in the header
-    // description, and we need to pass true as little_endian to FlattenValue
-    // per item 2.
     const Node* node = pair.first;
     Z3_ast translation = pair.second;
     std::vector<Z3_ast> bits = ir_translator_->FlattenValue(
         node->GetType(), translation, /*little_endian=*/true);
-    std::reverse(bits.begin(), bits.end());
-    for (int i = 0; i < bits.size(); i++) {
-      // We have a flat IR node that's our input; we need to find the matching
-      // cells and use their outputs.
-      std::string name;
-      if (bits.size() == 1) {
-        name = NodeToNetlistName(node, absl::nullopt);
-      } else {
-        name = NodeToNetlistName(node, i);
-      }
-
-      // Get the cell...
-      auto status_or_cell = module_->ResolveCell(name);
-      if (!status_or_cell.ok()) {
-        XLS_VLOG(3) << "Could not resolve input cell: " << name << "; skipping";
-        XLS_LOG(INFO) << "Could not resolve input cell: " << name
-                      << "; skipping";
-        continue;
-      }
-
-      // Then plop its output in.
-      for (const auto& output : status_or_cell.value()->outputs()) {
-        netlist_inputs[output.netref->name()] = bits[i];
-      }
+    for (const auto& [netref, bit_index] : GetNetlistInputBits(node)) {
+      netlist_inputs[netref->name()] = bits[bit_index];
     }
   }
 
   return netlist_inputs;
 }
 
+std::vector<std::pair<NetRef, int64_t>> Lec::GetNetlistInputBits(
+    const Node* node) {
+  std::vector<std::pair<NetRef, int64_t>> input_bits;
+  // We need to reverse the entire bits vector, per item 1 in the header
+  // description, and we need to pass true as little_endian to FlattenValue
+  // per item 2; netlist bit i is flattened bit (bit_count - 1 - i).
+  int64_t bit_count = node->GetType()->GetFlatBitCount();
+  for (int i = 0; i < bit_count; i++) {
+    // We have a flat IR node that's our input; we need to find the matching
+    // cells and use their outputs.
+    std::string name;
+    if (bit_count == 1) {
+      name = NodeToNetlistName(node, absl::nullopt);
+    } else {
+      name = NodeToNetlistName(node, i);
+    }
+
+    // Get the cell...
+    auto status_or_cell = module_->ResolveCell(name);
+    if (!status_or_cell.ok()) {
+      XLS_VLOG(3) << "Could not resolve input cell: " << name << "; skipping";
+      XLS_LOG(INFO) << "Could not resolve input cell: " << name
+                    << "; skipping";
+      continue;
+    }
+
+    // Then plop its output in.
+    for (const auto& output : status_or_cell.value()->outputs()) {
+      input_bits.push_back({output.netref, bit_count - 1 - i});
+    }
+  }
+  return input_bits;
+}
+
 absl::StatusOr<std::vector<Z3_ast>> Lec::GetNetlistZ3ForIr(const Node* node) {
   std::vector<Z3_ast> netlist_output;
 
-  XLS_ASSIGN_OR_RETURN(std::vector<NetRef> netrefs, GetIrNetrefs(node));
+  XLS_ASSIGN_OR_RETURN(std::vector<NetRef> netrefs, GetComparedNetrefs(node));
   netlist_output.reserve(netrefs.size());
   for (const auto& netref : netrefs) {
     if (netref == nullptr) {
       netlist_output.push_back(nullptr);
-    } else if (netref->name() == "output_valid") {
-      // Drop output wires not part of the original signature.
-      // TODO(rspringer): These special wires aren't necessarily fixed - they're
-      // specified by codegen, and could change in the future. These need to be
-      // properly handled (i.e., not hardcoded).
-      continue;
     } else {
       XLS_ASSIGN_OR_RETURN(Z3_ast z3_output,
                            netlist_translator_->GetTranslation(netref));
@@ -389,6 +900,21 @@ absl::StatusOr<std::vector<Z3_ast>> Lec::GetNetlistZ3ForIr(const Node* node) {
   return netlist_output;
 }
 
+absl::StatusOr<std::vector<NetRef>> Lec::GetComparedNetrefs(const Node* node) {
+  XLS_ASSIGN_OR_RETURN(std::vector<NetRef> netrefs, GetIrNetrefs(node));
+  // Drop output wires not part of the original signature.
+  // TODO(rspringer): These special wires aren't necessarily fixed - they're
+  // specified by codegen, and could change in the future. These need to be
+  // properly handled (i.e., not hardcoded).
+  netrefs.erase(std::remove_if(netrefs.begin(), netrefs.end(),
+                               [](NetRef netref) {
+                                 return netref != nullptr &&
+                                        netref->name() == "output_valid";
+                               }),
+                netrefs.end());
+  return netrefs;
+}
+
 absl::Status Lec::CreateNetlistTranslator() {
   absl::flat_hash_map<std::string, const Module*> module_refs;
   for (const std::unique_ptr<Module>& module : netlist_->modules()) {
@@ -15,15 +15,21 @@
 #ifndef XLS_SOLVERS_Z3_LEC_H_
 #define XLS_SOLVERS_Z3_LEC_H_
 
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/time/time.h"
 #include "absl/types/optional.h"
+#include "absl/types/span.h"
 #include "xls/ir/package.h"
 #include "xls/netlist/netlist.h"
 #include "xls/scheduling/pipeline_schedule.h"
+#include "xls/solvers/random_simulation.h"
 #include "xls/solvers/z3_ir_translator.h"
 #include "xls/solvers/z3_netlist_translator.h"
 
@@ -48,6 +54,41 @@ struct LecParams {
   std::string netlist_module_name;
 };
 
+// Options for Lec::RunParallel().
+struct ParallelLecOptions {
+  // Number of worker threads; each owns a Z3 context and checks one cone at a
+  // time.
+  int64_t thread_count = 1;
+
+  // Limit on the wall-clock time of the whole check. Cones still unresolved
+  // when it expires are reported as ConeStatus::kUnknown.
+  absl::optional<absl::Duration> timeout;
+
+  // If true, the check is abandoned as soon as any cone fails; the remaining
+  // cones are reported as ConeStatus::kUnknown.
+  bool stop_at_first_failure = true;
+};
+
+// The outcome of checking a single output bit's cone.
+enum class ConeStatus {
+  kProved,
+  kFailed,
+  // The solver timed out or the cone was abandoned.
+  kUnknown,
+};
+
+// Result for one output bit of a Lec::RunParallel() check.
+struct ConeResult {
+  // The IR output node and the index of the bit within its (little-endian)
+  // flattened value.
+  const Node* node;
+  int64_t bit_index;
+  ConeStatus status;
+  // True if the IR and netlist cones simplified to the same term, so that no
+  // solver query was needed.
+  bool structurally_equal;
+};
+
 // Class for performing logical equivalence checks between a function specified
 // in XLS IR (perhaps converted from DSLX) and a netlist.
 class Lec {
@@ -73,8 +114,48 @@ class Lec {
   // Constraints can not be currently specified with per-stage evaluation.
   absl::Status AddConstraints(Function* constraints);
 
-  // Returns true of the netlist and IR are proved to be equivalent.
-  bool Run();
+  // Returns true of the netlist and IR are proved to be equivalent. If
+  // "timeout" is given and expires before the query is resolved, returns false
+  // without a counterexample (see satisfiable()).
+  bool Run(absl::optional<absl::Duration> timeout = absl::nullopt);
+
+  // As Run(), but rather than posing a single query over every output, checks
+  // each output bit's cone as an independent query. Queries are spread across
+  // options.thread_count threads, each with its own Z3 context, which keeps
+  // the per-query problems small and lets them proceed concurrently. Output
+  // bits whose cones are structurally identical share a query. On failure, the
+  // counterexample is available through ResultToString() and DumpIrTree(), as
+  // with Run(). Returns true iff every cone was proved equivalent.
+  bool RunParallel(const ParallelLecOptions& options);
+
+  // The per-output-bit results of the last RunParallel() call, in output
+  // order.
+  absl::Span<const ConeResult> cone_results() const { return cone_results_; }
+
+  // Returns true if the last Run(), RunParallel() or Simulate() call found an
+  // input on which the IR and netlist differ.
+  bool satisfiable() const { return satisfiable_; }
+
+  // A cheap search for counterexamples to run before Run() or RunParallel():
+  // simulates the IR function with the JIT and the netlist with the compiled
+  // netlist evaluator (64 vectors at a time) on the vectors of
+  // GenerateSimulationArguments(). Only whole-function checks are supported.
+  //
+  // Returns false if a compared output bit differs on a vector satisfying the
+  // constraints; the counterexample is then available through
+  // ResultToString() and DumpIrTree(), as with Run(). Otherwise returns true
+  // and, unless options.signature_vector_count is zero, proposes IR node bits
+  // and netlist nets whose simulated values agree as internal equivalence
+  // points. Each one proved within "candidate_timeout" (and before
+  // "deadline") has its netlist term replaced by the IR term in the queries of
+  // later Run() and RunParallel() calls, so the solver sees the two sides'
+  // shared structure directly.
+  absl::StatusOr<bool> Simulate(const SimulationOptions& options,
+                                absl::Duration candidate_timeout,
+                                absl::Time deadline = absl::InfiniteFuture());
+
+  // The number of internal equivalence points established by Simulate().
+  int64_t equivalence_point_count() const { return equivalence_point_count_; }
 
   // Dumps all Z3 values corresponding to IR nodes in the input function.
   void DumpIrTree();
@@ -104,6 +185,10 @@ class Lec {
   // Connects IR Params to netlist inputs.
   absl::Status BindNetlistInputs();
 
+  // (Re)creates solver_, asserting that some compared bit differs, along with
+  // the constraints.
+  void BuildSolver();
+
   // Explodes each param into individual bits. XLS IR and parsed netlist data
   // layouts are different in that:
   //  1) Netlists list input values from high-to-low bit, i.e.,
@@ -113,11 +198,22 @@ class Lec {
   //  input_value_0_ will be the LSB.
   absl::flat_hash_map<std::string, Z3_ast> FlattenNetlistInputs();
 
+  // Returns the netlist nets standing for the bits of the given input node,
+  // per the above, each paired with the index of the bit within the node's
+  // flattened value (as returned by FlattenValue(..., little_endian=true)).
+  std::vector<std::pair<netlist::rtl::NetRef, int64_t>> GetNetlistInputBits(
+      const Node* node);
+
   // The opposite of BindNetlistInputs - given the output nodes from the
   // stage, collect the corresponding NetRefs and use them to reconstruct
   // the composite output value.
   absl::StatusOr<std::vector<Z3_ast>> GetNetlistZ3ForIr(const Node* node);
 
+  // The NetRefs behind GetNetlistZ3ForIr(): those of GetIrNetrefs() less the
+  // wires that aren't part of the original signature.
+  absl::StatusOr<std::vector<netlist::rtl::NetRef>> GetComparedNetrefs(
+      const Node* node);
+
   // Retrieves the set of NetRefs corresponding to the output value of the given
   // node.
   absl::StatusOr<std::vector<netlist::rtl::NetRef>> GetIrNetrefs(
@@ -137,6 +233,25 @@ class Lec {
   void MarkDontCareBits(const std::vector<Z3_ast>& nl_bits,
                         std::string& nl_string);
 
+  // Summarizes cone_results_ per output node, for ResultToString().
+  std::string ConeResultsToString();
+
+  // Sets model_ to an assignment of the IR inputs to the given values.
+  absl::Status SetModelFromArguments(absl::Span<const Value> args);
+
+  // Releases the model from a previous Run() or RunParallel(), if any.
+  void ClearModel();
+
+  // An output bit present in both the IR and the netlist, i.e., one that's
+  // actually compared.
+  struct ComparedBit {
+    const Node* node;
+    int64_t bit_index;
+    Z3_ast ir;
+    Z3_ast netlist;
+    netlist::rtl::NetRef netref;
+  };
+
   Package* ir_package_;
   Function* ir_function_;
   std::unique_ptr<IrTranslator> ir_translator_;
@@ -151,6 +266,14 @@ class Lec {
   std::vector<const Node*> ir_output_nodes_;
   std::vector<Z3_ast> ir_outputs_;
   std::vector<Z3_ast> netlist_outputs_;
+  std::vector<ComparedBit> compared_bits_;
+
+  // Constraints added by AddConstraints(); RunParallel() must re-assert them
+  // for each query. Simulate() evaluates the functions they came from.
+  std::vector<Z3_ast> constraints_;
+  std::vector<Function*> constraint_functions_;
+
+  int64_t equivalence_point_count_ = 0;
 
   absl::optional<PipelineSchedule> schedule_;
   int stage_;
@@ -163,6 +286,15 @@ class Lec {
   // value is more understandable.
   bool satisfiable_;
   absl::optional<Z3_model> model_;
+
+  // How the result of the last check was obtained.
+  enum class CheckKind { kSolver, kPartitioned, kSimulation };
+  CheckKind last_check_ = CheckKind::kSolver;
+  std::vector<ConeResult> cone_results_;
+  // For CheckKind::kSimulation, the index of the failing vector and the number
+  // of vectors simulated.
+  int64_t failing_vector_ = 0;
+  int64_t simulated_vector_count_ = 0;
 };
 
 }  // namespace z3
@@ -17,6 +17,7 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/status/statusor.h"
+#include "absl/time/time.h"
 #include "xls/common/status/matchers.h"
 #include "xls/ir/ir_parser.h"
 #include "xls/netlist/cell_library.h"
@@ -30,6 +31,9 @@ namespace z3 {
 namespace {
 
 using netlist::rtl::Netlist;
+using status_testing::IsOkAndHolds;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
 
 absl::StatusOr<bool> Match(const std::string& ir_text,
                            const std::string& netlist_text, bool expect_equal) {
@@ -463,6 +467,185 @@ endmodule
   }
 }
 
+constexpr const char kNotIr[] = R"(
+package p
+
+fn main(input: bits[4]) -> bits[4] {
+  ret not.2: bits[4] = not(input)
+}
+)";
+
+// Implements kNotIr, except that bit 1 is computed with an OR rather than an
+// inverter when bad_bit_1 is set.
+std::string NotNetlist(bool bad_bit_1) {
+  std::string netlist_text = R"(
+module main ( clk, input_3_, input_2_, input_1_, input_0_, out_3_, out_2_, out_1_, out_0_);
+  input clk, input_3_, input_2_, input_1_, input_0_;
+  output out_3_, out_2_, out_1_, out_0_;
+  wire p0_input_3_, p0_input_2_, p0_input_1_, p0_input_0_,
+       p0_not_2_comb_3_, p0_not_2_comb_2_, p0_not_2_comb_1_, p0_not_2_comb_0_;
+
+  DFF p0_input_reg_3_ ( .D(input_3_), .CLK(clk), .Q(p0_input_3_) );
+  DFF p0_input_reg_2_ ( .D(input_2_), .CLK(clk), .Q(p0_input_2_) );
+  DFF p0_input_reg_1_ ( .D(input_1_), .CLK(clk), .Q(p0_input_1_) );
+  DFF p0_input_reg_0_ ( .D(input_0_), .CLK(clk), .Q(p0_input_0_) );
+
+  INV p0_not_2_3_ ( .A(p0_input_3_), .ZN(p0_not_2_comb_3_) );
+  INV p0_not_2_2_ ( .A(p0_input_2_), .ZN(p0_not_2_comb_2_) );
+  BIT_1_CELL
+  INV p0_not_2_0_ ( .A(p0_input_0_), .ZN(p0_not_2_comb_0_) );
+
+  DFF p0_not_2_reg_3_ (.D(p0_not_2_comb_3_), .CLK(clk), .Q(out_3_));
+  DFF p0_not_2_reg_2_ (.D(p0_not_2_comb_2_), .CLK(clk), .Q(out_2_));
+  DFF p0_not_2_reg_1_ (.D(p0_not_2_comb_1_), .CLK(clk), .Q(out_1_));
+  DFF p0_not_2_reg_0_ (.D(p0_not_2_comb_0_), .CLK(clk), .Q(out_0_));
+endmodule
+)";
+  std::string bit_1_cell =
+      bad_bit_1
+          ? "OR  p0_not_2_1_ ( .A(p0_input_1_), .B(p0_input_1_), "
+            ".Z(p0_not_2_comb_1_) );"
+          : "INV p0_not_2_1_ ( .A(p0_input_1_), .ZN(p0_not_2_comb_1_) );";
+  netlist_text.replace(netlist_text.find("BIT_1_CELL"), 10, bit_1_cell);
+  return netlist_text;
+}
+
+// Holds a whole-function Lec along with everything it borrows.
+struct LecHolder {
+  std::unique_ptr<Package> package;
+  std::unique_ptr<netlist::CellLibrary> cell_library;
+  std::unique_ptr<Netlist> netlist;
+  std::unique_ptr<Lec> lec;
+};
+
+absl::StatusOr<LecHolder> CreateLec(const std::string& ir_text,
+                                    const std::string& netlist_text) {
+  LecHolder holder;
+  XLS_ASSIGN_OR_RETURN(holder.package, Parser::ParsePackage(ir_text));
+  XLS_ASSIGN_OR_RETURN(Function * entry_function,
+                       holder.package->EntryFunction());
+  XLS_ASSIGN_OR_RETURN(netlist::CellLibrary cell_library,
+                       netlist::MakeFakeCellLibrary());
+  holder.cell_library =
+      std::make_unique<netlist::CellLibrary>(std::move(cell_library));
+  netlist::rtl::Scanner scanner(netlist_text);
+  XLS_ASSIGN_OR_RETURN(holder.netlist,
+                       netlist::rtl::Parser::ParseNetlist(
+                           holder.cell_library.get(), &scanner));
+
+  LecParams params;
+  params.ir_package = holder.package.get();
+  params.ir_function = entry_function;
+  params.netlist = holder.netlist.get();
+  params.netlist_module_name = "main";
+  XLS_ASSIGN_OR_RETURN(holder.lec, Lec::Create(params));
+  return holder;
+}
+
+TEST(Z3LecTest, ParallelLec) {
+  XLS_ASSERT_OK_AND_ASSIGN(LecHolder holder,
+                           CreateLec(kNotIr, NotNetlist(/*bad_bit_1=*/false)));
+  ParallelLecOptions options;
+  options.thread_count = 4;
+  EXPECT_TRUE(holder.lec->RunParallel(options));
+
+  ASSERT_EQ(holder.lec->cone_results().size(), 4);
+  for (int i = 0; i < 4; ++i) {
+    const ConeResult& result = holder.lec->cone_results()[i];
+    EXPECT_EQ(result.node->GetName(), "not.2");
+    EXPECT_EQ(result.bit_index, i);
+    EXPECT_EQ(result.status, ConeStatus::kProved);
+  }
+  EXPECT_THAT(holder.lec->ResultToString(),
+              HasSubstr("4 output bits: 4 proved"));
+}
+
+TEST(Z3LecTest, ParallelLecReportsFailingCone) {
+  XLS_ASSERT_OK_AND_ASSIGN(LecHolder holder,
+                           CreateLec(kNotIr, NotNetlist(/*bad_bit_1=*/true)));
+  ParallelLecOptions options;
+  options.thread_count = 2;
+  options.stop_at_first_failure = false;
+  EXPECT_FALSE(holder.lec->RunParallel(options));
+
+  // Cone results are indexed by position in the flattened value, which lists
+  // the MSB first, so netlist bit 1 is at index 2.
+  std::vector<ConeStatus> statuses;
+  for (const ConeResult& result : holder.lec->cone_results()) {
+    statuses.push_back(result.status);
+  }
+  EXPECT_THAT(statuses, ElementsAre(ConeStatus::kProved, ConeStatus::kProved,
+                                    ConeStatus::kFailed, ConeStatus::kProved));
+
+  // The counterexample is translated back for the usual reporting.
+  std::string result = holder.lec->ResultToString();
+  EXPECT_THAT(result, HasSubstr("not.2: FAILED (bits 2)"));
+  EXPECT_THAT(result, HasSubstr("Output IR node"));
+
+  // The same Lec can still be checked as a single query.
+  EXPECT_FALSE(holder.lec->Run());
+  EXPECT_TRUE(holder.lec->satisfiable());
+  EXPECT_THAT(holder.lec->ResultToString(), HasSubstr("satisfiable: true"));
+
+  // A generous timeout does not change the result.
+  EXPECT_FALSE(holder.lec->Run(absl::Minutes(1)));
+  EXPECT_TRUE(holder.lec->satisfiable());
+}
+
+TEST(Z3LecTest, ParallelLecStopsAtFirstFailure) {
+  XLS_ASSERT_OK_AND_ASSIGN(LecHolder holder,
+                           CreateLec(kNotIr, NotNetlist(/*bad_bit_1=*/true)));
+  ParallelLecOptions options;
+  options.thread_count = 1;
+  EXPECT_FALSE(holder.lec->RunParallel(options));
+
+  // Cones are dispatched in order, so with a single thread the failure in bit
+  // 2 is found before bit 3 is checked.
+  std::vector<ConeStatus> statuses;
+  for (const ConeResult& result : holder.lec->cone_results()) {
+    statuses.push_back(result.status);
+  }
+  EXPECT_THAT(statuses, ElementsAre(ConeStatus::kProved, ConeStatus::kProved,
+                                    ConeStatus::kFailed, ConeStatus::kUnknown));
+  EXPECT_THAT(holder.lec->ResultToString(), HasSubstr("1 unknown"));
+}
+
+TEST(Z3LecTest, SimulationFindsCounterexample) {
+  XLS_ASSERT_OK_AND_ASSIGN(LecHolder holder,
+                           CreateLec(kNotIr, NotNetlist(/*bad_bit_1=*/true)));
+  SimulationOptions options;
+  options.random_vector_count = 100;
+  EXPECT_THAT(holder.lec->Simulate(options, absl::Seconds(10)),
+              IsOkAndHolds(false));
+
+  // The all-zeros corner case is the first vector, and already differs.
+  std::string result = holder.lec->ResultToString();
+  EXPECT_THAT(result, HasSubstr("mismatch on vector 0 of 64 simulated"));
+  EXPECT_THAT(result, HasSubstr("IR: 0b1111 (0xf)"));
+  EXPECT_THAT(result, HasSubstr("NL: 0b1101 (0xd)"));
+}
+
+TEST(Z3LecTest, SimulationEstablishesEquivalencePoints) {
+  XLS_ASSERT_OK_AND_ASSIGN(LecHolder holder,
+                           CreateLec(kNotIr, NotNetlist(/*bad_bit_1=*/false)));
+  SimulationOptions options;
+  options.random_vector_count = 100;
+  EXPECT_THAT(holder.lec->Simulate(options, absl::Seconds(10)),
+              IsOkAndHolds(true));
+  EXPECT_THAT(holder.lec->ResultToString(),
+              HasSubstr("no mismatch in 105 vectors"));
+
+  // Each inverter's output matches a bit of the IR's not, so once those are
+  // proved every output cone is structurally equal.
+  EXPECT_EQ(holder.lec->equivalence_point_count(), 4);
+  EXPECT_TRUE(holder.lec->Run());
+  ParallelLecOptions parallel_options;
+  EXPECT_TRUE(holder.lec->RunParallel(parallel_options));
+  for (const ConeResult& result : holder.lec->cone_results()) {
+    EXPECT_TRUE(result.structurally_equal);
+  }
+}
+
 }  // namespace
 }  // namespace z3
 }  // namespace solvers
@@ -66,8 +66,9 @@ absl::Status NetlistTranslator::Init() {
   // Create a symbolic constant for each module input and make it available for
   // downstream nodes.
   for (const NetRef& input : module_->inputs()) {
+    std::string name(input->name());
     translated_[input] =
-        Z3_mk_const(ctx_, Z3_mk_string_symbol(ctx_, input->name().c_str()),
+        Z3_mk_const(ctx_, Z3_mk_string_symbol(ctx_, name.c_str()),
                     Z3_mk_bv_sort(ctx_, 1));
   }
 
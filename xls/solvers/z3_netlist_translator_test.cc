@@ -462,7 +462,7 @@ endmodule)";
 
   // Next, bind a fixed 0 to the input of the module. This will result in a
   // solver being unable to find a 1-valued output.
-  std::string src_ref_name = module_->inputs()[0]->name();
+  std::string src_ref_name(module_->inputs()[0]->name());
   XLS_ASSERT_OK(translator_->Retranslate({{src_ref_name, value_0}}));
   XLS_ASSERT_OK_AND_ASSIGN(module_output,
                            translator_->GetTranslation(module_->outputs()[0]));
@@ -495,7 +495,7 @@ endmodule)";
   Z3_ast value_1 = Z3_mk_int(ctx_, 1, bit_sort);
   Z3_ast free_constant =
       Z3_mk_const(ctx_, Z3_mk_string_symbol(ctx_, "foo"), bit_sort);
-  std::string src_ref_name = module_->inputs()[0]->name();
+  std::string src_ref_name(module_->inputs()[0]->name());
 
   // First, verify that the initial module can have a value of one or zero.
   XLS_ASSERT_OK_AND_ASSIGN(Z3_ast module_output,
@@ -554,8 +554,8 @@ endmodule)";
   ASSERT_TRUE(IsSatisfiable(Z3_mk_eq(ctx_, module_output, value_1)));
 
   // Now rebind, as above.
-  std::string src_ref_0 = module_->inputs()[0]->name();
-  std::string src_ref_1 = module_->inputs()[1]->name();
+  std::string src_ref_0(module_->inputs()[0]->name());
+  std::string src_ref_1(module_->inputs()[1]->name());
 
   // A&B
   XLS_ASSERT_OK(translator_->Retranslate({
@@ -13,6 +13,9 @@
 // limitations under the License.
 #include "xls/solvers/z3_utils.h"
 
+#include <algorithm>
+#include <cstdint>
+
 #include "absl/base/internal/sysinfo.h"
 #include "absl/strings/match.h"
 #include "absl/strings/numbers.h"
@@ -103,6 +106,47 @@ Z3_solver CreateSolver(Z3_context ctx, int num_threads) {
   return solver;
 }
 
+std::vector<std::pair<Z3_ast, Z3_ast>> ProveEquivalences(
+    Z3_context ctx, absl::Span<const std::pair<Z3_ast, Z3_ast>> candidates,
+    absl::Span<const Z3_ast> assumptions,
+    absl::Duration timeout_per_candidate, absl::Time deadline) {
+  Z3_solver solver = CreateSolver(ctx, /*num_threads=*/1);
+  for (Z3_ast assumption : assumptions) {
+    Z3_solver_assert(ctx, solver, assumption);
+  }
+
+  std::vector<std::pair<Z3_ast, Z3_ast>> proved;
+  for (const auto& [lhs, rhs] : candidates) {
+    if (Z3_is_eq_ast(ctx, lhs, rhs)) {
+      continue;
+    }
+    absl::Duration timeout =
+        std::min(timeout_per_candidate, deadline - absl::Now());
+    if (timeout <= absl::ZeroDuration()) {
+      break;
+    }
+    Z3_params params = Z3_mk_params(ctx);
+    Z3_params_inc_ref(ctx, params);
+    Z3_params_set_uint(
+        ctx, params, Z3_mk_string_symbol(ctx, "timeout"),
+        std::max<int64_t>(absl::ToInt64Milliseconds(timeout), 1));
+    Z3_solver_set_params(ctx, solver, params);
+    Z3_params_dec_ref(ctx, params);
+
+    Z3_ast equality = Z3_mk_eq(ctx, lhs, rhs);
+    Z3_solver_push(ctx, solver);
+    Z3_solver_assert(ctx, solver, Z3_mk_not(ctx, equality));
+    Z3_lbool result = Z3_solver_check(ctx, solver);
+    Z3_solver_pop(ctx, solver, 1);
+    if (result == Z3_L_FALSE) {
+      Z3_solver_assert(ctx, solver, equality);
+      proved.push_back({lhs, rhs});
+    }
+  }
+  Z3_solver_dec_ref(ctx, solver);
+  return proved;
+}
+
 std::string SolverResultToString(Z3_context ctx, Z3_solver solver,
                                  Z3_lbool satisfiable, bool hexify) {
   std::string result_str;
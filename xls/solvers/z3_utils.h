@@ -17,8 +17,12 @@
 #define XLS_SOLVERS_Z3_UTILS_H_
 
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
 #include "xls/ir/type.h"
 #include "../z3/src/api/z3.h"
 
@@ -48,6 +52,18 @@ class ScopedErrorHandler {
 // needed.
 Z3_solver CreateSolver(Z3_context ctx, int num_threads);
 
+// Attempts to prove each candidate pair of terms equal under the given
+// assumptions (e.g., input constraints), spending at most
+// "timeout_per_candidate" on each. Equalities proved so far are assumed when
+// attempting later candidates, so candidates closer to the inputs should come
+// first. Candidates not attempted by "deadline" are dropped. Returns the pairs
+// that were proved; within any query over the same terms and assumptions,
+// either term of a pair may stand in for the other.
+std::vector<std::pair<Z3_ast, Z3_ast>> ProveEquivalences(
+    Z3_context ctx, absl::Span<const std::pair<Z3_ast, Z3_ast>> candidates,
+    absl::Span<const Z3_ast> assumptions, absl::Duration timeout_per_candidate,
+    absl::Time deadline = absl::InfiniteFuture());
+
 // Printing / output functions ------------------------------------------------
 // Prints the solver's result, and, if satisfiable, prints a model demonstrating
 // such a case.
@@ -13,8 +13,12 @@
 // limitations under the License.
 #include "xls/solvers/z3_utils.h"
 
+#include <utility>
+#include <vector>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "../z3/src/api/z3_api.h"
 
 namespace {
 
@@ -27,4 +31,41 @@ TEST(Z3UtilsTest, Hexifies) {
             "This is some fun text. It has a boolean string, #xa5a5 .");
 }
 
+TEST(Z3UtilsTest, ProvesEquivalences) {
+  Z3_config config = Z3_mk_config();
+  Z3_context ctx = Z3_mk_context(config);
+  Z3_del_config(config);
+  Z3_sort sort = Z3_mk_bv_sort(ctx, 8);
+  Z3_ast x = Z3_mk_const(ctx, Z3_mk_string_symbol(ctx, "x"), sort);
+  Z3_ast y = Z3_mk_const(ctx, Z3_mk_string_symbol(ctx, "y"), sort);
+  Z3_ast x_plus_y = Z3_mk_bvadd(ctx, x, y);
+  Z3_ast y_plus_x = Z3_mk_bvadd(ctx, y, x);
+  Z3_ast x_or_y = Z3_mk_bvor(ctx, x, y);
+  Z3_ast x_xor_y = Z3_mk_bvxor(ctx, x, y);
+
+  // x + y == x | y only holds if x and y share no set bits.
+  std::vector<std::pair<Z3_ast, Z3_ast>> candidates = {
+      {x_plus_y, y_plus_x}, {x_plus_y, x_or_y}, {x_or_y, x_xor_y}};
+  std::vector<std::pair<Z3_ast, Z3_ast>> proved =
+      xls::solvers::z3::ProveEquivalences(ctx, candidates,
+                                          /*assumptions=*/{},
+                                          absl::Seconds(10));
+  ASSERT_EQ(proved.size(), 1);
+  EXPECT_EQ(proved[0].first, x_plus_y);
+  EXPECT_EQ(proved[0].second, y_plus_x);
+
+  Z3_ast disjoint = Z3_mk_eq(ctx, Z3_mk_bvand(ctx, x, y),
+                             Z3_mk_int(ctx, 0, sort));
+  proved = xls::solvers::z3::ProveEquivalences(ctx, candidates, {disjoint},
+                                               absl::Seconds(10));
+  EXPECT_EQ(proved.size(), 3);
+
+  // Nothing is attempted once the deadline has passed.
+  proved = xls::solvers::z3::ProveEquivalences(
+      ctx, candidates, {disjoint}, absl::Seconds(10),
+      /*deadline=*/absl::Now() - absl::Seconds(1));
+  EXPECT_TRUE(proved.empty());
+  Z3_del_context(ctx);
+}
+
 }  // namespace
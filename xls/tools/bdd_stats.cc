@@ -41,6 +41,10 @@ To gather BDD stats of a set of benchmarks:
 ABSL_FLAG(int64_t, bdd_path_limit, 0,
           "Maximum number of paths before truncating the BDD subgraph "
           "and declaring a new variable. If zero, then no limit.");
+ABSL_FLAG(int64_t, bdd_memory_limit_bytes, 0,
+          "Approximate limit on the memory used by the BDD. Beyond the limit "
+          "expressions are replaced with new variables. If zero, then no "
+          "limit.");
 ABSL_FLAG(std::vector<std::string>, benchmarks, {},
           "Comma-separated list of benchmarks gather BDD stats about.");
 
@@ -99,13 +103,17 @@ absl::Status RealMain(absl::string_view input_path) {
     absl::Time start = absl::Now();
     XLS_ASSIGN_OR_RETURN(
         std::unique_ptr<BddFunction> bdd_function,
-        BddFunction::Run(entry, absl::GetFlag(FLAGS_bdd_path_limit)));
+        BddFunction::Run(entry, absl::GetFlag(FLAGS_bdd_path_limit),
+                         /*do_not_evaluate_ops=*/{},
+                         absl::GetFlag(FLAGS_bdd_memory_limit_bytes)));
     absl::Duration bdd_time = absl::Now() - start;
     total_time += bdd_time;
     std::cout << "BDD construction time: " << bdd_time << "\n";
     std::cout << "BDD node count: " << bdd_function->bdd().size() << "\n";
     std::cout << "BDD variable count: " << bdd_function->bdd().variable_count()
               << "\n";
+    std::cout << "BDD estimated memory usage (bytes): "
+              << bdd_function->bdd().GetMemoryUsageBytes() << "\n";
 
     int64_t number_bits = 0;
     for (Node* node : entry->nodes()) {
@@ -113,10 +121,17 @@ absl::Status RealMain(absl::string_view input_path) {
     }
     std::cout << "Bits in graph: " << number_bits << "\n";
 
+    // An expression has at least as many paths as any of its subexpressions
+    // so it suffices to consider the expressions of the nodes.
     int64_t max_paths = 0;
-    for (int64_t i = 0; i < bdd_function->bdd().size(); ++i) {
-      max_paths =
-          std::max(max_paths, bdd_function->bdd().path_count(BddNodeIndex(i)));
+    for (Node* node : entry->nodes()) {
+      if (!node->GetType()->IsBits()) {
+        continue;
+      }
+      for (int64_t i = 0; i < node->BitCountOrDie(); ++i) {
+        max_paths = std::max(max_paths, bdd_function->bdd().path_count(
+                                            bdd_function->GetBddNode(node, i)));
+      }
     }
     if (max_paths == std::numeric_limits<int32_t>::max()) {
       std::cout << "Maximum paths of any expression: INT32_MAX\n";
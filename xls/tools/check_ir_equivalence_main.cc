@@ -12,13 +12,18 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
 
 #include "absl/base/internal/sysinfo.h"
 #include "absl/flags/flag.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
+#include "absl/time/time.h"
 #include "xls/common/file/filesystem.h"
 #include "xls/common/file/get_runfile_path.h"
 #include "xls/common/init_xls.h"
@@ -33,6 +38,7 @@
 #include "xls/passes/pass_base.h"
 #include "xls/passes/passes.h"
 #include "xls/passes/unroll_pass.h"
+#include "xls/solvers/random_simulation.h"
 #include "xls/solvers/z3_ir_translator.h"
 #include "xls/solvers/z3_utils.h"
 #include "../z3/src/api/z3.h"
@@ -49,6 +55,12 @@ Example invocation:
 If there are multiple functions in the specified files, then it's _strongly_
 recommended that you specify --function to ensure that the right functions are
 compared. If the tool picks the wrong one, a crash may result.
+
+Before the proof is attempted, both functions are simulated on corner-case and
+random inputs; a mismatch found this way is reported without invoking the
+solver. Otherwise, internal nodes whose simulated values agree are proposed as
+equivalence points, and those which can be proved are substituted into the
+final query.
 )";
 
 ABSL_FLAG(std::string, function, "",
@@ -56,6 +68,13 @@ ABSL_FLAG(std::string, function, "",
           "and check an entry function for the package.");
 ABSL_FLAG(absl::Duration, timeout, absl::InfiniteDuration(),
           "How long to wait for any proof to complete.");
+ABSL_FLAG(int64_t, simulation_vectors, 4096,
+          "Number of random input vectors on which to simulate the functions "
+          "before invoking the solver, in addition to the corner cases. 0 "
+          "disables simulation.");
+ABSL_FLAG(absl::Duration, equivalence_point_timeout, absl::Milliseconds(100),
+          "Time limit for proving each internal equivalence point proposed by "
+          "simulation. 0 disables equivalence points.");
 
 namespace xls {
 
@@ -76,9 +95,51 @@ absl::StatusOr<Z3_ast> CreateComparisonFunction(
   return Z3_mk_eq(ctx, result1, result2);
 }
 
+// Simulates the functions against each other. Returns true if a mismatch was
+// found (and printed, with the same result line as a satisfiable solver query);
+// otherwise, fills in "candidates" with the proposed equivalence points.
+absl::StatusOr<bool> Simulate(
+    const std::vector<Function*>& functions, int64_t simulation_vectors,
+    absl::Duration equivalence_point_timeout,
+    std::vector<std::pair<Node*, Node*>>* candidates) {
+  solvers::SimulationOptions options;
+  options.random_vector_count = simulation_vectors;
+  if (equivalence_point_timeout <= absl::ZeroDuration()) {
+    options.signature_vector_count = 0;
+  }
+  XLS_ASSIGN_OR_RETURN(
+      solvers::IrSimulationResult result,
+      solvers::SimulateIrEquivalence(functions[0], functions[1], options));
+  if (result.counterexample.has_value()) {
+    auto format_value = [](std::string* out, const Value& value) {
+      absl::StrAppend(out, value.ToString(FormatPreference::kHex));
+    };
+    std::cout << absl::StrFormat(
+                     "Solver result; satisfiable: true\n\n"
+                     "  Simulation found a mismatch on vector %d:\n"
+                     "  args: %s\n  results: %s vs. %s",
+                     result.vector_count - 1,
+                     absl::StrJoin(result.counterexample->args, ", ",
+                                   format_value),
+                     result.counterexample->lhs_result.ToString(
+                         FormatPreference::kHex),
+                     result.counterexample->rhs_result.ToString(
+                         FormatPreference::kHex))
+              << std::endl;
+    return true;
+  }
+  XLS_LOG(INFO) << "No mismatch in " << result.vector_count
+                << " simulated vectors; "
+                << result.candidate_equivalences.size()
+                << " candidate equivalence points";
+  *candidates = std::move(result.candidate_equivalences);
+  return false;
+}
+
 absl::Status RealMain(const std::vector<absl::string_view>& ir_paths,
                       const std::string& entry_function,
-                      absl::Duration timeout) {
+                      absl::Duration timeout, int64_t simulation_vectors,
+                      absl::Duration equivalence_point_timeout) {
   std::vector<std::unique_ptr<Package>> packages;
   for (const auto ir_path : ir_paths) {
     XLS_ASSIGN_OR_RETURN(std::string ir_text, GetFileContents(ir_path));
@@ -122,6 +183,21 @@ absl::Status RealMain(const std::vector<absl::string_view>& ir_paths,
     }
   }
 
+  // Simulation and proving the equivalence points it proposes count against
+  // the overall timeout. Simulation failures (e.g., functions the JIT can't
+  // compile) aren't fatal; the proof doesn't depend on it.
+  absl::Time deadline = absl::Now() + timeout;
+  std::vector<std::pair<Node*, Node*>> candidates;
+  if (simulation_vectors > 0) {
+    absl::StatusOr<bool> mismatch = Simulate(
+        functions, simulation_vectors, equivalence_point_timeout, &candidates);
+    if (!mismatch.ok()) {
+      XLS_LOG(WARNING) << "Simulation failed: " << mismatch.status();
+    } else if (mismatch.value()) {
+      return absl::OkStatus();
+    }
+  }
+
   std::vector<std::unique_ptr<IrTranslator>> translators;
   XLS_ASSIGN_OR_RETURN(std::unique_ptr<IrTranslator> translator,
                        IrTranslator::CreateAndTranslate(functions[0]));
@@ -143,7 +219,31 @@ absl::Status RealMain(const std::vector<absl::string_view>& ir_paths,
   XLS_ASSIGN_OR_RETURN(
       Z3_ast results_equal,
       CreateComparisonFunction(absl::MakeSpan(translators), functions));
-  translators[0]->SetTimeout(timeout);
+
+  // Replace the second function's nodes by the first's wherever they're
+  // proved equivalent, so the solver sees the structure they share.
+  if (!candidates.empty()) {
+    std::vector<std::pair<Z3_ast, Z3_ast>> z3_candidates;
+    for (const auto& [lhs, rhs] : candidates) {
+      z3_candidates.push_back({translators[1]->GetTranslation(rhs),
+                               translators[0]->GetTranslation(lhs)});
+    }
+    std::vector<std::pair<Z3_ast, Z3_ast>> proved =
+        solvers::z3::ProveEquivalences(ctx, z3_candidates, /*assumptions=*/{},
+                                       equivalence_point_timeout, deadline);
+    XLS_LOG(INFO) << "Proved " << proved.size() << " of "
+                  << z3_candidates.size() << " equivalence points";
+    std::vector<Z3_ast> from;
+    std::vector<Z3_ast> to;
+    for (const auto& [rhs, lhs] : proved) {
+      from.push_back(rhs);
+      to.push_back(lhs);
+    }
+    results_equal = Z3_substitute(ctx, results_equal, from.size(), from.data(),
+                                  to.data());
+  }
+  translators[0]->SetTimeout(
+      std::max(deadline - absl::Now(), absl::Milliseconds(1)));
 
   Z3_solver solver =
       solvers::z3::CreateSolver(ctx, std::thread::hardware_concurrency());
@@ -170,6 +270,8 @@ int main(int argc, char** argv) {
   std::vector<absl::string_view> positional_args =
       xls::InitXls(kUsage, argc, argv);
   XLS_QCHECK_EQ(positional_args.size(), 2) << "Two IR files must be specified!";
-  XLS_QCHECK_OK(xls::RealMain(positional_args, absl::GetFlag(FLAGS_function),
-                              absl::GetFlag(FLAGS_timeout)));
+  XLS_QCHECK_OK(xls::RealMain(
+      positional_args, absl::GetFlag(FLAGS_function),
+      absl::GetFlag(FLAGS_timeout), absl::GetFlag(FLAGS_simulation_vectors),
+      absl::GetFlag(FLAGS_equivalence_point_timeout)));
 }
@@ -12,10 +12,22 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "absl/flags/flag.h"
 #include "absl/status/status.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "xls/codegen/block_generator.h"
+#include "xls/codegen/codegen_options.h"
 #include "xls/codegen/combinational_generator.h"
 #include "xls/codegen/module_signature.pb.h"
 #include "xls/codegen/pipeline_generator.h"
@@ -24,9 +36,12 @@
 #include "xls/common/logging/logging.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/common/thread_pool.h"
 #include "xls/delay_model/delay_estimator.h"
 #include "xls/delay_model/delay_estimators.h"
 #include "xls/ir/ir_parser.h"
+#include "xls/passes/pass_base.h"
+#include "xls/passes/pass_profile.h"
 #include "xls/passes/standard_pipeline.h"
 #include "xls/scheduling/pipeline_schedule.h"
 
@@ -43,6 +58,13 @@ Emit a feed-forward pipelined module:
        --clock_period_ps=500 \
        --pipeline_stages=7 \
        IR_FILE
+
+Emit pipelined modules for several entries using four threads:
+   codegen_main --generator=pipeline \
+       --pipeline_stages=3 \
+       --entries=foo,bar,baz \
+       --codegen_thread_count=4 \
+       IR_FILE
 )";
 
 ABSL_FLAG(int64_t, clock_period_ps, 0, "Target clock period, in picoseconds.");
@@ -57,16 +79,38 @@ ABSL_FLAG(
 ABSL_FLAG(std::string, output_schedule_path, "",
           "Specific output path for the generated pipeline schedule. "
           "If not specified, then no schedule is output.");
+ABSL_FLAG(std::string, previous_schedule_path, "",
+          "Path to a pipeline schedule (as written by --output_schedule_path) "
+          "of a previous version of the IR. Nodes which are unchanged from "
+          "the previous version keep their pipeline stage where feasible; the "
+          "remaining nodes are scheduled around them.");
 ABSL_FLAG(
     std::string, output_signature_path, "",
     "Specific output path for the module signature. If not specified then "
     "no module signature is generated.");
+ABSL_FLAG(std::string, output_block_ir_path, "",
+          "Specific output path for the IR of the package holding the "
+          "generated block. Simulators which evaluate the block rather than "
+          "the Verilog (simulate_module_main --verilog_simulator=native) read "
+          "it through --block_ir_path. If not specified then no block IR is "
+          "output.");
 ABSL_FLAG(std::string, entry, "",
           "Entry function for the package.  Mutually-exclusive with "
           "--top_level_proc.");
 ABSL_FLAG(std::string, top_level_proc, "",
           "Entry (top-level) proc for the package, mutually-exclusive with "
           "--entry.");
+ABSL_FLAG(std::vector<std::string>, entries, {},
+          "Comma-separated list of functions and procs to generate modules "
+          "for. The modules are written to the Verilog output in the order "
+          "given. If more than one entry is given, the signature and "
+          "schedule of each entry are written to the respective output path "
+          "suffixed with '.' and the entry name. Mutually-exclusive with "
+          "--entry and --top_level_proc.");
+ABSL_FLAG(int64_t, codegen_thread_count, 1,
+          "Number of threads used to generate the modules given by "
+          "--entries. Each entry is scheduled and generated from a "
+          "separately parsed copy of the package.");
 ABSL_FLAG(std::string, generator, "pipeline",
           "The generator to use when emitting the device function. Valid "
           "values: pipeline, combinational.");
@@ -93,6 +137,29 @@ ABSL_FLAG(bool, flop_outputs, true,
 ABSL_FLAG(std::string, module_name, "",
           "Explicit name to use for the generated module; if not provided the "
           "mangled IR function name is used");
+ABSL_FLAG(std::string, scheduling_strategy, "minimize_registers",
+          "The pipeline scheduling strategy. Valid values: "
+          "minimize_registers (min-cut heuristic), sdc (optimal register "
+          "count via a system of difference constraints).");
+ABSL_FLAG(int64_t, scheduling_thread_count, 1,
+          "Number of threads used to evaluate min-cut cycle orders when "
+          "scheduling to minimize registers.");
+ABSL_FLAG(int64_t, cut_order_time_budget_ms, 0,
+          "If non-zero, the wall-clock budget in milliseconds for trying "
+          "additional min-cut cycle orders when scheduling to minimize "
+          "registers.");
+ABSL_FLAG(int64_t, retiming_register_budget_percent, -1,
+          "If non-negative, retime the pipeline after scheduling to minimize "
+          "the maximum stage delay while increasing the number of pipeline "
+          "register bits by at most this percentage.");
+ABSL_FLAG(int64_t, initiation_interval, 1,
+          "The number of cycles between successive inputs of the pipeline. "
+          "If greater than one, multipliers and dividers in different stages "
+          "share functional units. Requires --reset.");
+ABSL_FLAG(std::vector<std::string>, skid_buffer_stages, {},
+          "Comma-separated list of pipeline stages of a proc with ready/valid "
+          "channels to follow with a skid buffer. Stage i is the register "
+          "boundary between stage i and stage i+1. Requires --reset.");
 ABSL_FLAG(int64_t, clock_margin_percent, 0,
           "The percentage of clock period to set aside as a margin to ensure "
           "timing is met. Effectively, this lowers the clock period by this "
@@ -109,6 +176,17 @@ ABSL_FLAG(bool, reset_asynchronous, false,
 ABSL_FLAG(bool, use_system_verilog, true,
           "If true, emit SystemVerilog otherwise emit Verilog.");
 ABSL_FLAG(std::string, gate_format, "", "Format string to use for gate! ops.");
+ABSL_FLAG(std::string, clock_gate_format, "",
+          "Format string for instantiating a clock-gating cell which gates "
+          "the clock of registers with a load enable. Supported placeholders: "
+          "{clk}, {enable}, {gated_clk}. Example: "
+          "\"my_icg {gated_clk}_icg(.clk_in({clk}), .en({enable}), "
+          ".clk_out({gated_clk}))\"");
+ABSL_FLAG(std::string, pass_profile_out, "",
+          "If specified, write a profile of the codegen pass invocations to "
+          "this path and print a summary table to stderr. The profile is "
+          "written as JSON if the path ends in '.json' and as a text-format "
+          "PassProfileProto otherwise.");
 ABSL_FLAG(std::string, streaming_channel_data_suffix, "",
           "Suffix to append to data signals for streaming channels.");
 ABSL_FLAG(std::string, streaming_channel_valid_suffix, "_vld",
@@ -143,7 +221,19 @@ absl::StatusOr<SchedulingOptions> SetupSchedulingOptions() {
     return absl::InternalError("Scheduling only supported in pipeline mode.");
   }
 
-  SchedulingOptions scheduling_options;
+  SchedulingStrategy strategy;
+  std::string strategy_name = absl::GetFlag(FLAGS_scheduling_strategy);
+  if (strategy_name == "minimize_registers") {
+    strategy = SchedulingStrategy::MINIMIZE_REGISTERS;
+  } else if (strategy_name == "sdc") {
+    strategy = SchedulingStrategy::SDC;
+  } else {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Unknown scheduling strategy: %s. Valid values: minimize_registers, "
+        "sdc.",
+        strategy_name));
+  }
+  SchedulingOptions scheduling_options(strategy);
 
   if (absl::GetFlag(FLAGS_pipeline_stages) != 0) {
     scheduling_options.pipeline_stages(absl::GetFlag(FLAGS_pipeline_stages));
@@ -155,6 +245,23 @@ absl::StatusOr<SchedulingOptions> SetupSchedulingOptions() {
     scheduling_options.clock_margin_percent(
         absl::GetFlag(FLAGS_clock_margin_percent));
   }
+  scheduling_options.thread_count(absl::GetFlag(FLAGS_scheduling_thread_count));
+  if (absl::GetFlag(FLAGS_cut_order_time_budget_ms) != 0) {
+    scheduling_options.cut_order_time_budget_ms(
+        absl::GetFlag(FLAGS_cut_order_time_budget_ms));
+  }
+  if (absl::GetFlag(FLAGS_retiming_register_budget_percent) >= 0) {
+    scheduling_options.retiming_register_budget_percent(
+        absl::GetFlag(FLAGS_retiming_register_budget_percent));
+  }
+  scheduling_options.initiation_interval(
+      absl::GetFlag(FLAGS_initiation_interval));
+  if (!absl::GetFlag(FLAGS_previous_schedule_path).empty()) {
+    XLS_ASSIGN_OR_RETURN(PipelineScheduleProto previous_schedule,
+                         ParseTextProtoFile<PipelineScheduleProto>(
+                             absl::GetFlag(FLAGS_previous_schedule_path)));
+    scheduling_options.previous_schedule(std::move(previous_schedule));
+  }
 
   return scheduling_options;
 }
@@ -181,6 +288,18 @@ absl::StatusOr<verilog::CodegenOptions> GetCodegenOptions() {
     }
     options.flop_inputs(absl::GetFlag(FLAGS_flop_inputs));
     options.flop_outputs(absl::GetFlag(FLAGS_flop_outputs));
+    options.initiation_interval(absl::GetFlag(FLAGS_initiation_interval));
+
+    std::vector<int64_t> skid_buffer_stages;
+    for (const std::string& stage : absl::GetFlag(FLAGS_skid_buffer_stages)) {
+      int64_t value;
+      if (!absl::SimpleAtoi(stage, &value)) {
+        return absl::InvalidArgumentError(absl::StrFormat(
+            "Invalid value for --skid_buffer_stages: %s", stage));
+      }
+      skid_buffer_stages.push_back(value);
+    }
+    options.skid_buffer_stages(skid_buffer_stages);
 
     if (!absl::GetFlag(FLAGS_reset).empty()) {
       options.reset(absl::GetFlag(FLAGS_reset),
@@ -199,6 +318,9 @@ absl::StatusOr<verilog::CodegenOptions> GetCodegenOptions() {
   if (!absl::GetFlag(FLAGS_gate_format).empty()) {
     options.gate_format(absl::GetFlag(FLAGS_gate_format));
   }
+  if (!absl::GetFlag(FLAGS_clock_gate_format).empty()) {
+    options.clock_gate_format(absl::GetFlag(FLAGS_clock_gate_format));
+  }
 
   options.streaming_channel_data_suffix(
       absl::GetFlag(FLAGS_streaming_channel_data_suffix));
@@ -235,27 +357,48 @@ absl::StatusOr<PipelineSchedule> RunSchedulingPipeline(
   return schedule_status;
 }
 
-absl::Status RealMain(absl::string_view ir_path, absl::string_view verilog_path,
-                      absl::string_view signature_path,
-                      absl::string_view schedule_path) {
-  if (ir_path == "-") {
-    ir_path = "/dev/stdin";
+// The artifacts generated for a single entry function or proc. The Verilog is
+// not held in `result` but emitted from its block when the output is written.
+struct EntryResult {
+  std::unique_ptr<Package> package;
+  verilog::ModuleGeneratorResult result;
+  verilog::CodegenOptions emit_options;
+  PassResults pass_results;
+  absl::optional<PipelineScheduleProto> schedule;
+};
+
+// Returns the function or proc with the given name. If `name` is empty the
+// entry is determined by the --entry and --top_level_proc flags.
+absl::StatusOr<FunctionBase*> GetEntry(Package* p, absl::string_view name) {
+  if (name.empty()) {
+    return FindEntry(p);
   }
+  absl::StatusOr<Function*> function = p->GetFunction(name);
+  if (function.ok()) {
+    return function.value();
+  }
+  absl::StatusOr<Proc*> proc = p->GetProc(name);
+  if (proc.ok()) {
+    return proc.value();
+  }
+  return absl::NotFoundError(absl::StrFormat(
+      "No function or proc named '%s' in package '%s'", name, p->name()));
+}
 
-  XLS_ASSIGN_OR_RETURN(std::string ir_contents, GetFileContents(ir_path));
+// Parses the package and generates a module for the entry with the given
+// name. The package is parsed separately for each entry because scheduling
+// and codegen mutate the package (e.g., by adding blocks) so entries may be
+// generated concurrently.
+absl::StatusOr<EntryResult> GenerateEntry(
+    absl::string_view ir_contents, absl::string_view ir_path,
+    absl::string_view entry_name,
+    const verilog::CodegenOptions& codegen_options) {
   XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> p,
                        Parser::ParsePackage(ir_contents, ir_path));
-  verilog::ModuleGeneratorResult result;
-
-  XLS_ASSIGN_OR_RETURN(FunctionBase * main, FindEntry(p.get()));
-  XLS_ASSIGN_OR_RETURN(verilog::CodegenOptions codegen_options,
-                       GetCodegenOptions());
+  XLS_ASSIGN_OR_RETURN(FunctionBase * main, GetEntry(p.get(), entry_name));
 
+  EntryResult entry_result;
   if (absl::GetFlag(FLAGS_generator) == "pipeline") {
-    XLS_QCHECK(absl::GetFlag(FLAGS_pipeline_stages) != 0 ||
-               absl::GetFlag(FLAGS_clock_period_ps) != 0)
-        << "Musts specify --pipeline_stages or --clock_period_ps (or both).";
-
     XLS_ASSIGN_OR_RETURN(SchedulingOptions scheduling_options,
                          SetupSchedulingOptions());
     XLS_ASSIGN_OR_RETURN(const DelayEstimator* delay_estimator,
@@ -264,30 +407,155 @@ absl::Status RealMain(absl::string_view ir_path, absl::string_view verilog_path,
         PipelineSchedule schedule,
         RunSchedulingPipeline(main, scheduling_options, delay_estimator));
 
-    XLS_ASSIGN_OR_RETURN(
-        result, verilog::ToPipelineModuleText(schedule, main, codegen_options));
-
-    if (!schedule_path.empty()) {
-      XLS_RETURN_IF_ERROR(SetTextProtoFile(schedule_path, schedule.ToProto()));
-    }
+    XLS_ASSIGN_OR_RETURN(entry_result.result,
+                         verilog::ToPipelineModuleBlock(
+                             schedule, main, codegen_options,
+                             &entry_result.emit_options,
+                             &entry_result.pass_results));
+    entry_result.schedule = schedule.ToProto();
   } else if (absl::GetFlag(FLAGS_generator) == "combinational") {
     XLS_ASSIGN_OR_RETURN(
-        result, verilog::GenerateCombinationalModule(main, codegen_options));
+        entry_result.result,
+        verilog::GenerateCombinationalBlock(main, codegen_options,
+                                            &entry_result.pass_results));
+    entry_result.emit_options = codegen_options;
   } else {
     XLS_LOG(QFATAL) << absl::StreamFormat(
         "Invalid value for --generator: %s. Expected 'pipeline' or "
         "'combinational'",
         absl::GetFlag(FLAGS_generator));
   }
+  entry_result.package = std::move(p);
+  return entry_result;
+}
 
-  if (!signature_path.empty()) {
-    XLS_RETURN_IF_ERROR(
-        SetTextProtoFile(signature_path, result.signature.proto()));
+absl::Status RealMain(absl::string_view ir_path, absl::string_view verilog_path,
+                      absl::string_view signature_path,
+                      absl::string_view schedule_path) {
+  if (ir_path == "-") {
+    ir_path = "/dev/stdin";
+  }
+
+  std::vector<std::string> entries = absl::GetFlag(FLAGS_entries);
+  if (entries.empty()) {
+    // A single entry given by --entry or --top_level_proc (or the default
+    // entry function).
+    entries.push_back("");
+  } else if (!absl::GetFlag(FLAGS_entry).empty() ||
+             !absl::GetFlag(FLAGS_top_level_proc).empty()) {
+    return absl::InvalidArgumentError(
+        "Cannot provide --entries with --entry or --top_level_proc");
+  }
+  const bool multiple_entries = entries.size() > 1;
+  if (multiple_entries && !absl::GetFlag(FLAGS_module_name).empty()) {
+    return absl::InvalidArgumentError(
+        "Cannot provide --module_name with more than one entry");
+  }
+  if (multiple_entries &&
+      !absl::GetFlag(FLAGS_previous_schedule_path).empty()) {
+    return absl::InvalidArgumentError(
+        "Cannot provide --previous_schedule_path with more than one entry");
   }
-  if (verilog_path.empty()) {
-    std::cout << result.verilog_text;
+
+  XLS_ASSIGN_OR_RETURN(std::string ir_contents, GetFileContents(ir_path));
+  XLS_ASSIGN_OR_RETURN(verilog::CodegenOptions codegen_options,
+                       GetCodegenOptions());
+
+  if (absl::GetFlag(FLAGS_generator) == "pipeline") {
+    XLS_QCHECK(absl::GetFlag(FLAGS_pipeline_stages) != 0 ||
+               absl::GetFlag(FLAGS_clock_period_ps) != 0)
+        << "Musts specify --pipeline_stages or --clock_period_ps (or both).";
+  }
+
+  // The Verilog of all entries is streamed to a single output, so large
+  // designs are never held in memory as text.
+  std::ofstream verilog_file;
+  std::ostream* verilog_out = &std::cout;
+  if (!verilog_path.empty()) {
+    verilog_file.open(std::string(verilog_path));
+    if (!verilog_file.is_open()) {
+      return absl::NotFoundError(absl::StrFormat(
+          "Unable to open file for writing: %s", verilog_path));
+    }
+    verilog_out = &verilog_file;
+  }
+
+  // Returns the output path for an artifact of the i-th entry.
+  auto entry_path = [&](absl::string_view path, int64_t i) {
+    return multiple_entries ? absl::StrCat(path, ".", entries[i])
+                            : std::string(path);
+  };
+  std::string block_ir_path = absl::GetFlag(FLAGS_output_block_ir_path);
+  PassResults pass_results;
+  // Writes the artifacts of the i-th entry.
+  auto write_entry = [&](int64_t i,
+                         const EntryResult& entry_result) -> absl::Status {
+    pass_results.invocations.insert(
+        pass_results.invocations.end(),
+        entry_result.pass_results.invocations.begin(),
+        entry_result.pass_results.invocations.end());
+    if (!signature_path.empty()) {
+      XLS_RETURN_IF_ERROR(
+          SetTextProtoFile(entry_path(signature_path, i),
+                           entry_result.result.signature.proto()));
+    }
+    if (!schedule_path.empty() && entry_result.schedule.has_value()) {
+      XLS_RETURN_IF_ERROR(SetTextProtoFile(entry_path(schedule_path, i),
+                                           *entry_result.schedule));
+    }
+    if (!block_ir_path.empty()) {
+      XLS_RETURN_IF_ERROR(SetFileContents(entry_path(block_ir_path, i),
+                                          entry_result.package->DumpIr()));
+    }
+    if (i != 0) {
+      *verilog_out << "\n";
+    }
+    return verilog::GenerateVerilog(entry_result.result.block,
+                                    entry_result.emit_options, verilog_out);
+  };
+
+  // Generate the entries, concurrently if requested. Results are written in
+  // entry order so the output does not depend on the order in which the
+  // entries complete. When generating serially each entry is written (and its
+  // package released) before the next is generated.
+  int64_t thread_count = std::min<int64_t>(
+      absl::GetFlag(FLAGS_codegen_thread_count), entries.size());
+  if (thread_count <= 1) {
+    for (int64_t i = 0; i < entries.size(); ++i) {
+      XLS_ASSIGN_OR_RETURN(
+          EntryResult entry_result,
+          GenerateEntry(ir_contents, ir_path, entries[i], codegen_options));
+      XLS_RETURN_IF_ERROR(write_entry(i, entry_result));
+    }
   } else {
-    XLS_RETURN_IF_ERROR(SetFileContents(verilog_path, result.verilog_text));
+    // Default-constructed results hold an unknown error until generated.
+    std::vector<absl::StatusOr<EntryResult>> entry_results(entries.size());
+    ThreadPool pool(thread_count);
+    for (int64_t i = 0; i < entries.size(); ++i) {
+      pool.Schedule([&, i] {
+        entry_results[i] =
+            GenerateEntry(ir_contents, ir_path, entries[i], codegen_options);
+      });
+    }
+    pool.WaitForIdle();
+    for (int64_t i = 0; i < entries.size(); ++i) {
+      XLS_RETURN_IF_ERROR(entry_results[i].status());
+      XLS_RETURN_IF_ERROR(write_entry(i, entry_results[i].value()));
+    }
+  }
+  if (verilog_file.is_open()) {
+    verilog_file.close();
+    if (verilog_file.fail()) {
+      return absl::InternalError(
+          absl::StrFormat("Error writing file: %s", verilog_path));
+    }
+  }
+
+  std::string pass_profile_out = absl::GetFlag(FLAGS_pass_profile_out);
+  if (!pass_profile_out.empty()) {
+    XLS_RETURN_IF_ERROR(WritePassProfile(pass_profile_out, pass_results));
+    std::cerr << FormatPassProfileSummary(
+        PassResultsToProfileProto(pass_results));
   }
   return absl::OkStatus();
 }
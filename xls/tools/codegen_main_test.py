@@ -54,6 +54,20 @@ proc neg_proc(my_token: token, my_state: (), init=()) {
 """
 
 
+TWO_FUNCTIONS_IR = """package two_functions
+
+fn not_add(x: bits[32], y: bits[32]) -> bits[32] {
+  add.1: bits[32] = add(x, y)
+  ret not.2: bits[32] = not(add.1)
+}
+
+fn sub_mul(x: bits[32], y: bits[32]) -> bits[32] {
+  sub.3: bits[32] = sub(x, y)
+  ret umul.4: bits[32] = umul(sub.3, y)
+}
+"""
+
+
 class CodeGenMainTest(parameterized.TestCase):
 
   def test_combinational(self):
@@ -201,6 +215,43 @@ class CodeGenMainTest(parameterized.TestCase):
     self.assertIn('wire [31:0] out_d', verilog)
     self.assertIn('wire out_v', verilog)
     self.assertIn('wire out_r', verilog)
+  @parameterized.parameters([1, 2])
+  def test_multiple_entries(self, thread_count):
+    ir_file = self.create_tempfile(content=TWO_FUNCTIONS_IR)
+    signature_path = test_base.create_named_output_text_file(
+        f'two_functions.{thread_count}_threads.sig.textproto')
+    verilog = subprocess.check_output([
+        CODEGEN_MAIN_PATH, '--generator=pipeline', '--delay_model=unit',
+        '--pipeline_stages=2', '--alsologtostderr',
+        '--entries=sub_mul,not_add',
+        '--codegen_thread_count=' + str(thread_count),
+        '--output_signature_path=' + signature_path, ir_file.full_path
+    ]).decode('utf-8')
+
+    # Modules are emitted in the order the entries are given.
+    self.assertIn('module sub_mul(', verilog)
+    self.assertIn('module not_add(', verilog)
+    self.assertLess(
+        verilog.index('module sub_mul('), verilog.index('module not_add('))
+
+    for entry in ('sub_mul', 'not_add'):
+      with open(signature_path + '.' + entry, 'r') as f:
+        sig_proto = text_format.Parse(
+            f.read(), module_signature_pb2.ModuleSignatureProto())
+        self.assertEqual(sig_proto.module_name, entry)
+        self.assertTrue(sig_proto.HasField('pipeline'))
+
+  def test_entries_with_entry_is_error(self):
+    ir_file = self.create_tempfile(content=TWO_FUNCTIONS_IR)
+    comp = subprocess.run([
+        CODEGEN_MAIN_PATH, '--generator=combinational', '--entry=not_add',
+        '--entries=sub_mul,not_add', ir_file.full_path
+    ],
+                          stderr=subprocess.PIPE,
+                          check=False)
+    self.assertNotEqual(comp.returncode, 0)
+    self.assertIn('Cannot provide --entries with --entry',
+                  comp.stderr.decode('utf-8'))
 
 if __name__ == '__main__':
   absltest.main()
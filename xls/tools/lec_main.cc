@@ -14,26 +14,33 @@
 
 // Tool to prove or disprove logical equivalence of XLS IR and a netlist.
 
+#include <thread>  // NOLINT(build/c++11)
+
 #include "absl/base/internal/sysinfo.h"
 #include "absl/flags/flag.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/str_split.h"
+#include "absl/time/time.h"
 #include "xls/common/file/filesystem.h"
 #include "xls/common/file/get_runfile_path.h"
 #include "xls/common/init_xls.h"
+#include "xls/common/logging/logging.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/common/subprocess.h"
+#include "xls/common/thread_pool.h"
 #include "xls/ir/ir_parser.h"
 #include "xls/netlist/cell_library.h"
+#include "xls/netlist/cell_library_cache.h"
 #include "xls/netlist/function_extractor.h"
 #include "xls/netlist/lib_parser.h"
 #include "xls/netlist/netlist.h"
 #include "xls/netlist/netlist.pb.h"
 #include "xls/netlist/netlist_parser.h"
 #include "xls/scheduling/pipeline_schedule.pb.h"
+#include "xls/solvers/random_simulation.h"
 #include "xls/solvers/z3_lec.h"
 #include "xls/solvers/z3_utils.h"
 #include "../z3/src/api/z3_api.h"
@@ -46,6 +53,10 @@ ABSL_FLAG(std::string, cell_proto_path, "",
           "This is a whole bunch faster than specifiying an unprocessed "
           "cell library and should be favored.\n"
           "Either this or --cell_lib_path should be set.");
+ABSL_FLAG(std::string, cell_lib_cache_dir, "",
+          "If set, the cell library proto extracted from --cell_lib_path is "
+          "cached in this directory, keyed by the library's contents, so that "
+          "only the first run against a given library has to parse it.");
 ABSL_FLAG(std::string, constraints_file, "",
           "Optional path to a DSLX file containing a input parameter "
           "constraint function. This function must have the same signature as "
@@ -76,6 +87,19 @@ ABSL_FLAG(std::string, schedule_path, "",
           "impossible.");
 ABSL_FLAG(int32_t, timeout_sec, -1,
           "Amount of time to allow for a LEC operation.");
+ABSL_FLAG(int32_t, lec_threads, 0,
+          "Number of threads across which to partition the check by output "
+          "bit cone (and, with --auto_stage, across pipeline stages). If 0, "
+          "one per hardware thread is used. If 1, all outputs are checked as "
+          "a single query.");
+ABSL_FLAG(int64_t, simulation_vectors, 4096,
+          "For whole-function checks, the number of random input vectors on "
+          "which to simulate the IR and netlist before invoking the solver, "
+          "in addition to corner cases. A mismatch found this way is "
+          "reported without a solver query. 0 disables simulation.");
+ABSL_FLAG(absl::Duration, equivalence_point_timeout, absl::Milliseconds(100),
+          "Time limit for proving each internal equivalence point proposed by "
+          "simulation. 0 disables equivalence points.");
 ABSL_FLAG(bool, auto_stage, false,
           "If true, then the tool will determine on its own whether to perform "
           "staged or full LEC. This requires that a schedule be specified.");
@@ -91,20 +115,26 @@ using solvers::z3::IrTranslator;
 
 constexpr const char kIrConverterPath[] = "xls/dslx/ir_converter_main";
 
-// Loads a cell library, either from a raw Liberty file or a preprocessed
+// Loads a cell library, either from a raw Liberty file (going through the
+// extraction cache in cell_lib_cache_dir, if non-empty) or a preprocessed
 // CellLibraryProto proto.
 absl::StatusOr<netlist::CellLibrary> GetCellLibrary(
-    absl::string_view cell_lib_path, absl::string_view cell_proto_path) {
+    absl::string_view cell_lib_path, absl::string_view cell_proto_path,
+    absl::string_view cell_lib_cache_dir) {
   if (!cell_proto_path.empty()) {
     XLS_ASSIGN_OR_RETURN(std::string cell_proto_text,
                          GetFileContents(cell_proto_path));
     netlist::CellLibraryProto cell_proto;
     XLS_RET_CHECK(cell_proto.ParseFromString(cell_proto_text));
     return netlist::CellLibrary::FromProto(cell_proto);
+  } else if (!cell_lib_cache_dir.empty()) {
+    XLS_ASSIGN_OR_RETURN(netlist::CellLibraryProto proto,
+                         netlist::LoadCellLibraryProtoWithCache(
+                             cell_lib_path, cell_lib_cache_dir));
+    return netlist::CellLibrary::FromProto(proto);
   } else {
-    XLS_ASSIGN_OR_RETURN(std::string lib_text, GetFileContents(cell_lib_path));
-    XLS_ASSIGN_OR_RETURN(auto stream,
-                         netlist::cell_lib::CharStream::FromText(lib_text));
+    XLS_ASSIGN_OR_RETURN(
+        auto stream, netlist::cell_lib::CharStream::FromPath(cell_lib_path));
     XLS_ASSIGN_OR_RETURN(netlist::CellLibraryProto proto,
                          netlist::function::ExtractFunctions(&stream));
     return netlist::CellLibrary::FromProto(proto);
@@ -114,9 +144,9 @@ absl::StatusOr<netlist::CellLibrary> GetCellLibrary(
 // Loads and parses a netlist from a file.
 absl::StatusOr<std::unique_ptr<netlist::rtl::Netlist>> GetNetlist(
     absl::string_view netlist_path, netlist::CellLibrary* cell_library) {
-  XLS_ASSIGN_OR_RETURN(std::string netlist_text, GetFileContents(netlist_path));
-  netlist::rtl::Scanner scanner(netlist_text);
-  return netlist::rtl::Parser::ParseNetlist(cell_library, &scanner);
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<netlist::rtl::Scanner> scanner,
+                       netlist::rtl::Scanner::FromFile(netlist_path));
+  return netlist::rtl::Parser::ParseNetlist(cell_library, scanner.get());
 }
 
 // Returns true if the given function contains a large ( > 8 bit) multiply op.
@@ -167,11 +197,74 @@ void CancelAlarm(struct sigaction old_action) {
   sigaction(SIGALRM, &old_action, &dummy);
 }
 
+// Returns true if a partitioned check found a counterexample (as opposed to
+// failing to prove some cones in time).
+bool AnyConeFailed(const solvers::z3::Lec& lec) {
+  for (const solvers::z3::ConeResult& result : lec.cone_results()) {
+    if (result.status == solvers::z3::ConeStatus::kFailed) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Returns the deadline for a LEC operation started now, given --timeout_sec.
+absl::Time LecDeadline(int timeout_sec) {
+  return timeout_sec == -1 ? absl::InfiniteFuture()
+                           : absl::Now() + absl::Seconds(timeout_sec);
+}
+
+// Returns the whole seconds (rounded up) left before "deadline", as accepted
+// by SetAlarm(), or DeadlineExceededError if none are left.
+absl::StatusOr<int> SecondsUntil(absl::Time deadline) {
+  absl::Duration remaining = deadline - absl::Now();
+  if (remaining <= absl::ZeroDuration()) {
+    return absl::DeadlineExceededError("LEC timed out.");
+  }
+  return static_cast<int>(
+      absl::ToInt64Seconds(absl::Ceil(remaining, absl::Seconds(1))));
+}
+
+// Simulates the IR and netlist ahead of a whole-function check (see
+// Lec::Simulate()). Returns true if a mismatch was found, in which case it has
+// been reported. Simulation errors, e.g., from cells the compiled netlist
+// evaluator can't handle, are logged and otherwise ignored. Equivalence points
+// not proved by "deadline" are dropped.
+bool SimulateFirst(solvers::z3::Lec* lec, int64_t simulation_vectors,
+                   absl::Duration equivalence_point_timeout,
+                   absl::Time deadline) {
+  if (simulation_vectors == 0) {
+    return false;
+  }
+  solvers::SimulationOptions options;
+  options.random_vector_count = simulation_vectors;
+  if (equivalence_point_timeout <= absl::ZeroDuration()) {
+    options.signature_vector_count = 0;
+  }
+  absl::StatusOr<bool> equal =
+      lec->Simulate(options, equivalence_point_timeout, deadline);
+  if (!equal.ok()) {
+    XLS_LOG(WARNING) << "Simulation failed; continuing with the solver: "
+                     << equal.status();
+    return false;
+  }
+  if (equal.value()) {
+    XLS_LOG(INFO) << lec->ResultToString();
+    return false;
+  }
+  std::cout << lec->ResultToString() << std::endl;
+  std::cout << std::endl << "IR/netlist value dump:" << std::endl;
+  lec->DumpIrTree();
+  return true;
+}
+
 // This function applies heuristics to determine whether or not a full LEC can
 // be performed or if we should break into stages. For now, these are simple:
 // does the IR contain a greater-than-8-bit MUL?
 absl::Status AutoStage(const solvers::z3::LecParams& lec_params,
-                       const PipelineSchedule& schedule, int timeout_sec) {
+                       const PipelineSchedule& schedule, int timeout_sec,
+                       int64_t thread_count, int64_t simulation_vectors,
+                       absl::Duration equivalence_point_timeout) {
   bool do_staged = false;
 
   // Other staged/full heuristics should go here.
@@ -179,34 +272,72 @@ absl::Status AutoStage(const solvers::z3::LecParams& lec_params,
 
   if (do_staged) {
     std::cout << "Performing staged LEC.\n";
-    for (int i = 0; i < schedule.length(); i++) {
-      std::cout << "Stage " << i << "...";
-      XLS_ASSIGN_OR_RETURN(
-          auto lec, solvers::z3::Lec::CreateForStage(lec_params, schedule, i));
-
-      z3_interrupted = false;
-      struct sigaction old_action = SetAlarm(timeout_sec);
-      bool equal = lec->Run();
-      CancelAlarm(old_action);
-      absl::MutexLock lock(&mutex);
-      if (z3_interrupted) {
-        std::cout << "TIMED OUT!\n";
-        continue;
+    // Each stage is an independent problem with its own Z3 context, so the
+    // stages are checked concurrently. Threads beyond one per stage go to
+    // partitioning each stage's cones; as for the full LEC, a stage with a
+    // single thread is checked as a single query.
+    int64_t stage_count = schedule.length();
+    solvers::z3::ParallelLecOptions options;
+    options.thread_count = std::max<int64_t>(thread_count / stage_count, 1);
+    if (timeout_sec != -1) {
+      options.timeout = absl::Seconds(timeout_sec);
+    }
+    std::vector<absl::StatusOr<std::unique_ptr<solvers::z3::Lec>>> lecs(
+        stage_count);
+    std::vector<char> equal(stage_count);
+    {
+      ThreadPool pool(std::min<int64_t>(thread_count, stage_count));
+      for (int64_t i = 0; i < stage_count; i++) {
+        pool.Schedule([&, i] {
+          lecs[i] = solvers::z3::Lec::CreateForStage(lec_params, schedule, i);
+          if (!lecs[i].ok()) {
+            return;
+          }
+          solvers::z3::Lec* lec = lecs[i].value().get();
+          equal[i] = options.thread_count > 1 ? lec->RunParallel(options)
+                                              : lec->Run(options.timeout);
+        });
       }
+      pool.WaitForIdle();
+    }
 
-      if (equal) {
+    // Report in stage order once everything has finished.
+    for (int64_t i = 0; i < stage_count; i++) {
+      std::cout << "Stage " << i << "...";
+      XLS_ASSIGN_OR_RETURN(std::unique_ptr<solvers::z3::Lec> lec,
+                           std::move(lecs[i]));
+      if (equal[i]) {
         std::cout << "PASSED!\n";
-      } else {
+      } else if (lec->satisfiable()) {
         std::cout << "FAILED!\n";
+        std::cout << lec->ResultToString() << std::endl;
         std::cout << std::endl << "IR/netlist value dump:" << std::endl;
         lec->DumpIrTree();
+      } else {
+        std::cout << "TIMED OUT!\n";
       }
     }
   } else {
     std::cout << "Performing full LEC.\n";
     XLS_ASSIGN_OR_RETURN(auto lec,
                          solvers::z3::Lec::Create(std::move(lec_params)));
-    bool equal = lec->Run();
+    absl::Time deadline = LecDeadline(timeout_sec);
+    if (SimulateFirst(lec.get(), simulation_vectors,
+                      equivalence_point_timeout, deadline)) {
+      return absl::OkStatus();
+    }
+    bool equal;
+    if (thread_count > 1) {
+      solvers::z3::ParallelLecOptions options;
+      options.thread_count = thread_count;
+      if (timeout_sec != -1) {
+        XLS_ASSIGN_OR_RETURN(int remaining_sec, SecondsUntil(deadline));
+        options.timeout = absl::Seconds(remaining_sec);
+      }
+      equal = lec->RunParallel(options);
+    } else {
+      equal = lec->Run();
+    }
     std::cout << lec->ResultToString() << std::endl;
     if (!equal) {
       std::cout << std::endl << "IR/netlist value dump:" << std::endl;
@@ -222,9 +353,11 @@ absl::Status AutoStage(const solvers::z3::LecParams& lec_params,
 absl::Status RealMain(
     absl::string_view ir_path, absl::string_view entry_function_name,
     absl::string_view netlist_module_name, absl::string_view cell_lib_path,
-    absl::string_view cell_proto_path, absl::string_view netlist_path,
-    absl::string_view constraints_file, absl::string_view schedule_path,
-    int stage, bool auto_stage, int timeout_sec) {
+    absl::string_view cell_proto_path, absl::string_view cell_lib_cache_dir,
+    absl::string_view netlist_path, absl::string_view constraints_file,
+    absl::string_view schedule_path, int stage, bool auto_stage,
+    int timeout_sec, int64_t thread_count, int64_t simulation_vectors,
+    absl::Duration equivalence_point_timeout) {
   solvers::z3::LecParams lec_params;
   XLS_ASSIGN_OR_RETURN(std::string ir_text, GetFileContents(ir_path));
   XLS_ASSIGN_OR_RETURN(auto package, Parser::ParsePackage(ir_text));
@@ -238,7 +371,8 @@ absl::Status RealMain(
         lec_params.ir_package->GetFunction(entry_function_name));
   }
   XLS_ASSIGN_OR_RETURN(auto cell_library,
-                       GetCellLibrary(cell_lib_path, cell_proto_path));
+                       GetCellLibrary(cell_lib_path, cell_proto_path,
+                                      cell_lib_cache_dir));
   XLS_ASSIGN_OR_RETURN(auto netlist, GetNetlist(netlist_path, &cell_library));
   lec_params.netlist = netlist.get();
   lec_params.netlist_module_name = netlist_module_name;
@@ -252,7 +386,8 @@ absl::Status RealMain(
         PipelineSchedule schedule,
         PipelineSchedule::FromProto(lec_params.ir_function, proto));
     if (auto_stage) {
-      return AutoStage(lec_params, schedule, timeout_sec);
+      return AutoStage(lec_params, schedule, timeout_sec, thread_count,
+                       simulation_vectors, equivalence_point_timeout);
     }
     XLS_ASSIGN_OR_RETURN(lec, solvers::z3::Lec::CreateForStage(
                                   std::move(lec_params), schedule, stage));
@@ -275,17 +410,42 @@ absl::Status RealMain(
     XLS_RETURN_IF_ERROR(lec->AddConstraints(function));
   }
 
-  struct sigaction old_action;
-  if (timeout_sec != -1) {
-    old_action = SetAlarm(timeout_sec);
+  // Time spent simulating counts against --timeout_sec.
+  absl::Time deadline = LecDeadline(timeout_sec);
+  if ((schedule_path.empty() || stage == -1) &&
+      SimulateFirst(lec.get(), simulation_vectors, equivalence_point_timeout,
+                    deadline)) {
+    return absl::OkStatus();
   }
-  bool equal = lec->Run();
+  int remaining_sec = -1;
   if (timeout_sec != -1) {
-    CancelAlarm(old_action);
+    XLS_ASSIGN_OR_RETURN(remaining_sec, SecondsUntil(deadline));
   }
-  absl::MutexLock lock(&mutex);
-  if (z3_interrupted) {
-    return absl::DeadlineExceededError("LEC timed out.");
+
+  bool equal;
+  if (thread_count > 1) {
+    solvers::z3::ParallelLecOptions options;
+    options.thread_count = thread_count;
+    if (remaining_sec != -1) {
+      options.timeout = absl::Seconds(remaining_sec);
+    }
+    equal = lec->RunParallel(options);
+    if (!equal && !AnyConeFailed(*lec)) {
+      return absl::DeadlineExceededError("LEC timed out.");
+    }
+  } else {
+    struct sigaction old_action;
+    if (remaining_sec != -1) {
+      old_action = SetAlarm(remaining_sec);
+    }
+    equal = lec->Run();
+    if (remaining_sec != -1) {
+      CancelAlarm(old_action);
+    }
+    absl::MutexLock lock(&mutex);
+    if (z3_interrupted) {
+      return absl::DeadlineExceededError("LEC timed out.");
+    }
   }
 
   std::cout << lec->ResultToString() << std::endl;
@@ -326,10 +486,19 @@ int main(int argc, char* argv[]) {
   XLS_QCHECK(!(auto_stage && schedule_path.empty()))
       << "--schedule_path must be specified with --auto_stage.";
 
+  int64_t thread_count = absl::GetFlag(FLAGS_lec_threads);
+  XLS_QCHECK_GE(thread_count, 0) << "--lec_threads must be non-negative.";
+  if (thread_count == 0) {
+    thread_count = std::max<int64_t>(std::thread::hardware_concurrency(), 1);
+  }
+
   XLS_QCHECK_OK(xls::RealMain(
       ir_path, absl::GetFlag(FLAGS_entry_function_name),
       absl::GetFlag(FLAGS_netlist_module_name), cell_lib_path, cell_proto_path,
-      netlist_path, absl::GetFlag(FLAGS_constraints_file), schedule_path, stage,
-      auto_stage, absl::GetFlag(FLAGS_timeout_sec)));
+      absl::GetFlag(FLAGS_cell_lib_cache_dir), netlist_path,
+      absl::GetFlag(FLAGS_constraints_file), schedule_path, stage, auto_stage,
+      absl::GetFlag(FLAGS_timeout_sec), thread_count,
+      absl::GetFlag(FLAGS_simulation_vectors),
+      absl::GetFlag(FLAGS_equivalence_point_timeout)));
   return 0;
 }
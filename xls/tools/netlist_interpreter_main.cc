@@ -15,6 +15,11 @@
 // Driver for NetlistInterpreter: loads a netlist from disk, feeds Value input
 // (taken from the command line) into it, and prints the result.
 
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
 #include "absl/flags/flag.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -28,6 +33,7 @@
 #include "xls/ir/ir_parser.h"
 #include "xls/ir/value.h"
 #include "xls/netlist/cell_library.h"
+#include "xls/netlist/cell_library_cache.h"
 #include "xls/netlist/function_extractor.h"
 #include "xls/netlist/interpreter.h"
 #include "xls/netlist/lib_parser.h"
@@ -38,6 +44,11 @@ ABSL_FLAG(std::string, cell_library, "",
           "Cell library to use for interpretation.");
 ABSL_FLAG(std::string, cell_library_proto, "",
           "Preprocessed cell library proto to use for interpretation.");
+ABSL_FLAG(std::string, cell_library_cache_dir, "",
+          "If set, the cell library proto extracted from --cell_library is "
+          "cached in this directory, keyed by the library's contents, and "
+          "later runs against the same library load it from there instead of "
+          "re-parsing the library.");
 // TODO(rspringer): Eliminate the need for this flag.
 // This one is a hidden temporary flag until we can properly handle cells
 // with state_function attributes (e.g., some latches).
@@ -48,6 +59,11 @@ ABSL_FLAG(std::string, input, "",
           "The input to the function as a semicolon-separated list of typed "
           "values. For example: \"bits[32]:42; (bits[7]:0, bits[20]:4)\". "
           "Values must be listed in the same order as the module inputs.");
+ABSL_FLAG(std::string, input_file, "",
+          "Path to a file of inputs, one per line, each in the format of "
+          "--input. The module is evaluated bit-parallel on 64 inputs at a "
+          "time and one output is printed per line in the order of the "
+          "inputs. Mutually-exclusive with --input.");
 ABSL_FLAG(std::string, output_type, "",
           "Type of the value as an XLS-formatted string. If un-set, then the "
           "output will be printed as flat uninterpreted bits.");
@@ -58,40 +74,58 @@ namespace xls {
 
 absl::StatusOr<netlist::CellLibrary> GetCellLibrary(
     const std::string& cell_library_path,
-    const std::string& cell_library_proto_path) {
+    const std::string& cell_library_proto_path,
+    const std::string& cell_library_cache_dir) {
   if (!cell_library_proto_path.empty()) {
     XLS_ASSIGN_OR_RETURN(std::string proto_text,
                          GetFileContents(cell_library_proto_path));
     netlist::CellLibraryProto lib_proto;
     XLS_RET_CHECK(lib_proto.ParseFromString(proto_text));
     return netlist::CellLibrary::FromProto(lib_proto);
+  } else if (!cell_library_cache_dir.empty()) {
+    XLS_ASSIGN_OR_RETURN(netlist::CellLibraryProto lib_proto,
+                         netlist::LoadCellLibraryProtoWithCache(
+                             cell_library_path, cell_library_cache_dir));
+    return netlist::CellLibrary::FromProto(lib_proto);
   } else {
-    XLS_ASSIGN_OR_RETURN(std::string cell_library_text,
-                         GetFileContents(cell_library_path));
     XLS_ASSIGN_OR_RETURN(
         auto char_stream,
-        netlist::cell_lib::CharStream::FromText(cell_library_text));
+        netlist::cell_lib::CharStream::FromPath(cell_library_path));
     XLS_ASSIGN_OR_RETURN(netlist::CellLibraryProto lib_proto,
                          netlist::function::ExtractFunctions(&char_stream));
     return netlist::CellLibrary::FromProto(lib_proto);
   }
 }
 
+// Returns the flattened bits of the given typed input values. Bit i of the
+// result is the value of the module input at port offset i.
+absl::StatusOr<Bits> ParseInputBits(absl::Span<const std::string> inputs) {
+  Bits input_bits;
+  for (const auto& input_string : inputs) {
+    XLS_ASSIGN_OR_RETURN(Value input, Parser::ParseTypedValue(input_string));
+    Bits flat_value = FlattenValueToBits(input);
+    input_bits = bits_ops::Concat({input_bits, flat_value});
+  }
+  return bits_ops::Reverse(input_bits);
+}
+
 absl::Status RealMain(const std::string& netlist_path,
                       const std::string& cell_library_path,
                       const std::string& cell_library_proto_path,
+                      const std::string& cell_library_cache_dir,
                       const std::string& module_name,
-                      absl::Span<const std::string> inputs,
+                      absl::Span<const std::vector<std::string>> input_sets,
                       const std::string& output_type_string,
                       absl::Span<const std::string> dump_cells) {
   XLS_ASSIGN_OR_RETURN(
       netlist::CellLibrary cell_library,
-      GetCellLibrary(cell_library_path, cell_library_proto_path));
+      GetCellLibrary(cell_library_path, cell_library_proto_path,
+                     cell_library_cache_dir));
 
-  XLS_ASSIGN_OR_RETURN(std::string netlist_text, GetFileContents(netlist_path));
-  netlist::rtl::Scanner scanner(netlist_text);
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<netlist::rtl::Scanner> scanner,
+                       netlist::rtl::Scanner::FromFile(netlist_path));
   XLS_ASSIGN_OR_RETURN(auto netlist, netlist::rtl::Parser::ParseNetlist(
-                                         &cell_library, &scanner));
+                                         &cell_library, scanner.get()));
   XLS_ASSIGN_OR_RETURN(const auto* module, netlist->GetModule(module_name));
 
   // Input values are listed in the same order as inputs are declared by
@@ -106,47 +140,58 @@ absl::Status RealMain(const std::string& netlist_path,
   //
   // The values of --inputs should follow the module declaration, which would
   // also follow the declaration of the source language (e.g. C++ or XLS).
-
-  Bits input_bits;
-  for (const auto& input_string : inputs) {
-    XLS_ASSIGN_OR_RETURN(Value input, Parser::ParseTypedValue(input_string));
-    Bits flat_value = FlattenValueToBits(input);
-    input_bits = bits_ops::Concat({input_bits, flat_value});
-  }
-  input_bits = bits_ops::Reverse(input_bits);
-
-  absl::flat_hash_map<const netlist::rtl::NetRef, bool> input_nets;
   const std::vector<netlist::rtl::NetRef>& module_inputs = module->inputs();
-  XLS_RET_CHECK(module_inputs.size() == input_bits.bit_count());
-
-  for (int i = 0; i < module->inputs().size(); i++) {
-    const netlist::rtl::NetRef in = module_inputs[i];
-    input_nets[in] = input_bits.Get(module->GetInputPortOffset(in->name()));
+  std::vector<Bits> input_bits;
+  input_bits.reserve(input_sets.size());
+  for (const std::vector<std::string>& inputs : input_sets) {
+    XLS_ASSIGN_OR_RETURN(Bits bits, ParseInputBits(inputs));
+    XLS_RET_CHECK(module_inputs.size() == bits.bit_count());
+    input_bits.push_back(std::move(bits));
   }
 
-  netlist::Interpreter interpreter(netlist.get());
-  XLS_ASSIGN_OR_RETURN(auto output_nets, interpreter.InterpretModule(
-                                             module, input_nets, dump_cells));
-
-  BitsRope rope(output_nets.size());
-  for (const netlist::rtl::NetRef ref : module->outputs()) {
-    rope.push_back(output_nets[ref]);
-  }
-  Bits output_bits = rope.Build();
-
-  Value output;
+  // This is a disposable package - it only exists to hold the type below.
+  Package package("foo");
+  Type* output_type = nullptr;
   if (!output_type_string.empty()) {
-    // This is a disposable package - it only exists to hold the type below.
-    Package package("foo");
-    XLS_ASSIGN_OR_RETURN(Type * output_type,
+    XLS_ASSIGN_OR_RETURN(output_type,
                          Parser::ParseType(output_type_string, &package));
-    XLS_ASSIGN_OR_RETURN(output,
-                         UnflattenBitsToValue(output_bits, output_type));
-  } else {
-    output = Value(output_bits);
   }
 
-  std::cout << output.ToString(FormatPreference::kHex) << std::endl;
+  // Evaluate the inputs 64 at a time, with bit `lane` of each net holding the
+  // value of the net for input vector `base + lane`.
+  netlist::Interpreter interpreter(netlist.get());
+  for (int64_t base = 0; base < input_bits.size(); base += 64) {
+    int64_t lane_count = std::min<int64_t>(64, input_bits.size() - base);
+    absl::flat_hash_map<const netlist::rtl::NetRef, uint64_t> input_nets;
+    for (const netlist::rtl::NetRef in : module_inputs) {
+      int64_t offset = module->GetInputPortOffset(in->name());
+      uint64_t word = 0;
+      for (int64_t lane = 0; lane < lane_count; ++lane) {
+        word |= uint64_t{input_bits[base + lane].Get(offset)} << lane;
+      }
+      input_nets[in] = word;
+    }
+    XLS_ASSIGN_OR_RETURN(
+        auto output_nets,
+        interpreter.InterpretModuleBatch(module, input_nets, dump_cells));
+
+    for (int64_t lane = 0; lane < lane_count; ++lane) {
+      BitsRope rope(output_nets.size());
+      for (const netlist::rtl::NetRef ref : module->outputs()) {
+        rope.push_back((output_nets[ref] >> lane) & 1);
+      }
+      Bits output_bits = rope.Build();
+
+      Value output;
+      if (output_type != nullptr) {
+        XLS_ASSIGN_OR_RETURN(output,
+                             UnflattenBitsToValue(output_bits, output_type));
+      } else {
+        output = Value(output_bits);
+      }
+      std::cout << output.ToString(FormatPreference::kHex) << std::endl;
+    }
+  }
   return absl::OkStatus();
 }
 
@@ -168,17 +213,30 @@ int main(int argc, char* argv[]) {
   XLS_QCHECK(!module_name.empty()) << "--module_name must be specified.";
 
   std::string input = absl::GetFlag(FLAGS_input);
-  XLS_QCHECK(!input.empty()) << "--input must be specified.";
-  std::vector<std::string> inputs = absl::StrSplit(input, ';');
+  std::string input_file = absl::GetFlag(FLAGS_input_file);
+  XLS_QCHECK(!input.empty() ^ !input_file.empty())
+      << "One (and only one) of --input or --input_file must be specified.";
+  std::vector<std::vector<std::string>> input_sets;
+  if (!input.empty()) {
+    input_sets.push_back(absl::StrSplit(input, ';'));
+  } else {
+    absl::StatusOr<std::string> contents = xls::GetFileContents(input_file);
+    XLS_QCHECK_OK(contents.status());
+    for (absl::string_view line :
+         absl::StrSplit(contents.value(), '\n', absl::SkipWhitespace())) {
+      input_sets.push_back(absl::StrSplit(line, ';'));
+    }
+  }
 
   std::string dump_cells_str = absl::GetFlag(FLAGS_dump_cells);
   std::vector<std::string> dump_cells = absl::StrSplit(dump_cells_str, ',');
 
   std::string output_type = absl::GetFlag(FLAGS_output_type);
 
-  XLS_QCHECK_OK(xls::RealMain(netlist_path, cell_library_path,
-                              cell_library_proto_path, module_name, inputs,
-                              output_type, dump_cells));
+  XLS_QCHECK_OK(xls::RealMain(
+      netlist_path, cell_library_path, cell_library_proto_path,
+      absl::GetFlag(FLAGS_cell_library_cache_dir), module_name, input_sets,
+      output_type, dump_cells));
 
   return 0;
 }
@@ -49,6 +49,19 @@ class NetlistTranspilerMainTest(test_base.TestCase):
                                   'bits[8]')
     self.assertEqual(res, 'bits[8]:0xaa')
 
+  def test_input_file(self):
+    # More inputs than are evaluated in a single batch of 64 vectors.
+    inputs = ['bits[16]:{}'.format(i * i) for i in range(100)]
+    input_file = self.create_tempfile(content='\n'.join(inputs) + '\n')
+    result = subprocess.check_output([
+        NETLIST_INTERPRETER_MAIN,
+        '--netlist=' + runfiles.get_path(XLS_TOOLS + 'testdata/sqrt.v'),
+        '--module_name=isqrt', '--input_file=' + input_file.full_path,
+        '--output_type=bits[8]', '--cell_library=' + CELL_LIBRARY
+    ]).decode('utf-8')
+    self.assertEqual(result.split(),
+                     ['bits[8]:{:#x}'.format(i) for i in range(100)])
+
 
 if __name__ == '__main__':
   test_base.main()
@@ -14,9 +14,12 @@
 
 #include "xls/tools/opt.h"
 
+#include <iostream>
+
 #include "xls/dslx/ir_converter.h"
 #include "xls/dslx/parse_and_typecheck.h"
 #include "xls/ir/ir_parser.h"
+#include "xls/passes/pass_profile.h"
 #include "xls/passes/passes.h"
 #include "xls/passes/standard_pipeline.h"
 
@@ -41,10 +44,16 @@ absl::StatusOr<std::string> OptimizeIrForEntry(absl::string_view ir,
       .ir_dump_path = options.ir_dump_path,
       .run_only_passes = options.run_only_passes,
       .skip_passes = options.skip_passes,
+      .thread_count = options.thread_count,
+      .bdd_memory_limit_bytes = options.bdd_memory_limit_bytes,
   };
   PassResults results;
   XLS_RETURN_IF_ERROR(
       pipeline->Run(package.get(), pass_options, &results).status());
+  if (!options.pass_profile_out.empty()) {
+    XLS_RETURN_IF_ERROR(WritePassProfile(options.pass_profile_out, results));
+    std::cerr << FormatPassProfileSummary(PassResultsToProfileProto(results));
+  }
   return package->DumpIr();
 }
 
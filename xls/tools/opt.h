@@ -38,6 +38,15 @@ struct OptOptions {
   absl::optional<absl::string_view> ir_path = absl::nullopt;
   absl::optional<std::vector<std::string>> run_only_passes = absl::nullopt;
   std::vector<std::string> skip_passes;
+  // If non-empty, a profile of the pass invocations is written to this path
+  // and a summary table is printed to stderr.
+  absl::string_view pass_profile_out = "";
+  // Approximate memory limit of the BDD of each function in BDD-based passes.
+  // Zero means no limit.
+  int64_t bdd_memory_limit_bytes = int64_t{1} << 30;
+  // Maximum number of threads used within a pass to optimize independent
+  // functions and procs concurrently.
+  int64_t thread_count = 1;
 };
 
 // Helper used in the opt_main tool, optimizes the given IR for a particular
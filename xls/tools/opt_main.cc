@@ -38,6 +38,21 @@ ABSL_FLAG(std::vector<std::string>, skip_passes, {},
           "pass names are skipped. If both --run_only_passes and --skip_passes "
           "are specified only passes which are present in --run_only_passes "
           "and not present in --skip_passes will be run.");
+ABSL_FLAG(std::string, pass_profile_out, "",
+          "If specified, write a profile of the pass invocations (run time, "
+          "node counts, peak RSS growth) to this path and print a summary "
+          "table to stderr. The profile is written as JSON if the path ends in "
+          "'.json' and as a text-format PassProfileProto otherwise.");
+ABSL_FLAG(int64_t, bdd_memory_limit_bytes, int64_t{1} << 30,
+          "Approximate limit on the memory used by the binary decision "
+          "diagram of each function in BDD-based passes. Beyond the limit the "
+          "analysis loses precision instead of consuming more memory. If zero, "
+          "then no limit.");
+ABSL_FLAG(int64_t, pass_thread_count, 1,
+          "Maximum number of threads used within a pass. Passes which operate "
+          "on each function and proc separately optimize independent "
+          "functions and procs concurrently. The output does not depend on "
+          "the number of threads.");
 ABSL_FLAG(int64_t, opt_level, xls::kMaxOptLevel,
           absl::StrFormat("Optimization level. Ranges from 1 to %d.",
                           xls::kMaxOptLevel));
@@ -54,6 +69,7 @@ absl::Status RealMain(absl::string_view input_path) {
   std::string ir_dump_path = absl::GetFlag(FLAGS_ir_dump_path);
   std::vector<std::string> run_only_passes =
       absl::GetFlag(FLAGS_run_only_passes);
+  std::string pass_profile_out = absl::GetFlag(FLAGS_pass_profile_out);
   const OptOptions options = {
       .opt_level = absl::GetFlag(FLAGS_opt_level),
       .entry = entry,
@@ -62,6 +78,9 @@ absl::Status RealMain(absl::string_view input_path) {
                              ? absl::nullopt
                              : absl::make_optional(std::move(run_only_passes)),
       .skip_passes = absl::GetFlag(FLAGS_skip_passes),
+      .pass_profile_out = pass_profile_out,
+      .bdd_memory_limit_bytes = absl::GetFlag(FLAGS_bdd_memory_limit_bytes),
+      .thread_count = absl::GetFlag(FLAGS_pass_thread_count),
   };
   XLS_ASSIGN_OR_RETURN(std::string opt_ir,
                        tools::OptimizeIrForEntry(ir, options));
@@ -16,6 +16,7 @@
 
 """Tests for xls.tools.codegen_main."""
 
+import json
 import subprocess
 
 from xls.common import runfiles
@@ -103,6 +104,21 @@ class OptMainTest(test_base.TestCase):
     # Skipping DFE should leave the dead function in the IR.
     self.assertIn('dead_function', optimized_ir)
 
+  def test_pass_thread_count(self):
+    ir_file = self.create_tempfile(content=DEAD_FUNCTION_IR)
+
+    # Keep both functions so passes have independent functions to optimize
+    # concurrently. The output should not depend on the thread count.
+    single_threaded_ir = subprocess.check_output(
+        [OPT_MAIN_PATH, '--skip_passes=dfe',
+         ir_file.full_path]).decode('utf-8')
+    multi_threaded_ir = subprocess.check_output([
+        OPT_MAIN_PATH, '--skip_passes=dfe', '--pass_thread_count=4',
+        ir_file.full_path
+    ]).decode('utf-8')
+    self.assertIn('dead_function', multi_threaded_ir)
+    self.assertEqual(single_threaded_ir, multi_threaded_ir)
+
   def test_opt_level(self):
     ir_file = self.create_tempfile(content=ADD_LITERAL_IR)
 
@@ -129,6 +145,30 @@ class OptMainTest(test_base.TestCase):
     self.assertIn('bits[32] = add', optimized_ir)
     self.assertNotIn('concat', optimized_ir)
 
+  def test_pass_profile_out(self):
+    ir_file = self.create_tempfile(content=ADD_ZERO_IR)
+    profile_path = self.create_tempfile(file_path='profile.json').full_path
+
+    result = subprocess.run([
+        OPT_MAIN_PATH, '--run_only_passes=arith_simp,dce',
+        '--pass_profile_out=' + profile_path, ir_file.full_path
+    ],
+                            stdout=subprocess.PIPE,
+                            stderr=subprocess.PIPE,
+                            check=True)
+    self.assertIn('ret x', result.stdout.decode('utf-8'))
+
+    with open(profile_path) as f:
+      profile = json.load(f)
+    pass_names = set(i['pass_name'] for i in profile['invocations'])
+    self.assertEqual(pass_names, {'arith_simp', 'dce'})
+    self.assertTrue(any(i['ir_changed'] for i in profile['invocations']))
+
+    # The summary table is printed to stderr.
+    summary = result.stderr.decode('utf-8')
+    self.assertIn('arith_simp', summary)
+    self.assertIn('Total', summary)
+
 
 if __name__ == '__main__':
   test_base.main()
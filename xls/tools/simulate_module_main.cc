@@ -12,6 +12,9 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <memory>
+#include <string>
+
 #include "absl/flags/flag.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -23,8 +26,10 @@
 #include "xls/common/init_xls.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/ir/block.h"
 #include "xls/ir/format_preference.h"
 #include "xls/ir/ir_parser.h"
+#include "xls/ir/package.h"
 #include "xls/ir/value.h"
 #include "xls/simulation/module_simulator.h"
 #include "xls/simulation/verilog_simulators.h"
@@ -56,6 +61,11 @@ ABSL_FLAG(std::string, args, "",
           "The semicolon-separated arguments to pass to the module. The "
           "number of arguments must match the number of and types of the "
           "inputs of the module. Cannot be specified with --args_file.");
+ABSL_FLAG(std::string, block_ir_path, "",
+          "The path to the IR of the package holding the block the module was "
+          "generated from, as written by codegen_main --output_block_ir_path. "
+          "Required by simulators which evaluate the block rather than the "
+          "Verilog, such as \"native\".");
 ABSL_FLAG(std::string, verilog_simulator, "",
           "The Verilog simulator to use. If not specified, the default "
           "simulator is used.");
@@ -66,9 +76,17 @@ namespace {
 absl::Status RealMain(absl::string_view verilog_text,
                       const verilog::ModuleSignature& signature,
                       absl::Span<const std::string> args_strings,
-                      const verilog::VerilogSimulator* verilog_simulator) {
+                      const verilog::VerilogSimulator* verilog_simulator,
+                      absl::string_view block_ir_path) {
+  std::unique_ptr<Package> package;
+  Block* block = nullptr;
+  if (!block_ir_path.empty()) {
+    XLS_ASSIGN_OR_RETURN(std::string block_ir, GetFileContents(block_ir_path));
+    XLS_ASSIGN_OR_RETURN(package, Parser::ParsePackage(block_ir));
+    XLS_ASSIGN_OR_RETURN(block, package->GetBlock(signature.module_name()));
+  }
   verilog::ModuleSimulator simulator(signature, verilog_text,
-                                     verilog_simulator);
+                                     verilog_simulator, block);
 
   std::vector<absl::flat_hash_map<std::string, Value>> args_sets;
   for (absl::string_view args_string : args_strings) {
@@ -142,7 +160,8 @@ int main(int argc, char** argv) {
   XLS_QCHECK_OK(signature_status.status());
 
   XLS_QCHECK_OK(xls::RealMain(verilog_text.value(), signature_status.value(),
-                              args_strings, verilog_simulator));
+                              args_strings, verilog_simulator,
+                              absl::GetFlag(FLAGS_block_ir_path)));
 
   return EXIT_SUCCESS;
 }
@@ -81,6 +81,31 @@ class SimulateModuleMainTest(test_base.TestCase):
     self.assertMultiLineEqual('bits[32]:0xf01\nbits[32]:0x2a\n',
                               result.decode('utf-8'))
 
+  def test_native_simulator(self):
+    ir_file = self.create_tempfile(content=ADD_IR)
+    verilog_file = self.create_tempfile()
+    signature_file = self.create_tempfile()
+    block_ir_file = self.create_tempfile()
+    subprocess.check_call([
+        CODEGEN_MAIN_PATH,
+        '--generator=pipeline',
+        '--delay_model=unit',
+        '--pipeline_stages=2',
+        '--output_verilog_path=' + verilog_file.full_path,
+        '--output_signature_path=' + signature_file.full_path,
+        '--output_block_ir_path=' + block_ir_file.full_path,
+        '--alsologtostderr',
+        ir_file.full_path,
+    ])
+    result = subprocess.check_output([
+        SIMULATE_MODULE_MAIN_PATH, '--verilog_simulator=native',
+        '--alsologtostderr', '--v=1',
+        '--signature_file=' + signature_file.full_path,
+        '--block_ir_path=' + block_ir_file.full_path,
+        '--args=bits[32]:7; bits[32]:123', verilog_file.full_path
+    ])
+    self.assertEqual('bits[32]:0x82', result.decode('utf-8').strip())
+
 
 if __name__ == '__main__':
   test_base.main()
@@ -69,7 +69,9 @@ void RealMain() {
   absl::StatusOr<verilog::Module*> module_status = verilog::WrapIo(
       wrapped_module_name, instance_name, signature, io_strategy.get(), &f);
   XLS_QCHECK_OK(module_status.status());
-  std::cout << f.Emit() << std::endl;
+  verilog::LineWriter writer(&std::cout);
+  f.EmitTo(&writer);
+  std::cout << std::endl;
 }
 
 }  // namespace